@@ -1,5 +1,9 @@
 #include <Arduino.h>
 #include <Wire.h>
+#include <esp_timer.h>
+
+#include "i2c_frame.h" // xiaozhi/main/actuator, shared with xiaozhi and the actuator
+#include "i2c_reply_wait.h"
 
 // ==================== I2C CONFIG ====================
 #define I2C_SLAVE_ADDR 0x55
@@ -13,6 +17,7 @@ String serialBuffer = "";
 unsigned long lastStatusRequest = 0;
 unsigned long lastLedToggle = 0;
 bool ledState = false;
+uint8_t frameSeq = 0;
 
 #define LED_BUILTIN 2
 
@@ -104,6 +109,113 @@ String sendAndReceive(const String &json, uint16_t delayMs = 500) {
   return readI2CResponse(delayMs);
 }
 
+/**
+ * Send binary frame and poll until the reply carrying the same seq is written
+ */
+bool sendFrame(I2cFrame &request, I2cFrame &reply) {
+  // 0 is left for replies nobody asked for
+  if (++frameSeq == 0)
+    frameSeq = 1;
+  request.seq = frameSeq;
+
+  uint8_t buffer[I2C_FRAME_MAX_SIZE];
+  size_t size = request.Encode(buffer, sizeof(buffer));
+  if (size == 0) {
+    Serial.println("❌ Frame too large");
+    return false;
+  }
+
+  Wire.beginTransmission(I2C_SLAVE_ADDR);
+  Wire.write(buffer, size);
+  uint8_t error = Wire.endTransmission();
+  if (error != 0) {
+    Serial.printf("❌ I2C Send Error: %d\n", error);
+    return false;
+  }
+  // 64-bit clock: the 32-bit micros() wraps every ~71 minutes
+  int64_t start = esp_timer_get_time();
+  Serial.printf("📤 TX frame type=0x%02X seq=%d (%d bytes)\n", request.type,
+                request.seq, (int)size);
+
+  // Exactly the reply size: the slave answers busy until the reply is written
+  size_t replySize = I2cFrameReplySize(request.type);
+  I2cReplyWait wait(start, I2cReplyBudgetUs(request.type));
+  for (int64_t delayUs; (delayUs = wait.NextDelayUs(esp_timer_get_time())) >= 0;) {
+    if (delayUs < I2C_REPLY_SPIN_US)
+      delayMicroseconds(delayUs);
+    else
+      delay(delayUs / 1000);
+
+    Wire.requestFrom((uint8_t)I2C_SLAVE_ADDR, (uint8_t)replySize, (uint8_t)true);
+    size_t count = 0;
+    while (Wire.available() && count < replySize) {
+      buffer[count++] = Wire.read();
+    }
+
+    I2cFrameError frameError = reply.Decode(buffer, count);
+    if (frameError == kI2cFrameOk && reply.seq == request.seq &&
+        reply.type != kI2cFrameBusy) {
+      Serial.printf("📥 Reply after %d us (%d polls)\n",
+                    (int)(esp_timer_get_time() - start), wait.polls());
+      return true;
+    }
+  }
+
+  Serial.printf("❌ No reply after %d polls\n", wait.polls());
+  return false;
+}
+
+void printReply(const I2cFrame &reply) {
+  if (reply.type == kI2cFrameStatusReply) {
+    uint8_t flags = reply.u8(0);
+    uint8_t storage = reply.u8(3);
+    Serial.printf("✅ RX status: BLE=%d HR=%d moving=%d storage=[%d,%d,%d,%d] "
+                  "gamepad=0x%02X\n",
+                  (flags & I2C_STATUS_BLE_CONNECTED) ? 1 : 0,
+                  (int16_t)reply.u16(1), (flags & I2C_STATUS_MOVING) ? 1 : 0,
+                  storage & 1, (storage >> 1) & 1, (storage >> 2) & 1,
+                  (storage >> 3) & 1, reply.u8(4));
+  } else if (reply.type == kI2cFrameAck) {
+    Serial.printf("✅ RX ack: %d\n", (int8_t)reply.u8(0));
+  } else {
+    Serial.printf("⚠️ RX unknown frame type 0x%02X\n", reply.type);
+  }
+}
+
+/**
+ * Parse a short command into a frame:
+ *   v <dir> <speed> <ms>   d <dir> <speed> <mm>   s <slot> <action>   t
+ */
+bool parseFrameCommand(const String &line, I2cFrame &request) {
+  char kind = 0;
+  int a = 0, b = 0;
+  long c = 0;
+  int fields = sscanf(line.c_str(), "%c %d %d %ld", &kind, &a, &b, &c);
+
+  switch (kind) {
+  case 'v':
+  case 'd':
+    if (fields < 2)
+      return false;
+    request = I2cFrame(kind == 'v' ? kI2cFrameVehicleTime
+                                   : kI2cFrameVehicleDistance,
+                       0);
+    request.U8(a).U8(b).U32(c);
+    return true;
+  case 's':
+    if (fields < 3)
+      return false;
+    request = I2cFrame(kI2cFrameStorage, 0);
+    request.U8(a).U8(b);
+    return true;
+  case 't':
+    request = I2cFrame(kI2cFrameStatus, 0);
+    return true;
+  default:
+    return false;
+  }
+}
+
 /**
  * Check if slave is online
  */
@@ -127,13 +239,24 @@ void processSerialInput() {
         Serial.println("\n━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━");
         Serial.printf("🎯 Command: %s\n", serialBuffer.c_str());
         
-        // ✅ TĂNG DELAY LÊN 500ms
-        String response = sendAndReceive(serialBuffer, 20);
-        
-        if (response.length() > 0) {
-          Serial.println("✅ SUCCESS!");
+        if (serialBuffer.startsWith("{")) {
+          // JSON debug protocol
+          String response = sendAndReceive(serialBuffer, 20);
+
+          if (response.length() > 0) {
+            Serial.println("✅ SUCCESS!");
+          } else {
+            Serial.println("❌ NO VALID RESPONSE");
+          }
         } else {
-          Serial.println("❌ NO VALID RESPONSE");
+          I2cFrame request, reply;
+          if (!parseFrameCommand(serialBuffer, request)) {
+            Serial.println("❌ Unknown command");
+          } else if (sendFrame(request, reply)) {
+            printReply(reply);
+          } else {
+            Serial.println("❌ NO VALID RESPONSE");
+          }
         }
         
         Serial.println("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
@@ -155,7 +278,10 @@ void periodicStatusRequest() {
     lastStatusRequest = millis();
 
     Serial.println("\n🔄 ────── Auto Status Request ──────");
-    String response = sendAndReceive("{\"t\":\"t\"}");
+    I2cFrame request(kI2cFrameStatus, 0), reply;
+    if (sendFrame(request, reply)) {
+      printReply(reply);
+    }
     Serial.println("────────────────────────────────────\n");
   }
 }
@@ -198,7 +324,10 @@ void setup() {
     // Initial status request
     Serial.println("🧪 Initial test:");
     Serial.println("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━");
-    sendAndReceive("{\"t\":\"t\"}");
+    I2cFrame request(kI2cFrameStatus, 0), reply;
+    if (sendFrame(request, reply)) {
+      printReply(reply);
+    }
     Serial.println("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
   } else {
     Serial.println("❌ Slave not found!");
@@ -206,7 +335,13 @@ void setup() {
   }
 
   // Print command examples
-  Serial.println("📝 Command Examples:");
+  Serial.println("📝 Command Examples (binary frames):");
+  Serial.println("     v 1 60 2000   ← Forward 60% for 2000 ms");
+  Serial.println("     d 2 40 300    ← Backward 40% for 300 mm");
+  Serial.println("     v 0           ← Stop");
+  Serial.println("     s 0 1         ← Open slot 0");
+  Serial.println("     t             ← Get status");
+  Serial.println("📝 JSON debug protocol:");
   Serial.println("   Vehicle:");
   Serial.println("     {\"t\":\"v\",\"d\":1,\"s\":60,\"ms\":2000}  ← Forward");
   Serial.println("     {\"t\":\"v\",\"d\":2,\"s\":60,\"ms\":2000}  ← Backward");
@@ -1,6 +1,9 @@
 
 
 #include "HeartRateBLE.h"
+#include "i2c_batch.h"
+#include "i2c_frame.h" // xiaozhi/main/actuator, shared with the master
+#include "i2c_status_delta.h"
 #include <AccelStepper.h>
 #include <Arduino.h>
 #include <ArduinoJson.h>
@@ -44,20 +47,7 @@ PS2X ps2x; // create PS2 Controller Class
 #define TYPE_STORAGE "s"
 #define TYPE_STATUS "t"
 
-#define DIR_STOP 0
-#define DIR_FORWARD 1
-#define DIR_BACKWARD 2
-#define DIR_LEFT 3
-#define DIR_RIGHT 4
-#define DIR_ROTATE_LEFT 5
-#define DIR_ROTATE_RIGHT 6
-
-#define ACT_CLOSE 0
-#define ACT_OPEN 1
-
-#define STATUS_OK 1
-#define STATUS_ERROR -1
-#define STATUS_UNKNOWN -2
+// DIR_*, ACT_* and STATUS_* come from i2c_frame.h
 
 // ==================== BLE SETUP ====================
 HeartRateBLE hrBle;
@@ -103,6 +93,14 @@ void bluetooth_init() {
 #define SERVO_2 27
 #define SERVO_3 26
 #define LED_STATUS 12
+// Data-ready output to the master (CONFIG_ACTUATOR_DATA_READY_GPIO), -1 = none
+#ifndef DATA_READY_PIN
+#define DATA_READY_PIN -1
+#endif
+// Status-changed output (CONFIG_ACTUATOR_STATUS_CHANGED_GPIO), -1 = none
+#ifndef STATUS_CHANGED_PIN
+#define STATUS_CHANGED_PIN -1
+#endif
 
 // ==================== SERVO ANGLES ====================
 int servoOpenAngles[4] = {90, 80, 90, 90};
@@ -132,10 +130,45 @@ bool isPS2ControlMode = false; // true = PS2 continuous control, false = I2C tim
 unsigned long moveStartTime = 0;
 unsigned long moveDuration = 0;
 
-String rxBuffer = "";
+uint8_t rxBuffer[129]; // + NUL for the JSON debug protocol
 String responseBuffer = "";
 bool responseReady = false;
 
+// Reply to the last binary frame, kept until the next request so the master
+// can read it again; 0 = answer in JSON (debug protocol). A busy frame until
+// TaskI2CCommand has written the reply.
+uint8_t txFrame[I2C_FRAME_MAX_SIZE];
+size_t txFrameSize = 0;
+portMUX_TYPE txFrameMux = portMUX_INITIALIZER_UNLOCKED;
+QueueHandle_t frameQueue = NULL;
+// A queued frame whose reply the master has not read yet; a stop arriving
+// meanwhile must not overwrite that reply
+volatile bool replyPending = false;
+// Stops handled in onI2CReceive; a move queued before the latest one is dropped
+volatile uint32_t stopCount = 0;
+
+struct QueuedFrame {
+  I2cFrame request;
+  uint32_t stopCount;
+};
+
+// Versioned status for kI2cFrameStatusDelta, new epoch drawn in setup()
+I2cStatusRecord statusRecord(1);
+portMUX_TYPE statusMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Step list (kI2cFrameBatch) handed to TaskBatch, and its progress for the
+// status record. Every accepted list moves batchGeneration on, which aborts
+// the one running.
+I2cBatch batchNext;
+bool batchNextPending = false;
+uint32_t batchNextStops = 0; // stopCount when accepted
+volatile uint32_t batchGeneration = 0;
+uint8_t batchId = 0;
+uint8_t batchDone = 0;
+uint8_t batchState = kI2cBatchIdle;
+portMUX_TYPE batchMux = portMUX_INITIALIZER_UNLOCKED;
+TaskHandle_t batchTask = NULL;
+
 // ==================== MOTOR CONTROL ====================
 void enableMotors() { digitalWrite(MOTOR_EN, LOW); }
 void disableMotors() { digitalWrite(MOTOR_EN, HIGH); }
@@ -507,34 +540,266 @@ void processCommand(String jsonStr) {
   responseReady = true;
 }
 
-// Build response buffer in the required flat format: <conn>|<hr>|<servoStates>|<flags>
-void updateResponseBuffer() {
-  int conn = hrBle.isConnected() ? 1 : 0;
-  int hr = hrBle.getHeartRate();
+// ==================== BINARY COMMAND ====================
+void setReply(const I2cFrame &reply) {
+  uint8_t buffer[I2C_FRAME_MAX_SIZE];
+  size_t size = reply.Encode(buffer, sizeof(buffer));
+
+  portENTER_CRITICAL(&txFrameMux);
+  memcpy(txFrame, buffer, size);
+  txFrameSize = size;
+  portEXIT_CRITICAL(&txFrameMux);
+
+  if (DATA_READY_PIN >= 0)
+    digitalWrite(DATA_READY_PIN, reply.type == kI2cFrameBusy ? LOW : HIGH);
+}
 
-  // servoStates as 4 chars '0'/'1'
-  String servosStr = "";
+void clearReply() {
+  portENTER_CRITICAL(&txFrameMux);
+  txFrameSize = 0;
+  portEXIT_CRITICAL(&txFrameMux);
+}
+
+void replyAck(uint8_t seq, int status) {
+  I2cFrame reply(kI2cFrameAck, seq);
+  reply.U8((uint8_t)status);
+  setReply(reply);
+}
+
+I2cStatusFields readStatusFields() {
+  I2cStatusFields fields;
+  if (hrBle.isConnected())
+    fields.flags |= I2C_STATUS_BLE_CONNECTED;
+  if (isMoving)
+    fields.flags |= I2C_STATUS_MOVING;
+  if (digitalRead(MOTOR_EN) == LOW)
+    fields.flags |= I2C_STATUS_MOTOR_ENABLED;
+  fields.heart_rate = hrBle.getHeartRate();
   for (int i = 0; i < 4; i++) {
-    servosStr += (storageStates[i] ? '1' : '0');
+    if (storageStates[i])
+      fields.storage |= 1 << i;
   }
+  fields.gamepad = ps2_flags;
+  portENTER_CRITICAL(&batchMux);
+  fields.batch_id = batchId;
+  fields.batch_done = batchDone;
+  fields.batch_state = batchState;
+  portEXIT_CRITICAL(&batchMux);
+  return fields;
+}
 
-  String resp = String(conn) + "|" + String(hr) + "|" + servosStr + "|" + String(ps2_flags);
-  responseBuffer = resp;
-  responseReady = true;
+// True if the status moved on to a new version
+bool updateStatusRecord(const I2cStatusFields &fields) {
+  portENTER_CRITICAL(&statusMux);
+  bool changed = statusRecord.Update(fields);
+  portEXIT_CRITICAL(&statusMux);
+  return changed;
+}
+
+// Versions the status and raises STATUS_CHANGED_PIN when it changes
+void trackStatus() {
+  if (updateStatusRecord(readStatusFields()) && STATUS_CHANGED_PIN >= 0)
+    digitalWrite(STATUS_CHANGED_PIN, HIGH);
+}
+
+void replyStatus(uint8_t seq) {
+  I2cStatusFields fields = readStatusFields();
+  I2cFrame reply(kI2cFrameStatusReply, seq);
+  reply.U8(fields.flags)
+      .U16((uint16_t)fields.heart_rate)
+      .U8(fields.storage)
+      .U8(fields.gamepad);
+  setReply(reply);
+}
+
+void replyStatusDelta(const I2cFrame &request) {
+  // Low before reading: a change from here on raises it again
+  if (STATUS_CHANGED_PIN >= 0)
+    digitalWrite(STATUS_CHANGED_PIN, LOW);
+
+  // Fresh values, not only what TaskStatusTrack saw last
+  I2cStatusFields fields = readStatusFields();
+  I2cFrame reply(kI2cFrameStatusDeltaReply, request.seq);
+  portENTER_CRITICAL(&statusMux);
+  statusRecord.Update(fields);
+  statusRecord.EncodeDelta(request, reply);
+  portEXIT_CRITICAL(&statusMux);
+  setReply(reply);
+}
+
+// ==================== BATCH ====================
+void setBatchProgress(uint8_t id, uint8_t done, uint8_t state) {
+  portENTER_CRITICAL(&batchMux);
+  batchId = id;
+  batchDone = done;
+  batchState = state;
+  portEXIT_CRITICAL(&batchMux);
+  // At once, a step may end between two TaskStatusTrack rounds
+  trackStatus();
+}
+
+// Queues the list for TaskBatch, aborting the one running
+bool startBatch(const I2cFrame &request) {
+  I2cBatch batch;
+  if (!batch.Decode(request)) {
+    Serial.println("⚠️ Invalid step list");
+    return false;
+  }
+  portENTER_CRITICAL(&batchMux);
+  batchNext = batch;
+  batchNextPending = true;
+  batchNextStops = stopCount;
+  batchGeneration++;
+  portEXIT_CRITICAL(&batchMux);
+  xTaskNotifyGive(batchTask);
+  Serial.printf("📋 Step list %d: %d steps\n", batch.id, batch.count);
+  return true;
+}
+
+// A stop frame or a newer list since the list started
+bool batchAborted(uint32_t generation, uint32_t stops) {
+  return batchGeneration != generation || stopCount != stops;
+}
+
+// False if aborted; the vehicle is stopped then
+bool runBatchStep(const I2cBatchStep &step, uint32_t generation,
+                  uint32_t stops) {
+  switch (step.kind) {
+  case kI2cBatchMoveTime:
+    if (step.IsStop()) {
+      stopVehicle();
+      return true;
+    }
+    moveVehicleByTime(step.target, step.arg, step.value);
+    break;
+  case kI2cBatchMoveDistance:
+    moveVehicleByDistance(step.target, step.arg, step.value);
+    break;
+  case kI2cBatchStorage:
+    // Like a single storage frame, a door move runs to its end
+    controlStorageDoor(step.target, step.arg);
+    return !batchAborted(generation, stops);
+  case kI2cBatchWait: {
+    unsigned long start = millis();
+    while (millis() - start < step.value) {
+      if (batchAborted(generation, stops))
+        return false;
+      vTaskDelay(5 / portTICK_PERIOD_MS);
+    }
+    return true;
+  }
+  }
+
+  // Moves end in updateMotors()
+  while (isMoving) {
+    if (batchAborted(generation, stops)) {
+      stopVehicle();
+      return false;
+    }
+    vTaskDelay(5 / portTICK_PERIOD_MS);
+  }
+  return true;
+}
+
+void runBatch(const I2cBatch &batch, uint32_t generation, uint32_t stops) {
+  setBatchProgress(batch.id, 0, kI2cBatchRunning);
+  for (uint8_t i = 0; i < batch.count; i++) {
+    if (batchAborted(generation, stops) ||
+        !runBatchStep(batch.steps[i], generation, stops)) {
+      Serial.printf("⚠️ Step list %d aborted at step %d\n", batch.id, i + 1);
+      setBatchProgress(batch.id, i, kI2cBatchAborted);
+      return;
+    }
+    setBatchProgress(batch.id, i + 1, kI2cBatchRunning);
+  }
+  setBatchProgress(batch.id, batch.count, kI2cBatchDone);
+  Serial.printf("✅ Step list %d done\n", batch.id);
+}
+
+void processFrame(const I2cFrame &request) {
+  switch (request.type) {
+  case kI2cFrameVehicleTime:
+    if (request.u8(0) == DIR_STOP || request.u32(2) == 0)
+      stopVehicle();
+    else
+      moveVehicleByTime(request.u8(0), request.u8(1), request.u32(2));
+    replyAck(request.seq, STATUS_OK);
+    break;
+  case kI2cFrameVehicleDistance:
+    if (request.u8(0) == DIR_STOP || request.u32(2) == 0)
+      stopVehicle();
+    else
+      moveVehicleByDistance(request.u8(0), request.u8(1), request.u32(2));
+    replyAck(request.seq, STATUS_OK);
+    break;
+  case kI2cFrameStorage:
+    controlStorageDoor(request.u8(0), request.u8(1));
+    replyAck(request.seq, STATUS_OK);
+    break;
+  case kI2cFrameStatus:
+    replyStatus(request.seq);
+    break;
+  case kI2cFrameStatusDelta:
+    replyStatusDelta(request);
+    break;
+  case kI2cFrameBatch:
+    replyAck(request.seq, startBatch(request) ? STATUS_OK : STATUS_ERROR);
+    break;
+  default:
+    replyAck(request.seq, STATUS_UNKNOWN);
+    break;
+  }
+}
+
+bool isStopFrame(const I2cFrame &request) {
+  return (request.type == kI2cFrameVehicleTime ||
+          request.type == kI2cFrameVehicleDistance) &&
+         (request.u8(0) == DIR_STOP || request.u32(2) == 0);
 }
 
 // ==================== I2C HANDLERS ====================
-void onI2CReceive(int bytes) {
-  rxBuffer = "";
-  while (Wire.available())
-    rxBuffer += (char)Wire.read();
-  if (rxBuffer.startsWith("{") && rxBuffer.endsWith("}")) {
+void onI2CReceive(int) {
+  size_t size = 0;
+  while (Wire.available()) {
+    uint8_t c = Wire.read();
+    if (size < sizeof(rxBuffer) - 1)
+      rxBuffer[size++] = c;
+  }
+  rxBuffer[size] = '\0';
+
+  if (size > 0 && rxBuffer[0] == I2C_FRAME_MAGIC) {
+    I2cFrame request;
+    I2cFrameError error = request.Decode(rxBuffer, size);
+    if (error == kI2cFrameOk && isStopFrame(request)) {
+      // Stops run at once, even while a door is moving. The master may send
+      // one while it polls for another reply; that reply stays in place.
+      stopCount++;
+      stopVehicle();
+      if (!replyPending)
+        replyAck(request.seq, STATUS_OK);
+    } else if (error == kI2cFrameOk) {
+      // Servo moves take ~0.6 s: answer busy and run the command in
+      // TaskI2CCommand so onI2CRequest stays free to answer polls
+      replyPending = true;
+      setReply(I2cFrame(kI2cFrameBusy, request.seq));
+      QueuedFrame queued = {request, stopCount};
+      if (xQueueSend(frameQueue, &queued, 0) != pdTRUE)
+        replyAck(request.seq, STATUS_ERROR);
+    } else {
+      Serial.printf("⚠️ Bad frame: %s\n", I2cFrameErrorName(error));
+      replyAck(size > 2 ? rxBuffer[2] : 0, STATUS_ERROR);
+    }
+  } else if (size > 1 && rxBuffer[0] == '{' && rxBuffer[size - 1] == '}') {
+    // JSON debug protocol
+    clearReply();
     responseReady = false;
-    processCommand(rxBuffer);
-  } else {
+    processCommand(String((const char *)rxBuffer));
+  } else if (size > 1) {
+    clearReply();
     responseBuffer = "{\"" KEY_STATUS "\":" STR(STATUS_ERROR) "}";
     responseReady = true;
   }
+  // A single byte is the master's liveness probe, the pending reply stays
 }
 
 // void onI2CRequest() {
@@ -545,6 +810,18 @@ void onI2CReceive(int bytes) {
 // }
 
 void onI2CRequest() {
+  uint8_t frame[I2C_FRAME_MAX_SIZE];
+  portENTER_CRITICAL(&txFrameMux);
+  size_t frameSize = txFrameSize;
+  memcpy(frame, txFrame, frameSize);
+  portEXIT_CRITICAL(&txFrameMux);
+  if (frameSize > 0) {
+    Wire.write(frame, frameSize);
+    if (frame[1] != kI2cFrameBusy)
+      replyPending = false;
+    return;
+  }
+
   // Nếu chưa có phản hồi thì gửi trạng thái mặc định
   if (!responseReady || responseBuffer.isEmpty())
     responseBuffer = "{\"" KEY_STATUS "\":0}";
@@ -564,7 +841,7 @@ void onI2CRequest() {
 }
 
 // ==================== TASKS ====================
-void TaskHeartRateBluetooth(void *parameter) {
+void TaskHeartRateBluetooth(void *) {
   bluetooth_init();
   for (;;) {
     hrBle.loop();
@@ -572,7 +849,52 @@ void TaskHeartRateBluetooth(void *parameter) {
   }
 }
 
-void TaskMotorUpdate(void *parameter) {
+void TaskI2CCommand(void *) {
+  QueuedFrame queued;
+  for (;;) {
+    if (xQueueReceive(frameQueue, &queued, portMAX_DELAY) != pdTRUE)
+      continue;
+    bool move = queued.request.type == kI2cFrameVehicleTime ||
+                queued.request.type == kI2cFrameVehicleDistance ||
+                queued.request.type == kI2cFrameBatch;
+    if (move && queued.stopCount != stopCount) {
+      Serial.println("⚠️ Move cancelled by a later stop");
+      replyAck(queued.request.seq, STATUS_ERROR);
+      continue;
+    }
+    processFrame(queued.request);
+  }
+}
+
+void TaskStatusTrack(void *) {
+  for (;;) {
+    trackStatus();
+    vTaskDelay(20 / portTICK_PERIOD_MS);
+  }
+}
+
+// Runs step lists one at a time, kept off TaskI2CCommand so status requests
+// are still answered meanwhile
+void TaskBatch(void *) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    for (;;) {
+      I2cBatch batch;
+      portENTER_CRITICAL(&batchMux);
+      bool pending = batchNextPending;
+      batch = batchNext;
+      batchNextPending = false;
+      uint32_t generation = batchGeneration;
+      uint32_t stops = batchNextStops;
+      portEXIT_CRITICAL(&batchMux);
+      if (!pending)
+        break;
+      runBatch(batch, generation, stops);
+    }
+  }
+}
+
+void TaskMotorUpdate(void *) {
   for (;;) {
     updateMotors();
     vTaskDelay(1 / portTICK_PERIOD_MS);
@@ -592,6 +914,20 @@ void setup() {
   setupMotors();
   setupServos();
 
+  if (DATA_READY_PIN >= 0) {
+    pinMode(DATA_READY_PIN, OUTPUT);
+    digitalWrite(DATA_READY_PIN, LOW);
+  }
+  if (STATUS_CHANGED_PIN >= 0) {
+    pinMode(STATUS_CHANGED_PIN, OUTPUT);
+    digitalWrite(STATUS_CHANGED_PIN, LOW);
+  }
+  statusRecord = I2cStatusRecord((uint8_t)esp_random());
+  frameQueue = xQueueCreate(4, sizeof(QueuedFrame));
+  xTaskCreatePinnedToCore(TaskBatch, "Batch", 4096, NULL, 2, &batchTask, 1);
+  xTaskCreatePinnedToCore(TaskI2CCommand, "I2CCommand", 4096, NULL, 2, NULL,
+                          1);
+
   Wire.begin(I2C_SLAVE_ADDR, SDA_PIN, SCL_PIN, 100000);
   Wire.onReceive(onI2CReceive);
   Wire.onRequest(onI2CRequest);
@@ -600,14 +936,14 @@ void setup() {
                           4096 * 5, NULL, 1, NULL, 1);
   xTaskCreatePinnedToCore(TaskMotorUpdate, "MotorUpdate", 4096 * 5, NULL, 1,
                           NULL, 0);
+  xTaskCreatePinnedToCore(TaskStatusTrack, "StatusTrack", 4096, NULL, 1, NULL,
+                          1);
 
   digitalWrite(LED_STATUS, HIGH);
   Serial.println("✅ System ready!");
   Serial.println("📍 I2C Address: 0x55");
 
   ps2x.config_gamepad(PS2_CLK, PS2_CMD, PS2_SEL, PS2_DAT, pressures, rumble);
-  // Initialize response buffer for master
-  updateResponseBuffer();
 }
 
 byte vibrate = 0;
@@ -632,48 +968,38 @@ void loop() {
   if (ps2x.ButtonPressed(PSB_CROSS)) {
     int slot = 0;
     controlStorageDoor(slot, storageStates[slot] ? ACT_CLOSE : ACT_OPEN);
-    updateResponseBuffer();
   }
   if (ps2x.ButtonPressed(PSB_SQUARE)) {
     int slot = 1;
     controlStorageDoor(slot, storageStates[slot] ? ACT_CLOSE : ACT_OPEN);
-    updateResponseBuffer();
   }
   if (ps2x.ButtonPressed(PSB_TRIANGLE)) {
     int slot = 2;
     controlStorageDoor(slot, storageStates[slot] ? ACT_CLOSE : ACT_OPEN);
-    updateResponseBuffer();
   }
   if (ps2x.ButtonPressed(PSB_CIRCLE)) {
     int slot = 3;
     controlStorageDoor(slot, storageStates[slot] ? ACT_CLOSE : ACT_OPEN);
-    updateResponseBuffer();
   }
 
   // 3) Other buttons toggle flags (flip bit on press)
   if (ps2x.ButtonPressed(PSB_L1)) {
     ps2_flags ^= (1 << 0);
-    updateResponseBuffer();
   }
   if (ps2x.ButtonPressed(PSB_R1)) {
     ps2_flags ^= (1 << 1);
-    updateResponseBuffer();
   }
   if (ps2x.ButtonPressed(PSB_L2)) {
     ps2_flags ^= (1 << 2);
-    updateResponseBuffer();
   }
   if (ps2x.ButtonPressed(PSB_R2)) {
     ps2_flags ^= (1 << 3);
-    updateResponseBuffer();
   }
   if (ps2x.ButtonPressed(PSB_SELECT)) {
     ps2_flags ^= (1 << 4);
-    updateResponseBuffer();
   }
   if (ps2x.ButtonPressed(PSB_START)) {
     ps2_flags ^= (1 << 5);
-    updateResponseBuffer();
   }
 
   // optional: use an analog value for vibration feedback
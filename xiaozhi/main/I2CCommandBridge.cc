@@ -1,15 +1,25 @@
 #include "I2CCommandBridge.h"
+#include "i2c_reply_wait.h"
+#include "telemetry.h"
+#include "driver/gpio.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <cstdio>
 #include <cstring>
 
 static const char *TAG = "I2CCommandBridge";
 
 I2CCommandBridge::I2CCommandBridge()
     : initialized_(false), owns_bus_handle_(false), bus_handle_(nullptr),
-      dev_handle_(nullptr), polling_active_(false), polling_interval_ms_(1000),
+      dev_handle_(nullptr), seq_(0), batch_id_(0), data_ready_sem_(nullptr),
+      status_changed_sem_(nullptr),
+      bus_task_handle_(nullptr),
+      polling_active_(false), polling_interval_ms_(1000),
       polling_task_handle_(nullptr), status_callback_(nullptr),
-      callback_user_data_(nullptr) {}
+      callback_user_data_(nullptr), last_status_(), liveness_callback_(nullptr),
+      liveness_user_data_(nullptr) {}
 
 I2CCommandBridge::~I2CCommandBridge() { Deinit(); }
 
@@ -52,6 +62,8 @@ bool I2CCommandBridge::Init() {
   }
 
   initialized_ = true;
+  SetupEdgeInputs();
+  StartBusTask();
   ESP_LOGI(TAG,
            "✅ I2C Command Bridge initialized (SCL=%d, SDA=%d, Slave=0x%02X)",
            I2C_MASTER_SCL_IO, I2C_MASTER_SDA_IO, ACTUATOR_ESP32_ADDR);
@@ -89,6 +101,8 @@ bool I2CCommandBridge::InitWithExistingBus(
   }
 
   initialized_ = true;
+  SetupEdgeInputs();
+  StartBusTask();
   ESP_LOGI(TAG,
            "✅ I2C Command Bridge initialized with shared bus (Slave=0x%02X)",
            ACTUATOR_ESP32_ADDR);
@@ -99,8 +113,9 @@ void I2CCommandBridge::Deinit() {
   if (!initialized_)
     return;
 
-  // Stop polling first
+  // Stop polling first, then let the bus task finish its transaction
   StopStatusPolling();
+  StopBusTask();
 
   if (dev_handle_) {
     i2c_master_bus_rm_device(dev_handle_);
@@ -113,6 +128,19 @@ void I2CCommandBridge::Deinit() {
   bus_handle_ = nullptr;
   owns_bus_handle_ = false;
 
+  if (data_ready_sem_) {
+    gpio_isr_handler_remove(static_cast<gpio_num_t>(ACTUATOR_DATA_READY_GPIO));
+    vSemaphoreDelete(data_ready_sem_);
+    data_ready_sem_ = nullptr;
+  }
+  if (status_changed_sem_) {
+    gpio_isr_handler_remove(
+        static_cast<gpio_num_t>(ACTUATOR_STATUS_CHANGED_GPIO));
+    vSemaphoreDelete(status_changed_sem_);
+    status_changed_sem_ = nullptr;
+  }
+
+  liveness_.Reset();
   initialized_ = false;
   ESP_LOGI(TAG, "I2C Command Bridge deinitialized");
 }
@@ -121,21 +149,17 @@ void I2CCommandBridge::Deinit() {
 
 std::string I2CCommandBridge::VehicleMoveTime(int direction, int speed_percent,
                                               int duration_ms) {
-  if (!IsSlaveOnline()) {
+  bool stop = direction == DIR_STOP || duration_ms <= 0;
+  if (!IsSlaveOnline(stop ? kI2cBusStop : kI2cBusMotion)) {
     ESP_LOGW(TAG, "⚠️ Slave offline, skipping vehicle command");
     return "{\"error\":\"slave_offline\"}";
   }
 
-  cJSON *root = cJSON_CreateObject();
-  cJSON_AddStringToObject(root, KEY_TYPE, TYPE_VEHICLE);
-  cJSON_AddNumberToObject(root, KEY_DIR, direction);
-  cJSON_AddNumberToObject(root, KEY_SPEED, speed_percent);
-  if (duration_ms > 0) {
-    cJSON_AddNumberToObject(root, KEY_DURATION, duration_ms);
-  }
+  I2cFrame request(kI2cFrameVehicleTime, 0);
+  request.U8(direction).U8(speed_percent).U32(duration_ms > 0 ? duration_ms : 0);
 
-  std::string response = SendI2CCommand(root);
-  cJSON_Delete(root);
+  std::string response =
+      SendCommand(request, stop ? kI2cBusStop : kI2cBusMotion);
 
   ESP_LOGI(TAG, "🚗 Vehicle: dir=%d speed=%d%% time=%dms → %s", direction,
            speed_percent, duration_ms, response.c_str());
@@ -146,19 +170,17 @@ std::string I2CCommandBridge::VehicleMoveTime(int direction, int speed_percent,
 std::string I2CCommandBridge::VehicleMoveDistance(int direction,
                                                   int speed_percent,
                                                   int distance_mm) {
-  if (!IsSlaveOnline()) {
+  bool stop = direction == DIR_STOP || distance_mm <= 0;
+  if (!IsSlaveOnline(stop ? kI2cBusStop : kI2cBusMotion)) {
     ESP_LOGW(TAG, "⚠️ Slave offline, skipping vehicle command");
     return "{\"error\":\"slave_offline\"}";
   }
 
-  cJSON *root = cJSON_CreateObject();
-  cJSON_AddStringToObject(root, KEY_TYPE, TYPE_VEHICLE);
-  cJSON_AddNumberToObject(root, KEY_DIR, direction);
-  cJSON_AddNumberToObject(root, KEY_SPEED, speed_percent);
-  cJSON_AddNumberToObject(root, KEY_DISTANCE, distance_mm);
+  I2cFrame request(kI2cFrameVehicleDistance, 0);
+  request.U8(direction).U8(speed_percent).U32(distance_mm > 0 ? distance_mm : 0);
 
-  std::string response = SendI2CCommand(root);
-  cJSON_Delete(root);
+  std::string response =
+      SendCommand(request, stop ? kI2cBusStop : kI2cBusMotion);
 
   ESP_LOGI(TAG, "� Vehicle: dir=%d speed=%d%% dist=%dmm → %s", direction,
            speed_percent, distance_mm, response.c_str());
@@ -167,12 +189,10 @@ std::string I2CCommandBridge::VehicleMoveDistance(int direction,
 }
 
 std::string I2CCommandBridge::VehicleStop() {
-  cJSON *root = cJSON_CreateObject();
-  cJSON_AddStringToObject(root, KEY_TYPE, TYPE_VEHICLE);
-  cJSON_AddNumberToObject(root, KEY_DIR, DIR_STOP);
+  I2cFrame request(kI2cFrameVehicleTime, 0);
+  request.U8(DIR_STOP).U8(0).U32(0);
 
-  std::string response = SendI2CCommand(root);
-  cJSON_Delete(root);
+  std::string response = SendCommand(request, kI2cBusStop);
 
   ESP_LOGI(TAG, "🛑 Vehicle: STOP → %s", response.c_str());
 
@@ -182,18 +202,15 @@ std::string I2CCommandBridge::VehicleStop() {
 // ==================== STORAGE CONTROL ====================
 
 std::string I2CCommandBridge::StorageControl(int slot, int action) {
-  if (!IsSlaveOnline()) {
+  if (!IsSlaveOnline(kI2cBusStorage)) {
     ESP_LOGW(TAG, "⚠️ Slave offline, skipping storage command");
     return "{\"error\":\"slave_offline\"}";
   }
 
-  cJSON *root = cJSON_CreateObject();
-  cJSON_AddStringToObject(root, KEY_TYPE, TYPE_STORAGE);
-  cJSON_AddNumberToObject(root, KEY_SLOT, slot);
-  cJSON_AddNumberToObject(root, KEY_ACTION, action);
+  I2cFrame request(kI2cFrameStorage, 0);
+  request.U8(slot).U8(action);
 
-  std::string response = SendI2CCommand(root);
-  cJSON_Delete(root);
+  std::string response = SendCommand(request, kI2cBusStorage);
 
   ESP_LOGI(TAG, "� Storage: slot=%d action=%s → %s", slot,
            (action == ACT_OPEN ? "OPEN" : "CLOSE"), response.c_str());
@@ -209,6 +226,46 @@ std::string I2CCommandBridge::StorageClose(int slot) {
   return StorageControl(slot, ACT_CLOSE);
 }
 
+// ==================== STEP LISTS ====================
+
+std::string I2CCommandBridge::RunBatch(I2cBatch &batch) {
+#ifdef CONFIG_ACTUATOR_I2C_JSON
+  // The debug protocol has no step lists, callers send the steps one by one
+  return "{\"error\":\"not_supported\"}";
+#else
+  if (batch.count == 0 || batch.overflow) {
+    return "{\"error\":\"invalid_batch\"}";
+  }
+  if (!IsSlaveOnline(kI2cBusMotion)) {
+    ESP_LOGW(TAG, "⚠️ Slave offline, skipping step list");
+    return "{\"error\":\"slave_offline\"}";
+  }
+
+  // Tells this list's progress apart from the previous one's
+  if (++batch_id_ == 0)
+    batch_id_ = 1;
+  batch.id = batch_id_;
+  I2cFrame request(kI2cFrameBatch, 0);
+  batch.Encode(request);
+
+  std::string response = SendCommand(request, kI2cBusMotion);
+
+  ESP_LOGI(TAG, "📋 Step list %d: %d steps (%d bytes) → %s", batch.id,
+           batch.count, (int)request.size(), response.c_str());
+
+  return response;
+#endif
+}
+
+bool I2CCommandBridge::GetBatchProgress(I2cStatusView &view) {
+#ifdef CONFIG_ACTUATOR_I2C_JSON
+  return false;
+#else
+  uint8_t changed = 0;
+  return RequestStatusDelta(view, changed, 0);
+#endif
+}
+
 // ==================== STATUS ====================
 
 std::string I2CCommandBridge::GetStatus() {
@@ -217,11 +274,9 @@ std::string I2CCommandBridge::GetStatus() {
     return "{\"error\":\"slave_offline\"}";
   }
 
-  cJSON *root = cJSON_CreateObject();
-  cJSON_AddStringToObject(root, KEY_TYPE, TYPE_STATUS);
-
-  std::string response = SendI2CCommand(root);
-  cJSON_Delete(root);
+  ActuatorStatus status = {};
+  std::string response;
+  RequestStatus(status, response);
 
   ESP_LOGI(TAG, "� Status: %s", response.c_str());
 
@@ -376,6 +431,7 @@ std::string I2CCommandBridge::SendI2CCommand(cJSON *jsonCmd) {
   esp_err_t err = i2c_master_transmit(dev_handle_, (uint8_t *)jsonString,
                                       jsonLen, TX_TIMEOUT_MS);
   free(jsonString);
+  RecordLiveness(err == ESP_OK);
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "⚠️ I2C transmit failed: %s", esp_err_to_name(err));
     return "{\"error\":\"i2c_send_failed\"}";
@@ -436,22 +492,506 @@ std::string I2CCommandBridge::SendI2CCommand(cJSON *jsonCmd) {
   return response;
 }
 
-bool I2CCommandBridge::IsSlaveOnline() {
-  if (!initialized_) {
+#ifdef CONFIG_ACTUATOR_I2C_JSON
+// JSON debug protocol: the same request as {"t":"v","d":1,"p":50,"ms":2000}
+static cJSON *FrameToJson(const I2cFrame &frame) {
+  cJSON *root = cJSON_CreateObject();
+  switch (frame.type) {
+  case kI2cFrameVehicleTime:
+  case kI2cFrameVehicleDistance:
+    cJSON_AddStringToObject(root, KEY_TYPE, TYPE_VEHICLE);
+    cJSON_AddNumberToObject(root, KEY_DIR, frame.u8(0));
+    if (frame.u8(0) == DIR_STOP) {
+      break;
+    }
+    cJSON_AddNumberToObject(root, KEY_SPEED, frame.u8(1));
+    if (frame.u32(2) > 0) {
+      cJSON_AddNumberToObject(root,
+                              frame.type == kI2cFrameVehicleTime ? KEY_DURATION
+                                                                 : KEY_DISTANCE,
+                              frame.u32(2));
+    }
+    break;
+  case kI2cFrameStorage:
+    cJSON_AddStringToObject(root, KEY_TYPE, TYPE_STORAGE);
+    cJSON_AddNumberToObject(root, KEY_SLOT, frame.u8(0));
+    cJSON_AddNumberToObject(root, KEY_ACTION, frame.u8(1));
+    break;
+  default:
+    cJSON_AddStringToObject(root, KEY_TYPE, TYPE_STATUS);
+    break;
+  }
+  return root;
+}
+#else
+// flags u8, heart_rate i16, storage u8, gamepad u8
+static void StatusFromFields(const I2cStatusFields &fields,
+                             ActuatorStatus &status) {
+  status.status = STATUS_OK;
+  status.ble_connected = fields.flags & I2C_STATUS_BLE_CONNECTED;
+  status.is_moving = fields.flags & I2C_STATUS_MOVING;
+  status.motor_enabled = fields.flags & I2C_STATUS_MOTOR_ENABLED;
+  status.heart_rate = fields.heart_rate;
+  for (int i = 0; i < 4; i++) {
+    status.storage[i].slot = i;
+    status.storage[i].is_open = fields.storage & (1 << i);
+  }
+  status.batch.id = fields.batch_id;
+  status.batch.steps_done = fields.batch_done;
+  status.batch.state = fields.batch_state;
+}
+
+static void DecodeStatus(const I2cFrame &reply, ActuatorStatus &status) {
+  I2cStatusFields fields;
+  fields.flags = reply.u8(0);
+  fields.heart_rate = (int16_t)reply.u16(1);
+  fields.storage = reply.u8(3);
+  fields.gamepad = reply.u8(4);
+  StatusFromFields(fields, status);
+}
+
+// Same JSON the actuator answers in the JSON debug protocol
+static std::string FormatStatus(const ActuatorStatus &status) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "{\"c\":%d,\"h\":%d,\"g\":[%d,%d,%d,%d]}",
+           status.ble_connected ? 1 : 0, status.heart_rate,
+           status.storage[0].is_open ? 1 : 0, status.storage[1].is_open ? 1 : 0,
+           status.storage[2].is_open ? 1 : 0,
+           status.storage[3].is_open ? 1 : 0);
+  return buffer;
+}
+#endif
+
+std::string I2CCommandBridge::SendCommand(const I2cFrame &request,
+                                          I2cBusPriority priority,
+                                          uint32_t deadline_ms) {
+#ifdef CONFIG_ACTUATOR_I2C_JSON
+  // Debug protocol, sent from the calling task as before
+  cJSON *root = FrameToJson(request);
+  std::string response = SendI2CCommand(root);
+  cJSON_Delete(root);
+  return response;
+#else
+  I2cBusTicket ticket;
+  ticket.request = request;
+  ticket.priority = priority;
+  const char *error = RunOnBus(ticket, deadline_ms);
+  if (error != nullptr) {
+    return std::string("{\"error\":\"") + error + "\"}";
+  }
+  if (ticket.reply.type != kI2cFrameAck) {
+    ESP_LOGW(TAG, "⚠️ Unexpected reply type 0x%02X", ticket.reply.type);
+    return "{\"error\":\"invalid_reply\"}";
+  }
+  return "{\"s\":" + std::to_string((int8_t)ticket.reply.u8(0)) + "}";
+#endif
+}
+
+bool I2CCommandBridge::RequestStatus(ActuatorStatus &status,
+                                     std::string &response,
+                                     uint32_t deadline_ms) {
+  I2cFrame request(kI2cFrameStatus, 0);
+#ifdef CONFIG_ACTUATOR_I2C_JSON
+  cJSON *root = FrameToJson(request);
+  response = SendI2CCommand(root);
+  cJSON_Delete(root);
+  return ParseStatusResponse(response, status);
+#else
+  I2cBusTicket ticket;
+  ticket.request = request;
+  ticket.priority = kI2cBusPoll;
+  const char *error = RunOnBus(ticket, deadline_ms);
+  if (error != nullptr) {
+    response = std::string("{\"error\":\"") + error + "\"}";
+    return false;
+  }
+  if (ticket.reply.type != kI2cFrameStatusReply) {
+    ESP_LOGW(TAG, "⚠️ Unexpected status reply type 0x%02X",
+             ticket.reply.type);
+    response = "{\"error\":\"invalid_reply\"}";
+    return false;
+  }
+  DecodeStatus(ticket.reply, status);
+  response = FormatStatus(status);
+  return true;
+#endif
+}
+
+bool I2CCommandBridge::RequestStatusDelta(uint8_t &changed,
+                                          uint32_t deadline_ms) {
+#ifdef CONFIG_ACTUATOR_I2C_JSON
+  // The debug protocol has no versions: full status, reported as changed
+  std::string response;
+  changed = I2C_STATUS_ALL_FIELDS;
+  return RequestStatus(last_status_, response, deadline_ms);
+#else
+  if (!RequestStatusDelta(status_view_, changed, deadline_ms)) {
+    return false;
+  }
+  if (changed) {
+    StatusFromFields(status_view_.fields, last_status_);
+    ESP_LOGD(TAG, "Status v%d changed 0x%02X", status_view_.version, changed);
+  }
+  return true;
+#endif
+}
+
+bool I2CCommandBridge::RequestStatusDelta(I2cStatusView &view,
+                                          uint8_t &changed,
+                                          uint32_t deadline_ms) {
+  I2cBusTicket ticket;
+  ticket.request = I2cFrame(kI2cFrameStatusDelta, 0);
+  view.BuildRequest(ticket.request);
+  ticket.priority = kI2cBusPoll;
+  const char *error = RunOnBus(ticket, deadline_ms);
+  if (error != nullptr) {
+    ESP_LOGD(TAG, "Status delta failed: %s", error);
+    return false;
+  }
+  if (ticket.reply.type != kI2cFrameStatusDeltaReply) {
+    ESP_LOGW(TAG, "⚠️ Unexpected status delta reply type 0x%02X",
+             ticket.reply.type);
     return false;
   }
+  changed = view.Apply(ticket.reply);
+  return true;
+}
+
+// ==================== BUS TASK ====================
+
+const char *I2CCommandBridge::RunOnBus(I2cBusTicket &ticket,
+                                       uint32_t deadline_ms) {
+  // The bus task would wait for itself
+  if (xTaskGetCurrentTaskHandle() == bus_task_handle_) {
+    ESP_LOGE(TAG, "Bridge called from its own bus task");
+    return "bus_reentry";
+  }
+
+  StaticSemaphore_t done_buffer;
+  SemaphoreHandle_t done = xSemaphoreCreateBinaryStatic(&done_buffer);
+  int64_t now_us = esp_timer_get_time();
+  ticket.deadline_us =
+      deadline_ms > 0 ? now_us + (int64_t)deadline_ms * 1000 : 0;
+  ticket.user_data = done;
+  ticket.done = [](I2cBusTicket *t) {
+    xSemaphoreGive(static_cast<SemaphoreHandle_t>(t->user_data));
+  };
+
+  if (!bus_.Submit(&ticket, now_us)) {
+    vSemaphoreDelete(done);
+    return "not_initialized";
+  }
+  TaskHandle_t bus_task = bus_task_handle_;
+  if (bus_task) {
+    xTaskNotifyGive(bus_task);
+  }
+
+  // Every ticket is completed: run, expired, or failed by StopBusTask()
+  xSemaphoreTake(done, portMAX_DELAY);
+  vSemaphoreDelete(done);
+  return ticket.error;
+}
+
+void I2CCommandBridge::StartBusTask() {
+  bus_.Open();
+
+  // Above the polling task so a stop is not held up behind it
+  BaseType_t result =
+      xTaskCreate(BusTask, "I2CBus", 4096, this, 6, &bus_task_handle_);
+  if (result != pdPASS) {
+    ESP_LOGE(TAG, "Failed to create bus task");
+    bus_task_handle_ = nullptr;
+    bus_.Close("bus_task_failed");
+  }
+}
+
+void I2CCommandBridge::StopBusTask() {
+  bus_.Close("not_initialized");
+  if (!bus_task_handle_) {
+    return;
+  }
+  xTaskNotifyGive(bus_task_handle_);
+
+  // The task clears the handle on exit, after its last transaction
+  while (bus_task_handle_) {
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+  ESP_LOGI(TAG, "Bus task stopped");
+}
+
+void I2CCommandBridge::BusTask(void *param) {
+  I2CCommandBridge *bridge = static_cast<I2CCommandBridge *>(param);
+
+  ESP_LOGI(TAG, "🚌 Bus task started");
+
+  while (!bridge->bus_.closed()) {
+    I2cBusTicket *ticket = bridge->bus_.Next(esp_timer_get_time());
+    if (!ticket) {
+      // Submit() notifies, a notification given meanwhile is not lost
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      continue;
+    }
+    bridge->RunTicket(*ticket);
+    bridge->bus_.Complete(ticket);
+  }
+
+  bridge->bus_task_handle_ = nullptr;
+  vTaskDelete(NULL);
+}
+
+void I2CCommandBridge::RunTicket(I2cBusTicket &ticket) {
+  if (ticket.probe) {
+    // A transaction just ahead may have settled it already
+    if (liveness_.NeedsProbe(esp_timer_get_time())) {
+      ticket.error = Probe();
+    } else {
+      ticket.error = liveness_.online() ? nullptr : "slave_offline";
+    }
+    return;
+  }
+  ticket.error = Transact(ticket.request, ticket.reply,
+                          ticket.priority != kI2cBusStop);
+}
 
-  // Probe slave with minimal data
+void I2CCommandBridge::RunUrgent() {
+  I2cBusTicket *ticket;
+  while ((ticket = bus_.Next(esp_timer_get_time(), kI2cBusStop)) != nullptr) {
+    if (ticket->probe) {
+      RunTicket(*ticket);
+    } else {
+      // The actuator stops as soon as the frame arrives and keeps the reply
+      // the interrupted transaction waits for, so the address ack is the
+      // answer
+      ticket->error = Transmit(ticket->request);
+      if (ticket->error == nullptr) {
+        ticket->reply = I2cFrame(kI2cFrameAck, ticket->request.seq);
+        ticket->reply.U8((uint8_t)STATUS_OK);
+      }
+      ESP_LOGI(TAG, "🛑 Stop sent while waiting for a reply");
+    }
+    bus_.Complete(ticket);
+  }
+}
+
+// ==================== TRANSACTIONS ====================
+
+const char *I2CCommandBridge::Transmit(I2cFrame &request) {
+  // 0 is left for replies nobody asked for
+  if (++seq_ == 0)
+    seq_ = 1;
+  request.seq = seq_;
+
+  uint8_t buffer[I2C_FRAME_MAX_SIZE];
+  size_t size = request.Encode(buffer, sizeof(buffer));
+  if (size == 0)
+    return "frame_encode_failed";
+
+  const int TX_TIMEOUT_MS = 100;
+  esp_err_t err =
+      i2c_master_transmit(dev_handle_, buffer, size, TX_TIMEOUT_MS);
+  RecordLiveness(err == ESP_OK);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "⚠️ I2C transmit failed: %s", esp_err_to_name(err));
+    return "i2c_send_failed";
+  }
+  ESP_LOGD(TAG, "📤 Frame type=0x%02X seq=%d (%d bytes)", request.type,
+           request.seq, (int)size);
+  return nullptr;
+}
+
+const char *I2CCommandBridge::Probe() {
   uint8_t dummy = 0;
   esp_err_t err = i2c_master_transmit(dev_handle_, &dummy, 1, 50);
+  RecordLiveness(err == ESP_OK);
+  if (err != ESP_OK) {
+    ESP_LOGD(TAG, "Slave probe: %s (offline)", esp_err_to_name(err));
+    return "i2c_send_failed";
+  }
+  return nullptr;
+}
 
-  bool online = (err == ESP_OK);
+bool I2CCommandBridge::WaitDataReady(int64_t start_us, uint32_t budget_us,
+                                     bool preemptible) {
+  for (;;) {
+    int64_t left_us = start_us + budget_us - esp_timer_get_time();
+    TickType_t ticks = left_us > 0 ? pdMS_TO_TICKS(left_us / 1000) + 1 : 0;
+    // A tick at a time, so a stop waits at most one tick
+    if (preemptible && ticks > 1)
+      ticks = 1;
+    if (xSemaphoreTake(data_ready_sem_, ticks) == pdTRUE)
+      return true;
+    if (!preemptible || left_us <= 0)
+      return false;
+    RunUrgent();
+  }
+}
 
-  if (!online) {
-    ESP_LOGD(TAG, "Slave probe: %s (offline)", esp_err_to_name(err));
+const char *I2CCommandBridge::Transact(I2cFrame &request, I2cFrame &reply,
+                                       bool preemptible) {
+  if (!initialized_)
+    return "not_initialized";
+
+  // An edge from the previous reply must not count for this one
+  if (data_ready_sem_)
+    xSemaphoreTake(data_ready_sem_, 0);
+
+  const char *error = Transmit(request);
+  if (error != nullptr)
+    return error;
+
+  // ==== Poll until the reply carrying our seq is written ====
+  int64_t start_us = esp_timer_get_time();
+  uint32_t budget_us = I2cReplyBudgetUs(request.type);
+  uint32_t first_poll_us = I2C_REPLY_FIRST_POLL_US;
+  if (data_ready_sem_ && WaitDataReady(start_us, budget_us, preemptible)) {
+    first_poll_us = 0;
   }
 
-  return online;
+  // Exactly the reply size: the slave answers every read with its current
+  // reply (busy until written), so polling again is safe
+  const int RX_TIMEOUT_MS = 100;
+  uint8_t buffer[I2C_FRAME_MAX_SIZE];
+  size_t reply_size = I2cFrameReplySize(request.type);
+  error = "reply_timeout";
+  I2cReplyWait wait(start_us, budget_us, first_poll_us);
+  for (int64_t delay_us; (delay_us = wait.NextDelayUs(esp_timer_get_time())) >= 0;) {
+    if (delay_us < I2C_REPLY_SPIN_US) {
+      esp_rom_delay_us(delay_us);
+    } else {
+      TickType_t ticks = pdMS_TO_TICKS(delay_us / 1000);
+      if (ticks == 0)
+        ticks = 1;
+      if (preemptible) {
+        // Submit() cuts the sleep short, a stop goes out before the next poll
+        ulTaskNotifyTake(pdTRUE, ticks);
+        RunUrgent();
+      } else {
+        vTaskDelay(ticks);
+      }
+    }
+
+    esp_err_t err =
+        i2c_master_receive(dev_handle_, buffer, reply_size, RX_TIMEOUT_MS);
+    if (err != ESP_OK) {
+      ESP_LOGD(TAG, "Receive error: %s", esp_err_to_name(err));
+      error = "i2c_receive_failed";
+      continue;
+    }
+
+    I2cFrameError frame_error = reply.Decode(buffer, reply_size);
+    if (frame_error != kI2cFrameOk) {
+      // Corrupted on the wire or nothing written yet (0xFF)
+      ESP_LOGD(TAG, "Invalid reply frame: %s", I2cFrameErrorName(frame_error));
+      error = "invalid_reply";
+      continue;
+    }
+    if (reply.seq != request.seq) {
+      error = "stale_reply";
+      continue;
+    }
+    if (reply.type == kI2cFrameBusy) {
+      error = "reply_timeout";
+      continue;
+    }
+
+    ESP_LOGD(TAG, "📥 Reply type=0x%02X after %d us (%d polls)", reply.type,
+             (int)(esp_timer_get_time() - start_us), wait.polls());
+    return nullptr;
+  }
+
+  ESP_LOGW(TAG, "⚠️ No reply to type=0x%02X seq=%d within %d ms (%d polls): %s",
+           request.type, request.seq, (int)(budget_us / 1000), wait.polls(),
+           error);
+  return error;
+}
+
+void I2CCommandBridge::SetupEdgeInputs() {
+  if (!data_ready_sem_) {
+    data_ready_sem_ = SetupEdgeInput(ACTUATOR_DATA_READY_GPIO, "Data-ready");
+  }
+  if (!status_changed_sem_) {
+    status_changed_sem_ =
+        SetupEdgeInput(ACTUATOR_STATUS_CHANGED_GPIO, "Status-changed");
+  }
+}
+
+SemaphoreHandle_t I2CCommandBridge::SetupEdgeInput(int gpio,
+                                                   const char *name) {
+  if (gpio < 0) {
+    return nullptr;
+  }
+
+  gpio_num_t pin = static_cast<gpio_num_t>(gpio);
+  gpio_config_t io_conf = {};
+  io_conf.pin_bit_mask = 1ULL << pin;
+  io_conf.mode = GPIO_MODE_INPUT;
+  io_conf.pull_down_en = GPIO_PULLDOWN_ENABLE;
+  io_conf.intr_type = GPIO_INTR_POSEDGE;
+  esp_err_t err = gpio_config(&io_conf);
+
+  // Another driver may have installed the service already
+  if (err == ESP_OK) {
+    err = gpio_install_isr_service(0);
+    if (err == ESP_ERR_INVALID_STATE) {
+      err = ESP_OK;
+    }
+  }
+  SemaphoreHandle_t sem = nullptr;
+  if (err == ESP_OK) {
+    sem = xSemaphoreCreateBinary();
+    err = gpio_isr_handler_add(pin, EdgeIsr, sem);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "⚠️ %s GPIO %d unavailable (%s), polling only", name, gpio,
+             esp_err_to_name(err));
+    if (sem) {
+      vSemaphoreDelete(sem);
+    }
+    return nullptr;
+  }
+  ESP_LOGI(TAG, "%s line on GPIO %d", name, gpio);
+  return sem;
+}
+
+void IRAM_ATTR I2CCommandBridge::EdgeIsr(void *param) {
+  BaseType_t woken = pdFALSE;
+  xSemaphoreGiveFromISR(static_cast<SemaphoreHandle_t>(param), &woken);
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+bool I2CCommandBridge::IsSlaveOnline(I2cBusPriority priority) {
+  if (!initialized_) {
+    return false;
+  }
+
+  // An address ack on a recent command counts, no need to probe again
+  if (!liveness_.NeedsProbe(esp_timer_get_time())) {
+    return liveness_.online();
+  }
+
+  // Probe slave with minimal data, on the bus task like any transaction
+  I2cBusTicket probe;
+  probe.probe = true;
+  probe.priority = priority;
+  RunOnBus(probe, 0);
+
+  return liveness_.online();
+}
+
+void I2CCommandBridge::RecordLiveness(bool ok) {
+  if (!liveness_.Record(ok, esp_timer_get_time())) {
+    return;
+  }
+  if (ok) {
+    ESP_LOGI(TAG, "✅ Actuator online");
+  } else {
+    ESP_LOGW(TAG, "⚠️ Actuator offline, probing with backoff");
+  }
+  if (liveness_callback_) {
+    liveness_callback_(ok, liveness_user_data_);
+  }
 }
 
 // ==================== STATUS CALLBACK & POLLING ====================
@@ -463,6 +1003,12 @@ void I2CCommandBridge::SetStatusCallback(ActuatorStatusCallback callback,
   ESP_LOGI(TAG, "Status callback registered");
 }
 
+void I2CCommandBridge::SetLivenessCallback(ActuatorLivenessCallback callback,
+                                           void *user_data) {
+  liveness_callback_ = callback;
+  liveness_user_data_ = user_data;
+}
+
 bool I2CCommandBridge::StartStatusPolling(uint32_t interval_ms) {
   if (!initialized_) {
     ESP_LOGE(TAG, "Cannot start polling - not initialized");
@@ -505,11 +1051,18 @@ void I2CCommandBridge::StopStatusPolling() {
 
   polling_active_ = false;
 
-  // Wait for task to finish
-  if (polling_task_handle_) {
-    vTaskDelay(pdMS_TO_TICKS(100)); // Give task time to exit
-    vTaskDelete(polling_task_handle_);
-    polling_task_handle_ = nullptr;
+  // Không xóa task từ bên ngoài: ticket và semaphore của RunOnBus nằm trên
+  // stack của nó. Đánh thức task, chờ nó xong transaction đang chạy và tự
+  // xóa handle khi thoát (giống BusTask), bus vẫn mở trong lúc chờ
+  TaskHandle_t polling_task = polling_task_handle_;
+  if (polling_task) {
+    if (status_changed_sem_) {
+      xSemaphoreGive(status_changed_sem_);
+    }
+    xTaskNotifyGive(polling_task);
+    while (polling_task_handle_) {
+      vTaskDelay(pdMS_TO_TICKS(10));
+    }
   }
 
   ESP_LOGI(TAG, "Status polling stopped");
@@ -520,30 +1073,52 @@ void I2CCommandBridge::StatusPollingTask(void *param) {
 
   ESP_LOGI(TAG, "📊 Status polling task started");
 
+  uint32_t max_ms = bridge->polling_interval_ms_;
+  I2cStatusPollInterval interval(ACTUATOR_STATUS_MIN_POLL_MS, max_ms);
+  uint32_t wait_ms = 0; // first read right away, every field
+  bridge->status_view_.Reset();
+
   while (bridge->polling_active_) {
+    // With the status-changed line, read as soon as the actuator says so
+    if (bridge->status_changed_sem_) {
+      xSemaphoreTake(bridge->status_changed_sem_, pdMS_TO_TICKS(wait_ms));
+    } else {
+      // StopStatusPolling() notifies to cut the wait short
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms));
+    }
+    if (!bridge->polling_active_) {
+      break;
+    }
+
     // Check if slave is online first
     if (!bridge->IsSlaveOnline()) {
       ESP_LOGD(TAG, "Slave offline, skipping poll");
-      vTaskDelay(pdMS_TO_TICKS(bridge->polling_interval_ms_));
+      Telemetry::GetInstance().Record(kTelemetryI2cErrors, 1);
+      // It may come back rebooted, read every field then
+      bridge->status_view_.Reset();
+      wait_ms = max_ms;
       continue;
     }
 
-    // Request status
-    std::string response = bridge->GetStatus();
-
-    ActuatorStatus status;
-    if (bridge->ParseStatusResponse(response, status)) {
-      // Parse and callback if successful
-      if (bridge->status_callback_) {
-        bridge->status_callback_(status, bridge->callback_user_data_);
+    // A poll not started before the longest interval is dropped
+    uint8_t changed = 0;
+    if (bridge->RequestStatusDelta(changed, max_ms)) {
+      Telemetry::GetInstance().Record(kTelemetryI2cErrors, 0);
+      Telemetry::GetInstance().Record(kTelemetryActuatorBattery,
+                                      bridge->last_status_.battery * 1000);
+      if (changed && bridge->status_callback_) {
+        bridge->status_callback_(bridge->last_status_,
+                                 bridge->callback_user_data_);
       }
+    } else {
+      Telemetry::GetInstance().Record(kTelemetryI2cErrors, 1);
     }
 
-    // Wait for next poll
-    vTaskDelay(pdMS_TO_TICKS(bridge->polling_interval_ms_));
+    wait_ms = bridge->status_changed_sem_ ? max_ms : interval.Next(changed);
   }
 
   ESP_LOGI(TAG, "📊 Status polling task exiting");
+  bridge->polling_task_handle_ = nullptr;
   vTaskDelete(NULL);
 }
 
@@ -2,8 +2,14 @@
 
 #include "cJSON.h"
 #include "driver/i2c_master.h"
+#include "actuator_liveness.h"
+#include "i2c_batch.h"
+#include "i2c_bus_scheduler.h"
+#include "i2c_frame.h"
+#include "i2c_status_delta.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 #include <string>
 #include <vector>
@@ -33,18 +39,25 @@
 #define TYPE_STORAGE "s"
 #define TYPE_STATUS "t"
 
-// Direction values
-#define DIR_STOP 0
-#define DIR_FORWARD 1
-#define DIR_BACKWARD 2
-#define DIR_LEFT 3
-#define DIR_RIGHT 4
-#define DIR_ROTATE_LEFT 5
-#define DIR_ROTATE_RIGHT 6
+// Direction (DIR_*), action (ACT_*) and ack (STATUS_*) values are shared with
+// the actuator through i2c_frame.h
 
-// Action values
-#define ACT_CLOSE 0
-#define ACT_OPEN 1
+// Optional data-ready line from the actuator (-1 = poll only)
+#ifdef CONFIG_ACTUATOR_DATA_READY_GPIO
+#define ACTUATOR_DATA_READY_GPIO CONFIG_ACTUATOR_DATA_READY_GPIO
+#else
+#define ACTUATOR_DATA_READY_GPIO -1
+#endif
+
+// Optional status-changed line from the actuator (-1 = adaptive polling only)
+#ifdef CONFIG_ACTUATOR_STATUS_CHANGED_GPIO
+#define ACTUATOR_STATUS_CHANGED_GPIO CONFIG_ACTUATOR_STATUS_CHANGED_GPIO
+#else
+#define ACTUATOR_STATUS_CHANGED_GPIO -1
+#endif
+
+// Shortest status poll interval, right after a poll that found a change
+#define ACTUATOR_STATUS_MIN_POLL_MS 250
 
 /**
  * @brief Status data structure từ actuator
@@ -62,6 +75,13 @@ struct ActuatorStatus {
     int slot;     // Số ô (0-3)
     bool is_open; // true = mở, false = đóng
   } storage[4];
+
+  // Chuỗi bước gần nhất (RunBatch)
+  struct {
+    int id;         // I2cBatch::id
+    int steps_done; // Số bước đã xong
+    int state;      // I2cBatchState
+  } batch;
 };
 
 /**
@@ -72,12 +92,24 @@ struct ActuatorStatus {
 typedef void (*ActuatorStatusCallback)(const ActuatorStatus &status,
                                        void *user_data);
 
+/**
+ * @brief Callback khi actuator chuyển online <-> offline
+ * @param online true nếu actuator vừa phản hồi lại
+ * @param user_data Con trỏ dữ liệu user (optional)
+ */
+typedef void (*ActuatorLivenessCallback)(bool online, void *user_data);
+
 /**
  * @brief I2C Command Bridge
  *
- * Gửi lệnh JSON qua I2C từ ESP32 chính (Xiaozhi) sang ESP32 phụ (actuator)
+ * Gửi lệnh qua I2C từ ESP32 chính (Xiaozhi) sang ESP32 phụ (actuator)
  *
- * Protocol (compact JSON):
+ * Protocol: binary CRC-16 frames (i2c_frame.h), e.g. 12 bytes for a timed
+ * move instead of 33 bytes of JSON plus a 32-byte chunked read. Replies are
+ * still returned to callers as the JSON below.
+ *
+ * With CONFIG_ACTUATOR_I2C_JSON the bridge sends the JSON debug protocol
+ * instead (compact JSON):
  * Vehicle (time-based):
  *   {"t":"v","d":1,"p":50,"ms":2000}  - Forward 50% speed for 2s
  *   {"t":"v","d":2,"p":60,"ms":1000}  - Backward 60% speed for 1s
@@ -102,6 +134,7 @@ typedef void (*ActuatorStatusCallback)(const ActuatorStatus &status,
  * Response format:
  *   {"s":1}                           - Status OK
  *   {"s":-1}                          - Status Error
+ *   {"c":1,"h":72,"g":[0,0,1,1]}      - Status (BLE, heart rate, slots)
  */
 class I2CCommandBridge {
 public:
@@ -192,6 +225,23 @@ public:
    */
   std::string StorageControl(int slot, int action);
 
+  // ==================== STEP LISTS ====================
+
+  /**
+   * @brief Gửi cả chuỗi bước trong một frame, actuator tự chạy lần lượt
+   * (i2c_batch.h); lệnh stop hoặc chuỗi tiếp theo sẽ huỷ chuỗi đang chạy
+   * @param batch Tối đa I2C_BATCH_MAX_STEPS bước, id được gán khi gửi
+   * @return JSON response, {"s":1} khi actuator đã nhận chuỗi (chưa chạy xong)
+   */
+  std::string RunBatch(I2cBatch &batch);
+
+  /**
+   * @brief Đọc tiến độ chuỗi bước từ status (view.fields.batch_*)
+   * @param view Status caller giữ giữa các lần gọi, chỉ đọc field đã đổi
+   * @return true nếu đọc được status
+   */
+  bool GetBatchProgress(I2cStatusView &view);
+
   // ==================== STATUS ====================
 
   /**
@@ -201,10 +251,15 @@ public:
   std::string GetStatus();
 
   /**
-   * @brief Kiểm tra slave có online không (ping test)
+   * @brief Kiểm tra slave có online không
+   *
+   * Dựa vào kết quả các transaction gần nhất (actuator_liveness.h), chỉ gửi
+   * probe 1 byte trước lệnh đầu tiên, sau lỗi, sau ACTUATOR_IDLE_PROBE_MS không
+   * có traffic, hoặc theo backoff khi đang offline.
+   * @param priority Lane của probe trên bus task (lane của lệnh theo sau)
    * @return true nếu slave phản hồi
    */
-  bool IsSlaveOnline();
+  bool IsSlaveOnline(I2cBusPriority priority = kI2cBusPoll);
 
   // ==================== STATUS CALLBACK ====================
 
@@ -217,8 +272,22 @@ public:
                          void *user_data = nullptr);
 
   /**
-   * @brief Bắt đầu polling status từ actuator với interval
-   * @param interval_ms Khoảng thời gian giữa các lần lấy status (ms)
+   * @brief Đăng ký callback khi actuator chuyển online <-> offline
+   * @param callback Gọi từ bus task, không được gọi lại bridge trong callback
+   * @param user_data Con trỏ dữ liệu user (optional)
+   */
+  void SetLivenessCallback(ActuatorLivenessCallback callback,
+                           void *user_data = nullptr);
+
+  /**
+   * @brief Bắt đầu polling status từ actuator
+   *
+   * Chỉ đọc các field đã đổi từ version trước (i2c_status_delta.h) và chỉ gọi
+   * callback khi có thay đổi. Không có status-changed GPIO: interval
+   * ACTUATOR_STATUS_MIN_POLL_MS sau một thay đổi, gấp đôi mỗi lần không có gì
+   * mới, tối đa interval_ms. Có GPIO: đọc ngay khi actuator báo, và ít nhất
+   * mỗi interval_ms.
+   * @param interval_ms Khoảng cách tối đa giữa hai lần lấy status (ms)
    * @return true nếu khởi động thành công
    */
   bool StartStatusPolling(uint32_t interval_ms = 1000);
@@ -243,7 +312,102 @@ public:
 
 private:
   /**
-   * @brief Gửi JSON command qua I2C
+   * @brief Gửi command (binary frame qua bus task hoặc JSON debug) và đợi
+   * phản hồi
+   * @param request Frame command, seq được gán khi gửi
+   * @param priority Lane trên bus task
+   * @param deadline_ms Bỏ lệnh ("deadline_expired") nếu chưa được gửi sau
+   * khoảng này, 0 = không giới hạn
+   * @return JSON response string
+   */
+  std::string SendCommand(const I2cFrame &request, I2cBusPriority priority,
+                          uint32_t deadline_ms = 0);
+
+  /**
+   * @brief Lấy status từ actuator
+   * @param status Output struct
+   * @param response JSON status string
+   * @param deadline_ms Như SendCommand, poll trùng nhau được gộp làm một
+   * @return true nếu nhận được status hợp lệ
+   */
+  bool RequestStatus(ActuatorStatus &status, std::string &response,
+                     uint32_t deadline_ms = 0);
+
+  /**
+   * @brief Lấy các field đã đổi từ version trước vào last_status_
+   * @param changed Mask các field đã đổi (I2cStatusField)
+   * @return true nếu nhận được phản hồi hợp lệ
+   */
+  bool RequestStatusDelta(uint8_t &changed, uint32_t deadline_ms);
+
+  /**
+   * @brief Như trên, vào view của caller
+   */
+  bool RequestStatusDelta(I2cStatusView &view, uint8_t &changed,
+                          uint32_t deadline_ms);
+
+  /**
+   * @brief Đưa ticket cho bus task và đợi đến khi xong
+   * @return ticket.error
+   */
+  const char *RunOnBus(I2cBusTicket &ticket, uint32_t deadline_ms);
+
+  /**
+   * @brief Bus task: chủ duy nhất của các transaction với actuator, chạy
+   * ticket theo lane (i2c_bus_scheduler.h)
+   */
+  void StartBusTask();
+  void StopBusTask();
+  static void BusTask(void *param);
+  void RunTicket(I2cBusTicket &ticket);
+
+  /**
+   * @brief Gửi ngay các lệnh stop đang chờ, gọi giữa các lần poll của một
+   * transaction chậm (cửa kho ~0.6 s)
+   */
+  void RunUrgent();
+
+  /**
+   * @brief Gửi binary frame và poll (backoff, i2c_reply_wait.h) đến khi có
+   * frame phản hồi cùng seq, trong budget của loại lệnh
+   * @param preemptible Cho phép RunUrgent() chen vào lúc đợi phản hồi
+   * @return nullptr nếu thành công, ngược lại mã lỗi ("i2c_send_failed", ...)
+   */
+  const char *Transact(I2cFrame &request, I2cFrame &reply,
+                       bool preemptible = false);
+
+  /**
+   * @brief Gán seq, encode và gửi frame, không đợi phản hồi
+   * @return nullptr nếu thành công, ngược lại mã lỗi
+   */
+  const char *Transmit(I2cFrame &request);
+
+  /**
+   * @brief Gửi probe 1 byte, cập nhật liveness
+   * @return nullptr nếu slave ack
+   */
+  const char *Probe();
+
+  /**
+   * @brief Đợi data-ready trong budget, từng tick một nếu preemptible
+   * @return true nếu actuator báo sẵn sàng
+   */
+  bool WaitDataReady(int64_t start_us, uint32_t budget_us, bool preemptible);
+
+  /**
+   * @brief Cấu hình GPIO data-ready và status-changed (nếu có)
+   */
+  void SetupEdgeInputs();
+  static SemaphoreHandle_t SetupEdgeInput(int gpio, const char *name);
+  static void EdgeIsr(void *param);
+
+  /**
+   * @brief Ghi nhận kết quả transmit vào liveness, gọi callback nếu đổi trạng thái
+   */
+  void RecordLiveness(bool ok);
+
+  /**
+   * @brief Gửi JSON command qua I2C (JSON debug protocol)
    * @param jsonCmd JSON object command
    * @return JSON response string
    */
@@ -267,6 +431,14 @@ private:
   bool owns_bus_handle_;
   i2c_master_bus_handle_t bus_handle_;
   i2c_master_dev_handle_t dev_handle_;
+  uint8_t seq_;
+  uint8_t batch_id_;
+  SemaphoreHandle_t data_ready_sem_;
+  SemaphoreHandle_t status_changed_sem_;
+
+  // Bus task
+  I2cBusScheduler bus_;
+  TaskHandle_t bus_task_handle_;
 
   // Status polling
   bool polling_active_;
@@ -274,4 +446,11 @@ private:
   TaskHandle_t polling_task_handle_;
   ActuatorStatusCallback status_callback_;
   void *callback_user_data_;
+  I2cStatusView status_view_;
+  ActuatorStatus last_status_;
+
+  // Slave liveness
+  ActuatorLiveness liveness_;
+  ActuatorLivenessCallback liveness_callback_;
+  void *liveness_user_data_;
 };
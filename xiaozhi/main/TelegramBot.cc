@@ -4,6 +4,7 @@
 #include <cstring>
 #include <ctime>
 #include "board.h"
+#include "https_client_pool.h"
 
 #include "cJSON.h"
 #include "esp_log.h"
@@ -505,7 +506,9 @@ esp_err_t TelegramBot::makeHttpRequest(const std::string &endpoint,
   config.cert_pem = telegram_certificate_pem_start;
   config.timeout_ms = 30000; // 30 second timeout
 
-  esp_http_client_handle_t client = esp_http_client_init(&config);
+  // Pooled keep-alive client, later requests reuse the connection / TLS session
+  auto &pool = HttpsClientPool::GetInstance();
+  esp_http_client_handle_t client = pool.Acquire(config);
   if (!client) {
     ESP_LOGE(TAG, "Failed to initialize HTTP client");
     return ESP_FAIL;
@@ -525,15 +528,20 @@ esp_err_t TelegramBot::makeHttpRequest(const std::string &endpoint,
     }
   } else {
     err = esp_http_client_set_method(client, HTTP_METHOD_GET);
+    if (err == ESP_OK) {
+      esp_http_client_delete_header(client, "Content-Type");
+      err = esp_http_client_set_post_field(client, nullptr, 0);
+    }
   }
 
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "Failed to configure HTTP client: %s", esp_err_to_name(err));
-    esp_http_client_cleanup(client);
+    pool.Release(client, false);
     return err;
   }
 
   err = esp_http_client_perform(client);
+  bool transport_ok = err == ESP_OK;
 
   if (err == ESP_OK) {
     int status_code = esp_http_client_get_status_code(client);
@@ -556,8 +564,8 @@ esp_err_t TelegramBot::makeHttpRequest(const std::string &endpoint,
              esp_err_to_name(err));
   }
 
-  esp_http_client_close(client);
-  esp_http_client_cleanup(client);
+  // A failed transfer leaves the connection in an unknown state, drop it
+  pool.Release(client, transport_ok);
 
   return err;
 }
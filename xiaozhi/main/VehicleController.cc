@@ -3,11 +3,60 @@
 #include <algorithm>
 #include <cctype>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+// Khoảng cách giữa các lần đọc tiến độ step list
+#define VEHICLE_BATCH_POLL_MS 50
+
 const char* VehicleController::TAG = "VehicleController";
 
+static int DirectionValue(const std::string& direction) {
+    if (direction == "forward") return DIR_FORWARD;
+    if (direction == "backward") return DIR_BACKWARD;
+    if (direction == "left") return DIR_LEFT;
+    if (direction == "right") return DIR_RIGHT;
+    if (direction == "rotate_left") return DIR_ROTATE_LEFT;
+    if (direction == "rotate_right") return DIR_ROTATE_RIGHT;
+    return DIR_STOP;
+}
+
+// Largest distance (mm) or duration (ms) one step carries
+#define VEHICLE_STEP_MAX_VALUE 0xFFFF
+
+// Distance or duration ExecuteMove() sends, 0 for a stop
+static int MoveValue(const VehicleController::MoveCommand& cmd) {
+    if (DirectionValue(cmd.direction) == DIR_STOP) {
+        return 0;
+    }
+    if (cmd.distance_mm > 0) {
+        return cmd.distance_mm;
+    }
+    return cmd.duration_ms > 0 ? cmd.duration_ms : 1000;
+}
+
+// Steps a move takes in a step list, a longer one is split into equal parts
+static size_t MoveStepCount(const VehicleController::MoveCommand& cmd) {
+    int value = MoveValue(cmd);
+    return std::max(1, value / VEHICLE_STEP_MAX_VALUE + (value % VEHICLE_STEP_MAX_VALUE != 0 ? 1 : 0));
+}
+
+// Same move ExecuteMove() sends, as MoveStepCount() steps run back to back
+static void AddMoveSteps(I2cBatch& batch, const VehicleController::MoveCommand& cmd) {
+    int direction = DirectionValue(cmd.direction);
+    if (direction == DIR_STOP) {
+        batch.Add(I2cBatchStep(kI2cBatchMoveTime, DIR_STOP, 0, 0));
+        return;
+    }
+    uint8_t kind = cmd.distance_mm > 0 ? kI2cBatchMoveDistance : kI2cBatchMoveTime;
+    int value = MoveValue(cmd);
+    int parts = (int)MoveStepCount(cmd);
+    for (int i = 0; i < parts; i++) {
+        batch.Add(I2cBatchStep(kind, direction, cmd.speed, value / parts + (i < value % parts ? 1 : 0)));
+    }
+}
+
 VehicleController::VehicleController(I2CCommandBridge* i2c_bridge, DistanceSensor* distance_sensor)
     : i2c_bridge_(i2c_bridge), distance_sensor_(distance_sensor), is_moving_(false) {
     
@@ -51,14 +100,7 @@ bool VehicleController::ExecuteMove(const MoveCommand& cmd) {
     bool success = false;
     
     // Convert string direction to int constant
-    int direction = DIR_STOP;
-    if (cmd.direction == "forward") direction = DIR_FORWARD;
-    else if (cmd.direction == "backward") direction = DIR_BACKWARD;
-    else if (cmd.direction == "left") direction = DIR_LEFT;
-    else if (cmd.direction == "right") direction = DIR_RIGHT;
-    else if (cmd.direction == "rotate_left") direction = DIR_ROTATE_LEFT;
-    else if (cmd.direction == "rotate_right") direction = DIR_ROTATE_RIGHT;
-    else if (cmd.direction == "stop") direction = DIR_STOP;
+    int direction = DirectionValue(cmd.direction);
     
     if (direction == DIR_STOP) {
         response = i2c_bridge_->VehicleStop();
@@ -95,10 +137,168 @@ bool VehicleController::ExecuteMove(const MoveCommand& cmd) {
     return success;
 }
 
-bool VehicleController::ExecuteSequence(const std::vector<MoveCommand>& commands) {
+bool VehicleController::ExecuteSequence(const std::vector<MoveCommand>& commands, ProgressCallback progress) {
     ESP_LOGI(TAG, "Executing sequence of %d commands", (int)commands.size());
-    
-    for (size_t i = 0; i < commands.size(); i++) {
+
+    size_t first = 0;
+    while (first < commands.size()) {
+        // Whole commands that fit one step list
+        size_t count = 0;
+        size_t steps = 0;
+        while (first + count < commands.size() &&
+               steps + MoveStepCount(commands[first + count]) <= I2C_BATCH_MAX_STEPS) {
+            steps += MoveStepCount(commands[first + count]);
+            count++;
+        }
+        if (count == 0) {
+            // Lệnh đơn mang giá trị 32 bit, gửi riêng lệnh quá dài cho một step list
+            ESP_LOGW(TAG, "Command %d too long for a step list, sending it on its own", (int)first + 1);
+            if (!ExecuteStepByStep(commands, first, 1, progress)) {
+                return false;
+            }
+            first++;
+            continue;
+        }
+
+        bool unsupported = false;
+        if (RunBatch(commands, first, count, progress, unsupported)) {
+            first += count;
+            continue;
+        }
+        if (!unsupported) {
+            return false;
+        }
+        ESP_LOGW(TAG, "Step lists not supported, sending commands one by one");
+        // RunBatch() already reported command first
+        ProgressCallback rest;
+        if (progress) {
+            rest = [&progress, first](size_t done, size_t total) { return done == first || progress(done, total); };
+        }
+        if (!ExecuteStepByStep(commands, first, commands.size() - first, rest)) {
+            return false;
+        }
+        break;
+    }
+
+    if (progress) {
+        progress(commands.size(), commands.size());
+    }
+    NotifyStatus("Hoàn thành chuỗi lệnh");
+    return true;
+}
+
+bool VehicleController::RunBatch(const std::vector<MoveCommand>& commands, size_t first, size_t count,
+                                 const ProgressCallback& progress, bool& unsupported) {
+    if (!i2c_bridge_) {
+        ESP_LOGE(TAG, "I2C bridge not available");
+        return false;
+    }
+
+    I2cBatch batch;
+    size_t step_command[I2C_BATCH_MAX_STEPS];  // command of each step
+    bool forward_or_backward = false;
+    for (size_t i = first; i < first + count; i++) {
+        size_t steps = MoveStepCount(commands[i]);
+        if (steps > 1) {
+            ESP_LOGW(TAG, "Command %d: %s %d longer than one step, split into %d steps", (int)i + 1,
+                     commands[i].direction.c_str(), MoveValue(commands[i]), (int)steps);
+        }
+        for (size_t step = 0; step < steps; step++) {
+            step_command[batch.count + step] = i;
+        }
+        AddMoveSteps(batch, commands[i]);
+        forward_or_backward |= commands[i].direction == "forward" || commands[i].direction == "backward";
+    }
+    // Later steps are covered by the obstacle callback while the list runs
+    if (forward_or_backward && distance_sensor_ && distance_sensor_->HasObstacle()) {
+        ESP_LOGW(TAG, "🛑 NGĂN CẢN chuỗi lệnh: Phát hiện vật cản ở %.1f cm", distance_sensor_->GetCurrentDistance());
+        NotifyStatus("Dừng xe do phát hiện vật cản");
+        return false;
+    }
+    if (progress && !progress(first, commands.size())) {
+        ESP_LOGW(TAG, "Sequence aborted before command %d", (int)first + 1);
+        Stop();
+        return false;
+    }
+
+    std::string response = i2c_bridge_->RunBatch(batch);
+    if (response.find("not_supported") != std::string::npos ||
+        response == "{\"s\":" + std::to_string(STATUS_UNKNOWN) + "}") {
+        unsupported = true;
+        return false;
+    }
+    if (response != "{\"s\":" + std::to_string(STATUS_OK) + "}") {
+        ESP_LOGE(TAG, "⚠️ I2C error detected: %s", response.c_str());
+        i2c_bridge_->VehicleStop();
+        NotifyStatus("Lỗi I2C - Đã dừng khẩn cấp");
+        return false;
+    }
+
+    NotifyStatus("Đang thực hiện chuỗi " + std::to_string(count) + " lệnh");
+    is_moving_ = true;
+
+    // ========== ĐỢI ACTUATOR CHẠY XONG, BÁO TIẾN ĐỘ TỪNG BƯỚC ==========
+    I2cStatusView view;
+    size_t reported = 0;  // step
+    int64_t step_start_us = esp_timer_get_time();
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(VEHICLE_BATCH_POLL_MS));
+        if (!is_moving_) {
+            // Stopped meanwhile (obstacle)
+            return false;
+        }
+
+        int64_t now_us = esp_timer_get_time();
+        if (i2c_bridge_->GetBatchProgress(view) && view.fields.batch_id == batch.id) {
+            if (view.fields.batch_state == kI2cBatchDone) {
+                break;
+            }
+            size_t done = std::min((size_t)view.fields.batch_done, (size_t)batch.count - 1);
+            if (view.fields.batch_state == kI2cBatchAborted) {
+                ESP_LOGW(TAG, "Sequence aborted by the actuator at command %d", (int)step_command[done] + 1);
+                is_moving_ = false;
+                NotifyStatus("Lỗi thực hiện lệnh " + std::to_string(step_command[done] + 1));
+                return false;
+            }
+            if (done != reported) {
+                // Parts of a split move are one command for the progress
+                bool next_command = step_command[done] != step_command[reported];
+                reported = done;
+                step_start_us = now_us;
+                size_t command = step_command[done];
+                if (next_command) {
+                    ESP_LOGI(TAG, "Command %d/%d: %s", (int)command + 1, (int)commands.size(),
+                             commands[command].direction.c_str());
+                    if (progress && !progress(command, commands.size())) {
+                        ESP_LOGW(TAG, "Sequence aborted before command %d", (int)command + 1);
+                        Stop();
+                        return false;
+                    }
+                }
+            }
+        }
+
+        if (now_us - step_start_us > (int64_t)batch.steps[reported].TimeoutMs() * 1000) {
+            ESP_LOGE(TAG, "Command %d did not finish in time", (int)step_command[reported] + 1);
+            Stop();
+            NotifyStatus("Lỗi thực hiện lệnh " + std::to_string(step_command[reported] + 1));
+            return false;
+        }
+    }
+
+    is_moving_ = false;
+    return true;
+}
+
+bool VehicleController::ExecuteStepByStep(const std::vector<MoveCommand>& commands, size_t first, size_t count,
+                                          const ProgressCallback& progress) {
+    for (size_t i = first; i < first + count; i++) {
+        if (progress && !progress(i, commands.size())) {
+            ESP_LOGW(TAG, "Sequence aborted before command %d", (int)i+1);
+            Stop();
+            return false;
+        }
+
         ESP_LOGI(TAG, "Command %d/%d: %s", (int)i+1, (int)commands.size(), 
                  commands[i].direction.c_str());
         
@@ -111,8 +311,6 @@ bool VehicleController::ExecuteSequence(const std::vector<MoveCommand>& commands
         // Delay nhỏ giữa các lệnh
         vTaskDelay(pdMS_TO_TICKS(100));
     }
-    
-    NotifyStatus("Hoàn thành chuỗi lệnh");
     return true;
 }
 
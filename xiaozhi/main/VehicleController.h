@@ -2,6 +2,7 @@
 
 #include "I2CCommandBridge.h"
 #include "DistanceSensor.h"
+#include <atomic>
 #include <string>
 #include <vector>
 #include <functional>
@@ -30,6 +31,8 @@ public:
     };
 
     typedef std::function<void(const std::string& status)> StatusCallback;
+    // Called before each command of a sequence with the number done so far, false aborts and stops
+    typedef std::function<bool(size_t done, size_t total)> ProgressCallback;
 
     VehicleController(I2CCommandBridge* i2c_bridge, DistanceSensor* distance_sensor = nullptr);
     ~VehicleController();
@@ -41,8 +44,12 @@ public:
 
     /**
      * @brief Thực hiện chuỗi lệnh di chuyển
+     *
+     * Gửi tối đa I2C_BATCH_MAX_STEPS step trong một frame, actuator tự chạy
+     * lần lượt và báo tiến độ qua status. Lệnh dài hơn 65535 mm/ms chiếm
+     * nhiều step. Actuator hoặc protocol không hỗ trợ thì gửi từng lệnh như trước.
      */
-    bool ExecuteSequence(const std::vector<MoveCommand>& commands);
+    bool ExecuteSequence(const std::vector<MoveCommand>& commands, ProgressCallback progress = nullptr);
 
     /**
      * @brief Di chuyển mặc định (0.5m)
@@ -79,7 +86,17 @@ private:
     I2CCommandBridge* i2c_bridge_;
     DistanceSensor* distance_sensor_;
     StatusCallback status_callback_;
-    bool is_moving_;
+    // Stop() và callback vật cản chạy trên task khác với lệnh đang di chuyển
+    std::atomic<bool> is_moving_;
+
+    // Chuỗi con [first, first + count) chạy trên actuator; unsupported = true
+    // nếu actuator không nhận step list. Lệnh dài hơn một step (16 bit) được
+    // chia thành nhiều step, count lệnh phải vừa I2C_BATCH_MAX_STEPS step
+    bool RunBatch(const std::vector<MoveCommand>& commands, size_t first, size_t count,
+                  const ProgressCallback& progress, bool& unsupported);
+    // Từng lệnh một trong [first, first + count), một transaction mỗi lệnh
+    bool ExecuteStepByStep(const std::vector<MoveCommand>& commands, size_t first, size_t count,
+                           const ProgressCallback& progress);
 
     void NotifyStatus(const std::string& status);
     int ParseDistance(const std::string& text, size_t& pos);
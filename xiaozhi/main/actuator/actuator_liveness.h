@@ -0,0 +1,93 @@
+#ifndef ACTUATOR_LIVENESS_H
+#define ACTUATOR_LIVENESS_H
+
+#include <cstdint>
+#include <mutex>
+
+// A successful transaction is trusted for this long before probing again
+#define ACTUATOR_IDLE_PROBE_MS 5000
+// Consecutive failed transactions before the actuator counts as offline
+#define ACTUATOR_OFFLINE_FAILURES 2
+// Probe interval while offline, doubling up to the max
+#define ACTUATOR_PROBE_BACKOFF_MS 500
+#define ACTUATOR_PROBE_BACKOFF_MAX_MS 8000
+
+/*
+ * Whether the actuator answers, inferred from the real transactions
+ * (I2CCommandBridge::Transact) instead of a probe before every command.
+ * A probe is only due before the first command, after a failed transaction,
+ * after ACTUATOR_IDLE_PROBE_MS without traffic and, once offline, on an
+ * exponential backoff. Time comes from the caller, so the class also builds
+ * on the host.
+ */
+class ActuatorLiveness {
+public:
+    enum State { kUnknown, kOnline, kOffline };
+
+    // True if state() cannot be trusted without a probe
+    bool NeedsProbe(int64_t now_us) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        switch (state_) {
+        case kOnline:
+            return failures_ > 0 || now_us - last_ok_us_ >= (int64_t)ACTUATOR_IDLE_PROBE_MS * 1000;
+        case kOffline:
+            return now_us >= next_probe_us_;
+        default:
+            return true;
+        }
+    }
+
+    // Outcome of a probe or a transaction, true if the state changed
+    bool Record(bool ok, int64_t now_us) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (ok) {
+            failures_ = 0;
+            last_ok_us_ = now_us;
+            if (state_ == kOnline) {
+                return false;
+            }
+            state_ = kOnline;
+            return true;
+        }
+
+        failures_++;
+        if (state_ == kOffline) {
+            backoff_ms_ = backoff_ms_ * 2 > ACTUATOR_PROBE_BACKOFF_MAX_MS ? ACTUATOR_PROBE_BACKOFF_MAX_MS
+                                                                          : backoff_ms_ * 2;
+            next_probe_us_ = now_us + (int64_t)backoff_ms_ * 1000;
+            return false;
+        }
+        if (failures_ < ACTUATOR_OFFLINE_FAILURES) {
+            return false;
+        }
+        state_ = kOffline;
+        backoff_ms_ = ACTUATOR_PROBE_BACKOFF_MS;
+        next_probe_us_ = now_us + (int64_t)backoff_ms_ * 1000;
+        return true;
+    }
+
+    // Back to kUnknown, e.g. after the bus was re-initialised
+    void Reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        state_ = kUnknown;
+        failures_ = 0;
+        backoff_ms_ = ACTUATOR_PROBE_BACKOFF_MS;
+    }
+
+    State state() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return state_;
+    }
+
+    bool online() { return state() == kOnline; }
+
+private:
+    std::mutex mutex_;
+    State state_ = kUnknown;
+    int failures_ = 0;
+    int64_t last_ok_us_ = 0;
+    int64_t next_probe_us_ = 0;
+    uint32_t backoff_ms_ = ACTUATOR_PROBE_BACKOFF_MS;
+};
+
+#endif // ACTUATOR_LIVENESS_H
@@ -0,0 +1,148 @@
+#ifndef I2C_BATCH_H
+#define I2C_BATCH_H
+
+/*
+ * Step lists the actuator runs on its own (kI2cFrameBatch): a sequence of
+ * moves, door moves and pauses goes out in one frame instead of one
+ * transaction per step, and each step starts as soon as the one before it
+ * has finished.
+ *
+ *   request  id u8, then per step: op u8, arg u8, value u16
+ *            op = kind << 4 | target (direction for moves, slot for doors)
+ *   reply    ack, STATUS_OK once the list is accepted, before it has run
+ *
+ * Progress is the batch field of the versioned status (kI2cStatusBatch in
+ * i2c_status_delta.h): the id of the last accepted list, the steps finished
+ * and an I2cBatchState. A stop frame or the next list aborts a running one.
+ *
+ * Plain C++11 without the standard library, built by the actuator too.
+ */
+
+#include "i2c_frame.h"
+
+#define I2C_BATCH_STEP_SIZE 4
+#define I2C_BATCH_MAX_STEPS ((I2C_FRAME_MAX_PAYLOAD - 1) / I2C_BATCH_STEP_SIZE)
+// Master's allowance on top of a timed step before it gives up on the list
+#define I2C_BATCH_STEP_SLACK_MS 2000
+// Allowance for steps without a known length (distance, door)
+#define I2C_BATCH_STEP_TIMEOUT_MS 30000
+
+enum I2cBatchKind {
+    kI2cBatchMoveTime = 1,      // target dir, arg speed, value duration_ms (dir 0 or 0 ms: stop)
+    kI2cBatchMoveDistance = 2,  // target dir, arg speed, value distance_mm
+    kI2cBatchStorage = 3,       // target slot, arg action
+    kI2cBatchWait = 4,          // value ms
+};
+
+// Two bits in the status field, next to up to 63 steps done
+enum I2cBatchState {
+    kI2cBatchIdle = 0,     // nothing accepted since boot
+    kI2cBatchRunning = 1,
+    kI2cBatchDone = 2,
+    kI2cBatchAborted = 3,  // by a stop or the next list
+};
+
+struct I2cBatchStep {
+    uint8_t kind;
+    uint8_t target;
+    uint8_t arg;
+    uint16_t value;
+
+    I2cBatchStep() : kind(0), target(0), arg(0), value(0) {}
+    I2cBatchStep(uint8_t step_kind, uint8_t step_target, uint8_t step_arg, uint16_t step_value)
+        : kind(step_kind), target(step_target), arg(step_arg), value(step_value) {}
+
+    bool IsStop() const { return kind == kI2cBatchMoveTime && (target == DIR_STOP || value == 0); }
+
+    bool Valid() const {
+        switch (kind) {
+        case kI2cBatchMoveTime:
+            return target <= DIR_ROTATE_RIGHT;
+        case kI2cBatchMoveDistance:
+            return target >= DIR_FORWARD && target <= DIR_ROTATE_RIGHT && value > 0;
+        case kI2cBatchStorage:
+            return target <= 3 && (arg == ACT_OPEN || arg == ACT_CLOSE);
+        case kI2cBatchWait:
+            return true;
+        }
+        return false;
+    }
+
+    // How long the master waits for this step before giving up on the list
+    uint32_t TimeoutMs() const {
+        if ((kind == kI2cBatchMoveTime && !IsStop()) || kind == kI2cBatchWait) {
+            return (uint32_t)value + I2C_BATCH_STEP_SLACK_MS;
+        }
+        return kind == kI2cBatchMoveTime ? I2C_BATCH_STEP_SLACK_MS : I2C_BATCH_STEP_TIMEOUT_MS;
+    }
+};
+
+/*
+ * One list, built step by step and carried by a single frame:
+ *
+ *   I2cBatch batch;
+ *   batch.MoveTime(DIR_FORWARD, 50, 800).Storage(0, ACT_OPEN).Wait(500);
+ *   I2cFrame request(kI2cFrameBatch, seq);
+ *   batch.Encode(request);
+ *
+ * Steps past I2C_BATCH_MAX_STEPS set overflow(), the caller splits the list.
+ */
+struct I2cBatch {
+    uint8_t id;
+    uint8_t count;
+    bool overflow;
+    I2cBatchStep steps[I2C_BATCH_MAX_STEPS];
+
+    I2cBatch() : id(0), count(0), overflow(false) {}
+
+    I2cBatch& Add(const I2cBatchStep& step) {
+        if (count >= I2C_BATCH_MAX_STEPS) {
+            overflow = true;
+            return *this;
+        }
+        steps[count++] = step;
+        return *this;
+    }
+
+    I2cBatch& MoveTime(uint8_t dir, uint8_t speed, uint16_t duration_ms) {
+        return Add(I2cBatchStep(kI2cBatchMoveTime, dir, speed, duration_ms));
+    }
+
+    I2cBatch& MoveDistance(uint8_t dir, uint8_t speed, uint16_t distance_mm) {
+        return Add(I2cBatchStep(kI2cBatchMoveDistance, dir, speed, distance_mm));
+    }
+
+    I2cBatch& Storage(uint8_t slot, uint8_t action) { return Add(I2cBatchStep(kI2cBatchStorage, slot, action, 0)); }
+
+    I2cBatch& Wait(uint16_t ms) { return Add(I2cBatchStep(kI2cBatchWait, 0, 0, ms)); }
+
+    void Encode(I2cFrame& request) const {
+        request.U8(id);
+        for (uint8_t i = 0; i < count; i++) {
+            request.U8((uint8_t)(steps[i].kind << 4 | (steps[i].target & 0x0F)))
+                .U8(steps[i].arg)
+                .U16(steps[i].value);
+        }
+    }
+
+    // False if the length is not a whole number of steps or a step is invalid
+    bool Decode(const I2cFrame& request) {
+        count = 0;
+        overflow = false;
+        if (request.length < 1 + I2C_BATCH_STEP_SIZE || (request.length - 1) % I2C_BATCH_STEP_SIZE != 0) {
+            return false;
+        }
+        id = request.u8(0);
+        for (size_t offset = 1; offset < request.length; offset += I2C_BATCH_STEP_SIZE) {
+            I2cBatchStep step(request.u8(offset) >> 4, request.u8(offset) & 0x0F, request.u8(offset + 1),
+                request.u16(offset + 2));
+            if (!step.Valid()) {
+                return false;
+            }
+            Add(step);
+        }
+        return !overflow;
+    }
+};
+
+#endif // I2C_BATCH_H
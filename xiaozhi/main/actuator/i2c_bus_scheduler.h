@@ -0,0 +1,220 @@
+#ifndef I2C_BUS_SCHEDULER_H
+#define I2C_BUS_SCHEDULER_H
+
+#include "i2c_frame.h"
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+
+enum I2cBusPriority {
+    kI2cBusStop,     // VehicleStop, may cut into a transaction waiting for its reply
+    kI2cBusMotion,   // moves
+    kI2cBusStorage,  // door servos, about 0.6 s each
+    kI2cBusPoll,     // status and probes, identical pending ones are coalesced
+    kI2cBusPriorityCount
+};
+
+struct I2cBusLaneStats {
+    uint32_t submitted = 0;
+    uint32_t run = 0;
+    uint32_t coalesced = 0;
+    uint32_t expired = 0;
+    uint32_t max_wait_us = 0;
+};
+
+/*
+ * One transaction for the bus task. Owned by the caller and kept alive until
+ * done() is called, on the device it sits on the caller's stack while the
+ * caller waits on a semaphore given by done().
+ */
+struct I2cBusTicket {
+    I2cFrame request;
+    I2cFrame reply;
+    bool probe = false;  // one byte liveness probe instead of request
+    I2cBusPriority priority = kI2cBusPoll;
+    int64_t deadline_us = 0;  // completed with "deadline_expired" if not started by then, 0 = none
+    const char* error = nullptr;  // nullptr on success
+    void (*done)(I2cBusTicket* ticket) = nullptr;  // called once, from the bus task
+    void* user_data = nullptr;
+
+    // Scheduler state
+    int64_t submit_us = 0;
+    I2cBusTicket* next = nullptr;
+    I2cBusTicket* joined = nullptr;  // coalesced tickets answered with this one's reply
+};
+
+/*
+ * Pending actuator transactions, owned by a single bus task. Strict priority
+ * across lanes (kI2cBusStop first), FIFO within a lane. A poll that matches
+ * one already pending joins it and gets the same reply instead of a second
+ * transaction. Tickets not started before their deadline are dropped with
+ * "deadline_expired". Time comes from the caller, so the class also builds
+ * on the host.
+ *
+ *   Submit(&ticket, now)      any task, then wake the bus task
+ *   Next(now)                 bus task: next ticket to run, nullptr if idle
+ *   Next(now, kI2cBusStop)    bus task, between polls of a slow reply
+ *   Complete(ticket)          bus task: after setting reply and error
+ */
+class I2cBusScheduler {
+public:
+    // False once closed, the ticket is then not queued and done() not called
+    bool Submit(I2cBusTicket* ticket, int64_t now_us) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return false;
+        }
+        ticket->submit_us = now_us;
+        ticket->error = nullptr;
+        ticket->next = nullptr;
+        ticket->joined = nullptr;
+
+        Lane& lane = lanes_[ticket->priority];
+        lane.stats.submitted++;
+        if (ticket->priority == kI2cBusPoll) {
+            for (I2cBusTicket* pending = lane.head; pending != nullptr; pending = pending->next) {
+                if (!SameRequest(*pending, *ticket)) {
+                    continue;
+                }
+                // The later deadline of the two, none beats any
+                if (pending->deadline_us != 0 && (ticket->deadline_us == 0 || ticket->deadline_us > pending->deadline_us)) {
+                    pending->deadline_us = ticket->deadline_us;
+                }
+                ticket->joined = pending->joined;
+                pending->joined = ticket;
+                lane.stats.coalesced++;
+                return true;
+            }
+        }
+
+        if (lane.tail != nullptr) {
+            lane.tail->next = ticket;
+        } else {
+            lane.head = ticket;
+        }
+        lane.tail = ticket;
+        return true;
+    }
+
+    // Highest priority ticket down to `lowest`, nullptr if none. Expired
+    // tickets met on the way are completed.
+    I2cBusTicket* Next(int64_t now_us, I2cBusPriority lowest = kI2cBusPoll) {
+        I2cBusTicket* found = nullptr;
+        I2cBusTicket* expired = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (int priority = 0; priority <= lowest && found == nullptr; priority++) {
+                Lane& lane = lanes_[priority];
+                while (lane.head != nullptr) {
+                    I2cBusTicket* ticket = lane.head;
+                    lane.head = ticket->next;
+                    if (lane.head == nullptr) {
+                        lane.tail = nullptr;
+                    }
+                    if (ticket->deadline_us != 0 && now_us > ticket->deadline_us) {
+                        for (I2cBusTicket* t = ticket; t != nullptr; t = t->joined) {
+                            lane.stats.expired++;
+                        }
+                        ticket->next = expired;
+                        expired = ticket;
+                        continue;
+                    }
+                    lane.stats.run++;
+                    int64_t wait_us = now_us - ticket->submit_us;
+                    if (wait_us > lane.stats.max_wait_us) {
+                        lane.stats.max_wait_us = (uint32_t)wait_us;
+                    }
+                    found = ticket;
+                    break;
+                }
+            }
+        }
+
+        while (expired != nullptr) {
+            I2cBusTicket* ticket = expired;
+            expired = ticket->next;
+            ticket->error = "deadline_expired";
+            Finish(ticket);
+        }
+        return found;
+    }
+
+    // Hands reply and error of a ticket from Next() to it and to the tickets coalesced into it
+    void Complete(I2cBusTicket* ticket) { Finish(ticket); }
+
+    // Completes every pending ticket with `error`, Submit() fails until Open()
+    void Close(const char* error) {
+        I2cBusTicket* pending = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            for (auto& lane : lanes_) {
+                if (lane.tail != nullptr) {
+                    lane.tail->next = pending;
+                    pending = lane.head;
+                }
+                lane.head = lane.tail = nullptr;
+            }
+        }
+        while (pending != nullptr) {
+            I2cBusTicket* ticket = pending;
+            pending = ticket->next;
+            ticket->error = error;
+            Finish(ticket);
+        }
+    }
+
+    void Open() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = false;
+    }
+
+    bool closed() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+    I2cBusLaneStats stats(I2cBusPriority priority) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lanes_[priority].stats;
+    }
+
+private:
+    struct Lane {
+        I2cBusTicket* head = nullptr;
+        I2cBusTicket* tail = nullptr;
+        I2cBusLaneStats stats;
+    };
+
+    std::mutex mutex_;
+    bool closed_ = false;
+    Lane lanes_[kI2cBusPriorityCount];
+
+    static bool SameRequest(const I2cBusTicket& a, const I2cBusTicket& b) {
+        if (a.probe || b.probe) {
+            return a.probe == b.probe;
+        }
+        return a.request.type == b.request.type && a.request.length == b.request.length &&
+            memcmp(a.request.payload, b.request.payload, a.request.length) == 0;
+    }
+
+    // done() may free the ticket, so everything is read before it runs
+    static void Finish(I2cBusTicket* ticket) {
+        I2cBusTicket* joined = ticket->joined;
+        while (joined != nullptr) {
+            I2cBusTicket* next = joined->joined;
+            joined->reply = ticket->reply;
+            joined->error = ticket->error;
+            if (joined->done != nullptr) {
+                joined->done(joined);
+            }
+            joined = next;
+        }
+        if (ticket->done != nullptr) {
+            ticket->done(ticket);
+        }
+    }
+};
+
+#endif // I2C_BUS_SCHEDULER_H
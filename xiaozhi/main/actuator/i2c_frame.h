@@ -0,0 +1,214 @@
+#ifndef I2C_FRAME_H
+#define I2C_FRAME_H
+
+/*
+ * Binary frames between xiaozhi (I2C master) and the actuator (slave 0x55).
+ * Shared by I2CCommandBridge, xiaozhi-actuator and esp32s3_test_control; the
+ * two Arduino projects add this directory to their include path.
+ *
+ *   0xA5 | type | seq | length | payload[length] | crc16 hi | crc16 lo
+ *
+ * The CRC is CRC-16/CCITT-FALSE over type, seq, length and payload. The master
+ * numbers its requests (never 0) and the actuator echoes the number in its
+ * reply, so a reply left over from an earlier request is told apart from the
+ * answer to the current one. Multi-byte payload fields are little endian.
+ *
+ * The actuator answers a read with a busy frame until the reply is written,
+ * so the master polls instead of waiting a fixed time (i2c_reply_wait.h).
+ *
+ * A request starting with '{' instead of 0xA5 is the JSON debug protocol
+ * ({"t":"v","d":1,"p":50,"ms":2000}), still understood by the actuator.
+ *
+ * Plain C++11 without the standard library so the Arduino cores build it.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define I2C_FRAME_MAGIC 0xA5
+#define I2C_FRAME_HEADER_SIZE 4
+#define I2C_FRAME_CRC_SIZE 2
+// Room for a step list of I2C_BATCH_MAX_STEPS (i2c_batch.h), well inside the
+// 128-byte Wire buffer of the Arduino core
+#define I2C_FRAME_MAX_PAYLOAD 64
+#define I2C_FRAME_MAX_SIZE (I2C_FRAME_HEADER_SIZE + I2C_FRAME_MAX_PAYLOAD + I2C_FRAME_CRC_SIZE)
+
+// Direction values
+#define DIR_STOP 0
+#define DIR_FORWARD 1
+#define DIR_BACKWARD 2
+#define DIR_LEFT 3
+#define DIR_RIGHT 4
+#define DIR_ROTATE_LEFT 5
+#define DIR_ROTATE_RIGHT 6
+
+// Action values
+#define ACT_CLOSE 0
+#define ACT_OPEN 1
+
+// Ack values
+#define STATUS_OK 1
+#define STATUS_ERROR -1
+#define STATUS_UNKNOWN -2
+
+// Status reply flag bits
+#define I2C_STATUS_BLE_CONNECTED 0x01
+#define I2C_STATUS_MOVING 0x02
+#define I2C_STATUS_MOTOR_ENABLED 0x04
+
+enum I2cFrameType {
+    // master -> actuator
+    kI2cFrameVehicleTime = 0x01,      // dir u8, speed u8, duration_ms u32 (dir 0 or 0 ms: stop)
+    kI2cFrameVehicleDistance = 0x02,  // dir u8, speed u8, distance_mm u32
+    kI2cFrameStorage = 0x03,          // slot u8, action u8
+    kI2cFrameStatus = 0x04,           // no payload
+    kI2cFrameStatusDelta = 0x05,      // epoch u8, since u16 (i2c_status_delta.h)
+    kI2cFrameBatch = 0x06,            // id u8, steps (i2c_batch.h)
+    // actuator -> master
+    kI2cFrameBusy = 0x80,             // no payload: request seq received, reply not written yet
+    kI2cFrameAck = 0x81,              // status i8 (STATUS_OK, STATUS_ERROR, STATUS_UNKNOWN)
+    kI2cFrameStatusReply = 0x82,      // flags u8, heart_rate i16, storage u8 (bit per slot), gamepad u8
+    kI2cFrameStatusDeltaReply = 0x83, // epoch u8, version u16, mask u8, changed fields
+};
+
+enum I2cFrameError {
+    kI2cFrameOk,
+    kI2cFrameTruncated,   // fewer bytes than the header or its length announce
+    kI2cFrameBadMagic,    // not a frame (nothing written yet, 0xFF idle bytes, JSON)
+    kI2cFrameBadLength,   // length above I2C_FRAME_MAX_PAYLOAD
+    kI2cFrameBadCrc,
+};
+
+static inline uint16_t I2cFrameCrc16(const uint8_t* data, size_t size) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static inline const char* I2cFrameErrorName(I2cFrameError error) {
+    switch (error) {
+    case kI2cFrameOk:
+        return "ok";
+    case kI2cFrameTruncated:
+        return "truncated";
+    case kI2cFrameBadMagic:
+        return "bad_magic";
+    case kI2cFrameBadLength:
+        return "bad_length";
+    case kI2cFrameBadCrc:
+        return "bad_crc";
+    }
+    return "unknown";
+}
+
+/*
+ * One frame, built field by field and encoded into a caller buffer, or decoded
+ * from the bytes read off the bus:
+ *
+ *   I2cFrame frame(kI2cFrameVehicleTime, seq);
+ *   frame.U8(DIR_FORWARD).U8(50).U32(2000);
+ *   uint8_t buffer[I2C_FRAME_MAX_SIZE];
+ *   size_t size = frame.Encode(buffer, sizeof(buffer));
+ *
+ * Writes past I2C_FRAME_MAX_PAYLOAD set overflow() and Encode() then returns 0.
+ * Reads past length return 0.
+ */
+struct I2cFrame {
+    uint8_t type;
+    uint8_t seq;
+    uint8_t length;
+    bool overflow;
+    uint8_t payload[I2C_FRAME_MAX_PAYLOAD];
+
+    I2cFrame() : type(0), seq(0), length(0), overflow(false) {}
+    I2cFrame(uint8_t frame_type, uint8_t frame_seq) : type(frame_type), seq(frame_seq), length(0), overflow(false) {}
+
+    size_t size() const { return I2C_FRAME_HEADER_SIZE + length + I2C_FRAME_CRC_SIZE; }
+
+    I2cFrame& U8(uint8_t value) {
+        if (length >= I2C_FRAME_MAX_PAYLOAD) {
+            overflow = true;
+            return *this;
+        }
+        payload[length++] = value;
+        return *this;
+    }
+
+    I2cFrame& U16(uint16_t value) { return U8(value & 0xFF).U8(value >> 8); }
+
+    I2cFrame& U32(uint32_t value) { return U16(value & 0xFFFF).U16(value >> 16); }
+
+    uint8_t u8(size_t offset) const { return offset < length ? payload[offset] : 0; }
+
+    uint16_t u16(size_t offset) const { return (uint16_t)(u8(offset) | u8(offset + 1) << 8); }
+
+    uint32_t u32(size_t offset) const { return u16(offset) | (uint32_t)u16(offset + 2) << 16; }
+
+    // Bytes written, 0 if out is too small or the payload overflowed
+    size_t Encode(uint8_t* out, size_t out_size) const {
+        if (overflow || out_size < size()) {
+            return 0;
+        }
+        out[0] = I2C_FRAME_MAGIC;
+        out[1] = type;
+        out[2] = seq;
+        out[3] = length;
+        for (size_t i = 0; i < length; i++) {
+            out[I2C_FRAME_HEADER_SIZE + i] = payload[i];
+        }
+        uint16_t crc = I2cFrameCrc16(out + 1, I2C_FRAME_HEADER_SIZE - 1 + length);
+        out[I2C_FRAME_HEADER_SIZE + length] = crc >> 8;
+        out[I2C_FRAME_HEADER_SIZE + length + 1] = crc & 0xFF;
+        return size();
+    }
+
+    // The frame must start at in[0], bytes after it are ignored
+    I2cFrameError Decode(const uint8_t* in, size_t in_size) {
+        if (in_size < 1) {
+            return kI2cFrameTruncated;
+        }
+        if (in[0] != I2C_FRAME_MAGIC) {
+            return kI2cFrameBadMagic;
+        }
+        if (in_size < I2C_FRAME_HEADER_SIZE) {
+            return kI2cFrameTruncated;
+        }
+        if (in[3] > I2C_FRAME_MAX_PAYLOAD) {
+            return kI2cFrameBadLength;
+        }
+        size_t frame_size = I2C_FRAME_HEADER_SIZE + in[3] + I2C_FRAME_CRC_SIZE;
+        if (in_size < frame_size) {
+            return kI2cFrameTruncated;
+        }
+        uint16_t crc = (uint16_t)(in[frame_size - 2] << 8 | in[frame_size - 1]);
+        if (I2cFrameCrc16(in + 1, frame_size - 1 - I2C_FRAME_CRC_SIZE) != crc) {
+            return kI2cFrameBadCrc;
+        }
+        type = in[1];
+        seq = in[2];
+        length = in[3];
+        overflow = false;
+        for (size_t i = 0; i < length; i++) {
+            payload[i] = in[I2C_FRAME_HEADER_SIZE + i];
+        }
+        return kI2cFrameOk;
+    }
+};
+
+// Bytes the master reads for the reply to a request of this type
+static inline size_t I2cFrameReplySize(uint8_t request_type) {
+    if (request_type == kI2cFrameStatus) {
+        return I2C_FRAME_HEADER_SIZE + 5 + I2C_FRAME_CRC_SIZE;
+    }
+    if (request_type == kI2cFrameStatusDelta) {
+        return I2C_FRAME_HEADER_SIZE + 4 + 7 + I2C_FRAME_CRC_SIZE;  // with every field
+    }
+    return I2C_FRAME_HEADER_SIZE + 1 + I2C_FRAME_CRC_SIZE;
+}
+
+#endif // I2C_FRAME_H
@@ -0,0 +1,76 @@
+#ifndef I2C_REPLY_WAIT_H
+#define I2C_REPLY_WAIT_H
+
+#include "i2c_frame.h"
+
+// First poll after the request, most requests are answered by then
+#define I2C_REPLY_FIRST_POLL_US 300
+// Poll interval doubles up to this
+#define I2C_REPLY_MAX_POLL_US 32000
+// The master spins for delays below this and sleeps whole ticks above it
+#define I2C_REPLY_SPIN_US 1000
+
+// How long the actuator may take to write its reply, by request type
+static inline uint32_t I2cReplyBudgetUs(uint8_t request_type) {
+    switch (request_type) {
+    case kI2cFrameStatus:
+    case kI2cFrameStatusDelta:
+        return 30000;
+    case kI2cFrameVehicleTime:
+    case kI2cFrameVehicleDistance:
+    case kI2cFrameBatch:  // acked when accepted, the steps run afterwards
+        return 50000;
+    case kI2cFrameStorage:
+        return 2000000;  // acked once the door servo has moved, about 0.6 s
+    default:
+        return 100000;
+    }
+}
+
+/*
+ * Poll schedule for the reply to one request: I2C_REPLY_FIRST_POLL_US, then
+ * doubling up to I2C_REPLY_MAX_POLL_US, until the budget of the request type
+ * is spent. The master reads the reply size each time and stops at the first
+ * frame carrying its seq that is not kI2cFrameBusy. Time comes from the
+ * caller (esp_timer_get_time() on the device, micros() on Arduino).
+ *
+ *   I2cReplyWait wait(now_us, I2cReplyBudgetUs(request.type));
+ *   for (int64_t delay_us; (delay_us = wait.NextDelayUs(now_us)) >= 0;) {
+ *       sleep(delay_us);
+ *       read and decode, break once replied
+ *   }
+ */
+class I2cReplyWait {
+public:
+    // first_poll_us 0: poll at once, e.g. after the data-ready line went high
+    I2cReplyWait(int64_t start_us, uint32_t budget_us, uint32_t first_poll_us = I2C_REPLY_FIRST_POLL_US)
+        : deadline_us_(start_us + budget_us), next_us_(first_poll_us), polls_(0) {}
+
+    // Delay before the next poll, -1 once the budget is spent. The first poll
+    // is always granted.
+    int64_t NextDelayUs(int64_t now_us) {
+        int64_t remaining = deadline_us_ - now_us;
+        if (remaining <= 0 && polls_ > 0) {
+            return -1;
+        }
+        int64_t delay_us = next_us_;
+        if (delay_us > remaining) {
+            delay_us = remaining > 0 ? remaining : 0;
+        }
+        next_us_ = next_us_ == 0 ? I2C_REPLY_FIRST_POLL_US : next_us_ * 2;
+        if (next_us_ > I2C_REPLY_MAX_POLL_US) {
+            next_us_ = I2C_REPLY_MAX_POLL_US;
+        }
+        polls_++;
+        return delay_us;
+    }
+
+    int polls() const { return polls_; }
+
+private:
+    int64_t deadline_us_;
+    uint32_t next_us_;
+    int polls_;
+};
+
+#endif // I2C_REPLY_WAIT_H
@@ -0,0 +1,225 @@
+#ifndef I2C_STATUS_DELTA_H
+#define I2C_STATUS_DELTA_H
+
+/*
+ * Versioned actuator status, read as deltas. The actuator keeps the status
+ * with a version that moves on at every change and the version each field
+ * last changed at. The master asks for the fields changed since the version
+ * it holds (kI2cFrameStatusDelta) and gets back only those:
+ *
+ *   request  epoch u8, since u16
+ *   reply    epoch u8, version u16, mask u8, then per set mask bit in order:
+ *            flags u8, heart_rate i16, storage u8, gamepad u8,
+ *            batch id u8, batch progress u8 (state << 6 | steps done, i2c_batch.h)
+ *
+ * The epoch is drawn at actuator boot (never 0). A request from another
+ * epoch, with since 0 or with a version the actuator has not reached yet
+ * gets every field, so a master never keeps fields from before a reboot.
+ *
+ * Plain C++11 without the standard library, built by the actuator too.
+ */
+
+#include "i2c_frame.h"
+
+// Bit per field in the delta mask, fields are encoded in this order
+enum I2cStatusField {
+    kI2cStatusFlags = 0x01,      // u8, I2C_STATUS_* bits
+    kI2cStatusHeartRate = 0x02,  // i16
+    kI2cStatusStorage = 0x04,    // u8, bit per slot
+    kI2cStatusGamepad = 0x08,    // u8
+    kI2cStatusBatch = 0x10,      // id u8, state << 6 | steps done u8
+};
+#define I2C_STATUS_FIELD_COUNT 5
+#define I2C_STATUS_ALL_FIELDS 0x1F
+
+struct I2cStatusFields {
+    uint8_t flags;
+    int16_t heart_rate;
+    uint8_t storage;
+    uint8_t gamepad;
+    uint8_t batch_id;
+    uint8_t batch_done;
+    uint8_t batch_state;
+
+    I2cStatusFields()
+        : flags(0), heart_rate(0), storage(0), gamepad(0), batch_id(0), batch_done(0), batch_state(0) {}
+
+    // Mask of the fields that differ
+    uint8_t Diff(const I2cStatusFields& other) const {
+        uint8_t mask = 0;
+        if (flags != other.flags) {
+            mask |= kI2cStatusFlags;
+        }
+        if (heart_rate != other.heart_rate) {
+            mask |= kI2cStatusHeartRate;
+        }
+        if (storage != other.storage) {
+            mask |= kI2cStatusStorage;
+        }
+        if (gamepad != other.gamepad) {
+            mask |= kI2cStatusGamepad;
+        }
+        if (batch_id != other.batch_id || batch_done != other.batch_done || batch_state != other.batch_state) {
+            mask |= kI2cStatusBatch;
+        }
+        return mask;
+    }
+};
+
+// Actuator side, the caller serialises Update() and EncodeDelta()
+class I2cStatusRecord {
+public:
+    explicit I2cStatusRecord(uint8_t epoch) : epoch_(epoch ? epoch : 1), version_(1) {
+        for (int i = 0; i < I2C_STATUS_FIELD_COUNT; i++) {
+            field_version_[i] = version_;
+        }
+    }
+
+    // True if a field changed, the version then moves on
+    bool Update(const I2cStatusFields& fields) {
+        uint8_t changed = fields_.Diff(fields);
+        if (changed == 0) {
+            return false;
+        }
+        if (++version_ == 0) {
+            version_ = 1;
+        }
+        for (int i = 0; i < I2C_STATUS_FIELD_COUNT; i++) {
+            if (changed & (1 << i)) {
+                field_version_[i] = version_;
+            }
+        }
+        fields_ = fields;
+        return true;
+    }
+
+    // Fields changed after `since` of `epoch`. A field left alone for more than
+    // 32767 versions may be reported again, with its unchanged value.
+    uint8_t ChangedSince(uint8_t epoch, uint16_t since) const {
+        if (epoch != epoch_ || since == 0 || Newer(since, version_)) {
+            return I2C_STATUS_ALL_FIELDS;
+        }
+        uint8_t mask = 0;
+        for (int i = 0; i < I2C_STATUS_FIELD_COUNT; i++) {
+            if (Newer(field_version_[i], since)) {
+                mask |= 1 << i;
+            }
+        }
+        return mask;
+    }
+
+    // Payload of the kI2cFrameStatusDeltaReply to a request
+    void EncodeDelta(const I2cFrame& request, I2cFrame& reply) const {
+        uint8_t mask = ChangedSince(request.u8(0), request.u16(1));
+        reply.U8(epoch_).U16(version_).U8(mask);
+        if (mask & kI2cStatusFlags) {
+            reply.U8(fields_.flags);
+        }
+        if (mask & kI2cStatusHeartRate) {
+            reply.U16((uint16_t)fields_.heart_rate);
+        }
+        if (mask & kI2cStatusStorage) {
+            reply.U8(fields_.storage);
+        }
+        if (mask & kI2cStatusGamepad) {
+            reply.U8(fields_.gamepad);
+        }
+        if (mask & kI2cStatusBatch) {
+            reply.U8(fields_.batch_id).U8((uint8_t)(fields_.batch_state << 6 | (fields_.batch_done & 0x3F)));
+        }
+    }
+
+    uint8_t epoch() const { return epoch_; }
+    uint16_t version() const { return version_; }
+    const I2cStatusFields& fields() const { return fields_; }
+
+private:
+    uint8_t epoch_;
+    uint16_t version_;
+    uint16_t field_version_[I2C_STATUS_FIELD_COUNT];
+    I2cStatusFields fields_;
+
+    static bool Newer(uint16_t a, uint16_t b) { return (int16_t)(a - b) > 0; }
+};
+
+// Master side: what it holds, and the request for what changed since
+struct I2cStatusView {
+    uint8_t epoch;
+    uint16_t version;
+    I2cStatusFields fields;
+
+    I2cStatusView() : epoch(0), version(0) {}
+
+    // Forget everything, the next reply carries every field
+    void Reset() {
+        epoch = 0;
+        version = 0;
+    }
+
+    void BuildRequest(I2cFrame& request) const { request.U8(epoch).U16(version); }
+
+    // Applies a kI2cFrameStatusDeltaReply, returns the mask of fields whose
+    // value changed
+    uint8_t Apply(const I2cFrame& reply) {
+        uint8_t mask = reply.u8(3);
+        I2cStatusFields next = fields;
+        size_t offset = 4;
+        if (mask & kI2cStatusFlags) {
+            next.flags = reply.u8(offset);
+            offset += 1;
+        }
+        if (mask & kI2cStatusHeartRate) {
+            next.heart_rate = (int16_t)reply.u16(offset);
+            offset += 2;
+        }
+        if (mask & kI2cStatusStorage) {
+            next.storage = reply.u8(offset);
+            offset += 1;
+        }
+        if (mask & kI2cStatusGamepad) {
+            next.gamepad = reply.u8(offset);
+            offset += 1;
+        }
+        if (mask & kI2cStatusBatch) {
+            next.batch_id = reply.u8(offset);
+            next.batch_done = reply.u8(offset + 1) & 0x3F;
+            next.batch_state = reply.u8(offset + 1) >> 6;
+        }
+        uint8_t changed = fields.Diff(next);
+        if (epoch != reply.u8(0)) {
+            changed = I2C_STATUS_ALL_FIELDS;
+        }
+        epoch = reply.u8(0);
+        version = reply.u16(1);
+        fields = next;
+        return changed;
+    }
+};
+
+/*
+ * Poll interval while nothing signals changes: back to min_ms after a poll
+ * that found one, doubling up to max_ms while polls come back empty.
+ */
+class I2cStatusPollInterval {
+public:
+    I2cStatusPollInterval(uint32_t min_ms, uint32_t max_ms)
+        : min_ms_(min_ms), max_ms_(max_ms > min_ms ? max_ms : min_ms), current_ms_(min_ms) {}
+
+    uint32_t Next(bool changed) {
+        if (changed) {
+            current_ms_ = min_ms_;
+        } else {
+            current_ms_ = current_ms_ * 2 > max_ms_ ? max_ms_ : current_ms_ * 2;
+        }
+        return current_ms_;
+    }
+
+    uint32_t current() const { return current_ms_; }
+
+private:
+    uint32_t min_ms_;
+    uint32_t max_ms_;
+    uint32_t current_ms_;
+};
+
+#endif // I2C_STATUS_DELTA_H
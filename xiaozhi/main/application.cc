@@ -4,23 +4,42 @@
 #include "assets/lang_config.h"
 #include "audio_codec.h"
 #include "board.h"
+#include "boot_sequence.h"
 #include "display.h"
 #include "mcp_server.h"
 #include "mqtt_protocol.h"
 #include "settings.h"
 #include "system_info.h"
+#include "telemetry.h"
 #include "websocket_protocol.h"
 
 #include <arpa/inet.h>
 #include <cJSON.h>
 #include <cstring>
 #include <driver/gpio.h>
+#include <esp_heap_caps.h>
 #include <esp_log.h>
+#include <esp_pthread.h>
 #include <font_awesome.h>
 #include <wifi_station.h>
 
 #define TAG "Application"
 
+// Boot steps run on pthreads; the version check needs room for TLS
+#define BOOT_STEP_STACK_SIZE 8192
+
+#if CONFIG_MAIN_LOOP_PROFILING
+#define MAIN_LOOP_PROFILE_EVENT(name) profiler_.BeginEvent(name)
+#define MAIN_LOOP_PROFILE_TASK() profiler_.BeginTask()
+#define MAIN_LOOP_PROFILE_CANCEL() profiler_.Cancel()
+#define MAIN_LOOP_PROFILE_END() profiler_.End()
+#else
+#define MAIN_LOOP_PROFILE_EVENT(name)
+#define MAIN_LOOP_PROFILE_TASK()
+#define MAIN_LOOP_PROFILE_CANCEL()
+#define MAIN_LOOP_PROFILE_END()
+#endif
+
 static const char *const STATE_STRINGS[] = {
     "unknown",    "starting",      "configuring", "idle",
     "connecting", "listening",     "speaking",    "upgrading",
@@ -63,7 +82,6 @@ Application::~Application() {
 
 void Application::CheckAssetsVersion() {
   auto &board = Board::GetInstance();
-  auto display = board.GetDisplay();
   auto &assets = Assets::GetInstance();
 
   if (!assets.partition_valid()) {
@@ -88,16 +106,14 @@ void Application::CheckAssetsVersion() {
     vTaskDelay(pdMS_TO_TICKS(3000));
     SetDeviceState(kDeviceStateUpgrading);
     board.SetPowerSaveMode(false);
-    display->SetChatMessage("system", Lang::Strings::PLEASE_WAIT);
+    display_updater_.SetChatMessage("system", Lang::Strings::PLEASE_WAIT);
 
     bool success = assets.Download(
-        download_url, [display](int progress, size_t speed) -> void {
-          std::thread([display, progress, speed]() {
-            char buffer[32];
-            snprintf(buffer, sizeof(buffer), "%d%% %uKB/s", progress,
-                     speed / 1024);
-            display->SetChatMessage("system", buffer);
-          }).detach();
+        download_url, [this](int progress, size_t speed) -> void {
+          char buffer[32];
+          snprintf(buffer, sizeof(buffer), "%d%% %uKB/s", progress,
+                   speed / 1024);
+          display_updater_.SetChatMessage("system", buffer);
         });
 
     board.SetPowerSaveMode(true);
@@ -113,8 +129,8 @@ void Application::CheckAssetsVersion() {
 
   // Apply assets
   assets.Apply();
-  display->SetChatMessage("system", "");
-  display->SetEmotion("microchip_ai");
+  display_updater_.SetChatMessage("system", "");
+  display_updater_.SetEmotion("microchip_ai");
 }
 
 void Application::CheckNewVersion(Ota &ota) {
@@ -125,8 +141,7 @@ void Application::CheckNewVersion(Ota &ota) {
   auto &board = Board::GetInstance();
   while (true) {
     SetDeviceState(kDeviceStateActivating);
-    auto display = board.GetDisplay();
-    display->SetStatus(Lang::Strings::CHECKING_NEW_VERSION);
+    display_updater_.SetStatus(Lang::Strings::CHECKING_NEW_VERSION);
 
     if (!ota.CheckVersion()) {
       retry_count++;
@@ -171,7 +186,7 @@ void Application::CheckNewVersion(Ota &ota) {
       break;
     }
 
-    display->SetStatus(Lang::Strings::ACTIVATION);
+    display_updater_.SetStatus(Lang::Strings::ACTIVATION);
     // Activation code is shown to the user and waiting for the user to input
     if (ota.HasActivationCode()) {
       ShowActivationCode(ota.GetActivationCode(), ota.GetActivationMessage());
@@ -231,10 +246,9 @@ void Application::ShowActivationCode(const std::string &code,
 void Application::Alert(const char *status, const char *message,
                         const char *emotion, const std::string_view &sound) {
   ESP_LOGW(TAG, "Alert [%s] %s: %s", emotion, status, message);
-  auto display = Board::GetInstance().GetDisplay();
-  display->SetStatus(status);
-  display->SetEmotion(emotion);
-  display->SetChatMessage("system", message);
+  display_updater_.SetStatus(status);
+  display_updater_.SetEmotion(emotion);
+  display_updater_.SetChatMessage("system", message);
   if (!sound.empty()) {
     audio_service_.PlaySound(sound);
   }
@@ -242,10 +256,9 @@ void Application::Alert(const char *status, const char *message,
 
 void Application::DismissAlert() {
   if (device_state_ == kDeviceStateIdle) {
-    auto display = Board::GetInstance().GetDisplay();
-    display->SetStatus(Lang::Strings::STANDBY);
-    display->SetEmotion("neutral");
-    display->SetChatMessage("system", "");
+    display_updater_.SetStatus(Lang::Strings::STANDBY);
+    display_updater_.SetEmotion("neutral");
+    display_updater_.SetChatMessage("system", "");
   }
 }
 
@@ -281,7 +294,7 @@ void Application::ToggleChatState() {
                                             : kListeningModeRealtime);
     });
   } else if (device_state_ == kDeviceStateSpeaking) {
-    Schedule([this]() { AbortSpeaking(kAbortReasonNone); });
+    Schedule(kTaskLaneRealtime, [this]() { AbortSpeaking(kAbortReasonNone); });
   } else if (device_state_ == kDeviceStateListening) {
     Schedule([this]() { protocol_->CloseAudioChannel(); });
   }
@@ -314,7 +327,7 @@ void Application::StartListening() {
       SetListeningMode(kListeningModeManualStop);
     });
   } else if (device_state_ == kDeviceStateSpeaking) {
-    Schedule([this]() {
+    Schedule(kTaskLaneRealtime, [this]() {
       AbortSpeaking(kAbortReasonNone);
       SetListeningMode(kListeningModeManualStop);
     });
@@ -347,74 +360,19 @@ void Application::StopListening() {
   });
 }
 
-void Application::Start() {
+// Creates the protocol and connects with the saved MQTT config
+bool Application::StartProtocol() {
   auto &board = Board::GetInstance();
-  SetDeviceState(kDeviceStateStarting);
-
-  /* Setup the display */
-  auto display = board.GetDisplay();
-
-  // Print board name/version info
-  display->SetChatMessage("system", SystemInfo::GetUserAgent().c_str());
-
-  /* Setup the audio service */
   auto codec = board.GetAudioCodec();
-  audio_service_.Initialize(codec);
-  audio_service_.Start();
 
-  AudioServiceCallbacks callbacks;
-  callbacks.on_send_queue_available = [this]() {
-    xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_AUDIO);
-  };
-  callbacks.on_wake_word_detected = [this](const std::string &wake_word) {
-    xEventGroupSetBits(event_group_, MAIN_EVENT_WAKE_WORD_DETECTED);
-  };
-  callbacks.on_vad_change = [this](bool speaking) {
-    xEventGroupSetBits(event_group_, MAIN_EVENT_VAD_CHANGE);
-  };
-  audio_service_.SetCallbacks(callbacks);
-
-  // Start the main event loop task with priority 3
-  xTaskCreate(
-      [](void *arg) {
-        ((Application *)arg)->MainEventLoop();
-        vTaskDelete(NULL);
-      },
-      "main_event_loop", 2048 * 4, this, 3, &main_event_loop_task_handle_);
-
-  /* Start the clock timer to update the status bar */
-  esp_timer_start_periodic(clock_timer_handle_, 1000000);
-
-  /* Wait for the network to be ready */
-  board.StartNetwork();
-
-  // Update the status bar immediately to show the network state
-  display->UpdateStatusBar(true);
-
-  // Check for new assets version
-  CheckAssetsVersion();
-
-  // Check for new firmware version or get the MQTT broker address
-  Ota ota;
-  CheckNewVersion(ota);
-
-  // Initialize the protocol
-  display->SetStatus(Lang::Strings::LOADING_PROTOCOL);
+  display_updater_.SetStatus(Lang::Strings::LOADING_PROTOCOL);
 
   // Add MCP common tools before initializing the protocol
   auto &mcp_server = McpServer::GetInstance();
   mcp_server.AddCommonTools();
   mcp_server.AddUserOnlyTools();
 
-  if (ota.HasMqttConfig()) {
-    protocol_ = std::make_unique<MqttProtocol>();
-  } else if (ota.HasWebsocketConfig()) {
-    protocol_ = std::make_unique<WebsocketProtocol>();
-  } else {
-    ESP_LOGW(TAG, "No protocol specified in the OTA config, using MQTT");
-    protocol_ = std::make_unique<MqttProtocol>();
-  }
-
+  // Always MQTT, the websocket config from OTA is not used on this device
   protocol_ = std::make_unique<MqttProtocol>();
 
   protocol_->OnConnected([this]() { DismissAlert(); });
@@ -439,19 +397,18 @@ void Application::Start() {
   });
   protocol_->OnAudioChannelClosed([this, &board]() {
     board.SetPowerSaveMode(true);
-    Schedule([this]() {
-      auto display = Board::GetInstance().GetDisplay();
-      display->SetChatMessage("system", "");
+    Schedule(kTaskLaneRealtime, [this]() {
+      display_updater_.SetChatMessage("system", "");
       SetDeviceState(kDeviceStateIdle);
     });
   });
-  protocol_->OnIncomingJson([this, display](const cJSON *root) {
+  protocol_->OnIncomingJson([this](const cJSON *root) {
     // Parse JSON data
     auto type = cJSON_GetObjectItem(root, "type");
     if (strcmp(type->valuestring, "tts") == 0) {
       auto state = cJSON_GetObjectItem(root, "state");
       if (strcmp(state->valuestring, "start") == 0) {
-        Schedule([this]() {
+        Schedule(kTaskLaneRealtime, [this]() {
           aborted_ = false;
           if (device_state_ == kDeviceStateIdle ||
               device_state_ == kDeviceStateListening) {
@@ -459,7 +416,7 @@ void Application::Start() {
           }
         });
       } else if (strcmp(state->valuestring, "stop") == 0) {
-        Schedule([this]() {
+        Schedule(kTaskLaneRealtime, [this]() {
           if (device_state_ == kDeviceStateSpeaking) {
             if (listening_mode_ == kListeningModeManualStop) {
               SetDeviceState(kDeviceStateIdle);
@@ -472,30 +429,24 @@ void Application::Start() {
         auto text = cJSON_GetObjectItem(root, "text");
         if (cJSON_IsString(text)) {
           ESP_LOGI(TAG, "<< %s", text->valuestring);
-          Schedule([this, display, message = std::string(text->valuestring)]() {
-            display->SetChatMessage("assistant", message.c_str());
-          });
+          display_updater_.SetChatMessage("assistant", text->valuestring);
         }
       }
     } else if (strcmp(type->valuestring, "stt") == 0) {
       auto text = cJSON_GetObjectItem(root, "text");
       if (cJSON_IsString(text)) {
         ESP_LOGI(TAG, ">> %s", text->valuestring);
-        Schedule([this, display, message = std::string(text->valuestring)]() {
-          display->SetChatMessage("user", message.c_str());
-        });
+        display_updater_.SetChatMessage("user", text->valuestring);
       }
     } else if (strcmp(type->valuestring, "llm") == 0) {
       auto emotion = cJSON_GetObjectItem(root, "emotion");
       if (cJSON_IsString(emotion)) {
-        Schedule(
-            [this, display, emotion_str = std::string(emotion->valuestring)]() {
-              display->SetEmotion(emotion_str.c_str());
-            });
+        display_updater_.SetEmotion(emotion->valuestring);
       }
     } else if (strcmp(type->valuestring, "mcp") == 0) {
       auto payload = cJSON_GetObjectItem(root, "payload");
-      if (cJSON_IsObject(payload)) {
+      // An array is a JSON-RPC batch
+      if (cJSON_IsObject(payload) || cJSON_IsArray(payload)) {
         McpServer::GetInstance().ParseMessage(payload);
       }
     } else if (strcmp(type->valuestring, "system") == 0) {
@@ -526,11 +477,9 @@ void Application::Start() {
       ESP_LOGI(TAG, "Received custom message: %s",
                cJSON_PrintUnformatted(root));
       if (cJSON_IsObject(payload)) {
-        Schedule(
-            [this, display,
-             payload_str = std::string(cJSON_PrintUnformatted(payload))]() {
-              display->SetChatMessage("system", payload_str.c_str());
-            });
+        char *payload_str = cJSON_PrintUnformatted(payload);
+        display_updater_.SetChatMessage("system", payload_str);
+        cJSON_free(payload_str);
       } else {
         ESP_LOGW(TAG, "Invalid custom message format: missing payload");
       }
@@ -539,7 +488,104 @@ void Application::Start() {
       ESP_LOGW(TAG, "Unknown message type: %s", type->valuestring);
     }
   });
-  bool protocol_started = protocol_->Start();
+  return protocol_->Start();
+}
+
+void Application::Start() {
+  auto &board = Board::GetInstance();
+
+  /* Setup the display */
+  auto display = board.GetDisplay();
+  display_updater_.Start(display);
+  SetDeviceState(kDeviceStateStarting);
+
+  // Print board name/version info
+  display_updater_.SetChatMessage("system", SystemInfo::GetUserAgent().c_str());
+
+  // A pending assets download shares the network with the version check and
+  // changes the device state, so it keeps the old serial order
+  bool assets_download_pending =
+      !Settings("assets").GetString("download_url").empty();
+
+  // Start the main event loop task with priority 3. It only waits for events
+  // until the audio step installs the audio callbacks.
+  xTaskCreate(
+      [](void *arg) {
+        ((Application *)arg)->MainEventLoop();
+        vTaskDelete(NULL);
+      },
+      "main_event_loop", 2048 * 4, this, 3, &main_event_loop_task_handle_);
+#if CONFIG_MAIN_LOOP_PROFILING
+  profiler_.Start();
+#endif
+
+  // Boot steps start as soon as their dependencies are done
+  BootSequence boot;
+  Ota ota;
+  bool protocol_started = false;
+
+  boot.AddStep("audio", {}, [this]() {
+    auto codec = Board::GetInstance().GetAudioCodec();
+    audio_service_.Initialize(codec);
+    audio_service_.Start();
+
+    AudioServiceCallbacks callbacks;
+    callbacks.on_send_queue_available = [this]() {
+      xEventGroupSetBits(event_group_, MAIN_EVENT_SEND_AUDIO);
+    };
+    callbacks.on_wake_word_detected = [this](const std::string &wake_word) {
+      xEventGroupSetBits(event_group_, MAIN_EVENT_WAKE_WORD_DETECTED);
+    };
+    callbacks.on_vad_change = [this](bool speaking) {
+      xEventGroupSetBits(event_group_, MAIN_EVENT_VAD_CHANGE);
+    };
+    audio_service_.SetCallbacks(callbacks);
+
+    /* Start the clock timer to update the status bar */
+    esp_timer_start_periodic(clock_timer_handle_, 1000000);
+  });
+
+  /* Wait for the network to be ready */
+  boot.AddStep("network", {}, [&board, display]() {
+    board.StartNetwork();
+    // Update the status bar immediately to show the network state
+    display->UpdateStatusBar(true);
+  });
+
+  // The assets constructor verifies the partition checksum
+  boot.AddStep("assets_verify", {}, []() { Assets::GetInstance(); });
+
+  // Check for new firmware version or get the MQTT broker address
+  if (assets_download_pending) {
+    boot.AddStep("assets", {"assets_verify", "audio", "network"},
+                 [this]() { CheckAssetsVersion(); });
+    boot.AddStep("ota", {"assets"}, [this, &ota]() { CheckNewVersion(ota); });
+  } else {
+    // Applying assets loads the wake word models into the audio service
+    boot.AddStep("assets", {"assets_verify", "audio"},
+                 [this]() { CheckAssetsVersion(); });
+    boot.AddStep("ota", {"network", "audio"},
+                 [this, &ota]() { CheckNewVersion(ota); });
+  }
+
+  // The version check sets the device state, shows alerts and writes the
+  // MQTT config the protocol connects with, so the two never overlap
+  boot.AddStep("protocol", {"ota"}, [this, &protocol_started]() {
+    protocol_started = StartProtocol();
+  });
+
+  esp_pthread_cfg_t boot_cfg = esp_pthread_get_default_config();
+  boot_cfg.stack_size = BOOT_STEP_STACK_SIZE;
+  boot_cfg.thread_name = "boot";
+  esp_pthread_set_cfg(&boot_cfg);
+  boot.Run();
+  esp_pthread_cfg_t default_cfg = esp_pthread_get_default_config();
+  esp_pthread_set_cfg(&default_cfg);
+
+  ESP_LOGI(TAG, "Boot steps done in %d ms", boot.total_ms());
+  for (auto &line : boot.Timeline()) {
+    ESP_LOGI(TAG, "%s", line.c_str());
+  }
 
   SystemInfo::PrintHeapStats();
   SetDeviceState(kDeviceStateIdle);
@@ -549,7 +595,7 @@ void Application::Start() {
     std::string message =
         std::string(Lang::Strings::VERSION) + ota.GetCurrentVersion();
     display->ShowNotification(message.c_str());
-    display->SetChatMessage("system", "");
+    display_updater_.SetChatMessage("system", "");
     // Play the success sound to indicate the device is ready
     audio_service_.PlaySound(Lang::Sounds::OGG_SUCCESS);
   }
@@ -591,17 +637,32 @@ void Application::Start() {
           // Lưu actuator status và heartrate info vào Application instance
           if (user_data) {
             auto *app = static_cast<Application *>(user_data);
-            app->last_actuator_status_ = status; // Lưu toàn bộ status
-            app->heartrate_info_ =
+            std::string heartrate_info =
                 "{ \"ble_connected\": " + std::to_string(status.ble_connected) +
                 ", \"heart_rate\": " + std::to_string(status.heart_rate) + " }";
+            std::lock_guard<std::mutex> lock(app->actuator_mutex_);
+            app->last_actuator_status_ = status; // Lưu toàn bộ status
+            app->heartrate_info_ = std::move(heartrate_info);
           }
         },
         this); // Pass 'this' as user_data
 
-    // Bật polling để tự động nhận status mỗi 2 giây
-    if (i2c_bridge.StartStatusPolling(2000)) {
-      ESP_LOGI(TAG, "✅ I2C status polling started (interval: 2s)");
+    // Actuator mất kết nối: không trả heart rate cũ nữa
+    i2c_bridge.SetLivenessCallback(
+        [](bool online, void *user_data) {
+          if (!online && user_data) {
+            auto *app = static_cast<Application *>(user_data);
+            std::lock_guard<std::mutex> lock(app->actuator_mutex_);
+            app->heartrate_info_ =
+                "{ \"ble_connected\": 0, \"heart_rate\": 0 }";
+          }
+        },
+        this);
+
+    // Bật polling status: 250 ms sau thay đổi, tối đa 4 giây khi không có gì mới
+    // (dưới ACTUATOR_IDLE_PROBE_MS nên không cần probe liveness riêng)
+    if (i2c_bridge.StartStatusPolling(4000)) {
+      ESP_LOGI(TAG, "✅ I2C status polling started (max interval: 4s)");
     } else {
       ESP_LOGW(TAG, "⚠️  Failed to start status polling");
     }
@@ -609,17 +670,12 @@ void Application::Start() {
 
   InitializeTelegramBot();
 }
-std::string Application::getHeartRate() { return heartrate_info_; }
-
-// Add a async task to MainLoop
-void Application::Schedule(std::function<void()> callback) {
-  {
-    std::lock_guard<std::mutex> lock(mutex_);
-    main_tasks_.push_back(std::move(callback));
-  }
-  xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
+std::string Application::getHeartRate() {
+  std::lock_guard<std::mutex> lock(actuator_mutex_);
+  return heartrate_info_;
 }
 
+// Add a async task to MainLoop
 // The Main Event Loop controls the chat state and websocket connection
 // If other tasks need to access the websocket or chat state,
 // they should use Schedule to call this function
@@ -633,12 +689,15 @@ void Application::MainEventLoop() {
         pdTRUE, pdFALSE, portMAX_DELAY);
 
     if (bits & MAIN_EVENT_ERROR) {
+      MAIN_LOOP_PROFILE_EVENT("event:error");
       SetDeviceState(kDeviceStateIdle);
       Alert(Lang::Strings::ERROR, last_error_message_.c_str(), "circle_xmark",
             Lang::Sounds::OGG_EXCLAMATION);
+      MAIN_LOOP_PROFILE_END();
     }
 
     if (bits & MAIN_EVENT_SEND_AUDIO) {
+      MAIN_LOOP_PROFILE_EVENT("event:send_audio");
       while (auto packet = audio_service_.PopPacketFromSendQueue()) {
         ESP_LOGD(TAG, "Sending audio packet, size()");
         if (protocol_ && !protocol_->SendAudio(std::move(packet))) {
@@ -646,43 +705,107 @@ void Application::MainEventLoop() {
           break;
         }
       }
+      MAIN_LOOP_PROFILE_END();
     }
 
     if (bits & MAIN_EVENT_WAKE_WORD_DETECTED) {
+      MAIN_LOOP_PROFILE_EVENT("event:wake_word");
       OnWakeWordDetected();
+      MAIN_LOOP_PROFILE_END();
     }
 
     if (bits & MAIN_EVENT_VAD_CHANGE) {
+      MAIN_LOOP_PROFILE_EVENT("event:vad_change");
       if (device_state_ == kDeviceStateListening) {
         auto led = Board::GetInstance().GetLed();
         led->OnStateChanged();
       }
+      MAIN_LOOP_PROFILE_END();
     }
 
     if (bits & MAIN_EVENT_SCHEDULE) {
-      std::unique_lock<std::mutex> lock(mutex_);
-      auto tasks = std::move(main_tasks_);
-      lock.unlock();
-      for (auto &task : tasks) {
-        task();
+      int count = 0;
+      while (count < MAIN_TASK_BATCH_SIZE) {
+        MAIN_LOOP_PROFILE_TASK();
+        if (!main_tasks_.RunNext(esp_timer_get_time())) {
+          MAIN_LOOP_PROFILE_CANCEL();
+          break;
+        }
+        MAIN_LOOP_PROFILE_END();
+        count++;
+      }
+      if (count == MAIN_TASK_BATCH_SIZE) {
+        // More may be pending, come back after the other events
+        xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
       }
     }
 
     if (bits & MAIN_EVENT_CLOCK_TICK) {
+      MAIN_LOOP_PROFILE_EVENT("event:clock_tick");
       clock_ticks_++;
       auto display = Board::GetInstance().GetDisplay();
       display->UpdateStatusBar();
+      RecordTelemetry();
 
       // Print the debug info every 10 seconds
       if (clock_ticks_ % 10 == 0) {
         // SystemInfo::PrintTaskCpuUsage(pdMS_TO_TICKS(1000));
         // SystemInfo::PrintTaskList();
         SystemInfo::PrintHeapStats();
+        PrintTaskLaneStats();
+        display_updater_.LogStats();
       }
+      MAIN_LOOP_PROFILE_END();
     }
   }
 }
 
+void Application::PrintTaskLaneStats() {
+  static const char *const kLaneNames[kTaskLaneCount] = {"realtime", "normal",
+                                                         "background"};
+  for (int lane = 0; lane < kTaskLaneCount; lane++) {
+    auto stats = main_tasks_.stats((TaskLane)lane);
+    if (stats.run == 0) {
+      continue;
+    }
+    auto &h = stats.wait_histogram;
+    ESP_LOGI(TAG,
+             "Lane %s: depth %lu run %lu missed %lu max wait %lu us, "
+             "wait <1/<5/<20/<100/<500/>500 ms: %lu/%lu/%lu/%lu/%lu/%lu",
+             kLaneNames[lane], stats.depth, stats.run, stats.deadline_misses,
+             stats.max_wait_us, h[0], h[1], h[2], h[3], h[4], h[5]);
+  }
+}
+
+void Application::RecordTelemetry() {
+  auto &telemetry = Telemetry::GetInstance();
+  telemetry.Record(kTelemetryHeapFree,
+                   heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024);
+  telemetry.Record(kTelemetryHeapMinFree,
+                   heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL) / 1024);
+  int cpu_load = SystemInfo::GetCpuLoad();
+  if (cpu_load >= 0) {
+    telemetry.Record(kTelemetryCpuLoad, cpu_load);
+  }
+
+  auto &wifi_station = WifiStation::GetInstance();
+  if (wifi_station.IsConnected()) {
+    telemetry.Record(kTelemetryWifiRssi, wifi_station.GetRssi());
+  }
+  int battery_level;
+  bool charging, discharging;
+  if (Board::GetInstance().GetBatteryLevel(battery_level, charging,
+                                           discharging)) {
+    telemetry.Record(kTelemetryBattery, battery_level);
+  }
+
+  uint32_t queue_depth = 0;
+  for (int lane = 0; lane < kTaskLaneCount; lane++) {
+    queue_depth += main_tasks_.stats((TaskLane)lane).depth;
+  }
+  telemetry.Record(kTelemetryQueueDepth, queue_depth);
+}
+
 void Application::OnWakeWordDetected() {
   if (!protocol_) {
     return;
@@ -702,9 +825,10 @@ void Application::OnWakeWordDetected() {
     auto wake_word = audio_service_.GetLastWakeWord();
     ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
 #if CONFIG_SEND_WAKE_WORD_DATA
-    // Encode and send the wake word data to the server
+    // Encode and send the wake word data to the server, all of it: the
+    // server verifies the wake word from the start of the preroll
     while (auto packet = audio_service_.PopWakeWordPacket()) {
-      protocol_->SendAudio(std::move(packet));
+      protocol_->SendAudio(std::move(packet), true);
     }
     // Set the chat state to wake word detected
     protocol_->SendWakeWordDetected(wake_word);
@@ -751,7 +875,6 @@ void Application::SetDeviceState(DeviceState state) {
                                                               state);
 
   auto &board = Board::GetInstance();
-  auto display = board.GetDisplay();
   auto led = board.GetLed();
   led->OnStateChanged();
 
@@ -767,19 +890,19 @@ void Application::SetDeviceState(DeviceState state) {
   switch (state) {
   case kDeviceStateUnknown:
   case kDeviceStateIdle:
-    display->SetStatus(Lang::Strings::STANDBY);
-    display->SetEmotion("neutral");
+    display_updater_.SetStatus(Lang::Strings::STANDBY);
+    display_updater_.SetEmotion("neutral");
     audio_service_.EnableVoiceProcessing(false);
     audio_service_.EnableWakeWordDetection(true);
     break;
   case kDeviceStateConnecting:
-    display->SetStatus(Lang::Strings::CONNECTING);
-    display->SetEmotion("neutral");
-    display->SetChatMessage("system", "");
+    display_updater_.SetStatus(Lang::Strings::CONNECTING);
+    display_updater_.SetEmotion("neutral");
+    display_updater_.SetChatMessage("system", "");
     break;
   case kDeviceStateListening:
-    display->SetStatus(Lang::Strings::LISTENING);
-    display->SetEmotion("neutral");
+    display_updater_.SetStatus(Lang::Strings::LISTENING);
+    display_updater_.SetEmotion("neutral");
 
     // Make sure the audio processor is running
     if (!audio_service_.IsAudioProcessorRunning()) {
@@ -790,7 +913,7 @@ void Application::SetDeviceState(DeviceState state) {
     }
     break;
   case kDeviceStateSpeaking:
-    display->SetStatus(Lang::Strings::SPEAKING);
+    display_updater_.SetStatus(Lang::Strings::SPEAKING);
 
     if (listening_mode_ != kListeningModeRealtime) {
       audio_service_.EnableVoiceProcessing(false);
@@ -820,7 +943,6 @@ void Application::Reboot() {
 
 bool Application::UpgradeFirmware(Ota &ota, const std::string &url) {
   auto &board = Board::GetInstance();
-  auto display = board.GetDisplay();
 
   // Use provided URL or get from OTA object
   std::string upgrade_url = url.empty() ? ota.GetFirmwareUrl() : url;
@@ -841,20 +963,18 @@ bool Application::UpgradeFirmware(Ota &ota, const std::string &url) {
   SetDeviceState(kDeviceStateUpgrading);
 
   std::string message = std::string(Lang::Strings::NEW_VERSION) + version_info;
-  display->SetChatMessage("system", message.c_str());
+  display_updater_.SetChatMessage("system", message.c_str());
 
   board.SetPowerSaveMode(false);
   audio_service_.Stop();
   vTaskDelay(pdMS_TO_TICKS(1000));
 
   bool upgrade_success = ota.StartUpgradeFromUrl(
-      upgrade_url, [display](int progress, size_t speed) {
-        std::thread([display, progress, speed]() {
-          char buffer[32];
-          snprintf(buffer, sizeof(buffer), "%d%% %uKB/s", progress,
-                   speed / 1024);
-          display->SetChatMessage("system", buffer);
-        }).detach();
+      upgrade_url, [this](int progress, size_t speed) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%d%% %uKB/s", progress,
+                 speed / 1024);
+        display_updater_.SetChatMessage("system", buffer);
       });
 
   if (!upgrade_success) {
@@ -870,7 +990,7 @@ bool Application::UpgradeFirmware(Ota &ota, const std::string &url) {
   } else {
     // Upgrade success, reboot immediately
     ESP_LOGI(TAG, "Firmware upgrade successful, rebooting...");
-    display->SetChatMessage("system", "Upgrade successful, rebooting...");
+    display_updater_.SetChatMessage("system", "Upgrade successful, rebooting...");
     vTaskDelay(pdMS_TO_TICKS(1000)); // Brief pause to show message
     Reboot();
     return true;
@@ -886,7 +1006,7 @@ void Application::WakeWordInvoke(const std::string &wake_word) {
       }
     });
   } else if (device_state_ == kDeviceStateSpeaking) {
-    Schedule([this]() { AbortSpeaking(kAbortReasonNone); });
+    Schedule(kTaskLaneRealtime, [this]() { AbortSpeaking(kAbortReasonNone); });
   } else if (device_state_ == kDeviceStateListening) {
     Schedule([this]() {
       if (protocol_) {
@@ -918,14 +1038,18 @@ void Application::SendMcpMessage(const std::string &payload) {
     return;
   }
 
-  // Make sure you are using main thread to send MCP message
-  if (xTaskGetCurrentTaskHandle() == main_event_loop_task_handle_) {
-    protocol_->SendMcpMessage(payload);
-  } else {
-    Schedule([this, payload = std::move(payload)]() {
-      protocol_->SendMcpMessage(payload);
-    });
+  // The protocol only queues the message on its send scheduler, so MCP
+  // workers reply from their own task without a hop through the main loop
+  protocol_->SendMcpMessage(payload);
+}
+
+void Application::SendMcpMessage(
+    size_t payload_size,
+    const std::function<void(JsonWriter &)> &write_payload) {
+  if (protocol_ == nullptr) {
+    return;
   }
+  protocol_->SendMcpMessage(payload_size, write_payload);
 }
 
 void Application::SetAecMode(AecMode mode) {
@@ -1171,7 +1295,7 @@ static void SensorReportingTask(void *param) {
     report = "📊 **Báo cáo cảm biến**\n\n";
 
     // Lấy actuator status qua getter
-    const ActuatorStatus& status = app->GetLastActuatorStatus();
+    ActuatorStatus status = app->GetLastActuatorStatus();
 
     // 1. Heart rate & BLE từ actuator
     report += "❤️ **Nhịp tim**: ";
@@ -13,8 +13,11 @@
 
 #include "audio_service.h"
 #include "device_state_event.h"
+#include "display_updater.h"
 #include "ota.h"
 #include "protocol.h"
+#include "task_scheduler.h"
+#include "main_loop_profiler.h"
 
 #include "RecurringSchedule.h"
 #include "StorageManager.h"
@@ -30,6 +33,9 @@
 #define MAIN_EVENT_CHECK_NEW_VERSION_DONE (1 << 5)
 #define MAIN_EVENT_CLOCK_TICK (1 << 6)
 
+// Scheduled tasks run per loop iteration before other events get a turn
+#define MAIN_TASK_BATCH_SIZE 16
+
 enum AecMode {
   kAecOff,
   kAecOnDeviceSide,
@@ -50,7 +56,25 @@ public:
   void MainEventLoop();
   DeviceState GetDeviceState() const { return device_state_; }
   bool IsVoiceDetected() const { return audio_service_.IsVoiceDetected(); }
-  void Schedule(std::function<void()> callback);
+  // Lock-free, captures up to TASK_INLINE_SIZE bytes are posted without allocating
+  template <typename F>
+  void Schedule(F &&callback, TaskSource source = TaskSource::Here()) {
+    Schedule(kTaskLaneNormal, std::forward<F>(callback), 0, source);
+  }
+  // deadline_ms 0 uses the lane default, see kTaskLaneDeadlineMs
+  template <typename F>
+  void Schedule(TaskLane lane, F &&callback, uint32_t deadline_ms = 0,
+                TaskSource source = TaskSource::Here()) {
+    main_tasks_.Post(lane, std::forward<F>(callback), esp_timer_get_time(),
+                     deadline_ms, source);
+    xEventGroupSetBits(event_group_, MAIN_EVENT_SCHEDULE);
+  }
+  TaskLaneStats GetTaskLaneStats(TaskLane lane) const {
+    return main_tasks_.stats(lane);
+  }
+#if CONFIG_MAIN_LOOP_PROFILING
+  std::string GetMainLoopStatsJson() { return profiler_.GetStatsJson(); }
+#endif
   void SetDeviceState(DeviceState state);
   void Alert(const char *status, const char *message, const char *emotion = "",
              const std::string_view &sound = "");
@@ -64,6 +88,9 @@ public:
   bool UpgradeFirmware(Ota &ota, const std::string &url = "");
   bool CanEnterSleepMode();
   void SendMcpMessage(const std::string &payload);
+  // payload_size bounds what write_payload adds, see Protocol::SendMcpMessage
+  void SendMcpMessage(size_t payload_size,
+                      const std::function<void(JsonWriter &)> &write_payload);
   void SetAecMode(AecMode mode);
   AecMode GetAecMode() const { return aec_mode_; }
   void PlaySound(const std::string_view &sound);
@@ -78,7 +105,10 @@ public:
   void SendTextCommandToServer(const std::string &text);
 
   std::string getHeartRate();
-  const ActuatorStatus& GetLastActuatorStatus() const { return last_actuator_status_; }
+  ActuatorStatus GetLastActuatorStatus() const {
+    std::lock_guard<std::mutex> lock(actuator_mutex_);
+    return last_actuator_status_;
+  }
   
   // Sensor data reporting to Telegram
   bool StartSensorReporting(uint32_t interval_seconds);
@@ -148,8 +178,11 @@ private:
   Application();
   ~Application();
 
-  std::mutex mutex_;
-  std::deque<std::function<void()>> main_tasks_;
+  TaskScheduler main_tasks_;
+#if CONFIG_MAIN_LOOP_PROFILING
+  MainLoopProfiler profiler_{main_tasks_};
+#endif
+  DisplayUpdater display_updater_;
   std::unique_ptr<Protocol> protocol_;
   EventGroupHandle_t event_group_ = nullptr;
   esp_timer_handle_t clock_timer_handle_ = nullptr;
@@ -159,6 +192,8 @@ private:
   std::string last_error_message_;
   AudioService audio_service_;
 
+  // Written from the I2C bus task (status / liveness callbacks)
+  mutable std::mutex actuator_mutex_;
   std::string heartrate_info_;
   ActuatorStatus last_actuator_status_;
 
@@ -179,8 +214,11 @@ private:
   TaskHandle_t main_event_loop_task_handle_ = nullptr;
 
   void OnWakeWordDetected();
+  void PrintTaskLaneStats();
+  void RecordTelemetry();
   void CheckNewVersion(Ota &ota);
   void CheckAssetsVersion();
+  bool StartProtocol();
   void ShowActivationCode(const std::string &code, const std::string &message);
   void SetListeningMode(ListeningMode mode);
 
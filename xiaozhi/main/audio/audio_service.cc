@@ -1,4 +1,5 @@
 #include "audio_service.h"
+#include "telemetry.h"
 #include <esp_log.h>
 #include <cstring>
 
@@ -647,6 +648,8 @@ void AudioService::CheckAndUpdateAudioPowerState() {
     if (!codec_->input_enabled() && !codec_->output_enabled()) {
         esp_timer_stop(audio_power_timer_);
     }
+    Telemetry::GetInstance().Record(kTelemetryAudioPower,
+        (codec_->input_enabled() ? 1 : 0) | (codec_->output_enabled() ? 2 : 0));
 }
 
 void AudioService::SetModelsList(srmodel_list_t* models_list) {
@@ -0,0 +1,157 @@
+#ifndef BOOT_SEQUENCE_H
+#define BOOT_SEQUENCE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Width of the bar drawn per step in the timeline
+#define BOOT_TIMELINE_WIDTH 40
+
+/*
+ * Boot steps as a dependency graph.
+ * Each step starts on its own thread as soon as every step it depends on has
+ * finished, so independent network round trips overlap instead of adding up.
+ * Run() blocks until all steps are done. Start and end of each step are
+ * recorded for Timeline(). Plain std::thread, so the class also builds on
+ * the host; on the device the caller sets the pthread stack with
+ * esp_pthread_set_cfg() before Run().
+ */
+class BootSequence {
+public:
+    BootSequence() : origin_(Clock::now()) {}
+
+    // Dependencies must be added before the steps that name them, an unknown
+    // name is a programming error and aborts rather than running the step early
+    void AddStep(const char* name, std::initializer_list<const char*> after, std::function<void()> body) {
+        Step step;
+        step.name = name;
+        step.body = std::move(body);
+        for (auto dependency : after) {
+            int index = Find(dependency);
+            if (index < 0) {
+                fprintf(stderr, "BootSequence: step %s depends on unknown step %s\n", name, dependency);
+                abort();
+            }
+            step.after.push_back(index);
+        }
+        steps_.push_back(std::move(step));
+    }
+
+    void Run() {
+        std::vector<std::thread> threads;
+        std::unique_lock<std::mutex> lock(mutex_);
+        size_t finished = 0;
+        while (finished < steps_.size()) {
+            for (size_t i = 0; i < steps_.size(); i++) {
+                if (!steps_[i].started && Ready(steps_[i])) {
+                    steps_[i].started = true;
+                    threads.emplace_back([this, i]() { RunStep(i); });
+                }
+            }
+            condition_.wait(lock, [this, finished]() { return finished_count_ > finished; });
+            finished = finished_count_;
+        }
+        lock.unlock();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Milliseconds since the sequence was created until the last step ended
+    int total_ms() const {
+        int64_t end_us = 0;
+        for (auto& step : steps_) {
+            if (step.end_us > end_us) {
+                end_us = step.end_us;
+            }
+        }
+        return end_us / 1000;
+    }
+
+    // One line per step: start, end and a bar on a common time axis
+    std::vector<std::string> Timeline() const {
+        std::vector<std::string> lines;
+        int64_t total_us = total_ms() * 1000;
+        if (total_us <= 0) {
+            total_us = 1;
+        }
+        char line[128];
+        for (auto& step : steps_) {
+            char bar[BOOT_TIMELINE_WIDTH + 1];
+            int from = step.start_us * BOOT_TIMELINE_WIDTH / total_us;
+            int to = step.end_us * BOOT_TIMELINE_WIDTH / total_us;
+            for (int i = 0; i < BOOT_TIMELINE_WIDTH; i++) {
+                bar[i] = (i >= from && (i < to || i == from)) ? '#' : '.';
+            }
+            bar[BOOT_TIMELINE_WIDTH] = '\0';
+            snprintf(line, sizeof(line), "%-14s %6d .. %6d ms %s", step.name, (int)(step.start_us / 1000),
+                (int)(step.end_us / 1000), bar);
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Step {
+        const char* name;
+        std::vector<int> after;
+        std::function<void()> body;
+        bool started = false;
+        bool finished = false;
+        int64_t start_us = 0;
+        int64_t end_us = 0;
+    };
+
+    Clock::time_point origin_;
+    std::vector<Step> steps_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    size_t finished_count_ = 0;
+
+    int Find(const char* name) const {
+        for (size_t i = 0; i < steps_.size(); i++) {
+            if (strcmp(steps_[i].name, name) == 0) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    bool Ready(const Step& step) const {
+        for (int index : step.after) {
+            if (!steps_[index].finished) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int64_t Elapsed() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - origin_).count();
+    }
+
+    void RunStep(size_t index) {
+        Step& step = steps_[index];
+        step.start_us = Elapsed();
+        step.body();
+        std::lock_guard<std::mutex> lock(mutex_);
+        step.end_us = Elapsed();
+        step.finished = true;
+        finished_count_++;
+        condition_.notify_all();
+    }
+};
+
+#endif // BOOT_SEQUENCE_H
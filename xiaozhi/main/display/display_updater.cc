@@ -0,0 +1,146 @@
+#include "display_updater.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#define TAG "DisplayUpdater"
+
+DisplayUpdater::~DisplayUpdater() {
+    if (task_handle_ != nullptr) {
+        vTaskDelete(task_handle_);
+    }
+}
+
+void DisplayUpdater::Start(Display* display) {
+    display_ = display;
+    xTaskCreate([](void* arg) {
+        DisplayUpdater* updater = (DisplayUpdater*)arg;
+        updater->UpdateTask();
+        vTaskDelete(NULL);
+    }, "display_update", 4096 * 2, this, 1, &task_handle_);
+    Notify();
+}
+
+void DisplayUpdater::Notify() {
+    if (task_handle_ != nullptr) {
+        xTaskNotifyGive(task_handle_);
+    }
+}
+
+void DisplayUpdater::SetStatus(const char* status) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.posted++;
+        if (status_pending_) {
+            stats_.coalesced++;
+        }
+        status_ = status;
+        status_pending_ = true;
+    }
+    Notify();
+}
+
+void DisplayUpdater::SetEmotion(const char* emotion) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.posted++;
+        if (emotion_pending_) {
+            stats_.coalesced++;
+        }
+        emotion_ = emotion;
+        emotion_pending_ = true;
+    }
+    Notify();
+}
+
+void DisplayUpdater::SetChatMessage(const char* role, const char* content) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.posted++;
+        chat_messages_.push_back({role, content});
+    }
+    Notify();
+}
+
+void DisplayUpdater::UpdateTask() {
+    int64_t last_flush_time = 0;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Let updates arriving within the frame interval pile up
+        int64_t wait_us = last_flush_time + DISPLAY_UPDATE_INTERVAL_MS * 1000 - esp_timer_get_time();
+        if (wait_us > 0) {
+            vTaskDelay(pdMS_TO_TICKS(wait_us / 1000) + 1);
+        }
+        last_flush_time = esp_timer_get_time();
+        Flush();
+    }
+}
+
+void DisplayUpdater::Flush() {
+    bool status_pending, emotion_pending;
+    std::string status, emotion;
+    std::deque<ChatMessage> chat_messages;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_pending = status_pending_;
+        emotion_pending = emotion_pending_;
+        status_.swap(status);
+        emotion_.swap(emotion);
+        chat_messages_.swap(chat_messages);
+        status_pending_ = false;
+        emotion_pending_ = false;
+    }
+    if (!status_pending && !emotion_pending && chat_messages.empty()) {
+        return;
+    }
+
+    // Status and emotion go with the first chat messages, the rest follow
+    // in groups, each under its own lock
+    size_t next = 0;
+    do {
+        size_t end = std::min(chat_messages.size(), next + DISPLAY_UPDATE_MAX_CHAT_PER_LOCK);
+        int64_t start_time = esp_timer_get_time();
+        {
+#if HAVE_LVGL
+            // The LVGL port lock is recursive, the setters below re-take it for free
+            DisplayLockGuard lock(display_);
+#endif
+            if (next == 0 && status_pending) {
+                display_->SetStatus(status.c_str());
+            }
+            if (next == 0 && emotion_pending) {
+                display_->SetEmotion(emotion.c_str());
+            }
+            for (size_t i = next; i < end; i++) {
+                display_->SetChatMessage(chat_messages[i].role.c_str(), chat_messages[i].content.c_str());
+            }
+        }
+        int64_t lock_us = esp_timer_get_time() - start_time;
+        next = end;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.flushes++;
+        stats_.total_lock_us += lock_us;
+        if (lock_us > stats_.max_lock_us) {
+            stats_.max_lock_us = lock_us;
+        }
+    } while (next < chat_messages.size());
+}
+
+DisplayUpdateStats DisplayUpdater::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void DisplayUpdater::LogStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stats_.flushes == 0) {
+        return;
+    }
+    ESP_LOGI(TAG, "posted %" PRIu32 " coalesced %" PRIu32 " flushes %" PRIu32 ", lock avg %d us max %d us",
+        stats_.posted, stats_.coalesced, stats_.flushes,
+        (int)(stats_.total_lock_us / stats_.flushes), (int)stats_.max_lock_us);
+}
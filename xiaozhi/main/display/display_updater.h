@@ -0,0 +1,71 @@
+#ifndef DISPLAY_UPDATER_H
+#define DISPLAY_UPDATER_H
+
+#include "display.h"
+
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+/*
+ * Coalescing front end for the status / emotion / chat widgets.
+ *
+ * Callers only record the new value and return. A low priority task applies
+ * what is pending at most once per DISPLAY_UPDATE_INTERVAL_MS. Status and
+ * emotion keep the last value written; chat messages are all kept and applied
+ * in order. The display lock is held for at most
+ * DISPLAY_UPDATE_MAX_CHAT_PER_LOCK chat messages at a time, so a burst of
+ * sentences does not stall other LVGL users for the whole batch.
+ */
+#define DISPLAY_UPDATE_INTERVAL_MS 50
+#define DISPLAY_UPDATE_MAX_CHAT_PER_LOCK 1
+
+struct DisplayUpdateStats {
+    uint32_t posted = 0;
+    uint32_t coalesced = 0;     // status / emotion overwritten before being shown
+    uint32_t flushes = 0;       // display lock acquisitions
+    int64_t total_lock_us = 0;
+    int64_t max_lock_us = 0;
+};
+
+class DisplayUpdater {
+public:
+    DisplayUpdater() = default;
+    ~DisplayUpdater();
+
+    // Updates posted before Start are kept and applied by the first flush
+    void Start(Display* display);
+
+    void SetStatus(const char* status);
+    void SetEmotion(const char* emotion);
+    void SetChatMessage(const char* role, const char* content);
+
+    DisplayUpdateStats stats() const;
+    void LogStats();
+
+private:
+    struct ChatMessage {
+        std::string role;
+        std::string content;
+    };
+
+    Display* display_ = nullptr;
+    TaskHandle_t task_handle_ = nullptr;
+
+    mutable std::mutex mutex_;
+    bool status_pending_ = false;
+    bool emotion_pending_ = false;
+    std::string status_;
+    std::string emotion_;
+    std::deque<ChatMessage> chat_messages_;
+    DisplayUpdateStats stats_;
+
+    void Notify();
+    void UpdateTask();
+    void Flush();
+};
+
+#endif // DISPLAY_UPDATER_H
@@ -0,0 +1,94 @@
+#include "https_client_pool.h"
+
+#include <esp_log.h>
+#include <algorithm>
+#include <cstring>
+
+#define TAG "HttpsClientPool"
+
+HttpsClientPool::~HttpsClientPool() {
+    Clear();
+}
+
+std::string HttpsClientPool::GetHost(const char* url) {
+    // scheme://host[:port]/path -> host[:port]
+    const char* start = strstr(url, "://");
+    start = start != nullptr ? start + 3 : url;
+    const char* end = strchr(start, '/');
+    return end != nullptr ? std::string(start, end - start) : std::string(start);
+}
+
+esp_http_client_handle_t HttpsClientPool::Acquire(const esp_http_client_config_t& config) {
+    auto host = GetHost(config.url);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Most recently released first, it is the most likely to still be connected
+        for (auto it = idle_.rbegin(); it != idle_.rend(); ++it) {
+            if (it->host == host && it->event_handler == config.event_handler) {
+                Entry entry = *it;
+                idle_.erase(std::next(it).base());
+                busy_.push_back(entry);
+                hits_++;
+                esp_http_client_set_url(entry.client, config.url);
+                esp_http_client_set_user_data(entry.client, config.user_data);
+                esp_http_client_set_timeout_ms(entry.client, config.timeout_ms);
+                ESP_LOGD(TAG, "Reuse client for %s (hits %lu, misses %lu)", host.c_str(), hits_, misses_);
+                return entry.client;
+            }
+        }
+        misses_++;
+    }
+
+    esp_http_client_config_t pooled_config = config;
+    pooled_config.keep_alive_enable = true;
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+    pooled_config.save_client_session = true;
+#endif
+    auto client = esp_http_client_init(&pooled_config);
+    if (client == nullptr) {
+        ESP_LOGE(TAG, "Failed to create client for %s", host.c_str());
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    busy_.push_back(Entry{host, config.event_handler, client});
+    ESP_LOGI(TAG, "New client for %s (hits %lu, misses %lu)", host.c_str(), hits_, misses_);
+    return client;
+}
+
+void HttpsClientPool::Release(esp_http_client_handle_t client, bool reusable) {
+    if (client == nullptr) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(busy_.begin(), busy_.end(), [client](const Entry& entry) {
+        return entry.client == client;
+    });
+    if (it == busy_.end()) {
+        ESP_LOGW(TAG, "Release of unknown client");
+        esp_http_client_cleanup(client);
+        return;
+    }
+    Entry entry = *it;
+    busy_.erase(it);
+
+    if (!reusable) {
+        esp_http_client_cleanup(entry.client);
+        return;
+    }
+    if (idle_.size() >= HTTPS_CLIENT_POOL_MAX_IDLE) {
+        // Evict the least recently used connection and its session
+        esp_http_client_cleanup(idle_.front().client);
+        idle_.erase(idle_.begin());
+    }
+    idle_.push_back(entry);
+}
+
+void HttpsClientPool::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : idle_) {
+        esp_http_client_cleanup(entry.client);
+    }
+    idle_.clear();
+}
@@ -0,0 +1,61 @@
+#ifndef HTTPS_CLIENT_POOL_H
+#define HTTPS_CLIENT_POOL_H
+
+#include <esp_http_client.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define HTTPS_CLIENT_POOL_MAX_IDLE 4
+
+/*
+ * Process-wide pool of keep-alive esp_http_client handles, keyed by host.
+ * A reused handle keeps its TCP connection when the server allows it, and
+ * with CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS it also keeps the TLS session,
+ * so a reconnect does an abbreviated handshake instead of a full one.
+ * Session state is allocated by mbedtls (PSRAM with MBEDTLS_EXTERNAL_MEM_ALLOC).
+ *
+ * The session lives in the handle, esp_http_client has no way to hand it to
+ * another one: a new handle for the same host, or one evicted and created
+ * again, does a full handshake. Only clients taken from this pool reuse
+ * sessions. Those created through the board's NetworkInterface (OTA, assets,
+ * WebsocketProtocol, camera uploads) come from esp-ml307, which has no TLS
+ * session hook, and still do a full handshake each time.
+ * scripts/tls_resume_bench measures the saving on mbedtls.
+ */
+class HttpsClientPool {
+public:
+    static HttpsClientPool& GetInstance() {
+        static HttpsClientPool instance;
+        return instance;
+    }
+    HttpsClientPool(const HttpsClientPool&) = delete;
+    HttpsClientPool& operator=(const HttpsClientPool&) = delete;
+
+    // Returns an idle client for the same host and event handler, or a new one
+    esp_http_client_handle_t Acquire(const esp_http_client_config_t& config);
+    // Give the client back; pass reusable=false after a transport error
+    void Release(esp_http_client_handle_t client, bool reusable = true);
+    void Clear();
+
+private:
+    struct Entry {
+        std::string host;
+        http_event_handle_cb event_handler;
+        esp_http_client_handle_t client;
+    };
+
+    std::mutex mutex_;
+    std::vector<Entry> idle_;
+    std::vector<Entry> busy_;
+    uint32_t hits_ = 0;
+    uint32_t misses_ = 0;
+
+    HttpsClientPool() = default;
+    ~HttpsClientPool();
+
+    static std::string GetHost(const char* url);
+};
+
+#endif // HTTPS_CLIENT_POOL_H
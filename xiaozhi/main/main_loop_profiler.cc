@@ -0,0 +1,196 @@
+#include "main_loop_profiler.h"
+
+#if CONFIG_MAIN_LOOP_PROFILING
+
+#include "json_writer.h"
+
+#include <esp_log.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#define TAG "MainLoopProfiler"
+
+static const char* const kLaneNames[kTaskLaneCount] = {"realtime", "normal", "background"};
+
+MainLoopProfiler::MainLoopProfiler(const TaskScheduler& scheduler) : scheduler_(scheduler) {
+    sites_[MAIN_LOOP_PROFILER_MAX_SITES].file = "other";
+}
+
+MainLoopProfiler::~MainLoopProfiler() {
+    if (watchdog_timer_ != nullptr) {
+        esp_timer_stop(watchdog_timer_);
+        esp_timer_delete(watchdog_timer_);
+    }
+}
+
+void MainLoopProfiler::Start() {
+    esp_timer_create_args_t watchdog_timer_args = {
+        .callback = [](void* arg) {
+            ((MainLoopProfiler*)arg)->CheckStall();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "main_loop_watchdog",
+        .skip_unhandled_events = true,
+    };
+    esp_timer_create(&watchdog_timer_args, &watchdog_timer_);
+    esp_timer_start_periodic(watchdog_timer_, std::max(CONFIG_MAIN_LOOP_STALL_MS / 2, 100) * 1000);
+}
+
+void MainLoopProfiler::BeginEvent(const char* name) {
+    busy_event_.store(name, std::memory_order_relaxed);
+    busy_since_.store(esp_timer_get_time(), std::memory_order_release);
+}
+
+void MainLoopProfiler::BeginTask() {
+    busy_event_.store(nullptr, std::memory_order_relaxed);
+    busy_since_.store(esp_timer_get_time(), std::memory_order_release);
+}
+
+void MainLoopProfiler::End() {
+    int64_t elapsed_us = esp_timer_get_time() - busy_since_.load(std::memory_order_relaxed);
+    busy_since_.store(0, std::memory_order_release);
+    stall_reported_ = false;
+
+    const char* event = busy_event_.load(std::memory_order_relaxed);
+    const char* file = event;
+    int line = 0;
+    if (event == nullptr) {
+        file = scheduler_.last_source().file;
+        line = scheduler_.last_source().line;
+    }
+    if (elapsed_us > CONFIG_MAIN_LOOP_SLOW_TASK_MS * 1000) {
+        ESP_LOGW(TAG, "Slow %s %s:%d took %d ms", event ? "event" : "task", BaseName(file), line,
+            (int)(elapsed_us / 1000));
+    }
+    Record(file, line, elapsed_us);
+}
+
+void MainLoopProfiler::Cancel() {
+    busy_since_.store(0, std::memory_order_release);
+}
+
+void MainLoopProfiler::Record(const char* file, int line, int64_t elapsed_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Site* site = nullptr;
+    for (int i = 0; i < site_count_; i++) {
+        if (sites_[i].file == file && sites_[i].line == line) {
+            site = &sites_[i];
+            break;
+        }
+    }
+    if (site == nullptr) {
+        if (site_count_ < MAIN_LOOP_PROFILER_MAX_SITES) {
+            site = &sites_[site_count_++];
+            site->file = file;
+            site->line = line;
+        } else {
+            site = &sites_[MAIN_LOOP_PROFILER_MAX_SITES];
+        }
+    }
+    site->count++;
+    site->total_us += elapsed_us;
+    site->max_us = std::max(site->max_us, elapsed_us);
+    if (elapsed_us > CONFIG_MAIN_LOOP_SLOW_TASK_MS * 1000) {
+        site->slow++;
+    }
+}
+
+// Runs in the esp_timer task
+void MainLoopProfiler::CheckStall() {
+    int64_t since = busy_since_.load(std::memory_order_acquire);
+    if (since == 0 || stall_reported_) {
+        return;
+    }
+    int64_t busy_ms = (esp_timer_get_time() - since) / 1000;
+    if (busy_ms < CONFIG_MAIN_LOOP_STALL_MS) {
+        return;
+    }
+    stall_reported_ = true;
+
+    const char* file = busy_event_.load(std::memory_order_relaxed);
+    int line = 0;
+    if (file == nullptr) {
+        auto source = scheduler_.running_source();
+        if (source != nullptr) {
+            file = source->file;
+            line = source->line;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stalls_++;
+    }
+    ESP_LOGE(TAG, "Main loop stalled for %d ms in %s:%d, queue depth realtime %lu normal %lu background %lu",
+        (int)busy_ms, BaseName(file), line, scheduler_.stats(kTaskLaneRealtime).depth,
+        scheduler_.stats(kTaskLaneNormal).depth, scheduler_.stats(kTaskLaneBackground).depth);
+}
+
+const char* MainLoopProfiler::BaseName(const char* path) {
+    if (path == nullptr) {
+        return "?";
+    }
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+std::string MainLoopProfiler::GetStatsJson() {
+    const int kTopSites = 10;
+    std::string json_str(1024 + kTopSites * 128, '\0');
+    JsonWriter json(json_str.data(), json_str.size());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    json.BeginObject().Field("stalls", (int)stalls_);
+    json.Key("lanes").BeginArray();
+    for (int lane = 0; lane < kTaskLaneCount; lane++) {
+        auto stats = scheduler_.stats((TaskLane)lane);
+        json.BeginObject()
+            .Field("lane", kLaneNames[lane])
+            .Field("depth", (int)stats.depth)
+            .Field("run", (int)stats.run)
+            .Field("deadline_misses", (int)stats.deadline_misses)
+            .Field("max_wait_us", (int)stats.max_wait_us)
+            .EndObject();
+    }
+    json.EndArray();
+
+    // Slowest sites by total time
+    Site* order[MAIN_LOOP_PROFILER_MAX_SITES + 1];
+    int count = 0;
+    for (int i = 0; i < site_count_; i++) {
+        order[count++] = &sites_[i];
+    }
+    if (sites_[MAIN_LOOP_PROFILER_MAX_SITES].count > 0) {
+        order[count++] = &sites_[MAIN_LOOP_PROFILER_MAX_SITES];
+    }
+    std::sort(order, order + count, [](const Site* a, const Site* b) { return a->total_us > b->total_us; });
+
+    json.Key("sites").BeginArray();
+    for (int i = 0; i < count && i < kTopSites; i++) {
+        const Site* site = order[i];
+        char name[64];
+        if (site->line > 0) {
+            snprintf(name, sizeof(name), "%s:%d", BaseName(site->file), site->line);
+        } else {
+            snprintf(name, sizeof(name), "%s", site->file);
+        }
+        json.BeginObject()
+            .Field("site", name)
+            .Field("count", (int)site->count)
+            .Field("slow", (int)site->slow)
+            .Key("avg_us").Number(site->total_us / site->count)
+            .Key("max_us").Number(site->max_us)
+            .EndObject();
+    }
+    json.EndArray().EndObject();
+
+    if (json.overflow()) {
+        return "{}";
+    }
+    json_str.resize(json.size());
+    return json_str;
+}
+
+#endif // CONFIG_MAIN_LOOP_PROFILING
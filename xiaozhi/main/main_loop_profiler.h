@@ -0,0 +1,73 @@
+#ifndef MAIN_LOOP_PROFILER_H
+#define MAIN_LOOP_PROFILER_H
+
+#include "task_scheduler.h"
+
+#if CONFIG_MAIN_LOOP_PROFILING
+
+#include <esp_timer.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+// Distinct call sites tracked, the rest are folded into one "other" entry
+#define MAIN_LOOP_PROFILER_MAX_SITES 32
+
+/*
+ * Per call site timing of the main event loop (CONFIG_MAIN_LOOP_PROFILING).
+ * Scheduled tasks are tagged with the Schedule() call site, event bit
+ * handlers with a fixed name. Work slower than CONFIG_MAIN_LOOP_SLOW_TASK_MS
+ * is logged when it finishes; a watchdog timer reports the site still running
+ * after CONFIG_MAIN_LOOP_STALL_MS together with the lane queue depths.
+ */
+class MainLoopProfiler {
+public:
+    explicit MainLoopProfiler(const TaskScheduler& scheduler);
+    ~MainLoopProfiler();
+
+    // Starts the stall watchdog
+    void Start();
+
+    // Event bit handler, name must be a literal
+    void BeginEvent(const char* name);
+    // Scheduled task, the site is read from the scheduler
+    void BeginTask();
+    void End();
+    // Nothing ran after Begin
+    void Cancel();
+
+    // Summary for the MCP stats tool: totals, lanes and the slowest sites
+    std::string GetStatsJson();
+
+private:
+    struct Site {
+        const char* file = nullptr;  // or the event name when line is 0
+        int line = 0;
+        uint32_t count = 0;
+        uint32_t slow = 0;
+        int64_t total_us = 0;
+        int64_t max_us = 0;
+    };
+
+    const TaskScheduler& scheduler_;
+    esp_timer_handle_t watchdog_timer_ = nullptr;
+
+    std::mutex mutex_;
+    Site sites_[MAIN_LOOP_PROFILER_MAX_SITES + 1];
+    int site_count_ = 0;
+    uint32_t stalls_ = 0;
+
+    // Written by the main loop, read by the watchdog
+    std::atomic<int64_t> busy_since_{0};
+    std::atomic<const char*> busy_event_{nullptr};
+    std::atomic<bool> stall_reported_{false};
+
+    void Record(const char* file, int line, int64_t elapsed_us);
+    void CheckStall();
+    static const char* BaseName(const char* path);
+};
+
+#endif // CONFIG_MAIN_LOOP_PROFILING
+
+#endif // MAIN_LOOP_PROFILER_H
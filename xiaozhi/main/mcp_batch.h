@@ -0,0 +1,199 @@
+#ifndef MCP_BATCH_H
+#define MCP_BATCH_H
+
+#include "mcp_call.h"
+
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+struct cJSON;
+
+// Most entries accepted in one JSON-RPC batch
+#define MCP_BATCH_MAX_SIZE 16
+// tools/call entries of one batch running at the same time
+#define MCP_BATCH_CONCURRENCY 2
+// Largest batch response message, more responses go out in further arrays
+#define MCP_BATCH_MAX_PAYLOAD 8000
+
+/*
+ * One JSON-RPC batch request.
+ * The server registers every id that expects a response (an id that is
+ * already waiting, in this batch or another, gets an error entry instead and
+ * is not run), then hands the
+ * tools/call entries out MCP_BATCH_CONCURRENCY at a time; each response or
+ * drop frees a slot. Once every expected id is answered the responses are sent
+ * as JSON arrays of at most MCP_BATCH_MAX_PAYLOAD bytes (a single larger
+ * response still goes out on its own). A batch without responses sends nothing.
+ * Dispatch is a drain loop: if a response frees a slot while another task is
+ * dispatching, that task picks it up, so nothing recurses.
+ */
+class McpBatch {
+public:
+    McpBatch(McpCall::Sender sender, void (*free_entry)(cJSON*))
+        : sender_(std::move(sender)), free_entry_(free_entry) {}
+
+    ~McpBatch() {
+        for (auto entry : pending_) {
+            free_entry_(entry);
+        }
+    }
+
+    McpBatch(const McpBatch&) = delete;
+    McpBatch& operator=(const McpBatch&) = delete;
+
+    // Registration, before anything is dispatched
+    void Expect(int id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        expected_.insert(id);
+    }
+
+    // Response for an entry refused at registration (e.g. a duplicate id), sent with the others
+    void AddResponse(std::string response) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        responses_.push_back(std::move(response));
+    }
+
+    void AddCall(int id, cJSON* entry) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(entry);
+        pending_ids_.push_back(id);
+    }
+
+    bool Expects(int id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return expected_.count(id) > 0;
+    }
+
+    // Response for id, false if the batch was not waiting for it
+    bool Complete(int id, std::string response) {
+        return Finish(id, &response);
+    }
+
+    // id gets no response (cancelled call, entry that could not be handled)
+    bool Drop(int id) {
+        return Finish(id, nullptr);
+    }
+
+    // true if the caller owns the dispatch loop
+    bool BeginDispatch() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (dispatching_) {
+            again_ = true;
+            return false;
+        }
+        dispatching_ = true;
+        again_ = false;
+        return true;
+    }
+
+    // Next tools/call entry while the window has room, the caller frees it after dispatch
+    cJSON* NextEntry(int& id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.empty() || running_.size() >= MCP_BATCH_CONCURRENCY) {
+            return nullptr;
+        }
+        auto entry = pending_.front();
+        id = pending_ids_.front();
+        pending_.pop_front();
+        pending_ids_.pop_front();
+        running_.insert(id);
+        return entry;
+    }
+
+    // false if a slot was freed meanwhile, the caller must run the loop again
+    bool EndDispatch() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (again_) {
+            again_ = false;
+            return false;
+        }
+        dispatching_ = false;
+        return true;
+    }
+
+    // Called once registration is over, sends right away if nothing is outstanding
+    void Seal() {
+        std::vector<std::string> payloads;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            sealed_ = true;
+            TakePayloads(payloads);
+        }
+        Send(payloads);
+    }
+
+    size_t messages_sent() const { return messages_sent_; }
+
+private:
+    McpCall::Sender sender_;
+    void (*free_entry_)(cJSON*);
+    std::mutex mutex_;
+    std::multiset<int> expected_;
+    std::deque<cJSON*> pending_;
+    std::deque<int> pending_ids_;
+    std::vector<std::string> responses_;
+    std::multiset<int> running_;
+    bool dispatching_ = false;
+    bool again_ = false;
+    bool sealed_ = false;
+    bool sent_ = false;
+    size_t messages_sent_ = 0;
+
+    bool Finish(int id, std::string* response) {
+        std::vector<std::string> payloads;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = expected_.find(id);
+            if (it == expected_.end()) {
+                return false;
+            }
+            expected_.erase(it);
+            if (response != nullptr) {
+                responses_.push_back(std::move(*response));
+            }
+            auto running = running_.find(id);
+            if (running != running_.end()) {
+                running_.erase(running);
+                again_ = true;
+            }
+            TakePayloads(payloads);
+        }
+        Send(payloads);
+        return true;
+    }
+
+    // Caller holds mutex_
+    void TakePayloads(std::vector<std::string>& payloads) {
+        if (!sealed_ || sent_ || !expected_.empty()) {
+            return;
+        }
+        sent_ = true;
+        std::string payload;
+        for (auto& response : responses_) {
+            if (!payload.empty() && payload.size() + response.size() + 2 > MCP_BATCH_MAX_PAYLOAD) {
+                payload += "]";
+                payloads.push_back(std::move(payload));
+                payload.clear();
+            }
+            payload += payload.empty() ? "[" : ",";
+            payload += response;
+        }
+        if (!payload.empty()) {
+            payload += "]";
+            payloads.push_back(std::move(payload));
+        }
+        responses_.clear();
+    }
+
+    void Send(std::vector<std::string>& payloads) {
+        for (auto& payload : payloads) {
+            sender_(payload);
+            messages_sent_++;
+        }
+    }
+};
+
+#endif // MCP_BATCH_H
@@ -0,0 +1,171 @@
+#ifndef MCP_CALL_H
+#define MCP_CALL_H
+
+#include "json_writer.h"
+#include "mcp_trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+// Least time between two notifications/progress of one call, the final step always goes out
+#define MCP_PROGRESS_INTERVAL_MS 500
+
+// Thrown by a tool that stops early because its call was cancelled, no reply is sent
+class McpCancelled : public std::runtime_error {
+public:
+    McpCancelled() : std::runtime_error("Cancelled") {}
+};
+
+/*
+ * One tools/call in flight, looked up by its JSON-RPC id.
+ * notifications/cancelled sets the token and the tool polls it at its own
+ * safe points (between moves, before opening a door, before an upload). A
+ * handler reaches its call through McpCall::Current(), set on the task that
+ * runs it, so handler signatures stay the same.
+ */
+class McpCall {
+public:
+    using Sender = std::function<void(const std::string& payload)>;
+
+    // progress_token is the raw JSON of _meta.progressToken, empty if the client sent none
+    McpCall(int id, const std::string& progress_token, Sender sender)
+        : id_(id), progress_token_(progress_token), sender_(std::move(sender)) {
+        trace_.id = id;
+    }
+
+    int id() const { return id_; }
+    bool cancelled() const { return cancelled_.load(); }
+    void Cancel() { cancelled_ = true; }
+    int progress_sent() const { return progress_sent_; }
+    McpTrace& trace() { return trace_; }
+    // Client asked for the trace in the result's _meta
+    bool trace_reply() const { return trace_reply_; }
+    void set_trace_reply(bool trace_reply) { trace_reply_ = trace_reply; }
+
+    void Progress(int progress, int total, const std::string& message = "") {
+        if (progress_token_.empty() || progress <= last_progress_) {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (progress < total && progress_sent_ > 0 &&
+            now - last_progress_time_ < std::chrono::milliseconds(MCP_PROGRESS_INTERVAL_MS)) {
+            return;
+        }
+        last_progress_ = progress;
+        last_progress_time_ = now;
+        progress_sent_++;
+
+        std::string payload(progress_token_.size() + JsonWriter::EscapedSize(message.size()) + 128, '\0');
+        JsonWriter json(payload.data(), payload.size());
+        json.BeginObject()
+            .Field("jsonrpc", "2.0")
+            .Field("method", "notifications/progress")
+            .Key("params").BeginObject()
+            .Key("progressToken").Raw(progress_token_)
+            .Field("progress", progress)
+            .Field("total", total);
+        if (!message.empty()) {
+            json.Field("message", message);
+        }
+        json.EndObject().EndObject();
+        payload.resize(json.size());
+        sender_(payload);
+    }
+
+    // Call run by this task, nullptr outside a tool handler
+    static McpCall* Current() { return current_; }
+
+    static bool CurrentCancelled() {
+        return current_ != nullptr && current_->cancelled();
+    }
+
+    static void ThrowIfCancelled() {
+        if (CurrentCancelled()) {
+            throw McpCancelled();
+        }
+    }
+
+    static void ReportProgress(int progress, int total, const std::string& message = "") {
+        if (current_ != nullptr) {
+            current_->Progress(progress, total, message);
+        }
+    }
+
+    // Makes call the current one while a handler runs
+    class Scope {
+    public:
+        explicit Scope(McpCall* call) : previous_(current_) { current_ = call; }
+        ~Scope() { current_ = previous_; }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        McpCall* previous_;
+    };
+
+private:
+    int id_;
+    std::string progress_token_;
+    Sender sender_;
+    std::atomic<bool> cancelled_{false};
+    int last_progress_ = -1;
+    int progress_sent_ = 0;
+    std::chrono::steady_clock::time_point last_progress_time_;
+    McpTrace trace_;
+    bool trace_reply_ = false;
+
+    inline static thread_local McpCall* current_ = nullptr;
+};
+
+// Calls in flight by JSON-RPC id, shared by the main loop and the MCP workers
+class McpCallRegistry {
+public:
+    // nullptr if a call with this id is still running
+    std::shared_ptr<McpCall> Begin(int id, const std::string& progress_token, McpCall::Sender sender) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (calls_.count(id) > 0) {
+            return nullptr;
+        }
+        auto call = std::make_shared<McpCall>(id, progress_token, std::move(sender));
+        calls_[id] = call;
+        return call;
+    }
+
+    // false if the call already finished or never existed
+    bool Cancel(int id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = calls_.find(id);
+        if (it == calls_.end()) {
+            return false;
+        }
+        it->second->Cancel();
+        return true;
+    }
+
+    bool Contains(int id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return calls_.count(id) > 0;
+    }
+
+    void End(int id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        calls_.erase(id);
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return calls_.size();
+    }
+
+private:
+    std::mutex mutex_;
+    std::map<int, std::shared_ptr<McpCall>> calls_;
+};
+
+#endif // MCP_CALL_H
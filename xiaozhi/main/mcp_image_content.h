@@ -0,0 +1,62 @@
+#ifndef MCP_IMAGE_CONTENT_H
+#define MCP_IMAGE_CONTENT_H
+
+#include "json_writer.h"
+
+#include <string>
+
+/*
+ * Image returned by a tool.
+ * The raw bytes are kept as they are and only base64 encoded when the
+ * response is written, straight into the outgoing message (see
+ * McpTool::WriteResult). A 100 KB JPEG then costs the image plus one encoded
+ * copy instead of an encoded string, a cJSON tree and two printed copies.
+ * The content item is the same as before: the image object is carried as a
+ * JSON string in the "image" field.
+ */
+class ImageContent {
+public:
+    ImageContent(const std::string& mime_type, std::string data)
+        : mime_type_(mime_type), data_(std::move(data)) {}
+
+    // Upper bound of Write()
+    size_t json_size() const {
+        return JsonWriter::Base64Size(data_.size()) +
+            JsonWriter::EscapedSize(JsonWriter::EscapedSize(mime_type_.size())) + 96;
+    }
+
+    // {"type":"image","image":"{\"type\":\"image\",\"mimeType\":...,\"data\":\"...\"}"}
+    void Write(JsonWriter& json) const {
+        std::string mime_type(JsonWriter::EscapedSize(mime_type_.size()), '\0');
+        JsonWriter mime_json(mime_type.data(), mime_type.size());
+        mime_json.String(mime_type_);
+
+        json.BeginObject()
+            .Field("type", "image")
+            .Key("image").BeginString()
+            .Chars("{\"type\":\"image\",\"mimeType\":").Chars(mime_json.view()).Chars(",\"data\":\"")
+            .Base64(data_.data(), data_.size())
+            .Chars("\"}")
+            .EndString()
+            .EndObject();
+    }
+
+    // The image object alone
+    std::string to_json() const {
+        std::string result(json_size(), '\0');
+        JsonWriter json(result.data(), result.size());
+        json.BeginObject()
+            .Field("type", "image")
+            .Field("mimeType", mime_type_)
+            .Key("data").BeginString().Base64(data_.data(), data_.size()).EndString()
+            .EndObject();
+        result.resize(json.size());
+        return result;
+    }
+
+private:
+    std::string mime_type_;
+    std::string data_;
+};
+
+#endif // MCP_IMAGE_CONTENT_H
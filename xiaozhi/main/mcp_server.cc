@@ -9,6 +9,8 @@
 #include <esp_app_desc.h>
 #include <esp_log.h>
 #include <esp_pthread.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 #include "application.h"
 #include "board.h"
@@ -19,6 +21,8 @@
 #include "lvgl_theme.h"
 #include "oled_display.h"
 #include "settings.h"
+#include "json_writer.h"
+#include "telemetry.h"
 
 #include "I2CCommandBridge.h"
 #include "RecurringSchedule.h"
@@ -33,6 +37,10 @@
 static I2CCommandBridge *g_i2c_bridge = nullptr;
 static StorageManager *g_storage_manager = nullptr;
 static VehicleController *g_vehicle_controller = nullptr;
+// StorageManager and VehicleController have no lock of their own: the tools of
+// each run one call at a time, whichever tool it comes from
+static McpToolGroup g_vehicle_tools;
+static McpToolGroup g_storage_tools;
 
 // Initialize hardware controllers
 static void InitializeControllers() {
@@ -100,28 +108,27 @@ void McpServer::AddCommonTools() {
         return board.GetDeviceStatusJson();
       });
 
-  AddTool("self.audio_speaker.set_volume",
-          "Set the volume of the audio speaker. If the current volume is "
-          "unknown, you must call `self.get_device_status` tool first and then "
-          "call this tool.",
-          PropertyList({Property("volume", kPropertyTypeInteger, 0, 100)}),
-          [&board](const PropertyList &properties) -> ReturnValue {
-            auto codec = board.GetAudioCodec();
-            codec->SetOutputVolume(properties["volume"].value<int>());
-            return true;
-          });
+  AddTypedTool("self.audio_speaker.set_volume",
+               "Set the volume of the audio speaker. If the current volume is "
+               "unknown, you must call `self.get_device_status` tool first and "
+               "then call this tool.",
+               McpParams(McpInt("volume", 0, 100)),
+               [&board](int volume) -> ReturnValue {
+                 auto codec = board.GetAudioCodec();
+                 codec->SetOutputVolume(volume);
+                 return true;
+               });
 
   auto backlight = board.GetBacklight();
   if (backlight) {
-    AddTool(
-        "self.screen.set_brightness", "Set the brightness of the screen.",
-        PropertyList({Property("brightness", kPropertyTypeInteger, 0, 100)}),
-        [backlight](const PropertyList &properties) -> ReturnValue {
-          uint8_t brightness =
-              static_cast<uint8_t>(properties["brightness"].value<int>());
-          backlight->SetBrightness(brightness, true);
-          return true;
-        });
+    AddTypedTool("self.screen.set_brightness",
+                 "Set the brightness of the screen.",
+                 McpParams(McpInt("brightness", 0, 100)),
+                 [backlight](int brightness) -> ReturnValue {
+                   backlight->SetBrightness(static_cast<uint8_t>(brightness),
+                                            true);
+                   return true;
+                 });
   }
 
 #ifdef HAVE_LVGL
@@ -144,24 +151,24 @@ void McpServer::AddCommonTools() {
 
   auto camera = board.GetCamera();
   if (camera) {
-    AddTool("self.camera.take_photo",
-            "Take a photo and explain it. Use this tool after the user asks "
-            "you to see something.\n"
-            "Args:\n"
-            "  `question`: The question that you want to ask about the photo.\n"
-            "Return:\n"
-            "  A JSON object that provides the photo information.",
-            PropertyList({Property("question", kPropertyTypeString)}),
-            [camera](const PropertyList &properties) -> ReturnValue {
-              // Lower the priority to do the camera capture
-              TaskPriorityReset priority_reset(1);
-
-              if (!camera->Capture()) {
-                throw std::runtime_error("Failed to capture photo");
-              }
-              auto question = properties["question"].value<std::string>();
-              return camera->Explain(question);
-            });
+    AddBlockingTool("self.camera.take_photo",
+                    "Take a photo and explain it. Use this tool after the user asks "
+                    "you to see something.\n"
+                    "Args:\n"
+                    "  `question`: The question that you want to ask about the photo.\n"
+                    "Return:\n"
+                    "  A JSON object that provides the photo information.",
+                    PropertyList({Property("question", kPropertyTypeString)}),
+                    [camera](const PropertyList &properties) -> ReturnValue {
+                      // Lower the priority to do the camera capture
+                      TaskPriorityReset priority_reset(1);
+
+                      if (!camera->Capture()) {
+                        throw std::runtime_error("Failed to capture photo");
+                      }
+                      auto question = properties["question"].value<std::string>();
+                      return camera->Explain(question);
+                    });
   }
 #endif
 
@@ -170,35 +177,33 @@ void McpServer::AddCommonTools() {
 
   // ==================== VEHICLE CONTROL TOOLS ====================
   if (g_vehicle_controller) {
-    AddTool("vehicle.move",
-            "Di chuyển xe theo hướng và khoảng cách. Sử dụng tool này khi "
-            "người dùng yêu cầu di chuyển xe.\n"
-            "Hướng di chuyển: 'forward' (tiến), 'backward' (lùi), 'left' "
-            "(trái), 'right' (phải), 'rotate_left' (xoay trái), 'rotate_right' "
-            "(xoay phải), 'stop' (dừng).\n"
-            "Args:\n"
-            "  `direction`: Hướng di chuyển (bắt buộc).\n"
-            "  `distance_mm`: Khoảng cách di chuyển tính bằng mm (mặc định "
-            "500mm).\n"
-            "  `speed`: Tốc độ 0-100 (mặc định 50).",
-            PropertyList({Property("direction", kPropertyTypeString),
-                          Property("distance_mm", kPropertyTypeInteger, 500),
-                          Property("speed", kPropertyTypeInteger, 50)}),
-            [](const PropertyList &properties) -> ReturnValue {
-              auto direction = properties["direction"].value<std::string>();
-              int distance_mm = properties["distance_mm"].value<int>();
-              int speed = properties["speed"].value<int>();
-
-              VehicleController::MoveCommand cmd(direction, speed, distance_mm);
-              if (g_vehicle_controller->ExecuteMove(cmd)) {
-                return "{\"success\": true, \"message\": \"Xe đang di chuyển " +
-                       direction + "\"}";
-              }
-              return "{\"success\": false, \"message\": \"Không thể điều khiển "
-                     "xe\"}";
-            });
-
-    AddTool(
+    AddTypedBlockingTool("vehicle.move",
+                         "Di chuyển xe theo hướng và khoảng cách. Sử dụng tool này khi "
+                         "người dùng yêu cầu di chuyển xe.\n"
+                         "Hướng di chuyển: 'forward' (tiến), 'backward' (lùi), 'left' "
+                         "(trái), 'right' (phải), 'rotate_left' (xoay trái), 'rotate_right' "
+                         "(xoay phải), 'stop' (dừng).\n"
+                         "Args:\n"
+                         "  `direction`: Hướng di chuyển (bắt buộc).\n"
+                         "  `distance_mm`: Khoảng cách di chuyển tính bằng mm (mặc định "
+                         "500mm).\n"
+                         "  `speed`: Tốc độ 0-100 (mặc định 50).",
+                         McpParams(McpString("direction"),
+                                   McpIntDefault("distance_mm", 500),
+                                   McpIntDefault("speed", 50)),
+                         [](const std::string &direction, int distance_mm,
+                            int speed) -> ReturnValue {
+                           McpCall::ThrowIfCancelled();
+                           VehicleController::MoveCommand cmd(direction, speed, distance_mm);
+                           if (g_vehicle_controller->ExecuteMove(cmd)) {
+                             return "{\"success\": true, \"message\": \"Xe đang di chuyển " +
+                                    direction + "\"}";
+                           }
+                           return "{\"success\": false, \"message\": \"Không thể điều khiển "
+                                  "xe\"}";
+                         }, 1, &g_vehicle_tools);
+
+    AddBlockingTool(
         "vehicle.execute_command",
         "Thực hiện lệnh di chuyển phức tạp bằng ngôn ngữ tự nhiên. Ví dụ: 'đi "
         "tới 1m rẽ phải đi thẳng 500mm'.\n"
@@ -209,13 +214,20 @@ void McpServer::AddCommonTools() {
           auto command = properties["command"].value<std::string>();
 
           auto commands = g_vehicle_controller->ParseNaturalCommand(command);
-          if (g_vehicle_controller->ExecuteSequence(commands)) {
+          // Stops the vehicle between moves if the call is cancelled
+          bool done = g_vehicle_controller->ExecuteSequence(
+              commands, [](size_t step, size_t total) {
+                McpCall::ReportProgress(step, total);
+                return !McpCall::CurrentCancelled();
+              });
+          McpCall::ThrowIfCancelled();
+          if (done) {
             return "{\"success\": true, \"message\": \"Đang thực hiện lệnh: " +
                    command + "\"}";
           }
           return "{\"success\": false, \"message\": \"Không thể phân tích "
                  "lệnh\"}";
-        });
+        }, 1, &g_vehicle_tools);
 
     AddTool("vehicle.stop", "Dừng xe ngay lập tức.", PropertyList(),
             [](const PropertyList &properties) -> ReturnValue {
@@ -228,37 +240,35 @@ void McpServer::AddCommonTools() {
 
   // ==================== STORAGE CONTROL TOOLS ====================
   if (g_storage_manager) {
-    AddTool("storage.open_slot",
-            "Mở ô lưu trữ vật lý (0-3).\n"
-            "Args:\n"
-            "  `slot_id`: Số ô cần mở (0-3).",
-            PropertyList({Property("slot_id", kPropertyTypeInteger, 0, 3)}),
-            [](const PropertyList &properties) -> ReturnValue {
-              int slot_id = properties["slot_id"].value<int>();
-
-              if (g_storage_manager->OpenHardwareSlot(slot_id)) {
-                return "{\"success\": true, \"message\": \"Đã mở ô " +
-                       std::to_string(slot_id + 1) + "\"}";
-              }
-              return "{\"success\": false, \"message\": \"Không thể mở ô\"}";
-            });
-
-    AddTool("storage.close_slot",
-            "Đóng ô lưu trữ vật lý (0-3).\n"
-            "Args:\n"
-            "  `slot_id`: Số ô cần đóng (0-3).",
-            PropertyList({Property("slot_id", kPropertyTypeInteger, 0, 3)}),
-            [](const PropertyList &properties) -> ReturnValue {
-              int slot_id = properties["slot_id"].value<int>();
-
-              if (g_storage_manager->CloseHardwareSlot(slot_id)) {
-                return "{\"success\": true, \"message\": \"Đã đóng ô " +
-                       std::to_string(slot_id + 1) + "\"}";
-              }
-              return "{\"success\": false, \"message\": \"Không thể đóng ô\"}";
-            });
-
-    AddTool(
+    AddTypedBlockingTool("storage.open_slot",
+                         "Mở ô lưu trữ vật lý (0-3).\n"
+                         "Args:\n"
+                         "  `slot_id`: Số ô cần mở (0-3).",
+                         McpParams(McpInt("slot_id", 0, 3)),
+                         [](int slot_id) -> ReturnValue {
+                           McpCall::ThrowIfCancelled();
+                           if (g_storage_manager->OpenHardwareSlot(slot_id)) {
+                             return "{\"success\": true, \"message\": \"Đã mở ô " +
+                                    std::to_string(slot_id + 1) + "\"}";
+                           }
+                           return "{\"success\": false, \"message\": \"Không thể mở ô\"}";
+                         }, 1, &g_storage_tools);
+
+    AddTypedBlockingTool("storage.close_slot",
+                         "Đóng ô lưu trữ vật lý (0-3).\n"
+                         "Args:\n"
+                         "  `slot_id`: Số ô cần đóng (0-3).",
+                         McpParams(McpInt("slot_id", 0, 3)),
+                         [](int slot_id) -> ReturnValue {
+                           McpCall::ThrowIfCancelled();
+                           if (g_storage_manager->CloseHardwareSlot(slot_id)) {
+                             return "{\"success\": true, \"message\": \"Đã đóng ô " +
+                                    std::to_string(slot_id + 1) + "\"}";
+                           }
+                           return "{\"success\": false, \"message\": \"Không thể đóng ô\"}";
+                         }, 1, &g_storage_tools);
+
+    AddBlockingTool(
         "storage.store_item",
         "Lưu thông tin vật phẩm vào storage. Vị trí có thể là ô vật lý "
         "(slot_0, slot_1) hoặc vị trí ảo (trên bàn, trong túi).\n"
@@ -280,69 +290,70 @@ void McpServer::AddCommonTools() {
           }
           return "{\"success\": false, \"message\": \"Không thể lưu vật "
                  "phẩm\"}";
-        });
-
-    AddTool("storage.find_item",
-            "Tìm vị trí của vật phẩm.\n"
-            "Args:\n"
-            "  `item_name`: Tên vật phẩm cần tìm.",
-            PropertyList({Property("item_name", kPropertyTypeString)}),
-            [](const PropertyList &properties) -> ReturnValue {
-              auto item_name = properties["item_name"].value<std::string>();
-
-              std::string location =
-                  g_storage_manager->FindItemLocation(item_name);
-              if (!location.empty()) {
-                return "{\"success\": true, \"item\": \"" + item_name +
-                       "\", \"location\": \"" + location + "\"}";
-              }
-              return "{\"success\": false, \"message\": \"Không tìm thấy " +
-                     item_name + "\"}";
-            });
-
-    AddTool("storage.process_command",
-            "Xử lý lệnh lưu trữ bằng ngôn ngữ tự nhiên. Ví dụ: 'để kính vào ô "
-            "1', 'kính ở đâu', 'mở ô 2'.\n"
-            "Args:\n"
-            "  `command`: Lệnh bằng tiếng Việt.",
-            PropertyList({Property("command", kPropertyTypeString)}),
-            [](const PropertyList &properties) -> ReturnValue {
-              auto command = properties["command"].value<std::string>();
-
-              std::string response =
-                  g_storage_manager->ProcessNaturalCommand(command);
-              return "{\"success\": true, \"message\": \"" + response + "\"}";
-            });
+        }, 1, &g_storage_tools);
 
-    AddTool("storage.list_all_items", "Liệt kê tất cả vật phẩm trong storage.",
-            PropertyList(), [](const PropertyList &properties) -> ReturnValue {
-              auto items = g_storage_manager->GetAllItems();
-
-              cJSON *json = cJSON_CreateObject();
-              cJSON_AddNumberToObject(json, "total", items.size());
-
-              cJSON *items_array = cJSON_CreateArray();
-              for (const auto &item : items) {
-                cJSON *item_json = cJSON_CreateObject();
-                cJSON_AddStringToObject(item_json, "name", item.name.c_str());
-                cJSON_AddStringToObject(item_json, "location",
-                                        item.location.c_str());
-                cJSON_AddBoolToObject(item_json, "is_hardware",
-                                      item.is_hardware_slot);
-                if (!item.description.empty()) {
-                  cJSON_AddStringToObject(item_json, "description",
-                                          item.description.c_str());
-                }
-                cJSON_AddItemToArray(items_array, item_json);
-              }
-              cJSON_AddItemToObject(json, "items", items_array);
-
-              return json;
-            });
+    AddBlockingTool("storage.find_item",
+                    "Tìm vị trí của vật phẩm.\n"
+                    "Args:\n"
+                    "  `item_name`: Tên vật phẩm cần tìm.",
+                    PropertyList({Property("item_name", kPropertyTypeString)}),
+                    [](const PropertyList &properties) -> ReturnValue {
+                      auto item_name = properties["item_name"].value<std::string>();
+
+                      std::string location =
+                          g_storage_manager->FindItemLocation(item_name);
+                      if (!location.empty()) {
+                        return "{\"success\": true, \"item\": \"" + item_name +
+                               "\", \"location\": \"" + location + "\"}";
+                      }
+                      return "{\"success\": false, \"message\": \"Không tìm thấy " +
+                             item_name + "\"}";
+                    }, 1, &g_storage_tools);
+
+    AddBlockingTool("storage.process_command",
+                    "Xử lý lệnh lưu trữ bằng ngôn ngữ tự nhiên. Ví dụ: 'để kính vào ô "
+                    "1', 'kính ở đâu', 'mở ô 2'.\n"
+                    "Args:\n"
+                    "  `command`: Lệnh bằng tiếng Việt.",
+                    PropertyList({Property("command", kPropertyTypeString)}),
+                    [](const PropertyList &properties) -> ReturnValue {
+                      auto command = properties["command"].value<std::string>();
+
+                      McpCall::ThrowIfCancelled();
+                      std::string response =
+                          g_storage_manager->ProcessNaturalCommand(command);
+                      return "{\"success\": true, \"message\": \"" + response + "\"}";
+                    }, 1, &g_storage_tools);
+
+    AddBlockingTool("storage.list_all_items", "Liệt kê tất cả vật phẩm trong storage.",
+                    PropertyList(), [](const PropertyList &properties) -> ReturnValue {
+                      auto items = g_storage_manager->GetAllItems();
+
+                      cJSON *json = cJSON_CreateObject();
+                      cJSON_AddNumberToObject(json, "total", items.size());
+
+                      cJSON *items_array = cJSON_CreateArray();
+                      for (const auto &item : items) {
+                        cJSON *item_json = cJSON_CreateObject();
+                        cJSON_AddStringToObject(item_json, "name", item.name.c_str());
+                        cJSON_AddStringToObject(item_json, "location",
+                                                item.location.c_str());
+                        cJSON_AddBoolToObject(item_json, "is_hardware",
+                                              item.is_hardware_slot);
+                        if (!item.description.empty()) {
+                          cJSON_AddStringToObject(item_json, "description",
+                                                  item.description.c_str());
+                        }
+                        cJSON_AddItemToArray(items_array, item_json);
+                      }
+                      cJSON_AddItemToObject(json, "items", items_array);
+
+                      return json;
+                    }, 1, &g_storage_tools);
 
     // ==================== SMART STORAGE WORKFLOW TOOLS ====================
 
-    AddTool(
+    AddBlockingTool(
         "storage.smart_store",
         "🤖 THÔNG MINH: Tự động tìm ô trống, mở cửa để user bỏ đồ vào.\n"
         "⚠️ QUAN TRỌNG: User đếm từ 1-4, hệ thống internal dùng 0-3.\n"
@@ -377,6 +388,7 @@ void McpServer::AddCommonTools() {
           int user_slot = internal_slot + 1; // Convert 0-3 to 1-4
 
           // 2. Mở cửa ô trống
+          McpCall::ThrowIfCancelled();
           if (!g_storage_manager->OpenHardwareSlot(internal_slot)) {
             return "{\"success\": false, \"message\": \"Không thể mở cửa ô " +
                    std::to_string(user_slot) + "\"}";
@@ -399,9 +411,9 @@ void McpServer::AddCommonTools() {
           cJSON_AddStringToObject(json, "status", "waiting_for_item");
 
           return json;
-        });
+        }, 1, &g_storage_tools);
 
-    AddTool(
+    AddBlockingTool(
         "storage.smart_close",
         "🤖 THÔNG MINH: Đóng cửa ô đang mở và lưu thông tin đồ vật.\n"
         "⚠️ QUAN TRỌNG: Trả về số ô THEO USER (1-4).\n"
@@ -434,6 +446,7 @@ void McpServer::AddCommonTools() {
           int user_slot = internal_slot + 1; // Convert 0-3 to 1-4
 
           // 2. Đóng cửa
+          McpCall::ThrowIfCancelled();
           if (!g_storage_manager->CloseHardwareSlot(internal_slot)) {
             return "{\"success\": false, \"message\": \"Không thể đóng cửa ô " +
                    std::to_string(user_slot) + "\"}";
@@ -461,9 +474,9 @@ void McpServer::AddCommonTools() {
           cJSON_AddStringToObject(json, "message", message.c_str());
 
           return json;
-        });
+        }, 1, &g_storage_tools);
 
-    AddTool(
+    AddBlockingTool(
         "storage.smart_retrieve",
         "🤖 THÔNG MINH: Tự động tìm đồ và mở cửa ô chứa đồ đó.\n"
         "⚠️ QUAN TRỌNG: Trả về số ô THEO USER (1-4).\n"
@@ -492,6 +505,7 @@ void McpServer::AddCommonTools() {
             int user_slot = internal_slot + 1; // Convert 0-3 to 1-4
 
             // Mở cửa ô
+            McpCall::ThrowIfCancelled();
             if (!g_storage_manager->OpenHardwareSlot(internal_slot)) {
               return "{\"success\": false, \"message\": \"Không thể mở ô " +
                      std::to_string(user_slot) + "\"}";
@@ -526,86 +540,87 @@ void McpServer::AddCommonTools() {
 
             return json;
           }
-        });
+        }, 1, &g_storage_tools);
   }
 
   // ==================== TELEGRAM & SCHEDULE TOOLS ====================
 
   // Reuse board and camera from above (already declared at line 83, 143)
   if (camera) {
-    AddTool("telegram.send_photo",
-            "📸 Chụp ảnh và gửi qua Telegram bot.\n"
-            "Sử dụng khi user yêu cầu chụp ảnh gửi cho người thân.\n"
-            "Không cần tham số, hệ thống tự động chụp và gửi.",
-            PropertyList(),
-            [camera](const PropertyList &properties) -> ReturnValue {
-              auto &app = Application::GetInstance();
-
-              // Cast to Esp32Camera to access SendPhotoToTelegram
-              auto esp32_camera = dynamic_cast<Esp32Camera *>(camera);
-              if (!esp32_camera) {
-                return "{\"success\": false, \"message\": \"Camera không hỗ "
-                       "trợ gửi ảnh qua Telegram\"}";
-              }
-
-              app.Schedule([esp32_camera]() {
-                if (!esp32_camera->Capture()) {
-                  ESP_LOGE(TAG, "Failed to capture photo");
-                  return;
-                }
-
-                ESP_LOGI(TAG, "Captured photo, sending to Telegram...");
-                TelegramPhotoInfo info;
-
-                auto &telegram_manager = TelegramManager::GetInstance();
-                auto config = telegram_manager.GetConfig();
-
-                info.caption = "";
-                info.parse_mode = "";
-
-                if (!config.chat_id.empty() && !config.bot_token.empty()) {
-                  ESP_LOGI(TAG, "Loaded bot token from TelegramManager");
-                  info.bot_token = config.bot_token;
-                  info.chat_id = config.chat_id;
-
-                  esp32_camera->SendPhotoToTelegram(info);
-                } else {
-                  ESP_LOGW(TAG, "Telegram bot not configured");
-                }
-              });
-
-              return "{\"success\": true, \"message\": \"Đang chụp và gửi ảnh "
-                     "qua Telegram...\"}";
-            });
-
-    AddTool("telegram.send_message",
-            "💬 Gửi tin nhắn text qua Telegram.\n"
-            "Args:\n"
-            "  `message`: Nội dung tin nhắn (hỗ trợ tiếng Việt và emoji).",
-            PropertyList({Property("message", kPropertyTypeString)}),
-            [](const PropertyList &properties) -> ReturnValue {
-              auto message = properties["message"].value<std::string>();
-
-              // app.Schedule([message]() {
-              auto &telegram_manager = TelegramManager::GetInstance();
-              auto config = telegram_manager.GetConfig();
-
-              if (!config.chat_id.empty() && !config.bot_token.empty()) {
-                ESP_LOGI(TAG, "Sending message to Telegram: %s",
-                         message.c_str());
-                // TODO: Implement telegram_manager.SendMessage() method
-                // telegram_manager.SendMessage(message);
-                auto &app = Application::GetInstance();
-                app.SendTelegramMessage(message);
-
-              } else {
-                ESP_LOGW(TAG, "Telegram bot not configured");
-              }
-              // });
+    AddBlockingTool("telegram.send_photo",
+                    "📸 Chụp ảnh và gửi qua Telegram bot.\n"
+                    "Sử dụng khi user yêu cầu chụp ảnh gửi cho người thân.\n"
+                    "Không cần tham số, hệ thống tự động chụp và gửi.",
+                    PropertyList(),
+                    [camera](const PropertyList &properties) -> ReturnValue {
+                      // Cast to Esp32Camera to access SendPhotoToTelegram
+                      auto esp32_camera = dynamic_cast<Esp32Camera *>(camera);
+                      if (!esp32_camera) {
+                        return "{\"success\": false, \"message\": \"Camera không hỗ "
+                               "trợ gửi ảnh qua Telegram\"}";
+                      }
+
+                      // Runs on an MCP worker, capture and upload inline
+                      auto &telegram_manager = TelegramManager::GetInstance();
+                      auto config = telegram_manager.GetConfig();
+                      if (config.chat_id.empty() || config.bot_token.empty()) {
+                        ESP_LOGW(TAG, "Telegram bot not configured");
+                        return "{\"success\": false, \"message\": \"Telegram bot "
+                               "chưa được cấu hình\"}";
+                      }
+                      McpCall::ReportProgress(0, 2, "capture");
+                      if (!esp32_camera->Capture()) {
+                        ESP_LOGE(TAG, "Failed to capture photo");
+                        return "{\"success\": false, \"message\": \"Không thể chụp "
+                               "ảnh\"}";
+                      }
+
+                      // Last point to back out, the upload itself is not interrupted
+                      McpCall::ThrowIfCancelled();
+                      McpCall::ReportProgress(1, 2, "upload");
+
+                      ESP_LOGI(TAG, "Captured photo, sending to Telegram...");
+                      TelegramPhotoInfo info;
+                      info.caption = "";
+                      info.parse_mode = "";
+                      info.bot_token = config.bot_token;
+                      info.chat_id = config.chat_id;
+                      esp32_camera->SendPhotoToTelegram(info);
+                      McpCall::ReportProgress(2, 2);
+
+                      return "{\"success\": true, \"message\": \"Đã chụp và gửi ảnh "
+                             "qua Telegram\"}";
+                    });
 
-              return "{\"success\": true, \"message\": \"Đang gửi tin nhắn qua "
-                     "Telegram...\"}";
-            });
+    AddBlockingTool("telegram.send_message",
+                    "💬 Gửi tin nhắn text qua Telegram.\n"
+                    "Args:\n"
+                    "  `message`: Nội dung tin nhắn (hỗ trợ tiếng Việt và emoji).",
+                    PropertyList({Property("message", kPropertyTypeString)}),
+                    [](const PropertyList &properties) -> ReturnValue {
+                      auto message = properties["message"].value<std::string>();
+
+                      // app.Schedule([message]() {
+                      auto &telegram_manager = TelegramManager::GetInstance();
+                      auto config = telegram_manager.GetConfig();
+
+                      McpCall::ThrowIfCancelled();
+                      if (!config.chat_id.empty() && !config.bot_token.empty()) {
+                        ESP_LOGI(TAG, "Sending message to Telegram: %s",
+                                 message.c_str());
+                        // TODO: Implement telegram_manager.SendMessage() method
+                        // telegram_manager.SendMessage(message);
+                        auto &app = Application::GetInstance();
+                        app.SendTelegramMessage(message);
+
+                      } else {
+                        ESP_LOGW(TAG, "Telegram bot not configured");
+                      }
+                      // });
+
+                      return "{\"success\": true, \"message\": \"Đang gửi tin nhắn qua "
+                             "Telegram...\"}";
+                    });
   }
 
   // ==================== RECURRING SCHEDULE TOOLS ====================
@@ -822,6 +837,62 @@ void McpServer::AddUserOnlyTools() {
                     return board.GetSystemInfoJson();
                   });
 
+  AddUserOnlyTool(
+      "self.telemetry.query",
+      "Get the recorded history of one device metric as [time, value] points, "
+      "time in seconds since boot. Series: " +
+          Telemetry::SeriesNames() +
+          ". Recent data has 1 s resolution, up to a day 1 min, up to 30 days "
+          "1 h.\n"
+          "Args:\n"
+          "  `range_seconds`: How far back to look from now.\n"
+          "  `step_seconds`: Average over this many seconds per point, 0 picks "
+          "a step that keeps the reply short.",
+      PropertyList({Property("series", kPropertyTypeString),
+                    Property("range_seconds", kPropertyTypeInteger, 600, 1,
+                             30 * 24 * 3600),
+                    Property("step_seconds", kPropertyTypeInteger, 0, 0,
+                             24 * 3600)}),
+      [this](const PropertyList &properties) -> ReturnValue {
+        auto series = properties["series"].value<std::string>();
+        auto json = Telemetry::GetInstance().QueryJson(
+            series, properties["range_seconds"].value<int>(),
+            properties["step_seconds"].value<int>());
+        if (json.empty()) {
+          throw std::runtime_error("Unknown series: " + series);
+        }
+        cJSON *result = cJSON_Parse(json.c_str());
+        if (result == nullptr) {
+          return json;
+        }
+        return result;
+      });
+
+  AddUserOnlyTool("self.get_mcp_stats",
+                  "Get MCP tool call timing: per tool counts, errors, average "
+                  "parse / queue / run / reply time and a latency histogram, "
+                  "plus the most recent calls",
+                  PropertyList(),
+                  [this](const PropertyList &properties) -> ReturnValue {
+                    return tracer_.GetStatsJson();
+                  });
+
+#if CONFIG_MAIN_LOOP_PROFILING
+  AddUserOnlyTool("self.main_loop.get_stats",
+                  "Get main loop timing: stall count, lane queue stats and the "
+                  "slowest call sites",
+                  PropertyList(),
+                  [this](const PropertyList &properties) -> ReturnValue {
+                    auto &app = Application::GetInstance();
+                    auto json = app.GetMainLoopStatsJson();
+                    cJSON *stats = cJSON_Parse(json.c_str());
+                    if (stats == nullptr) {
+                      return json;
+                    }
+                    return stats;
+                  });
+#endif
+
   AddUserOnlyTool("self.reboot", "Reboot the system", PropertyList(),
                   [this](const PropertyList &properties) -> ReturnValue {
                     auto &app = Application::GetInstance();
@@ -1003,9 +1074,7 @@ void McpServer::AddUserOnlyTools() {
 
 void McpServer::AddTool(McpTool *tool) {
   // Prevent adding duplicate tools
-  if (std::find_if(tools_.begin(), tools_.end(), [tool](const McpTool *t) {
-        return t->name() == tool->name();
-      }) != tools_.end()) {
+  if (tool_index_.count(tool->name()) > 0) {
     ESP_LOGW(TAG, "Tool %s already added", tool->name().c_str());
     return;
   }
@@ -1013,6 +1082,8 @@ void McpServer::AddTool(McpTool *tool) {
   ESP_LOGI(TAG, "Add tool: %s%s", tool->name().c_str(),
            tool->user_only() ? " [user]" : "");
   tools_.push_back(tool);
+  tool_index_[tool->name()] = tool;
+  tools_list_.Clear();
 }
 
 void McpServer::AddTool(
@@ -1031,6 +1102,16 @@ void McpServer::AddUserOnlyTool(
   AddTool(tool);
 }
 
+void McpServer::AddBlockingTool(
+    const std::string &name, const std::string &description,
+    const PropertyList &properties,
+    std::function<ReturnValue(const PropertyList &)> callback,
+    int max_concurrency, McpToolGroup *group) {
+  auto tool = new McpTool(name, description, properties, callback);
+  tool->set_blocking(max_concurrency, group);
+  AddTool(tool);
+}
+
 void McpServer::ParseMessage(const std::string &message) {
   cJSON *json = cJSON_Parse(message.c_str());
   if (json == nullptr) {
@@ -1061,6 +1142,12 @@ void McpServer::ParseCapabilities(const cJSON *capabilities) {
 }
 
 void McpServer::ParseMessage(const cJSON *json) {
+  if (cJSON_IsArray(json)) {
+    ParseBatch(json);
+    return;
+  }
+  auto received_us = esp_timer_get_time();
+
   // Check JSONRPC version
   auto version = cJSON_GetObjectItem(json, "jsonrpc");
   if (version == nullptr || !cJSON_IsString(version) ||
@@ -1078,6 +1165,16 @@ void McpServer::ParseMessage(const cJSON *json) {
   }
 
   auto method_str = std::string(method->valuestring);
+  if (method_str == "notifications/cancelled") {
+    auto params = cJSON_GetObjectItem(json, "params");
+    auto request_id = cJSON_GetObjectItem(params, "requestId");
+    if (cJSON_IsNumber(request_id)) {
+      bool found = calls_.Cancel(request_id->valueint);
+      ESP_LOGI(TAG, "Cancel call %d%s", request_id->valueint,
+               found ? "" : ": not running");
+    }
+    return;
+  }
   if (method_str.find("notifications") == 0) {
     return;
   }
@@ -1142,7 +1239,8 @@ void McpServer::ParseMessage(const cJSON *json) {
       ReplyError(id_int, "Invalid arguments");
       return;
     }
-    DoToolCall(id_int, std::string(tool_name->valuestring), tool_arguments);
+    DoToolCall(id_int, std::string(tool_name->valuestring), tool_arguments,
+               cJSON_GetObjectItem(params, "_meta"), received_us);
   } else {
     ESP_LOGE(TAG, "Method not implemented: %s", method_str.c_str());
     ReplyError(id_int, "Method not implemented: " + method_str);
@@ -1150,136 +1248,382 @@ void McpServer::ParseMessage(const cJSON *json) {
 }
 
 void McpServer::ReplyResult(int id, const std::string &result) {
-  std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":";
-  payload += std::to_string(id) + ",\"result\":";
-  payload += result;
-  payload += "}";
-  Application::GetInstance().SendMcpMessage(payload);
+  // The (possibly large) result is copied exactly once
+  SendReply(id, result.size() + 64, [id, &result](JsonWriter &json) {
+    json.BeginObject()
+        .Field("jsonrpc", "2.0")
+        .Field("id", id)
+        .Key("result").Raw(result)
+        .EndObject();
+  });
+}
+
+void McpServer::ReplyToolResult(int id, const ReturnValue &value,
+                                const McpTrace *trace) {
+  // Text is escaped and images are base64 encoded straight into the message
+  SendReply(id, McpTool::ResultSize(value, trace) + 64,
+            [id, &value, trace](JsonWriter &json) {
+              json.BeginObject()
+                  .Field("jsonrpc", "2.0")
+                  .Field("id", id)
+                  .Key("result");
+              McpTool::WriteResult(json, value, trace);
+              json.EndObject();
+            });
 }
 
 void McpServer::ReplyError(int id, const std::string &message) {
-  std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":";
-  payload += std::to_string(id);
-  payload += ",\"error\":{\"message\":\"";
-  payload += message;
-  payload += "\"}}";
-  Application::GetInstance().SendMcpMessage(payload);
+  SendReply(id, JsonWriter::EscapedSize(message.size()) + 64,
+            [id, &message](JsonWriter &json) {
+              json.BeginObject()
+                  .Field("jsonrpc", "2.0")
+                  .Field("id", id)
+                  .Key("error").BeginObject().Field("message", message).EndObject()
+                  .EndObject();
+            });
 }
 
-void McpServer::GetToolsList(int id, const std::string &cursor,
-                             bool list_user_only_tools) {
-  const int max_payload_size = 8000;
-  std::string json = "{\"tools\":[";
-
-  bool found_cursor = cursor.empty();
-  auto it = tools_.begin();
-  std::string next_cursor = "";
-
-  while (it != tools_.end()) {
-    // 如果我们还没有找到起始位置，继续搜索
-    if (!found_cursor) {
-      if ((*it)->name() == cursor) {
-        found_cursor = true;
-      } else {
-        ++it;
+void McpServer::SendReply(int id, size_t size,
+                          const std::function<void(JsonWriter &)> &write) {
+  auto batch = TakeBatch(id);
+  if (batch == nullptr) {
+    Application::GetInstance().SendMcpMessage(size, write);
+    return;
+  }
+  std::string payload(size, '\0');
+  JsonWriter json(payload.data(), payload.size());
+  write(json);
+  if (json.overflow()) {
+    ESP_LOGE(TAG, "Response %d larger than %d bytes", id, (int)size);
+    batch->Drop(id);
+  } else {
+    payload.resize(json.size());
+    batch->Complete(id, std::move(payload));
+  }
+  PumpBatch(batch);
+}
+
+void McpServer::DropReply(int id) {
+  auto batch = TakeBatch(id);
+  if (batch != nullptr) {
+    batch->Drop(id);
+    PumpBatch(batch);
+  }
+}
+
+std::shared_ptr<McpBatch> McpServer::TakeBatch(int id) {
+  std::lock_guard<std::mutex> lock(batches_mutex_);
+  auto it = batches_.find(id);
+  if (it == batches_.end()) {
+    return nullptr;
+  }
+  auto batch = std::move(it->second);
+  batches_.erase(it);
+  return batch;
+}
+
+void McpServer::ParseBatch(const cJSON *json) {
+  int size = cJSON_GetArraySize(json);
+  if (size == 0 || size > MCP_BATCH_MAX_SIZE) {
+    ESP_LOGE(TAG, "Invalid batch of %d entries", size);
+    Application::GetInstance().SendMcpMessage(
+        "{\"jsonrpc\":\"2.0\",\"id\":null,\"error\":{\"code\":-32600,"
+        "\"message\":\"Invalid batch size\"}}");
+    return;
+  }
+
+  auto batch = std::make_shared<McpBatch>(
+      [](const std::string &payload) {
+        Application::GetInstance().SendMcpMessage(payload);
+      },
+      cJSON_Delete);
+
+  // Every id that expects a response is known before anything runs, so an
+  // early response cannot send a partial batch
+  std::vector<const cJSON *> others;
+  const cJSON *entry;
+  cJSON_ArrayForEach(entry, json) {
+    if (!cJSON_IsObject(entry)) {
+      ESP_LOGW(TAG, "Batch: skipping entry that is not an object");
+      continue;
+    }
+    auto id = cJSON_GetObjectItem(entry, "id");
+    auto method = cJSON_GetObjectItem(entry, "method");
+    bool request = cJSON_IsNumber(id) && cJSON_IsString(method) &&
+                   strncmp(method->valuestring, "notifications", 13) != 0;
+    if (request) {
+      // A single call still running holds the id in calls_ only
+      bool registered = !calls_.Contains(id->valueint);
+      if (registered) {
+        std::lock_guard<std::mutex> lock(batches_mutex_);
+        registered = batches_.emplace(id->valueint, batch).second;
+      }
+      // The id is already waiting for a response, from a single call, this
+      // batch or another one: answering it twice would confuse the server and
+      // a cancel could not tell the calls apart, refuse the entry
+      if (!registered) {
+        ESP_LOGW(TAG, "Batch: rejecting duplicate id %d", id->valueint);
+        batch->AddResponse(
+            "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(id->valueint) +
+            ",\"error\":{\"code\":-32600,\"message\":\"Duplicate id\"}}");
         continue;
       }
+      batch->Expect(id->valueint);
     }
-
-    if (!list_user_only_tools && (*it)->user_only()) {
-      ++it;
-      continue;
+    if (request && strcmp(method->valuestring, "tools/call") == 0) {
+      batch->AddCall(id->valueint, cJSON_Duplicate(entry, true));
+    } else {
+      others.push_back(entry);
     }
+  }
 
-    // 添加tool前检查大小
-    std::string tool_json = (*it)->to_json() + ",";
-    if (json.length() + tool_json.length() + 30 > max_payload_size) {
-      // 如果添加这个tool会超出大小限制，设置next_cursor并退出循环
-      next_cursor = (*it)->name();
-      break;
+  // Everything but tools/call is handled right away
+  for (auto other : others) {
+    ParseMessage(other);
+    auto id = cJSON_GetObjectItem(other, "id");
+    if (cJSON_IsNumber(id) && batch->Expects(id->valueint)) {
+      DropReply(id->valueint);
     }
+  }
+  ESP_LOGI(TAG, "Batch of %d entries", size);
+  batch->Seal();
+  PumpBatch(batch);
+}
 
-    json += tool_json;
-    ++it;
+void McpServer::PumpBatch(const std::shared_ptr<McpBatch> &batch) {
+  if (!batch->BeginDispatch()) {
+    return;
   }
+  do {
+    int id;
+    cJSON *entry;
+    while ((entry = batch->NextEntry(id)) != nullptr) {
+      ParseMessage(entry);
+      cJSON_Delete(entry);
+      // Rejected without a response, free its slot
+      if (batch->Expects(id) && !calls_.Contains(id)) {
+        DropReply(id);
+      }
+    }
+  } while (!batch->EndDispatch());
+}
 
-  if (json.back() == ',') {
-    json.pop_back();
+void McpServer::GetToolsList(int id, const std::string &cursor,
+                             bool list_user_only_tools) {
+  // Schemas do not change after registration, serialise them once
+  if (tools_list_.empty()) {
+    for (auto tool : tools_) {
+      tools_list_.Add(tool->name(), tool->to_json(), tool->user_only());
+    }
   }
 
-  if (json.back() == '[' && !tools_.empty()) {
+  std::string json;
+  std::string failed_tool;
+  if (!tools_list_.Render(cursor, list_user_only_tools, json, failed_tool)) {
+    if (failed_tool.empty()) {
+      ESP_LOGE(TAG, "tools/list: Unknown cursor: %s", cursor.c_str());
+      ReplyError(id, "Unknown cursor: " + cursor);
+      return;
+    }
     // 如果没有添加任何tool，返回错误
     ESP_LOGE(TAG,
              "tools/list: Failed to add tool %s because of payload size limit",
-             next_cursor.c_str());
-    ReplyError(id, "Failed to add tool " + next_cursor +
+             failed_tool.c_str());
+    ReplyError(id, "Failed to add tool " + failed_tool +
                        " because of payload size limit");
     return;
   }
 
-  if (next_cursor.empty()) {
-    json += "]}";
-  } else {
-    json += "],\"nextCursor\":\"" + next_cursor + "\"}";
-  }
-
   ReplyResult(id, json);
 }
 
 void McpServer::DoToolCall(int id, const std::string &tool_name,
-                           const cJSON *tool_arguments) {
-  auto tool_iter = std::find_if(
-      tools_.begin(), tools_.end(),
-      [&tool_name](const McpTool *tool) { return tool->name() == tool_name; });
-
-  if (tool_iter == tools_.end()) {
+                           const cJSON *tool_arguments, const cJSON *meta,
+                           int64_t received_us) {
+  auto tool_iter = tool_index_.find(tool_name);
+  if (tool_iter == tool_index_.end()) {
     ESP_LOGE(TAG, "tools/call: Unknown tool: %s", tool_name.c_str());
     ReplyError(id, "Unknown tool: " + tool_name);
     return;
   }
 
-  PropertyList arguments = (*tool_iter)->properties();
+  auto tool = tool_iter->second;
+  McpTool::BoundCall bound;
   try {
-    for (auto &argument : arguments) {
-      bool found = false;
-      if (cJSON_IsObject(tool_arguments)) {
-        auto value =
-            cJSON_GetObjectItem(tool_arguments, argument.name().c_str());
-        if (argument.type() == kPropertyTypeBoolean && cJSON_IsBool(value)) {
-          argument.set_value<bool>(value->valueint == 1);
-          found = true;
-        } else if (argument.type() == kPropertyTypeInteger &&
-                   cJSON_IsNumber(value)) {
-          argument.set_value<int>(value->valueint);
-          found = true;
-        } else if (argument.type() == kPropertyTypeString &&
-                   cJSON_IsString(value)) {
-          argument.set_value<std::string>(value->valuestring);
-          found = true;
-        }
-      }
-
-      if (!argument.has_default_value() && !found) {
-        ESP_LOGE(TAG, "tools/call: Missing valid argument: %s",
-                 argument.name().c_str());
-        ReplyError(id, "Missing valid argument: " + argument.name());
-        return;
-      }
-    }
+    bound = tool->Bind(tool_arguments);
   } catch (const std::exception &e) {
     ESP_LOGE(TAG, "tools/call: %s", e.what());
     ReplyError(id, e.what());
     return;
   }
+  auto parsed_us = esp_timer_get_time();
+
+  // Progress is only reported when the client passes a token
+  std::string progress_token;
+  auto token = cJSON_GetObjectItem(meta, "progressToken");
+  if (cJSON_IsString(token) || cJSON_IsNumber(token)) {
+    char *token_str = cJSON_PrintUnformatted(token);
+    progress_token = token_str;
+    cJSON_free(token_str);
+  }
+
+  auto call = calls_.Begin(id, progress_token, [](const std::string &payload) {
+    Application::GetInstance().SendMcpMessage(payload);
+  });
+  if (call == nullptr) {
+    ESP_LOGE(TAG, "tools/call: Request %d is already running", id);
+    ReplyError(id, "Duplicate request id");
+    return;
+  }
+  auto &trace = call->trace();
+  trace.tool = tool->name().c_str();
+  trace.Mark(kMcpTraceReceived, received_us);
+  trace.Mark(kMcpTraceParsed, parsed_us);
+  call->set_trace_reply(cJSON_IsTrue(cJSON_GetObjectItem(meta, "trace")));
+  trace.Mark(kMcpTraceScheduled, esp_timer_get_time());
+
+  if (tool->blocking()) {
+    RunOnWorker(std::move(call), tool, std::move(bound));
+    return;
+  }
 
   // Use main thread to call the tool
   auto &app = Application::GetInstance();
-  app.Schedule([this, id, tool_iter, arguments = std::move(arguments)]() {
+  app.Schedule(kTaskLaneBackground,
+               [this, call = std::move(call), bound = std::move(bound)]() {
+                 RunCall(*call, bound);
+               });
+}
+
+void McpServer::RunCall(McpCall &call, const McpTool::BoundCall &bound) {
+  ReturnValue value;
+  std::string error;
+  call.trace().Mark(kMcpTraceStarted, esp_timer_get_time());
+  {
+    McpCall::Scope scope(&call);
     try {
-      ReplyResult(id, (*tool_iter)->Call(arguments));
+      McpCall::ThrowIfCancelled();
+      value = bound();
+      McpTool::PrintResult(value);
+    } catch (const McpCancelled &) {
     } catch (const std::exception &e) {
       ESP_LOGE(TAG, "tools/call: %s", e.what());
-      ReplyError(id, e.what());
+      error = e.what();
+    }
+  }
+  call.trace().Mark(kMcpTraceFinished, esp_timer_get_time());
+  // Written into the response, freed here whatever happens to the call
+  std::unique_ptr<ImageContent> image(
+      std::holds_alternative<ImageContent *>(value)
+          ? std::get<ImageContent *>(value)
+          : nullptr);
+
+  // A cancelled request gets no response
+  if (call.cancelled()) {
+    ESP_LOGI(TAG, "tools/call: %d cancelled", call.id());
+    DropReply(call.id());
+  } else if (!error.empty()) {
+    call.trace().error = true;
+    ReplyError(call.id(), error);
+  } else {
+    ReplyToolResult(call.id(), value,
+                    call.trace_reply() ? &call.trace() : nullptr);
+  }
+  RecordTrace(call);
+  // Only after the reply, a batch treats an id it still waits for as running
+  calls_.End(call.id());
+}
+
+void McpServer::RecordTrace(McpCall &call) {
+  auto &trace = call.trace();
+  trace.Mark(kMcpTraceReplied, esp_timer_get_time());
+  trace.cancelled = call.cancelled();
+  tracer_.Record(trace);
+  int64_t total_us = trace.Span(kMcpTraceReceived, kMcpTraceReplied);
+  if (total_us >= (int64_t)MCP_TRACE_SLOW_MS * 1000) {
+    ESP_LOGW(TAG, "tools/call: %s took %d ms (queue %d, run %d, reply %d)",
+             trace.tool, (int)(total_us / 1000),
+             (int)(trace.Span(kMcpTraceScheduled, kMcpTraceStarted) / 1000),
+             (int)(trace.Span(kMcpTraceStarted, kMcpTraceFinished) / 1000),
+             (int)(trace.Span(kMcpTraceFinished, kMcpTraceReplied) / 1000));
+  }
+}
+
+struct McpToolJob {
+  std::shared_ptr<McpCall> call;
+  McpTool *tool;
+  McpTool::BoundCall bound;
+};
+
+void McpServer::RunOnWorker(std::shared_ptr<McpCall> call, McpTool *tool,
+                            McpTool::BoundCall &&bound) {
+  int id = call->id();
+  StartWorkers();
+  {
+    // The tool's slot is taken when a worker starts the job, so a second call
+    // to a busy tool waits its turn instead of being turned away
+    std::lock_guard<std::mutex> lock(worker_mutex_);
+    if (worker_jobs_.size() < MCP_TOOL_WORKER_QUEUE_SIZE) {
+      worker_jobs_.push_back(
+          new McpToolJob{std::move(call), tool, std::move(bound)});
+      worker_condition_.notify_all();
+      return;
+    }
+  }
+  ESP_LOGW(TAG, "tools/call: worker queue full, rejecting %s",
+           tool->name().c_str());
+  call->trace().error = true;
+  calls_.End(id);
+  ReplyError(id, "Too many tool calls in progress");
+  RecordTrace(*call);
+}
+
+void McpServer::StartWorkers() {
+  // Started on first use, boards without blocking tools never pay for the
+  // stacks. Batches can dispatch from a worker, so guard against two callers
+  std::call_once(workers_once_, [this]() {
+    for (int i = 0; i < MCP_TOOL_WORKER_COUNT; i++) {
+      char name[16];
+      snprintf(name, sizeof(name), "mcp_worker_%d", i);
+      xTaskCreate(
+          [](void *arg) {
+            ((McpServer *)arg)->WorkerTask();
+            vTaskDelete(NULL);
+          },
+          name, MCP_TOOL_WORKER_STACK_SIZE, this, 2, nullptr);
     }
   });
 }
+
+void McpServer::WorkerTask() {
+  while (true) {
+    McpToolJob *job = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(worker_mutex_);
+      worker_condition_.wait(lock, [this, &job]() {
+        // First job in arrival order whose tool has a free slot
+        auto it = std::find_if(
+            worker_jobs_.begin(), worker_jobs_.end(),
+            [](McpToolJob *queued) { return queued->tool->TryAcquire(); });
+        if (it == worker_jobs_.end()) {
+          return false;
+        }
+        job = *it;
+        worker_jobs_.erase(it);
+        return true;
+      });
+    }
+    auto start_time = esp_timer_get_time();
+    RunCall(*job->call, job->bound);
+    ESP_LOGI(TAG, "tools/call: %s done on worker in %d ms",
+             job->tool->name().c_str(),
+             (int)((esp_timer_get_time() - start_time) / 1000));
+    {
+      // A call queued behind this one may be waiting for the slot
+      std::lock_guard<std::mutex> lock(worker_mutex_);
+      job->tool->Release();
+      worker_condition_.notify_all();
+    }
+    delete job;
+  }
+}
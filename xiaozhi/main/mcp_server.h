@@ -4,47 +4,31 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <functional>
 #include <variant>
 #include <optional>
 #include <stdexcept>
 #include <thread>
-#include <mbedtls/base64.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 #include <cJSON.h>
 
-class ImageContent {
-private:
-    std::string encoded_data_;
-    std::string mime_type_;
-
-    static std::string Base64Encode(const std::string& data) {
-        size_t dlen = 0, olen = 0;
-        mbedtls_base64_encode((unsigned char*)nullptr, 0, &dlen, (const unsigned char*)data.data(), data.size());
-        std::string result(dlen, 0);
-        mbedtls_base64_encode((unsigned char*)result.data(), result.size(), &olen, (const unsigned char*)data.data(), data.size());
-        return result;
-    }
+#include "mcp_batch.h"
+#include "mcp_call.h"
+#include "mcp_image_content.h"
+#include "mcp_tool_params.h"
+#include "mcp_tools_list.h"
 
-public:
-    ImageContent(const std::string& mime_type, const std::string& data) {
-        mime_type_ = mime_type;
-        // base64 encode data
-        encoded_data_ = Base64Encode(data);
-    }
-
-    std::string to_json() const {
-        cJSON *json = cJSON_CreateObject();
-        cJSON_AddStringToObject(json, "type", "image");
-        cJSON_AddStringToObject(json, "mimeType", mime_type_.c_str());
-        cJSON_AddStringToObject(json, "data", encoded_data_.c_str());
-        char* json_str = cJSON_PrintUnformatted(json);
-        std::string result(json_str);
-        cJSON_free(json_str);
-        cJSON_Delete(json);
-        return result;
-    }
-};
+// Blocking tools run on this many worker tasks instead of the main loop
+#define MCP_TOOL_WORKER_COUNT 2
+#define MCP_TOOL_WORKER_STACK_SIZE 8192
+// Calls waiting for a free worker or for their tool's slot, more are rejected
+#define MCP_TOOL_WORKER_QUEUE_SIZE 4
 
 // 添加类型别名
 using ReturnValue = std::variant<bool, int, std::string, cJSON*, ImageContent*>;
@@ -205,13 +189,75 @@ public:
     }
 };
 
+// Schema of a typed parameter, see mcp_tool_params.h
+inline Property ToProperty(const McpParam<bool>& param) {
+    if (param.default_value.has_value()) {
+        return Property(param.name, kPropertyTypeBoolean, param.default_value.value());
+    }
+    return Property(param.name, kPropertyTypeBoolean);
+}
+
+inline Property ToProperty(const McpParam<int>& param) {
+    if (param.min_value.has_value() && param.max_value.has_value()) {
+        if (param.default_value.has_value()) {
+            return Property(param.name, kPropertyTypeInteger, param.default_value.value(), param.min_value.value(), param.max_value.value());
+        }
+        return Property(param.name, kPropertyTypeInteger, param.min_value.value(), param.max_value.value());
+    }
+    if (param.default_value.has_value()) {
+        return Property(param.name, kPropertyTypeInteger, param.default_value.value());
+    }
+    return Property(param.name, kPropertyTypeInteger);
+}
+
+inline Property ToProperty(const McpParam<std::string>& param) {
+    if (param.default_value.has_value()) {
+        return Property(param.name, kPropertyTypeString, param.default_value.value());
+    }
+    return Property(param.name, kPropertyTypeString);
+}
+
+// Tools that drive the same resource (the vehicle, the storage cabinet) share
+// one group, a worker only starts a call when both the tool and its group
+// have a free slot
+class McpToolGroup {
+private:
+    int max_concurrency_;
+    std::atomic<int> running_{0};
+
+public:
+    explicit McpToolGroup(int max_concurrency = 1) : max_concurrency_(max_concurrency) {}
+
+    bool TryAcquire() {
+        int running = running_.load();
+        while (running < max_concurrency_) {
+            if (running_.compare_exchange_weak(running, running + 1)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    void Release() { running_--; }
+};
+
 class McpTool {
+public:
+    // A call with its arguments checked and copied out of the request
+    using BoundCall = std::function<ReturnValue()>;
+    // Typed tools read their arguments from the request themselves, throws on invalid ones
+    using ArgumentParser = std::function<BoundCall(const cJSON* arguments)>;
+
 private:
     std::string name_;
     std::string description_;
     PropertyList properties_;
     std::function<ReturnValue(const PropertyList&)> callback_;
+    ArgumentParser parser_;
     bool user_only_ = false;
+    bool blocking_ = false;
+    int max_concurrency_ = 1;
+    std::atomic<int> running_{0};
+    McpToolGroup* group_ = nullptr;
 
 public:
     McpTool(const std::string& name, 
@@ -223,11 +269,50 @@ public:
         properties_(properties), 
         callback_(callback) {}
 
+    // properties only describe the schema, the parser reads the arguments
+    McpTool(const std::string& name,
+            const std::string& description,
+            const PropertyList& properties,
+            ArgumentParser parser)
+        : name_(name),
+        description_(description),
+        properties_(properties),
+        parser_(std::move(parser)) {}
+
     void set_user_only(bool user_only) { user_only_ = user_only; }
+    // Blocking tools run on the MCP worker pool, at most max_concurrency calls
+    // at once (and one group slot each); further calls wait in the worker
+    // queue for a slot
+    void set_blocking(int max_concurrency, McpToolGroup* group = nullptr) {
+        blocking_ = true;
+        max_concurrency_ = max_concurrency;
+        group_ = group;
+    }
     inline const std::string& name() const { return name_; }
     inline const std::string& description() const { return description_; }
     inline const PropertyList& properties() const { return properties_; }
     inline bool user_only() const { return user_only_; }
+    inline bool blocking() const { return blocking_; }
+
+    bool TryAcquire() {
+        int running = running_.load();
+        do {
+            if (running >= max_concurrency_) {
+                return false;
+            }
+        } while (!running_.compare_exchange_weak(running, running + 1));
+        if (group_ != nullptr && !group_->TryAcquire()) {
+            running_--;
+            return false;
+        }
+        return true;
+    }
+    void Release() {
+        if (group_ != nullptr) {
+            group_->Release();
+        }
+        running_--;
+    }
 
     std::string to_json() const {
         std::vector<std::string> required = properties_.GetRequired();
@@ -269,48 +354,101 @@ public:
         return result;
     }
 
-    std::string Call(const PropertyList& properties) {
-        ReturnValue return_value = callback_(properties);
-        // 返回结果
-        cJSON* result = cJSON_CreateObject();
-        cJSON* content = cJSON_CreateArray();
+    // Checks and copies the arguments of a call, throws on a missing or invalid one
+    BoundCall Bind(const cJSON* arguments) {
+        if (parser_) {
+            return parser_(arguments);
+        }
 
-        if (std::holds_alternative<ImageContent*>(return_value)) {
-            auto image_content = std::get<ImageContent*>(return_value);
-            cJSON* image = cJSON_CreateObject();
-            cJSON_AddStringToObject(image, "type", "image");
-            cJSON_AddStringToObject(image, "image", image_content->to_json().c_str());
-            cJSON_AddItemToArray(content, image);
-            delete image_content;
+        PropertyList properties = properties_;
+        for (auto& property : properties) {
+            bool found = false;
+            if (cJSON_IsObject(arguments)) {
+                auto value = cJSON_GetObjectItem(arguments, property.name().c_str());
+                if (property.type() == kPropertyTypeBoolean && cJSON_IsBool(value)) {
+                    property.set_value<bool>(value->valueint == 1);
+                    found = true;
+                } else if (property.type() == kPropertyTypeInteger && cJSON_IsNumber(value)) {
+                    property.set_value<int>(value->valueint);
+                    found = true;
+                } else if (property.type() == kPropertyTypeString && cJSON_IsString(value)) {
+                    property.set_value<std::string>(value->valuestring);
+                    found = true;
+                }
+            }
+            if (!property.has_default_value() && !found) {
+                throw std::runtime_error("Missing valid argument: " + property.name());
+            }
+        }
+        return [this, properties = std::move(properties)]() { return callback_(properties); };
+    }
+
+    // tools/call result for the value a tool returned
+    // cJSON results are printed into a string once, before sizing
+    static void PrintResult(ReturnValue& value) {
+        if (std::holds_alternative<cJSON*>(value)) {
+            cJSON* json = std::get<cJSON*>(value);
+            char* json_str = cJSON_PrintUnformatted(json);
+            std::string text(json_str != nullptr ? json_str : "");
+            cJSON_free(json_str);
+            cJSON_Delete(json);
+            value = std::move(text);
+        }
+    }
+
+    // Upper bound of WriteResult(), after PrintResult()
+    static size_t ResultSize(const ReturnValue& value, const McpTrace* trace = nullptr) {
+        size_t size = trace != nullptr ? 256 : 0;
+        if (std::holds_alternative<ImageContent*>(value)) {
+            return size + std::get<ImageContent*>(value)->json_size() + 64;
+        }
+        if (std::holds_alternative<std::string>(value)) {
+            return size + JsonWriter::StringSize(std::get<std::string>(value)) + 64;
+        }
+        return size + 96;
+    }
+
+    // {"content":[...],"isError":false}, after PrintResult(); the image stays
+    // with the caller. With a trace, the timings so far go into _meta
+    static void WriteResult(JsonWriter& json, const ReturnValue& value, const McpTrace* trace = nullptr) {
+        json.BeginObject().Key("content").BeginArray();
+        if (std::holds_alternative<ImageContent*>(value)) {
+            std::get<ImageContent*>(value)->Write(json);
         } else {
-            cJSON* text = cJSON_CreateObject();
-            cJSON_AddStringToObject(text, "type", "text");
-            if (std::holds_alternative<std::string>(return_value)) {
-                cJSON_AddStringToObject(text, "text", std::get<std::string>(return_value).c_str());
-            } else if (std::holds_alternative<bool>(return_value)) {
-                cJSON_AddStringToObject(text, "text", std::get<bool>(return_value) ? "true" : "false");
-            } else if (std::holds_alternative<int>(return_value)) {
-                cJSON_AddStringToObject(text, "text", std::to_string(std::get<int>(return_value)).c_str());
-            } else if (std::holds_alternative<cJSON*>(return_value)) {
-                cJSON* json = std::get<cJSON*>(return_value);
-                char* json_str = cJSON_PrintUnformatted(json);
-                cJSON_AddStringToObject(text, "text", json_str);
-                cJSON_free(json_str);
-                cJSON_Delete(json);
+            json.BeginObject().Field("type", "text").Key("text");
+            if (std::holds_alternative<std::string>(value)) {
+                json.String(std::get<std::string>(value));
+            } else if (std::holds_alternative<bool>(value)) {
+                json.String(std::get<bool>(value) ? "true" : "false");
+            } else if (std::holds_alternative<int>(value)) {
+                json.String(std::to_string(std::get<int>(value)));
             }
-            cJSON_AddItemToArray(content, text);
+            json.EndObject();
         }
-        cJSON_AddItemToObject(result, "content", content);
-        cJSON_AddBoolToObject(result, "isError", false);
+        json.EndArray().Field("isError", false);
+        if (trace != nullptr) {
+            json.Key("_meta").BeginObject().Key("trace");
+            trace->Write(json);
+            json.EndObject();
+        }
+        json.EndObject();
+    }
 
-        auto json_str = cJSON_PrintUnformatted(result);
-        std::string result_str(json_str);
-        cJSON_free(json_str);
-        cJSON_Delete(result);
-        return result_str;
+    static std::string FormatResult(ReturnValue return_value) {
+        PrintResult(return_value);
+        std::string result(ResultSize(return_value), '\0');
+        JsonWriter json(result.data(), result.size());
+        WriteResult(json, return_value);
+        result.resize(json.size());
+        if (std::holds_alternative<ImageContent*>(return_value)) {
+            delete std::get<ImageContent*>(return_value);
+        }
+        return result;
     }
 };
 
+struct McpToolJob;
+
 class McpServer {
 public:
     static McpServer& GetInstance() {
@@ -323,6 +461,19 @@ public:
     void AddTool(McpTool* tool);
     void AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
     void AddUserOnlyTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
+    // For tools that wait on hardware or the network: runs off the main loop, the reply is sent from the worker
+    void AddBlockingTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback, int max_concurrency = 1, McpToolGroup* group = nullptr);
+    // Typed parameters and handler, see mcp_tool_params.h
+    template <typename... Ts, typename Handler>
+    void AddTypedTool(const std::string& name, const std::string& description, const std::tuple<McpParam<Ts>...>& params, Handler handler) {
+        AddTool(NewTypedTool(name, description, params, std::move(handler)));
+    }
+    template <typename... Ts, typename Handler>
+    void AddTypedBlockingTool(const std::string& name, const std::string& description, const std::tuple<McpParam<Ts>...>& params, Handler handler, int max_concurrency = 1, McpToolGroup* group = nullptr) {
+        auto tool = NewTypedTool(name, description, params, std::move(handler));
+        tool->set_blocking(max_concurrency, group);
+        AddTool(tool);
+    }
     void ParseMessage(const cJSON* json);
     void ParseMessage(const std::string& message);
 
@@ -332,13 +483,53 @@ private:
 
     void ParseCapabilities(const cJSON* capabilities);
 
+    template <typename... Ts, typename Handler>
+    static McpTool* NewTypedTool(const std::string& name, const std::string& description, const std::tuple<McpParam<Ts>...>& params, Handler handler) {
+        auto properties = std::apply([](const auto&... param) {
+            return PropertyList(std::vector<Property>{ToProperty(param)...});
+        }, params);
+        return new McpTool(name, description, properties, [params, handler](const cJSON* arguments) -> McpTool::BoundCall {
+            auto values = McpParseArguments(arguments, params);
+            return [handler, values = std::move(values)]() -> ReturnValue { return std::apply(handler, values); };
+        });
+    }
+
     void ReplyResult(int id, const std::string& result);
+    void ReplyToolResult(int id, const ReturnValue& value, const McpTrace* trace);
     void ReplyError(int id, const std::string& message);
+    // Responses of batch entries are collected by their batch, the rest are
+    // written straight into the outgoing message
+    void SendReply(int id, size_t size, const std::function<void(JsonWriter&)>& write);
+    void DropReply(int id);
+
+    void ParseBatch(const cJSON* json);
+    void PumpBatch(const std::shared_ptr<McpBatch>& batch);
+    std::shared_ptr<McpBatch> TakeBatch(int id);
 
     void GetToolsList(int id, const std::string& cursor, bool list_user_only_tools);
-    void DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments);
+    void DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, const cJSON* meta,
+        int64_t received_us);
+    void RunOnWorker(std::shared_ptr<McpCall> call, McpTool* tool, McpTool::BoundCall&& bound);
+    void RunCall(McpCall& call, const McpTool::BoundCall& bound);
+    // Once the call is answered (or dropped)
+    void RecordTrace(McpCall& call);
+    void StartWorkers();
+    void WorkerTask();
 
     std::vector<McpTool*> tools_;
+    std::unordered_map<std::string, McpTool*> tool_index_;
+    // Serialised once on the first tools/list, dropped when a tool is added
+    McpToolsList tools_list_;
+    McpCallRegistry calls_;
+    McpTracer tracer_;
+    // Batch waiting for each id, shared by the main loop and the MCP workers
+    std::mutex batches_mutex_;
+    std::unordered_map<int, std::shared_ptr<McpBatch>> batches_;
+    std::once_flag workers_once_;
+    // Jobs in arrival order, a worker runs the first whose tool has a free slot
+    std::mutex worker_mutex_;
+    std::condition_variable worker_condition_;
+    std::deque<McpToolJob*> worker_jobs_;
 };
 
 #endif // MCP_SERVER_H
@@ -0,0 +1,122 @@
+#ifndef MCP_TOOL_PARAMS_H
+#define MCP_TOOL_PARAMS_H
+
+#include <cJSON.h>
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+/*
+ * Typed tool arguments, see McpServer::AddTypedTool.
+ * The parameter list is a tuple of McpParam<bool|int|std::string>, its types
+ * are fixed at compile time and the handler takes the values in the same
+ * order, e.g. McpParams(McpInt("speed", 0, 100), McpBool("forward", true))
+ * with [](int speed, bool forward) { ... }. A call reads each argument from
+ * the request object straight into a std::tuple, so there is no PropertyList
+ * copy and the handler does no lookups by name or variant checks.
+ */
+template <typename T>
+struct McpParam {
+    const char* name;
+    std::optional<T> default_value;
+    std::optional<int> min_value;  // integers only
+    std::optional<int> max_value;
+};
+
+inline McpParam<bool> McpBool(const char* name) {
+    return {name, std::nullopt, std::nullopt, std::nullopt};
+}
+
+inline McpParam<bool> McpBool(const char* name, bool default_value) {
+    return {name, default_value, std::nullopt, std::nullopt};
+}
+
+inline McpParam<int> McpInt(const char* name) {
+    return {name, std::nullopt, std::nullopt, std::nullopt};
+}
+
+inline McpParam<int> McpInt(const char* name, int min_value, int max_value) {
+    return {name, std::nullopt, min_value, max_value};
+}
+
+inline McpParam<int> McpInt(const char* name, int default_value, int min_value, int max_value) {
+    return {name, default_value, min_value, max_value};
+}
+
+// Default without a range
+inline McpParam<int> McpIntDefault(const char* name, int default_value) {
+    return {name, default_value, std::nullopt, std::nullopt};
+}
+
+inline McpParam<std::string> McpString(const char* name) {
+    return {name, std::nullopt, std::nullopt, std::nullopt};
+}
+
+inline McpParam<std::string> McpString(const char* name, const std::string& default_value) {
+    return {name, default_value, std::nullopt, std::nullopt};
+}
+
+template <typename... Ts>
+std::tuple<McpParam<Ts>...> McpParams(const McpParam<Ts>&... params) {
+    return std::tuple<McpParam<Ts>...>(params...);
+}
+
+inline bool McpReadArgument(const cJSON* item, bool& value) {
+    if (!cJSON_IsBool(item)) {
+        return false;
+    }
+    value = cJSON_IsTrue(item);
+    return true;
+}
+
+inline bool McpReadArgument(const cJSON* item, int& value) {
+    if (!cJSON_IsNumber(item)) {
+        return false;
+    }
+    value = item->valueint;
+    return true;
+}
+
+inline bool McpReadArgument(const cJSON* item, std::string& value) {
+    if (!cJSON_IsString(item)) {
+        return false;
+    }
+    value = item->valuestring;
+    return true;
+}
+
+// Same rules and messages as the PropertyList path in McpTool::Bind
+template <typename T>
+T McpParseArgument(const cJSON* arguments, const McpParam<T>& param) {
+    T value{};
+    const cJSON* item = cJSON_IsObject(arguments) ? cJSON_GetObjectItem(arguments, param.name) : nullptr;
+    if (!McpReadArgument(item, value)) {
+        if (!param.default_value.has_value()) {
+            throw std::runtime_error(std::string("Missing valid argument: ") + param.name);
+        }
+        return param.default_value.value();
+    }
+    if constexpr (std::is_same_v<T, int>) {
+        if (param.min_value.has_value() && value < param.min_value.value()) {
+            throw std::invalid_argument("Value is below minimum allowed: " + std::to_string(param.min_value.value()));
+        }
+        if (param.max_value.has_value() && value > param.max_value.value()) {
+            throw std::invalid_argument("Value exceeds maximum allowed: " + std::to_string(param.max_value.value()));
+        }
+    }
+    return value;
+}
+
+// Throws on a missing or out of range argument
+template <typename... Ts>
+std::tuple<Ts...> McpParseArguments(const cJSON* arguments, const std::tuple<McpParam<Ts>...>& params) {
+    return std::apply([arguments](const auto&... param) {
+        // Braced initialisation keeps the arguments in order
+        return std::tuple<Ts...>{McpParseArgument(arguments, param)...};
+    }, params);
+}
+
+#endif // MCP_TOOL_PARAMS_H
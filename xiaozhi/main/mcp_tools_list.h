@@ -0,0 +1,119 @@
+#ifndef MCP_TOOLS_LIST_H
+#define MCP_TOOLS_LIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Most bytes of one tools/list result, larger lists are paged with nextCursor
+#define MCP_TOOLS_LIST_PAGE_SIZE 8000
+
+/*
+ * Serialised tools/list entries, built once after the tools are registered.
+ * Every tool's JSON is kept back to back in one string with its offset and
+ * length, so a page is sized from the lengths alone and copied out in one
+ * pass. The cursor is the name of the first tool of the page.
+ */
+class McpToolsList {
+public:
+    bool empty() const { return entries_.empty(); }
+
+    void Clear() {
+        json_.clear();
+        entries_.clear();
+        positions_.clear();
+    }
+
+    // In list order
+    void Add(const std::string& name, const std::string& json, bool user_only) {
+        positions_[name] = entries_.size();
+        entries_.push_back({(uint32_t)json_.size(), (uint32_t)json.size(), user_only, name});
+        json_ += json;
+    }
+
+    /*
+     * Writes the result object of the page starting at cursor ("" for the
+     * first). Returns false if the cursor is unknown, or with the offending
+     * name in failed_tool if the first tool alone does not fit a page.
+     */
+    bool Render(const std::string& cursor, bool include_user_only, std::string& result,
+                std::string& failed_tool) const {
+        static const char kHead[] = "{\"tools\":[";
+        static const char kTail[] = "]}";
+        static const char kCursorHead[] = "],\"nextCursor\":\"";
+        static const char kCursorTail[] = "\"}";
+
+        size_t first = 0;
+        if (!cursor.empty()) {
+            auto it = positions_.find(cursor);
+            if (it == positions_.end()) {
+                failed_tool.clear();
+                return false;
+            }
+            first = it->second;
+        }
+
+        // Same budget as before: room for the closing part is kept in reserve
+        size_t size = sizeof(kHead) - 1;
+        size_t count = 0;
+        size_t next = entries_.size();
+        size_t i = first;
+        for (; i < entries_.size(); i++) {
+            const Entry& entry = entries_[i];
+            if (entry.user_only && !include_user_only) {
+                continue;
+            }
+            if (size + entry.length + 1 + 30 > MCP_TOOLS_LIST_PAGE_SIZE) {
+                next = i;
+                break;
+            }
+            size += entry.length + 1;
+            count++;
+        }
+        if (count == 0 && next < entries_.size()) {
+            failed_tool = entries_[next].name;
+            return false;
+        }
+
+        const std::string* next_cursor = next < entries_.size() ? &entries_[next].name : nullptr;
+        result.clear();
+        result.reserve(size + (next_cursor ? sizeof(kCursorHead) + next_cursor->size() + sizeof(kCursorTail) : sizeof(kTail)));
+        result.append(kHead, sizeof(kHead) - 1);
+        bool comma = false;
+        for (size_t j = first; j < i; j++) {
+            const Entry& entry = entries_[j];
+            if (entry.user_only && !include_user_only) {
+                continue;
+            }
+            if (comma) {
+                result.push_back(',');
+            }
+            result.append(json_, entry.offset, entry.length);
+            comma = true;
+        }
+        if (next_cursor != nullptr) {
+            result.append(kCursorHead, sizeof(kCursorHead) - 1);
+            result.append(*next_cursor);
+            result.append(kCursorTail, sizeof(kCursorTail) - 1);
+        } else {
+            result.append(kTail, sizeof(kTail) - 1);
+        }
+        return true;
+    }
+
+private:
+    struct Entry {
+        uint32_t offset;
+        uint32_t length;
+        bool user_only;
+        std::string name;
+    };
+
+    std::string json_;
+    std::vector<Entry> entries_;
+    std::unordered_map<std::string, size_t> positions_;
+};
+
+#endif // MCP_TOOLS_LIST_H
@@ -0,0 +1,214 @@
+#ifndef MCP_TRACE_H
+#define MCP_TRACE_H
+
+#include "json_writer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+// Finished calls kept for self.get_mcp_stats
+#define MCP_TRACE_RING_SIZE 16
+// Tools with their own latency histogram, the rest share one "other" entry
+#define MCP_TRACE_MAX_TOOLS 24
+#define MCP_TRACE_HISTOGRAM_BUCKETS 6
+// Calls slower than this end to end are logged with their breakdown
+#define MCP_TRACE_SLOW_MS 1000
+
+// Upper bounds of the latency histogram buckets in ms, the last bucket is open ended
+static constexpr uint32_t kMcpTraceBucketMs[MCP_TRACE_HISTOGRAM_BUCKETS - 1] = {10, 50, 200, 1000, 5000};
+
+enum McpTracePoint {
+    kMcpTraceReceived,   // ParseMessage() got the request
+    kMcpTraceParsed,     // arguments bound
+    kMcpTraceScheduled,  // queued on a worker or the background lane
+    kMcpTraceStarted,    // tool body started
+    kMcpTraceFinished,   // tool body returned
+    kMcpTraceReplied,    // response handed to the transport (or the batch)
+    kMcpTracePointCount
+};
+
+/*
+ * Timestamps of one tools/call, in microseconds from the caller's clock
+ * (esp_timer_get_time() on the device). The spans between them tell where a
+ * slow call spent its time: parsing, waiting for the main loop or a worker,
+ * the tool body itself (I2C, HTTP, servo) or writing the reply.
+ */
+struct McpTrace {
+    int id = 0;
+    const char* tool = nullptr;  // tool names live as long as the server
+    int64_t at[kMcpTracePointCount] = {};
+    bool error = false;
+    bool cancelled = false;
+
+    void Mark(McpTracePoint point, int64_t now_us) { at[point] = now_us; }
+
+    // 0 if either point was never reached
+    int64_t Span(McpTracePoint from, McpTracePoint to) const {
+        if (at[from] == 0 || at[to] == 0 || at[to] < at[from]) {
+            return 0;
+        }
+        return at[to] - at[from];
+    }
+
+    // {"parse_us":..,"queue_us":..,"run_us":..,"reply_us":..,"total_us":..}, reply
+    // and total only once the call is replied
+    void Write(JsonWriter& json) const {
+        json.BeginObject()
+            .Key("parse_us").Number(Span(kMcpTraceReceived, kMcpTraceParsed))
+            .Key("queue_us").Number(Span(kMcpTraceScheduled, kMcpTraceStarted))
+            .Key("run_us").Number(Span(kMcpTraceStarted, kMcpTraceFinished));
+        if (at[kMcpTraceReplied] != 0) {
+            json.Key("reply_us").Number(Span(kMcpTraceFinished, kMcpTraceReplied))
+                .Key("total_us").Number(Span(kMcpTraceReceived, kMcpTraceReplied));
+        }
+        json.EndObject();
+    }
+};
+
+/*
+ * Finished calls: the last MCP_TRACE_RING_SIZE traces and per tool counters
+ * with a histogram of the end to end latency. Fixed memory, fed from the
+ * main loop and the MCP workers. Timestamps come from the caller, so the
+ * class also builds on the host.
+ */
+class McpTracer {
+public:
+    void Record(const McpTrace& trace) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ring_[ring_next_] = trace;
+        ring_next_ = (ring_next_ + 1) % MCP_TRACE_RING_SIZE;
+        if (ring_count_ < MCP_TRACE_RING_SIZE) {
+            ring_count_++;
+        }
+        total_++;
+
+        ToolStats& stats = Find(trace.tool);
+        stats.count++;
+        if (trace.error) {
+            stats.errors++;
+        }
+        if (trace.cancelled) {
+            stats.cancelled++;
+        }
+        stats.parse_us += trace.Span(kMcpTraceReceived, kMcpTraceParsed);
+        stats.queue_us += trace.Span(kMcpTraceScheduled, kMcpTraceStarted);
+        stats.run_us += trace.Span(kMcpTraceStarted, kMcpTraceFinished);
+        stats.reply_us += trace.Span(kMcpTraceFinished, kMcpTraceReplied);
+        int64_t total_us = trace.Span(kMcpTraceReceived, kMcpTraceReplied);
+        if (total_us > stats.max_us) {
+            stats.max_us = total_us;
+        }
+        int bucket = 0;
+        while (bucket < MCP_TRACE_HISTOGRAM_BUCKETS - 1 && total_us >= (int64_t)kMcpTraceBucketMs[bucket] * 1000) {
+            bucket++;
+        }
+        stats.histogram[bucket]++;
+    }
+
+    uint32_t total() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return total_;
+    }
+
+    // Summary for self.get_mcp_stats: per tool averages and histogram, then the recent calls
+    std::string GetStatsJson() {
+        std::string json_str(512 + (MCP_TRACE_MAX_TOOLS + 1) * 320 + MCP_TRACE_RING_SIZE * 192, '\0');
+        JsonWriter json(json_str.data(), json_str.size());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        json.BeginObject().Field("calls", (int)total_);
+        json.Key("histogram_ms").BeginArray();
+        for (auto bound : kMcpTraceBucketMs) {
+            json.Number(bound);
+        }
+        json.EndArray();
+
+        json.Key("tools").BeginArray();
+        for (int i = 0; i <= MCP_TRACE_MAX_TOOLS; i++) {
+            const ToolStats& stats = tools_[i];
+            if (stats.count == 0) {
+                continue;
+            }
+            json.BeginObject()
+                .Field("tool", stats.name != nullptr ? stats.name : "other")
+                .Field("count", (int)stats.count)
+                .Field("errors", (int)stats.errors)
+                .Field("cancelled", (int)stats.cancelled)
+                .Key("avg_parse_us").Number(stats.parse_us / stats.count)
+                .Key("avg_queue_us").Number(stats.queue_us / stats.count)
+                .Key("avg_run_us").Number(stats.run_us / stats.count)
+                .Key("avg_reply_us").Number(stats.reply_us / stats.count)
+                .Key("max_us").Number(stats.max_us)
+                .Key("histogram").BeginArray();
+            for (auto count : stats.histogram) {
+                json.Number(count);
+            }
+            json.EndArray().EndObject();
+        }
+        json.EndArray();
+
+        // Newest first
+        json.Key("recent").BeginArray();
+        for (int i = 1; i <= ring_count_; i++) {
+            const McpTrace& trace = ring_[(ring_next_ + MCP_TRACE_RING_SIZE - i) % MCP_TRACE_RING_SIZE];
+            json.BeginObject()
+                .Field("id", trace.id)
+                .Field("tool", trace.tool != nullptr ? trace.tool : "")
+                .Field("error", trace.error)
+                .Field("cancelled", trace.cancelled)
+                .Key("trace");
+            trace.Write(json);
+            json.EndObject();
+        }
+        json.EndArray().EndObject();
+
+        if (json.overflow()) {
+            return "{}";
+        }
+        json_str.resize(json.size());
+        return json_str;
+    }
+
+private:
+    struct ToolStats {
+        const char* name = nullptr;
+        uint32_t count = 0;
+        uint32_t errors = 0;
+        uint32_t cancelled = 0;
+        int64_t parse_us = 0;
+        int64_t queue_us = 0;
+        int64_t run_us = 0;
+        int64_t reply_us = 0;
+        int64_t max_us = 0;
+        uint32_t histogram[MCP_TRACE_HISTOGRAM_BUCKETS] = {};
+    };
+
+    std::mutex mutex_;
+    McpTrace ring_[MCP_TRACE_RING_SIZE];
+    int ring_next_ = 0;
+    int ring_count_ = 0;
+    uint32_t total_ = 0;
+    ToolStats tools_[MCP_TRACE_MAX_TOOLS + 1];
+    int tool_count_ = 0;
+
+    // Caller holds mutex_
+    ToolStats& Find(const char* name) {
+        if (name == nullptr) {
+            return tools_[MCP_TRACE_MAX_TOOLS];
+        }
+        for (int i = 0; i < tool_count_; i++) {
+            if (tools_[i].name == name || strcmp(tools_[i].name, name) == 0) {
+                return tools_[i];
+            }
+        }
+        if (tool_count_ < MCP_TRACE_MAX_TOOLS) {
+            tools_[tool_count_].name = name;
+            return tools_[tool_count_++];
+        }
+        return tools_[MCP_TRACE_MAX_TOOLS];
+    }
+};
+
+#endif // MCP_TRACE_H
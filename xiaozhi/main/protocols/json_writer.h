@@ -0,0 +1,253 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+/*
+ * Streaming JSON writer for outbound control messages.
+ * Writes into a caller-provided buffer without allocating; commas are inserted
+ * automatically. The output is not NUL terminated, use data()/size(). If the
+ * buffer is too small, overflow() becomes true and the output must be discarded.
+ *
+ *   char buffer[128];
+ *   JsonWriter json(buffer, sizeof(buffer));
+ *   json.BeginObject().Field("type", "listen").Field("state", "stop").EndObject();
+ */
+class JsonWriter {
+public:
+    JsonWriter(char* buffer, size_t capacity) : buffer_(buffer), capacity_(capacity) {}
+
+    // Worst case size of a string value once escaped and quoted
+    static constexpr size_t EscapedSize(size_t length) {
+        return length * 6 + 2;
+    }
+
+    // Exact size of a string value once escaped and quoted, for large values
+    static size_t StringSize(std::string_view value) {
+        size_t size = value.size() + 2;
+        for (unsigned char c : value) {
+            if (c == '"' || c == '\\' || c == '\n' || c == '\r' || c == '\t') {
+                size += 1;
+            } else if (c < 0x20) {
+                size += 5;
+            }
+        }
+        return size;
+    }
+
+    // Length of data once base64 encoded
+    static constexpr size_t Base64Size(size_t length) {
+        return (length + 2) / 3 * 4;
+    }
+
+    JsonWriter& BeginObject() { return Open('{'); }
+    JsonWriter& EndObject() { return Close('}'); }
+    JsonWriter& BeginArray() { return Open('['); }
+    JsonWriter& EndArray() { return Close(']'); }
+
+    JsonWriter& Key(std::string_view key) {
+        Separator();
+        WriteString(key);
+        Put(':');
+        after_key_ = true;
+        return *this;
+    }
+
+    JsonWriter& String(std::string_view value) {
+        Separator();
+        WriteString(value);
+        return *this;
+    }
+
+    // A string value written in pieces: BeginString(), Chars() / Base64(), EndString()
+    JsonWriter& BeginString() {
+        Separator();
+        Put('"');
+        return *this;
+    }
+
+    JsonWriter& EndString() {
+        Put('"');
+        return *this;
+    }
+
+    // Escaped string contents, between BeginString() and EndString()
+    JsonWriter& Chars(std::string_view value) {
+        WriteChars(value);
+        return *this;
+    }
+
+    // base64 of data encoded straight into the buffer, between BeginString()
+    // and EndString(); base64 never needs escaping
+    JsonWriter& Base64(const void* data, size_t length) {
+        static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        size_t encoded = Base64Size(length);
+        if (encoded > capacity_ - length_) {
+            overflow_ = true;
+            return *this;
+        }
+        auto in = (const uint8_t*)data;
+        char* out = buffer_ + length_;
+        size_t i = 0;
+        for (; i + 3 <= length; i += 3) {
+            uint32_t v = (uint32_t)in[i] << 16 | (uint32_t)in[i + 1] << 8 | in[i + 2];
+            out[0] = table[v >> 18];
+            out[1] = table[(v >> 12) & 0x3f];
+            out[2] = table[(v >> 6) & 0x3f];
+            out[3] = table[v & 0x3f];
+            out += 4;
+        }
+        if (i < length) {
+            uint32_t v = (uint32_t)in[i] << 16;
+            if (i + 1 < length) {
+                v |= (uint32_t)in[i + 1] << 8;
+            }
+            out[0] = table[v >> 18];
+            out[1] = table[(v >> 12) & 0x3f];
+            out[2] = i + 1 < length ? table[(v >> 6) & 0x3f] : '=';
+            out[3] = '=';
+        }
+        length_ += encoded;
+        return *this;
+    }
+
+    JsonWriter& Number(int64_t value) {
+        Separator();
+        // Formatted by hand, newlib nano printf has no 64-bit support
+        char digits[24];
+        size_t pos = sizeof(digits);
+        uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+        do {
+            digits[--pos] = '0' + magnitude % 10;
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (value < 0) {
+            digits[--pos] = '-';
+        }
+        Append(digits + pos, sizeof(digits) - pos);
+        return *this;
+    }
+
+    JsonWriter& Bool(bool value) {
+        Separator();
+        Append(value ? "true" : "false", value ? 4 : 5);
+        return *this;
+    }
+
+    // Already serialized JSON value, copied verbatim
+    JsonWriter& Raw(std::string_view json) {
+        Separator();
+        Append(json.data(), json.size());
+        return *this;
+    }
+
+    JsonWriter& Field(std::string_view key, std::string_view value) { return Key(key).String(value); }
+    JsonWriter& Field(std::string_view key, const char* value) { return Key(key).String(value); }
+    JsonWriter& Field(std::string_view key, const std::string& value) { return Key(key).String(value); }
+    JsonWriter& Field(std::string_view key, int value) { return Key(key).Number(value); }
+    JsonWriter& Field(std::string_view key, bool value) { return Key(key).Bool(value); }
+
+    bool overflow() const { return overflow_; }
+    size_t size() const { return length_; }
+    const char* data() const { return buffer_; }
+    std::string_view view() const { return std::string_view(buffer_, length_); }
+    std::string str() const { return std::string(buffer_, length_); }
+
+private:
+    char* buffer_;
+    size_t capacity_;
+    size_t length_ = 0;
+    uint32_t has_items_ = 0;  // one bit per nesting level
+    int depth_ = 0;
+    bool after_key_ = false;
+    bool overflow_ = false;
+
+    void Put(char c) {
+        if (length_ >= capacity_) {
+            overflow_ = true;
+            return;
+        }
+        buffer_[length_++] = c;
+    }
+
+    void Append(const char* data, size_t length) {
+        if (length > capacity_ - length_) {
+            overflow_ = true;
+            return;
+        }
+        memcpy(buffer_ + length_, data, length);
+        length_ += length;
+    }
+
+    void Separator() {
+        if (after_key_) {
+            after_key_ = false;
+            return;
+        }
+        if (depth_ > 0) {
+            uint32_t bit = 1u << (depth_ - 1);
+            if (has_items_ & bit) {
+                Put(',');
+            }
+            has_items_ |= bit;
+        }
+    }
+
+    JsonWriter& Open(char c) {
+        Separator();
+        Put(c);
+        if (depth_ < 32) {
+            depth_++;
+            has_items_ &= ~(1u << (depth_ - 1));
+        } else {
+            overflow_ = true;
+        }
+        return *this;
+    }
+
+    JsonWriter& Close(char c) {
+        if (depth_ > 0) {
+            depth_--;
+        }
+        Put(c);
+        return *this;
+    }
+
+    void WriteString(std::string_view value) {
+        Put('"');
+        WriteChars(value);
+        Put('"');
+    }
+
+    void WriteChars(std::string_view value) {
+        static const char hex[] = "0123456789abcdef";
+        size_t start = 0;
+        for (size_t i = 0; i < value.size(); i++) {
+            unsigned char c = value[i];
+            if (__builtin_expect(c >= 0x20 && c != '"' && c != '\\', 1)) {
+                continue;
+            }
+            Append(value.data() + start, i - start);
+            start = i + 1;
+            switch (c) {
+            case '"': Append("\\\"", 2); break;
+            case '\\': Append("\\\\", 2); break;
+            case '\n': Append("\\n", 2); break;
+            case '\r': Append("\\r", 2); break;
+            case '\t': Append("\\t", 2); break;
+            default: {
+                char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0f]};
+                Append(escaped, sizeof(escaped));
+                break;
+            }
+            }
+        }
+        Append(value.data() + start, value.size() - start);
+    }
+};
+
+#endif // JSON_WRITER_H
@@ -28,14 +28,34 @@ MqttProtocol::MqttProtocol() {
         .arg = this,
     };
     esp_timer_create(&reconnect_timer_args, &reconnect_timer_);
+
+    // Release a parked audio channel once its idle window has passed
+    esp_timer_create_args_t idle_timer_args = {
+        .callback = [](void* arg) {
+            MqttProtocol* protocol = (MqttProtocol*)arg;
+            Application::GetInstance().Schedule([protocol]() {
+                if (protocol->channel_parked_) {
+                    ESP_LOGI(TAG, "Audio channel idle window expired");
+                    protocol->ReleaseAudioChannel();
+                }
+            });
+        },
+        .arg = this,
+    };
+    esp_timer_create(&idle_timer_args, &idle_timer_);
 }
 
 MqttProtocol::~MqttProtocol() {
     ESP_LOGI(TAG, "MqttProtocol deinit");
+    send_scheduler_.Stop();
     if (reconnect_timer_ != nullptr) {
         esp_timer_stop(reconnect_timer_);
         esp_timer_delete(reconnect_timer_);
     }
+    if (idle_timer_ != nullptr) {
+        esp_timer_stop(idle_timer_);
+        esp_timer_delete(idle_timer_);
+    }
 
     udp_.reset();
     mqtt_.reset();
@@ -52,6 +72,7 @@ bool MqttProtocol::Start() {
 bool MqttProtocol::StartMqttClient(bool report_error) {
     if (mqtt_ != nullptr) {
         ESP_LOGW(TAG, "Mqtt client already started");
+        auto transport_lock = send_scheduler_.LockTransport();
         mqtt_.reset();
     }
 
@@ -62,6 +83,7 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
     auto password = settings.GetString("password");
     int keepalive_interval = settings.GetInt("keepalive", 240);
     publish_topic_ = settings.GetString("publish_topic");
+    idle_window_seconds_ = settings.GetInt("idle_window", CONFIG_AUDIO_CHANNEL_IDLE_WINDOW_SECONDS);
 
     if (endpoint.empty()) {
         ESP_LOGW(TAG, "MQTT endpoint is not specified");
@@ -72,7 +94,10 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
     }
 
     auto network = Board::GetInstance().GetNetwork();
-    mqtt_ = network->CreateMqtt(0);
+    {
+        auto transport_lock = send_scheduler_.LockTransport();
+        mqtt_ = network->CreateMqtt(0);
+    }
     mqtt_->SetKeepAlive(keepalive_interval);
 
     mqtt_->OnDisconnected([this]() {
@@ -108,9 +133,9 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
         } else if (strcmp(type->valuestring, "goodbye") == 0) {
             auto session_id = cJSON_GetObjectItem(root, "session_id");
             ESP_LOGI(TAG, "Received goodbye message, session_id: %s", session_id ? session_id->valuestring : "null");
-            if (session_id == nullptr || session_id_ == session_id->valuestring) {
+            if (session_id == nullptr || this->session_id() == session_id->valuestring) {
                 Application::GetInstance().Schedule([this]() {
-                    CloseAudioChannel();
+                    ReleaseAudioChannel();
                 });
             }
         } else if (on_incoming_json_ != nullptr) {
@@ -141,7 +166,7 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
 }
 
 bool MqttProtocol::SendText(const std::string& text) {
-    if (publish_topic_.empty()) {
+    if (publish_topic_.empty() || mqtt_ == nullptr) {
         return false;
     }
     if (!mqtt_->Publish(publish_topic_, text)) {
@@ -152,7 +177,7 @@ bool MqttProtocol::SendText(const std::string& text) {
     return true;
 }
 
-bool MqttProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
+bool MqttProtocol::SendAudioPacket(std::unique_ptr<AudioStreamPacket> packet) {
     std::lock_guard<std::mutex> lock(channel_mutex_);
     if (udp_ == nullptr) {
         return false;
@@ -179,23 +204,75 @@ bool MqttProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
 }
 
 void MqttProtocol::CloseAudioChannel() {
+    if (idle_window_seconds_ > 0 && !channel_parked_ && udp_ != nullptr && !error_occurred_ &&
+        mqtt_ != nullptr && mqtt_->IsConnected()) {
+        // Keep the session and UDP channel alive so the next turn skips the hello round trip
+        channel_parked_ = true;
+        // Audio left from this turn must not go out when the channel is reused
+        send_scheduler_.ClearAudio();
+        esp_timer_start_once(idle_timer_, idle_window_seconds_ * 1000000LL);
+        ESP_LOGI(TAG, "Audio channel parked for %d seconds", idle_window_seconds_);
+        if (on_audio_channel_closed_ != nullptr) {
+            on_audio_channel_closed_();
+        }
+        return;
+    }
+    ReleaseAudioChannel();
+}
+
+void MqttProtocol::ReleaseAudioChannel() {
+    esp_timer_stop(idle_timer_);
+    bool was_parked = channel_parked_;
+    channel_parked_ = false;
+    session_resumable_ = false;
+    send_scheduler_.ClearAudio();
     {
         std::lock_guard<std::mutex> lock(channel_mutex_);
         udp_.reset();
     }
+    send_scheduler_.LogStats();
+
+    if (mqtt_ != nullptr && mqtt_->IsConnected()) {
+        char buffer[kControlMessageBufferSize];
+        JsonWriter json(buffer, sizeof(buffer));
+        json.BeginObject().Field("session_id", session_id()).Field("type", "goodbye").EndObject();
+        // After the listen messages still queued for this session
+        SendJson(json, true);
+    }
 
-    std::string message = "{";
-    message += "\"session_id\":\"" + session_id_ + "\",";
-    message += "\"type\":\"goodbye\"";
-    message += "}";
-    SendText(message);
-
-    if (on_audio_channel_closed_ != nullptr) {
+    // A parked channel has already been reported closed to the application
+    if (!was_parked && on_audio_channel_closed_ != nullptr) {
         on_audio_channel_closed_();
     }
 }
 
+bool MqttProtocol::CanResumeSession() const {
+    if (idle_window_seconds_ <= 0 || !session_resumable_ || session_id().empty()) {
+        return false;
+    }
+    return std::chrono::steady_clock::now() - last_incoming_time_ < std::chrono::seconds(idle_window_seconds_);
+}
+
 bool MqttProtocol::OpenAudioChannel() {
+    auto start_time = esp_timer_get_time();
+    if (channel_parked_) {
+        if (udp_ != nullptr && !error_occurred_ && mqtt_ != nullptr && mqtt_->IsConnected() && !IsTimeout()) {
+            esp_timer_stop(idle_timer_);
+            channel_parked_ = false;
+            ESP_LOGI(TAG, "Audio channel ready (warm) in %d ms", (int)((esp_timer_get_time() - start_time) / 1000));
+            if (on_audio_channel_opened_ != nullptr) {
+                on_audio_channel_opened_();
+            }
+            return true;
+        }
+        if (CanResumeSession()) {
+            esp_timer_stop(idle_timer_);
+            channel_parked_ = false;
+        } else {
+            ReleaseAudioChannel();
+        }
+    }
+
     if (mqtt_ == nullptr || !mqtt_->IsConnected()) {
         ESP_LOGI(TAG, "MQTT is not connected, try to connect now");
         if (!StartMqttClient(true)) {
@@ -204,23 +281,45 @@ bool MqttProtocol::OpenAudioChannel() {
     }
 
     error_occurred_ = false;
-    session_id_ = "";
-    xEventGroupClearBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
+    bool resume = CanResumeSession();
+    if (resume) {
+        // Reuse the cached session id, key and nonce, the server hello is applied when it arrives
+        if (!SendHello(GetHelloMessage(true))) {
+            return false;
+        }
+    } else {
+        SetSessionId("");
+        session_resumable_ = false;
+        xEventGroupClearBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 
-    auto message = GetHelloMessage();
-    if (!SendText(message)) {
-        return false;
+        auto message = GetHelloMessage();
+        if (!SendHello(message)) {
+            return false;
+        }
+
+        // 等待服务器响应
+        EventBits_t bits = xEventGroupWaitBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(10000));
+        if (!(bits & MQTT_PROTOCOL_SERVER_HELLO_EVENT)) {
+            ESP_LOGE(TAG, "Failed to receive server hello");
+            SetError(Lang::Strings::SERVER_TIMEOUT);
+            return false;
+        }
     }
 
-    // 等待服务器响应
-    EventBits_t bits = xEventGroupWaitBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(10000));
-    if (!(bits & MQTT_PROTOCOL_SERVER_HELLO_EVENT)) {
-        ESP_LOGE(TAG, "Failed to receive server hello");
-        SetError(Lang::Strings::SERVER_TIMEOUT);
-        return false;
+    {
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        CreateUdpChannel();
     }
+    ESP_LOGI(TAG, "Audio channel ready (%s) in %d ms", resume ? "resumed" : "cold", (int)((esp_timer_get_time() - start_time) / 1000));
 
-    std::lock_guard<std::mutex> lock(channel_mutex_);
+    if (on_audio_channel_opened_ != nullptr) {
+        on_audio_channel_opened_();
+    }
+    return true;
+}
+
+// Must be called with channel_mutex_ held
+void MqttProtocol::CreateUdpChannel() {
     auto network = Board::GetInstance().GetNetwork();
     udp_ = network->CreateUdp(2);
     udp_->OnMessage([this](const std::string& data) {
@@ -229,6 +328,9 @@ bool MqttProtocol::OpenAudioChannel() {
          * |type 1u|flags 1u|payload_len 2u|ssrc 4u|timestamp 4u|sequence 4u|
          * |payload payload_len|
          */
+        if (channel_parked_) {
+            return;
+        }
         if (data.size() < sizeof(aes_nonce_)) {
             ESP_LOGE(TAG, "Invalid audio packet size: %u", data.size());
             return;
@@ -270,36 +372,30 @@ bool MqttProtocol::OpenAudioChannel() {
     });
 
     udp_->Connect(udp_server_, udp_port_);
-
-    if (on_audio_channel_opened_ != nullptr) {
-        on_audio_channel_opened_();
-    }
-    return true;
 }
 
-std::string MqttProtocol::GetHelloMessage() {
+std::string MqttProtocol::GetHelloMessage(bool resume) {
     // 发送 hello 消息申请 UDP 通道
-    cJSON* root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "type", "hello");
-    cJSON_AddNumberToObject(root, "version", 3);
-    cJSON_AddStringToObject(root, "transport", "udp");
-    cJSON* features = cJSON_CreateObject();
+    char buffer[kControlMessageBufferSize];
+    JsonWriter json(buffer, sizeof(buffer));
+    json.BeginObject().Field("type", "hello");
+    if (resume) {
+        json.Field("session_id", session_id());
+    }
+    json.Field("version", 3).Field("transport", "udp");
+    json.Key("features").BeginObject();
 #if CONFIG_USE_SERVER_AEC
-    cJSON_AddBoolToObject(features, "aec", true);
+    json.Field("aec", true);
 #endif
-    cJSON_AddBoolToObject(features, "mcp", true);
-    cJSON_AddItemToObject(root, "features", features);
-    cJSON* audio_params = cJSON_CreateObject();
-    cJSON_AddStringToObject(audio_params, "format", "opus");
-    cJSON_AddNumberToObject(audio_params, "sample_rate", 16000);
-    cJSON_AddNumberToObject(audio_params, "channels", 1);
-    cJSON_AddNumberToObject(audio_params, "frame_duration", OPUS_FRAME_DURATION_MS);
-    cJSON_AddItemToObject(root, "audio_params", audio_params);
-    auto json_str = cJSON_PrintUnformatted(root);
-    std::string message(json_str);
-    cJSON_free(json_str);
-    cJSON_Delete(root);
-    return message;
+    json.Field("mcp", true).EndObject();
+    json.Key("audio_params").BeginObject()
+        .Field("format", "opus")
+        .Field("sample_rate", 16000)
+        .Field("channels", 1)
+        .Field("frame_duration", OPUS_FRAME_DURATION_MS)
+        .EndObject();
+    json.EndObject();
+    return json.overflow() ? std::string() : json.str();
 }
 
 void MqttProtocol::ParseServerHello(const cJSON* root) {
@@ -311,8 +407,8 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
 
     auto session_id = cJSON_GetObjectItem(root, "session_id");
     if (cJSON_IsString(session_id)) {
-        session_id_ = session_id->valuestring;
-        ESP_LOGI(TAG, "Session ID: %s", session_id_.c_str());
+        SetSessionId(session_id->valuestring);
+        ESP_LOGI(TAG, "Session ID: %s", session_id->valuestring);
     }
 
     // Get sample rate from hello message
@@ -333,18 +429,28 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
         ESP_LOGE(TAG, "UDP is not specified");
         return;
     }
-    udp_server_ = cJSON_GetObjectItem(udp, "server")->valuestring;
-    udp_port_ = cJSON_GetObjectItem(udp, "port")->valueint;
+    std::string udp_server = cJSON_GetObjectItem(udp, "server")->valuestring;
+    int udp_port = cJSON_GetObjectItem(udp, "port")->valueint;
     auto key = cJSON_GetObjectItem(udp, "key")->valuestring;
     auto nonce = cJSON_GetObjectItem(udp, "nonce")->valuestring;
 
     // auto encryption = cJSON_GetObjectItem(udp, "encryption")->valuestring;
     // ESP_LOGI(TAG, "UDP server: %s, port: %d, encryption: %s", udp_server_.c_str(), udp_port_, encryption);
+    // A resumed channel may already be sending audio, so swap the key under the channel lock
+    std::lock_guard<std::mutex> lock(channel_mutex_);
+    bool endpoint_changed = udp_server != udp_server_ || udp_port != udp_port_;
+    udp_server_ = udp_server;
+    udp_port_ = udp_port;
     aes_nonce_ = DecodeHexString(nonce);
     mbedtls_aes_init(&aes_ctx_);
     mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)DecodeHexString(key).c_str(), 128);
     local_sequence_ = 0;
     remote_sequence_ = 0;
+    session_resumable_ = true;
+    if (udp_ != nullptr && endpoint_changed) {
+        ESP_LOGI(TAG, "UDP endpoint changed on resume, reconnecting");
+        CreateUdpChannel();
+    }
     xEventGroupSetBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 }
 
@@ -368,5 +474,5 @@ std::string MqttProtocol::DecodeHexString(const std::string& hex_string) {
 }
 
 bool MqttProtocol::IsAudioChannelOpened() const {
-    return udp_ != nullptr && !error_occurred_ && !IsTimeout();
+    return udp_ != nullptr && !channel_parked_ && !error_occurred_ && !IsTimeout();
 }
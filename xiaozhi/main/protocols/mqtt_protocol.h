@@ -11,6 +11,7 @@
 #include <freertos/event_groups.h>
 #include <esp_timer.h>
 
+#include <atomic>
 #include <functional>
 #include <string>
 #include <map>
@@ -27,7 +28,6 @@ public:
     ~MqttProtocol();
 
     bool Start() override;
-    bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) override;
     bool OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
@@ -43,17 +43,26 @@ private:
     mbedtls_aes_context aes_ctx_;
     std::string aes_nonce_;
     std::string udp_server_;
-    int udp_port_;
+    int udp_port_ = 0;
     uint32_t local_sequence_;
     uint32_t remote_sequence_;
     esp_timer_handle_t reconnect_timer_;
+    esp_timer_handle_t idle_timer_;
+    int idle_window_seconds_ = 0;
+    // Read by the UDP receive callback
+    std::atomic<bool> channel_parked_{false};
+    bool session_resumable_ = false;
 
     bool StartMqttClient(bool report_error=false);
+    void CreateUdpChannel();
+    void ReleaseAudioChannel();
+    bool CanResumeSession() const;
     void ParseServerHello(const cJSON* root);
     std::string DecodeHexString(const std::string& hex_string);
 
     bool SendText(const std::string& text) override;
-    std::string GetHelloMessage();
+    bool SendAudioPacket(std::unique_ptr<AudioStreamPacket> packet) override;
+    std::string GetHelloMessage(bool resume=false);
 };
 
 
@@ -4,6 +4,13 @@
 
 #define TAG "Protocol"
 
+Protocol::Protocol()
+    : send_scheduler_(
+          [this](const std::string &text) { return SendText(text); },
+          [this](std::unique_ptr<AudioStreamPacket> packet) {
+            return SendAudioPacket(std::move(packet));
+          }) {}
+
 void Protocol::OnIncomingJson(std::function<void(const cJSON *root)> callback) {
   on_incoming_json_ = callback;
 }
@@ -41,69 +48,123 @@ void Protocol::SetError(const std::string &message) {
   }
 }
 
+bool Protocol::SendJson(const JsonWriter &json, bool after_audio) {
+  if (json.overflow()) {
+    ESP_LOGE(TAG, "Outbound message does not fit its buffer, dropped");
+    return false;
+  }
+  if (after_audio) {
+    return send_scheduler_.EnqueueAfterAudio(json.str());
+  }
+  return send_scheduler_.EnqueueControl(json.str());
+}
+
+bool Protocol::SendHello(const std::string &message) {
+  // The hello opens the channel, so it bypasses the queue and goes out first
+  auto transport_lock = send_scheduler_.LockTransport();
+  return SendText(message);
+}
+
+bool Protocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet, bool preroll) {
+  return send_scheduler_.EnqueueAudio(std::move(packet), preroll);
+}
+
 void Protocol::SendAbortSpeaking(AbortReason reason) {
-  std::string message =
-      "{\"session_id\":\"" + session_id_ + "\",\"type\":\"abort\"";
+  char buffer[kControlMessageBufferSize];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.BeginObject().Field("session_id", session_id()).Field("type", "abort");
   if (reason == kAbortReasonWakeWordDetected) {
-    message += ",\"reason\":\"wake_word_detected\"";
+    json.Field("reason", "wake_word_detected");
   }
-  message += "}";
-  SendText(message);
+  json.EndObject();
+  SendJson(json);
 }
 
 void Protocol::SendWakeWordDetected(const std::string &wake_word) {
-  std::string json = "{\"session_id\":\"" + session_id_ +
-                     "\",\"type\":\"listen\",\"state\":\"detect\",\"text\":\"" +
-                     wake_word + "\"}";
-  SendText(json);
+  char buffer[kControlMessageBufferSize];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.BeginObject()
+      .Field("session_id", session_id())
+      .Field("type", "listen")
+      .Field("state", "detect")
+      .Field("text", wake_word)
+      .EndObject();
+  SendJson(json, true);
 }
 
 void Protocol::SendStartListening(ListeningMode mode) {
-  std::string message = "{\"session_id\":\"" + session_id_ + "\"";
-  message += ",\"type\":\"listen\",\"state\":\"start\"";
+  char buffer[kControlMessageBufferSize];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.BeginObject()
+      .Field("session_id", session_id())
+      .Field("type", "listen")
+      .Field("state", "start");
   if (mode == kListeningModeRealtime) {
-    message += ",\"mode\":\"realtime\"";
+    json.Field("mode", "realtime");
   } else if (mode == kListeningModeAutoStop) {
-    message += ",\"mode\":\"auto\"";
+    json.Field("mode", "auto");
   } else {
-    message += ",\"mode\":\"manual\"";
+    json.Field("mode", "manual");
   }
-  message += "}";
-  SendText(message);
+  json.EndObject();
+  SendJson(json, true);
 }
 
 void Protocol::SendStopListening() {
-  std::string message = "{\"session_id\":\"" + session_id_ +
-                        "\",\"type\":\"listen\",\"state\":\"stop\"}";
-  SendText(message);
+  char buffer[kControlMessageBufferSize];
+  JsonWriter json(buffer, sizeof(buffer));
+  json.BeginObject()
+      .Field("session_id", session_id())
+      .Field("type", "listen")
+      .Field("state", "stop")
+      .EndObject();
+  SendJson(json, true);
 }
 
 void Protocol::SendMcpMessage(const std::string &payload) {
-  std::string message = "{\"session_id\":\"" + session_id_ +
-                        "\",\"type\":\"mcp\",\"payload\":" + payload + "}";
-  SendText(message);
+  SendMcpMessage(payload.size(),
+                 [&payload](JsonWriter &json) { json.Raw(payload); });
+}
+
+void Protocol::SendMcpMessage(
+    size_t payload_size,
+    const std::function<void(JsonWriter &)> &write_payload) {
+  // Payloads can be large (tools list, images), write straight into the
+  // outgoing string so it is allocated exactly once
+  auto session = session_id();
+  std::string message(payload_size + session.size() * 6 + 64, '\0');
+  JsonWriter json(message.data(), message.size());
+  json.BeginObject()
+      .Field("session_id", session)
+      .Field("type", "mcp")
+      .Key("payload");
+  write_payload(json);
+  json.EndObject();
+  if (json.overflow()) {
+    ESP_LOGE(TAG, "MCP message larger than %d bytes, dropped",
+             (int)message.size());
+    return;
+  }
+  message.resize(json.size());
+  send_scheduler_.EnqueueControl(std::move(message));
 }
 
 void Protocol::SendTextCommand(const std::string &text) {
   // Gửi text trực tiếp để server xử lý như một câu lệnh voice bình thường
   // Server sẽ tự động tạo TTS response
-  // std::string append_text = "đọc lại đoạn sau: [" + text + "]";
-  // std::string message =
-  //     "{\"session_id\":\"" + session_id_ +
-  //     "\",\"type\":\"listen\",\"state\":\"detect\",\"text\":\"" +
-  //     append_text + "\"}";
-
-  // ESP_LOGI(TAG, "📤 SendTextCommand: %s", append_text.c_str());
-  // SendText(message);
-
-  // const std::string append_text = "đọc lên: " + text + "";
-  std::string message =
-      "{\"session_id\":\"" + session_id_ +
-      "\",\"type\":\"listen\",\"state\":\"detect\",\"text\":\"" +
-      text + "\"}";
+  auto session = session_id();
+  std::string message(JsonWriter::EscapedSize(text.size()) + session.size() * 6 + 64, '\0');
+  JsonWriter json(message.data(), message.size());
+  json.BeginObject()
+      .Field("session_id", session)
+      .Field("type", "listen")
+      .Field("state", "detect")
+      .Field("text", text)
+      .EndObject();
+  message.resize(json.size());
 
   ESP_LOGI(TAG, "📤 SendTextCommand: %s", text.c_str());
-  SendText(message);
+  send_scheduler_.EnqueueControl(std::move(message));
 }
 
 bool Protocol::IsTimeout() const {
@@ -6,6 +6,10 @@
 #include <functional>
 #include <chrono>
 #include <vector>
+#include <mutex>
+
+#include "json_writer.h"
+#include "send_scheduler.h"
 
 struct AudioStreamPacket {
     int sample_rate = 0;
@@ -43,6 +47,7 @@ enum ListeningMode {
 
 class Protocol {
 public:
+    Protocol();
     virtual ~Protocol() = default;
 
     inline int server_sample_rate() const {
@@ -51,7 +56,10 @@ public:
     inline int server_frame_duration() const {
         return server_frame_duration_;
     }
-    inline const std::string& session_id() const {
+    // A copy: the server hello rewrites it on the network task while senders
+    // (main loop, MCP workers) read it from theirs
+    std::string session_id() const {
+        std::lock_guard<std::mutex> lock(session_mutex_);
         return session_id_;
     }
 
@@ -67,12 +75,16 @@ public:
     virtual bool OpenAudioChannel() = 0;
     virtual void CloseAudioChannel() = 0;
     virtual bool IsAudioChannelOpened() const = 0;
-    virtual bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) = 0;
+    // Queued on the audio lane of the send scheduler, never blocks on the network.
+    // Preroll (wake word audio) is never dropped by the backlog or age limits.
+    bool SendAudio(std::unique_ptr<AudioStreamPacket> packet, bool preroll = false);
     virtual void SendWakeWordDetected(const std::string& wake_word);
     virtual void SendStartListening(ListeningMode mode);
     virtual void SendStopListening();
     virtual void SendAbortSpeaking(AbortReason reason);
     virtual void SendMcpMessage(const std::string& message);
+    // write_payload adds at most payload_size bytes straight into the outgoing message
+    void SendMcpMessage(size_t payload_size, const std::function<void(JsonWriter&)>& write_payload);
     virtual void SendTextCommand(const std::string& text);
 
 protected:
@@ -87,12 +99,28 @@ protected:
     int server_sample_rate_ = 24000;
     int server_frame_duration_ = 60;
     bool error_occurred_ = false;
-    std::string session_id_;
     std::chrono::time_point<std::chrono::steady_clock> last_incoming_time_;
+    // Subclasses must Stop() it first in their destructor, its task calls back into them
+    SendScheduler send_scheduler_;
+
+    // Fits the fixed control messages (listen/abort/wake word) with their session id
+    static constexpr size_t kControlMessageBufferSize = 256;
 
     virtual bool SendText(const std::string& text) = 0;
+    virtual bool SendAudioPacket(std::unique_ptr<AudioStreamPacket> packet) = 0;
+    // after_audio keeps the message in order with queued audio, otherwise it goes first
+    bool SendJson(const JsonWriter& json, bool after_audio = false);
+    bool SendHello(const std::string& message);
     virtual void SetError(const std::string& message);
+    void SetSessionId(const std::string& session_id) {
+        std::lock_guard<std::mutex> lock(session_mutex_);
+        session_id_ = session_id;
+    }
     virtual bool IsTimeout() const;
+
+private:
+    mutable std::mutex session_mutex_;
+    std::string session_id_;
 };
 
 #endif // PROTOCOL_H
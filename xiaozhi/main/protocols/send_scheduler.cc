@@ -0,0 +1,181 @@
+#include "send_scheduler.h"
+#include "protocol.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <esp_log.h>
+
+#define TAG "SendScheduler"
+
+SendScheduler::SendScheduler(std::function<bool(const std::string&)> send_text,
+    std::function<bool(std::unique_ptr<AudioStreamPacket>)> send_audio)
+    : send_text_(std::move(send_text)), send_audio_(std::move(send_audio)) {
+    xTaskCreate([](void* arg) {
+        SendScheduler* scheduler = (SendScheduler*)arg;
+        scheduler->SenderTask();
+        vTaskDelete(NULL);
+    }, "send_scheduler", 4096, this, 4, &task_handle_);
+}
+
+SendScheduler::~SendScheduler() {
+    Stop();
+}
+
+void SendScheduler::Stop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+    control_queue_.clear();
+    audio_queue_.clear();
+    preroll_queued_ = 0;
+    messages_queued_ = 0;
+    condition_.notify_all();
+    condition_.wait(lock, [this]() { return task_exited_ || task_handle_ == nullptr; });
+}
+
+bool SendScheduler::EnqueueControl(std::string message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+        return false;
+    }
+    control_queue_.push_back({std::move(message), esp_timer_get_time()});
+    condition_.notify_all();
+    return true;
+}
+
+bool SendScheduler::EnqueueAfterAudio(std::string message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+        return false;
+    }
+    messages_queued_++;
+    audio_queue_.push_back({nullptr, std::move(message), esp_timer_get_time()});
+    condition_.notify_all();
+    return true;
+}
+
+bool SendScheduler::EnqueueAudio(std::unique_ptr<AudioStreamPacket> packet, bool preroll) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+        return false;
+    }
+    if (preroll) {
+        preroll_queued_++;
+    } else if (audio_queue_.size() - preroll_queued_ - messages_queued_ >= SEND_SCHEDULER_MAX_AUDIO_BACKLOG) {
+        DropOldestLiveAudio();
+    }
+    audio_queue_.push_back({std::move(packet), std::string(), esp_timer_get_time(), preroll});
+    condition_.notify_all();
+    return true;
+}
+
+void SendScheduler::DropOldestLiveAudio() {
+    for (auto it = audio_queue_.begin(); it != audio_queue_.end(); ++it) {
+        if (it->packet && !it->preroll) {
+            audio_queue_.erase(it);
+            audio_stats_.dropped++;
+            return;
+        }
+    }
+}
+
+void SendScheduler::ClearAudio() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        audio_stats_.dropped += audio_queue_.size() - messages_queued_;
+        audio_queue_.erase(std::remove_if(audio_queue_.begin(), audio_queue_.end(),
+            [](const StreamItem& item) { return item.packet != nullptr; }), audio_queue_.end());
+        preroll_queued_ = 0;
+    }
+    // Wait for the frame being sent, if any
+    std::lock_guard<std::mutex> transport_lock(transport_mutex_);
+}
+
+void SendScheduler::Record(SendLaneStats& stats, int64_t enqueue_time, bool ok) {
+    int64_t latency = esp_timer_get_time() - enqueue_time;
+    if (!ok) {
+        stats.failed++;
+        return;
+    }
+    stats.sent++;
+    stats.total_latency_us += latency;
+    if (latency > stats.max_latency_us) {
+        stats.max_latency_us = latency;
+    }
+}
+
+void SendScheduler::SenderTask() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this]() {
+            return !running_ || !control_queue_.empty() || !audio_queue_.empty();
+        });
+        if (!running_) {
+            task_exited_ = true;
+            condition_.notify_all();
+            return;
+        }
+
+        // Control first; audio only when no control message is waiting
+        if (!control_queue_.empty()) {
+            auto item = std::move(control_queue_.front());
+            control_queue_.pop_front();
+            lock.unlock();
+
+            std::lock_guard<std::mutex> transport_lock(transport_mutex_);
+            bool ok = send_text_(item.message);
+            lock.lock();
+            Record(control_stats_, item.enqueue_time, ok);
+            continue;
+        }
+
+        // Only frames age out, a listen message keeps its place in the stream
+        auto now = esp_timer_get_time();
+        while (!audio_queue_.empty() && audio_queue_.front().packet && !audio_queue_.front().preroll &&
+               now - audio_queue_.front().enqueue_time > SEND_SCHEDULER_MAX_AUDIO_AGE_MS * 1000) {
+            audio_queue_.pop_front();
+            audio_stats_.dropped++;
+        }
+        if (audio_queue_.empty()) {
+            continue;
+        }
+        auto item = std::move(audio_queue_.front());
+        audio_queue_.pop_front();
+        if (item.preroll) {
+            preroll_queued_--;
+        }
+        bool is_message = item.packet == nullptr;
+        if (is_message) {
+            messages_queued_--;
+        }
+        lock.unlock();
+
+        std::lock_guard<std::mutex> transport_lock(transport_mutex_);
+        bool ok = is_message ? send_text_(item.message) : send_audio_(std::move(item.packet));
+        lock.lock();
+        Record(is_message ? control_stats_ : audio_stats_, item.enqueue_time, ok);
+    }
+}
+
+SendLaneStats SendScheduler::control_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return control_stats_;
+}
+
+SendLaneStats SendScheduler::audio_stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return audio_stats_;
+}
+
+void SendScheduler::LogStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto average = [](const SendLaneStats& stats) {
+        return stats.sent > 0 ? (int)(stats.total_latency_us / stats.sent) : 0;
+    };
+    ESP_LOGI(TAG, "control: sent %" PRIu32 " failed %" PRIu32 " avg %d us max %d us; "
+        "audio: sent %" PRIu32 " failed %" PRIu32 " dropped %" PRIu32 " avg %d us max %d us",
+        control_stats_.sent, control_stats_.failed, average(control_stats_), (int)control_stats_.max_latency_us,
+        audio_stats_.sent, audio_stats_.failed, audio_stats_.dropped, average(audio_stats_), (int)audio_stats_.max_latency_us);
+}
@@ -0,0 +1,104 @@
+#ifndef SEND_SCHEDULER_H
+#define SEND_SCHEDULER_H
+
+#include <cstdint>
+#include <memory>
+#include <deque>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+struct AudioStreamPacket;
+
+/*
+ * Outbound scheduler shared by both protocols.
+ *
+ * One sender task owns the transport. Control messages (abort, MCP replies...)
+ * always go before audio, so a barge-in abort never waits behind a burst of
+ * frames. Messages that mark a point in the audio stream (listen start, stop,
+ * detect) are queued with EnqueueAfterAudio instead and go out in order with
+ * the frames around them, so the server never sees the stop before the end of
+ * the utterance. Audio is bounded: when the backlog is full, or a frame is
+ * older than SEND_SCHEDULER_MAX_AUDIO_AGE_MS, the oldest frames are dropped
+ * since stale audio is useless to the server.
+ *
+ * Preroll frames (the wake word audio, about 2 s queued at once) are exempt
+ * from both limits: the server needs the start of the utterance to verify the
+ * wake word. They are bounded by the wake word buffer that produced them.
+ */
+#define SEND_SCHEDULER_MAX_AUDIO_BACKLOG 20
+#define SEND_SCHEDULER_MAX_AUDIO_AGE_MS 1200
+
+struct SendLaneStats {
+    uint32_t sent = 0;
+    uint32_t failed = 0;
+    uint32_t dropped = 0;
+    int64_t total_latency_us = 0;
+    int64_t max_latency_us = 0;
+};
+
+class SendScheduler {
+public:
+    SendScheduler(std::function<bool(const std::string&)> send_text,
+        std::function<bool(std::unique_ptr<AudioStreamPacket>)> send_audio);
+    ~SendScheduler();
+
+    bool EnqueueControl(std::string message);
+    // Sent after the audio already queued, counted as control
+    bool EnqueueAfterAudio(std::string message);
+    bool EnqueueAudio(std::unique_ptr<AudioStreamPacket> packet, bool preroll = false);
+
+    // Drops queued audio, keeping the messages queued with it, and returns
+    // once no audio send is in flight
+    void ClearAudio();
+    // Blocks the sender while the caller replaces or tears down the transport
+    std::unique_lock<std::mutex> LockTransport() {
+        return std::unique_lock<std::mutex>(transport_mutex_);
+    }
+    // Stops the sender task, must run before the owning protocol is destroyed
+    void Stop();
+
+    SendLaneStats control_stats() const;
+    SendLaneStats audio_stats() const;
+    void LogStats();
+
+private:
+    struct ControlItem {
+        std::string message;
+        int64_t enqueue_time;
+    };
+    // A frame, or a message when packet is null
+    struct StreamItem {
+        std::unique_ptr<AudioStreamPacket> packet;
+        std::string message;
+        int64_t enqueue_time;
+        bool preroll = false;
+    };
+
+    std::function<bool(const std::string&)> send_text_;
+    std::function<bool(std::unique_ptr<AudioStreamPacket>)> send_audio_;
+
+    mutable std::mutex mutex_;
+    std::mutex transport_mutex_;
+    std::condition_variable condition_;
+    std::deque<ControlItem> control_queue_;
+    std::deque<StreamItem> audio_queue_;
+    size_t preroll_queued_ = 0;
+    size_t messages_queued_ = 0;
+    SendLaneStats control_stats_;
+    SendLaneStats audio_stats_;
+    TaskHandle_t task_handle_ = nullptr;
+    bool running_ = true;
+    bool task_exited_ = false;
+
+    void SenderTask();
+    void DropOldestLiveAudio();
+    static void Record(SendLaneStats& stats, int64_t enqueue_time, bool ok);
+};
+
+#endif // SEND_SCHEDULER_H
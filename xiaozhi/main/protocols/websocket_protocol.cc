@@ -14,9 +14,29 @@
 
 WebsocketProtocol::WebsocketProtocol() {
     event_group_handle_ = xEventGroupCreate();
+
+    // Release a parked websocket once its idle window has passed
+    esp_timer_create_args_t idle_timer_args = {
+        .callback = [](void* arg) {
+            WebsocketProtocol* protocol = (WebsocketProtocol*)arg;
+            Application::GetInstance().Schedule([protocol]() {
+                if (protocol->channel_parked_) {
+                    ESP_LOGI(TAG, "Audio channel idle window expired");
+                    protocol->ReleaseAudioChannel();
+                }
+            });
+        },
+        .arg = this,
+    };
+    esp_timer_create(&idle_timer_args, &idle_timer_);
 }
 
 WebsocketProtocol::~WebsocketProtocol() {
+    send_scheduler_.Stop();
+    if (idle_timer_ != nullptr) {
+        esp_timer_stop(idle_timer_);
+        esp_timer_delete(idle_timer_);
+    }
     vEventGroupDelete(event_group_handle_);
 }
 
@@ -25,7 +45,7 @@ bool WebsocketProtocol::Start() {
     return true;
 }
 
-bool WebsocketProtocol::SendAudio(std::unique_ptr<AudioStreamPacket> packet) {
+bool WebsocketProtocol::SendAudioPacket(std::unique_ptr<AudioStreamPacket> packet) {
     if (websocket_ == nullptr || !websocket_->IsConnected()) {
         return false;
     }
@@ -72,14 +92,59 @@ bool WebsocketProtocol::SendText(const std::string& text) {
 }
 
 bool WebsocketProtocol::IsAudioChannelOpened() const {
-    return websocket_ != nullptr && websocket_->IsConnected() && !error_occurred_ && !IsTimeout();
+    return websocket_ != nullptr && websocket_->IsConnected() && !channel_parked_ && !error_occurred_ && !IsTimeout();
 }
 
 void WebsocketProtocol::CloseAudioChannel() {
+    if (idle_window_seconds_ > 0 && !channel_parked_ && websocket_ != nullptr && websocket_->IsConnected() &&
+        !error_occurred_) {
+        // Keep the connection alive so the next turn skips TCP, TLS and the hello round trip
+        channel_parked_ = true;
+        esp_timer_start_once(idle_timer_, idle_window_seconds_ * 1000000LL);
+        ESP_LOGI(TAG, "Audio channel parked for %d seconds", idle_window_seconds_);
+        if (on_audio_channel_closed_ != nullptr) {
+            on_audio_channel_closed_();
+        }
+        return;
+    }
+    ReleaseAudioChannel();
+}
+
+void WebsocketProtocol::ReleaseAudioChannel() {
+    esp_timer_stop(idle_timer_);
+    session_resumable_ = false;
+    send_scheduler_.ClearAudio();
+    send_scheduler_.LogStats();
+    // OnDisconnected stays silent while parked, the application already saw the close
+    auto transport_lock = send_scheduler_.LockTransport();
     websocket_.reset();
+    channel_parked_ = false;
+}
+
+bool WebsocketProtocol::CanResumeSession() const {
+    if (idle_window_seconds_ <= 0 || !session_resumable_ || session_id().empty()) {
+        return false;
+    }
+    return std::chrono::steady_clock::now() - last_incoming_time_ < std::chrono::seconds(idle_window_seconds_);
 }
 
 bool WebsocketProtocol::OpenAudioChannel() {
+    auto start_time = esp_timer_get_time();
+    if (channel_parked_) {
+        if (websocket_ != nullptr && websocket_->IsConnected() && !error_occurred_ && !IsTimeout()) {
+            esp_timer_stop(idle_timer_);
+            channel_parked_ = false;
+            ESP_LOGI(TAG, "Audio channel ready (warm) in %d ms", (int)((esp_timer_get_time() - start_time) / 1000));
+            if (on_audio_channel_opened_ != nullptr) {
+                on_audio_channel_opened_();
+            }
+            return true;
+        }
+        bool resumable = session_resumable_;
+        ReleaseAudioChannel();
+        session_resumable_ = resumable;
+    }
+
     Settings settings("websocket", false);
     std::string url = settings.GetString("url");
     std::string token = settings.GetString("token");
@@ -87,11 +152,16 @@ bool WebsocketProtocol::OpenAudioChannel() {
     if (version != 0) {
         version_ = version;
     }
+    idle_window_seconds_ = settings.GetInt("idle_window", CONFIG_AUDIO_CHANNEL_IDLE_WINDOW_SECONDS);
 
     error_occurred_ = false;
+    bool resume = CanResumeSession();
 
     auto network = Board::GetInstance().GetNetwork();
-    websocket_ = network->CreateWebSocket(1);
+    {
+        auto transport_lock = send_scheduler_.LockTransport();
+        websocket_ = network->CreateWebSocket(1);
+    }
     if (websocket_ == nullptr) {
         ESP_LOGE(TAG, "Failed to create websocket");
         return false;
@@ -110,7 +180,7 @@ bool WebsocketProtocol::OpenAudioChannel() {
 
     websocket_->OnData([this](const char* data, size_t len, bool binary) {
         if (binary) {
-            if (on_incoming_audio_ != nullptr) {
+            if (on_incoming_audio_ != nullptr && !channel_parked_) {
                 if (version_ == 2) {
                     BinaryProtocol2* bp2 = (BinaryProtocol2*)data;
                     bp2->version = ntohs(bp2->version);
@@ -166,7 +236,7 @@ bool WebsocketProtocol::OpenAudioChannel() {
 
     websocket_->OnDisconnected([this]() {
         ESP_LOGI(TAG, "Websocket disconnected");
-        if (on_audio_channel_closed_ != nullptr) {
+        if (on_audio_channel_closed_ != nullptr && !channel_parked_) {
             on_audio_channel_closed_();
         }
     });
@@ -179,18 +249,22 @@ bool WebsocketProtocol::OpenAudioChannel() {
     }
 
     // Send hello message to describe the client
-    auto message = GetHelloMessage();
-    if (!SendText(message)) {
+    xEventGroupClearBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT);
+    auto message = GetHelloMessage(resume);
+    if (!SendHello(message)) {
         return false;
     }
 
-    // Wait for server hello
-    EventBits_t bits = xEventGroupWaitBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(10000));
-    if (!(bits & WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT)) {
-        ESP_LOGE(TAG, "Failed to receive server hello");
-        SetError(Lang::Strings::SERVER_TIMEOUT);
-        return false;
+    // Wait for server hello, a resumed session keeps its cached audio params and applies the reply when it arrives
+    if (!resume) {
+        EventBits_t bits = xEventGroupWaitBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(10000));
+        if (!(bits & WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT)) {
+            ESP_LOGE(TAG, "Failed to receive server hello");
+            SetError(Lang::Strings::SERVER_TIMEOUT);
+            return false;
+        }
     }
+    ESP_LOGI(TAG, "Audio channel ready (%s) in %d ms", resume ? "resumed" : "cold", (int)((esp_timer_get_time() - start_time) / 1000));
 
     if (on_audio_channel_opened_ != nullptr) {
         on_audio_channel_opened_();
@@ -199,29 +273,29 @@ bool WebsocketProtocol::OpenAudioChannel() {
     return true;
 }
 
-std::string WebsocketProtocol::GetHelloMessage() {
+std::string WebsocketProtocol::GetHelloMessage(bool resume) {
     // keys: message type, version, audio_params (format, sample_rate, channels)
-    cJSON* root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "type", "hello");
-    cJSON_AddNumberToObject(root, "version", version_);
-    cJSON* features = cJSON_CreateObject();
+    char buffer[kControlMessageBufferSize];
+    JsonWriter json(buffer, sizeof(buffer));
+    json.BeginObject().Field("type", "hello");
+    if (resume) {
+        json.Field("session_id", session_id());
+    }
+    json.Field("version", version_);
+    json.Key("features").BeginObject();
 #if CONFIG_USE_SERVER_AEC
-    cJSON_AddBoolToObject(features, "aec", true);
+    json.Field("aec", true);
 #endif
-    cJSON_AddBoolToObject(features, "mcp", true);
-    cJSON_AddItemToObject(root, "features", features);
-    cJSON_AddStringToObject(root, "transport", "websocket");
-    cJSON* audio_params = cJSON_CreateObject();
-    cJSON_AddStringToObject(audio_params, "format", "opus");
-    cJSON_AddNumberToObject(audio_params, "sample_rate", 16000);
-    cJSON_AddNumberToObject(audio_params, "channels", 1);
-    cJSON_AddNumberToObject(audio_params, "frame_duration", OPUS_FRAME_DURATION_MS);
-    cJSON_AddItemToObject(root, "audio_params", audio_params);
-    auto json_str = cJSON_PrintUnformatted(root);
-    std::string message(json_str);
-    cJSON_free(json_str);
-    cJSON_Delete(root);
-    return message;
+    json.Field("mcp", true).EndObject();
+    json.Field("transport", "websocket");
+    json.Key("audio_params").BeginObject()
+        .Field("format", "opus")
+        .Field("sample_rate", 16000)
+        .Field("channels", 1)
+        .Field("frame_duration", OPUS_FRAME_DURATION_MS)
+        .EndObject();
+    json.EndObject();
+    return json.overflow() ? std::string() : json.str();
 }
 
 void WebsocketProtocol::ParseServerHello(const cJSON* root) {
@@ -233,8 +307,8 @@ void WebsocketProtocol::ParseServerHello(const cJSON* root) {
 
     auto session_id = cJSON_GetObjectItem(root, "session_id");
     if (cJSON_IsString(session_id)) {
-        session_id_ = session_id->valuestring;
-        ESP_LOGI(TAG, "Session ID: %s", session_id_.c_str());
+        SetSessionId(session_id->valuestring);
+        ESP_LOGI(TAG, "Session ID: %s", session_id->valuestring);
     }
 
     auto audio_params = cJSON_GetObjectItem(root, "audio_params");
@@ -249,5 +323,6 @@ void WebsocketProtocol::ParseServerHello(const cJSON* root) {
         }
     }
 
+    session_resumable_ = true;
     xEventGroupSetBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT);
 }
@@ -7,6 +7,7 @@
 #include <web_socket.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
+#include <esp_timer.h>
 
 #define WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
 
@@ -16,7 +17,6 @@ public:
     ~WebsocketProtocol();
 
     bool Start() override;
-    bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) override;
     bool OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
@@ -25,10 +25,17 @@ private:
     EventGroupHandle_t event_group_handle_;
     std::unique_ptr<WebSocket> websocket_;
     int version_ = 1;
+    esp_timer_handle_t idle_timer_ = nullptr;
+    int idle_window_seconds_ = 0;
+    bool channel_parked_ = false;
+    bool session_resumable_ = false;
 
+    void ReleaseAudioChannel();
+    bool CanResumeSession() const;
     void ParseServerHello(const cJSON* root);
     bool SendText(const std::string& text) override;
-    std::string GetHelloMessage();
+    bool SendAudioPacket(std::unique_ptr<AudioStreamPacket> packet) override;
+    std::string GetHelloMessage(bool resume=false);
 };
 
 #endif
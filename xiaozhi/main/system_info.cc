@@ -144,6 +144,29 @@ void SystemInfo::PrintTaskList() {
     ESP_LOGI(TAG, "Task list: \n%s", buffer);
 }
 
+int SystemInfo::GetCpuLoad() {
+#if configGENERATE_RUN_TIME_STATS
+    static configRUN_TIME_COUNTER_TYPE last_idle_time = 0;
+    static configRUN_TIME_COUNTER_TYPE last_run_time = 0;
+
+    configRUN_TIME_COUNTER_TYPE idle_time = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        idle_time += ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core));
+    }
+    configRUN_TIME_COUNTER_TYPE run_time = portGET_RUN_TIME_COUNTER_VALUE();
+    configRUN_TIME_COUNTER_TYPE elapsed = (run_time - last_run_time) * portNUM_PROCESSORS;
+    configRUN_TIME_COUNTER_TYPE idle = idle_time - last_idle_time;
+    last_idle_time = idle_time;
+    last_run_time = run_time;
+    if (elapsed == 0 || idle > elapsed) {
+        return 0;
+    }
+    return 100 - (int)(idle * 100 / elapsed);
+#else
+    return -1;
+#endif
+}
+
 void SystemInfo::PrintHeapStats() {
     int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
     int min_free_sram = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
@@ -15,6 +15,8 @@ public:
     static std::string GetChipModelName();
     static std::string GetUserAgent();
     static esp_err_t PrintTaskCpuUsage(TickType_t xTicksToWait);
+    // Busy percentage of all cores since the previous call, -1 without run time stats
+    static int GetCpuLoad();
     static void PrintTaskList();
     static void PrintHeapStats();
 };
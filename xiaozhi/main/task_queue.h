@@ -0,0 +1,213 @@
+#ifndef TASK_QUEUE_H
+#define TASK_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Captures up to this size are stored inline, larger ones fall back to the heap
+#define TASK_INLINE_SIZE 48
+
+/*
+ * Move-only void() callable with small-buffer storage.
+ * Lambdas capturing a few pointers or a std::string fit inline, so posting
+ * them costs no allocation, unlike std::function which only stores two words.
+ */
+class InlineTask {
+public:
+    InlineTask() = default;
+
+    template <typename F, typename Fn = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<Fn, InlineTask>>>
+    InlineTask(F&& callable) {
+        if constexpr (IsInline<Fn>()) {
+            new (storage_) Fn(std::forward<F>(callable));
+            ops_ = &kInlineOps<Fn>;
+        } else {
+            *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(callable));
+            ops_ = &kHeapOps<Fn>;
+        }
+    }
+
+    InlineTask(InlineTask&& other) noexcept {
+        MoveFrom(other);
+    }
+
+    InlineTask& operator=(InlineTask&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    InlineTask(const InlineTask&) = delete;
+    InlineTask& operator=(const InlineTask&) = delete;
+
+    ~InlineTask() {
+        Reset();
+    }
+
+    void operator()() {
+        ops_->invoke(storage_);
+    }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+    bool on_heap() const { return ops_ != nullptr && ops_->on_heap; }
+
+    void Reset() {
+        if (ops_ != nullptr) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* dst, void* src);  // move-constructs dst, destroys src
+        void (*destroy)(void* storage);
+        bool on_heap;
+    };
+
+    template <typename Fn>
+    static constexpr bool IsInline() {
+        return sizeof(Fn) <= TASK_INLINE_SIZE && alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    template <typename Fn>
+    static constexpr Ops kInlineOps = {
+        [](void* storage) { (*static_cast<Fn*>(storage))(); },
+        [](void* dst, void* src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* storage) { static_cast<Fn*>(storage)->~Fn(); },
+        false,
+    };
+
+    template <typename Fn>
+    static constexpr Ops kHeapOps = {
+        [](void* storage) { (**static_cast<Fn**>(storage))(); },
+        [](void* dst, void* src) { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); },
+        [](void* storage) { delete *static_cast<Fn**>(storage); },
+        true,
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[TASK_INLINE_SIZE];
+    const Ops* ops_ = nullptr;
+
+    void MoveFrom(InlineTask& other) {
+        ops_ = other.ops_;
+        if (ops_ != nullptr) {
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+};
+
+/*
+ * Bounded multi-producer / single-consumer queue of movable items (InlineTask
+ * or a struct wrapping one).
+ * Producers claim a slot with one CAS and never take a lock; the consumer
+ * never blocks. When the ring is full, tasks spill into a mutex protected
+ * overflow list instead of being dropped or blocking the producer (the main
+ * task may post to itself). Tasks from one producer always run in order.
+ */
+template <typename T, size_t Capacity>
+class TaskQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    TaskQueue() {
+        for (size_t i = 0; i < Capacity; i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    TaskQueue(const TaskQueue&) = delete;
+    TaskQueue& operator=(const TaskQueue&) = delete;
+
+    void Push(T&& task) {
+        // Keep per-producer order: once something spilled, follow it until drained
+        if (!overflow_pending_.load(std::memory_order_acquire)) {
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            while (true) {
+                Slot& slot = slots_[pos & (Capacity - 1)];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        slot.task = std::move(task);
+                        slot.sequence.store(pos + 1, std::memory_order_release);
+                        return;
+                    }
+                } else if (diff < 0) {
+                    break;  // full
+                } else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        overflow_.push_back(std::move(task));
+        overflow_pending_.store(true, std::memory_order_release);
+        overflow_count_++;
+    }
+
+    // Consumer side only
+    bool Pop(T& task) {
+        Slot& slot = slots_[dequeue_pos_ & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) == dequeue_pos_ + 1) {
+            task = std::move(slot.task);
+            slot.sequence.store(dequeue_pos_ + Capacity, std::memory_order_release);
+            dequeue_pos_++;
+            return true;
+        }
+        if (!overflow_pending_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        // The ring is not drained yet: a producer claimed the head slot and has
+        // not published it, and a task spilled after it may come from the same
+        // producer as one queued behind that slot. Retry once it is published.
+        if (enqueue_pos_.load(std::memory_order_relaxed) != dequeue_pos_) {
+            return false;
+        }
+        bool popped = !overflow_.empty();
+        if (popped) {
+            task = std::move(overflow_.front());
+            overflow_.pop_front();
+        }
+        if (overflow_.empty()) {
+            overflow_pending_.store(false, std::memory_order_release);
+        }
+        return popped;
+    }
+
+    // Number of tasks that did not fit the ring since boot
+    uint32_t overflow_count() const { return overflow_count_; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T task;
+    };
+
+    Slot slots_[Capacity];
+    std::atomic<size_t> enqueue_pos_{0};
+    size_t dequeue_pos_ = 0;
+    std::atomic<bool> overflow_pending_{false};
+    std::mutex overflow_mutex_;
+    std::deque<T> overflow_;
+    uint32_t overflow_count_ = 0;
+};
+
+#endif // TASK_QUEUE_H
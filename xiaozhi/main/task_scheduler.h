@@ -0,0 +1,159 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include "task_queue.h"
+
+#include <atomic>
+#include <cstdint>
+
+#if __has_include(<sdkconfig.h>)
+#include <sdkconfig.h>
+#endif
+
+// Record where each task was posted from, for the main loop profiler
+#if defined(CONFIG_MAIN_LOOP_PROFILING) && !defined(TASK_SCHEDULER_SOURCES)
+#define TASK_SCHEDULER_SOURCES 1
+#endif
+
+#define TASK_LANE_QUEUE_SIZE 32
+#define TASK_WAIT_HISTOGRAM_BUCKETS 6
+
+enum TaskLane {
+    kTaskLaneRealtime,    // abort, device state changes
+    kTaskLaneNormal,      // default for Schedule()
+    kTaskLaneBackground,  // MCP tool bodies, deferrable work
+    kTaskLaneCount
+};
+
+// Default deadline per lane in ms, counted from post to start of run
+static constexpr uint32_t kTaskLaneDeadlineMs[kTaskLaneCount] = {20, 200, 1000};
+
+// Upper bounds of the wait histogram buckets in ms, the last bucket is open ended
+static constexpr uint32_t kTaskWaitBucketMs[TASK_WAIT_HISTOGRAM_BUCKETS - 1] = {1, 5, 20, 100, 500};
+
+/*
+ * Call site of a posted task. Used as a default argument, Here() resolves to
+ * the caller's file and line. Empty when TASK_SCHEDULER_SOURCES is off, so
+ * tagging costs nothing in normal builds.
+ */
+struct TaskSource {
+#if TASK_SCHEDULER_SOURCES
+    const char* file = nullptr;
+    int line = 0;
+
+    static constexpr TaskSource Here(const char* file = __builtin_FILE(), int line = __builtin_LINE()) {
+        return TaskSource{file, line};
+    }
+#else
+    static constexpr TaskSource Here() {
+        return TaskSource{};
+    }
+#endif
+};
+
+struct TaskLaneStats {
+    uint32_t depth = 0;
+    uint32_t run = 0;
+    uint32_t deadline_misses = 0;
+    uint32_t max_wait_us = 0;
+    uint32_t wait_histogram[TASK_WAIT_HISTOGRAM_BUCKETS] = {};
+};
+
+/*
+ * Main loop work queue with strict priority lanes.
+ * Each lane is a lock-free TaskQueue, so within a lane the longest waiting
+ * task runs first; across lanes, realtime always goes before normal and
+ * normal before background, re-checked after every task. A task that starts
+ * later than its deadline is counted as a miss, the task still runs.
+ * Time is passed in by the caller (esp_timer_get_time() on the device) so
+ * the class also builds on the host.
+ */
+class TaskScheduler {
+public:
+    // deadline_ms 0 uses the lane default
+    template <typename F>
+    void Post(TaskLane lane, F&& callback, int64_t now_us, uint32_t deadline_ms = 0,
+              [[maybe_unused]] TaskSource source = TaskSource::Here()) {
+        if (deadline_ms == 0) {
+            deadline_ms = kTaskLaneDeadlineMs[lane];
+        }
+#if TASK_SCHEDULER_SOURCES
+        ScheduledTask task{InlineTask(std::forward<F>(callback)), now_us, deadline_ms, source};
+#else
+        ScheduledTask task{InlineTask(std::forward<F>(callback)), now_us, deadline_ms};
+#endif
+        lanes_[lane].queue.Push(std::move(task));
+        lanes_[lane].posted.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Consumer side only. Runs the next task by priority, false when all lanes are empty.
+    bool RunNext(int64_t now_us) {
+        for (int lane = 0; lane < kTaskLaneCount; lane++) {
+            if (lanes_[lane].queue.Pop(current_)) {
+                Record(lanes_[lane].stats, now_us - current_.post_time_us, current_.deadline_ms);
+#if TASK_SCHEDULER_SOURCES
+                running_.store(&current_.source, std::memory_order_release);
+                current_.task();
+                running_.store(nullptr, std::memory_order_release);
+#else
+                current_.task();
+#endif
+                current_.task.Reset();
+                return true;
+            }
+        }
+        return false;
+    }
+
+#if TASK_SCHEDULER_SOURCES
+    // Source of the task running now (nullptr between tasks), readable from other tasks
+    const TaskSource* running_source() const { return running_.load(std::memory_order_acquire); }
+    // Source of the task most recently run, consumer side only
+    const TaskSource& last_source() const { return current_.source; }
+#endif
+
+    TaskLaneStats stats(TaskLane lane) const {
+        TaskLaneStats stats = lanes_[lane].stats;
+        stats.depth = lanes_[lane].posted.load(std::memory_order_relaxed) - stats.run;
+        return stats;
+    }
+
+private:
+    struct ScheduledTask {
+        InlineTask task;
+        int64_t post_time_us = 0;
+        uint32_t deadline_ms = 0;
+#if TASK_SCHEDULER_SOURCES
+        TaskSource source;
+#endif
+    };
+
+    struct Lane {
+        TaskQueue<ScheduledTask, TASK_LANE_QUEUE_SIZE> queue;
+        std::atomic<uint32_t> posted{0};
+        TaskLaneStats stats;
+    };
+
+    Lane lanes_[kTaskLaneCount];
+    ScheduledTask current_;
+#if TASK_SCHEDULER_SOURCES
+    std::atomic<const TaskSource*> running_{nullptr};
+#endif
+
+    static void Record(TaskLaneStats& stats, int64_t wait_us, uint32_t deadline_ms) {
+        stats.run++;
+        if (wait_us > (int64_t)deadline_ms * 1000) {
+            stats.deadline_misses++;
+        }
+        if (wait_us > stats.max_wait_us) {
+            stats.max_wait_us = wait_us;
+        }
+        int bucket = 0;
+        while (bucket < TASK_WAIT_HISTOGRAM_BUCKETS - 1 && wait_us >= (int64_t)kTaskWaitBucketMs[bucket] * 1000) {
+            bucket++;
+        }
+        stats.wait_histogram[bucket]++;
+    }
+};
+
+#endif // TASK_SCHEDULER_H
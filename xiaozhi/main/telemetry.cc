@@ -0,0 +1,146 @@
+#include "telemetry.h"
+#include "json_writer.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#define TAG "Telemetry"
+
+struct TelemetryDefinition {
+    const char* name;
+    const char* unit;
+    TelemetryAggregate aggregate;
+};
+
+static const TelemetryDefinition kTelemetryDefinitions[kTelemetryCount] = {
+    {"heap_free", "KB", kTelemetryAverage},
+    {"heap_min_free", "KB", kTelemetryAverage},
+    {"cpu_load", "%", kTelemetryAverage},
+    {"wifi_rssi", "dBm", kTelemetryAverage},
+    {"battery", "%", kTelemetryAverage},
+    {"actuator_battery", "mV", kTelemetryAverage},
+    {"queue_depth", "tasks", kTelemetryMax},
+    {"audio_power", "bits", kTelemetryMax},
+    {"i2c_errors", "count", kTelemetrySum},
+};
+
+Telemetry::Telemetry() {
+    int allocated = 0;
+    for (int i = 0; i < kTelemetryCount; i++) {
+        void* memory = heap_caps_malloc(TelemetrySeries::MemorySize(), MALLOC_CAP_SPIRAM);
+        if (memory == nullptr) {
+            ESP_LOGW(TAG, "No PSRAM for series %s", kTelemetryDefinitions[i].name);
+            continue;
+        }
+        auto& definition = kTelemetryDefinitions[i];
+        series_[i] = new TelemetrySeries(definition.name, definition.unit, definition.aggregate, memory);
+        allocated++;
+    }
+    ESP_LOGI(TAG, "%d series, %u bytes each", allocated, (unsigned)TelemetrySeries::MemorySize());
+}
+
+Telemetry::~Telemetry() {
+    for (auto series : series_) {
+        delete series;
+    }
+}
+
+uint32_t Telemetry::Now() {
+    return esp_timer_get_time() / 1000000;
+}
+
+void Telemetry::Record(TelemetryId id, int32_t value) {
+    if (series_[id] == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    series_[id]->Record(Now(), value);
+}
+
+std::string Telemetry::SeriesNames() {
+    std::string names;
+    for (auto& definition : kTelemetryDefinitions) {
+        if (!names.empty()) {
+            names += ", ";
+        }
+        names += definition.name;
+    }
+    return names;
+}
+
+std::string Telemetry::QueryJson(const std::string& name, uint32_t range_s, uint32_t step_s) {
+    int id = -1;
+    for (int i = 0; i < kTelemetryCount; i++) {
+        if (name == kTelemetryDefinitions[i].name) {
+            id = i;
+            break;
+        }
+    }
+    if (id < 0 || series_[id] == nullptr) {
+        return "";
+    }
+
+    std::string json_str(256 + TELEMETRY_MAX_POINTS * 24, '\0');
+    JsonWriter json(json_str.data(), json_str.size());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& series = *series_[id];
+    uint32_t now = Now();
+    uint32_t from = now > range_s ? now - range_s : 0;
+    int level = series.LevelFor(from);
+    uint32_t resolution = level >= 0 ? kTelemetryResolution[level] : 1;
+
+    // Whole multiples of the level resolution, no more than TELEMETRY_MAX_POINTS buckets
+    uint32_t min_step = (range_s + TELEMETRY_MAX_POINTS - 1) / TELEMETRY_MAX_POINTS;
+    if (step_s < min_step) {
+        step_s = min_step;
+    }
+    step_s = (step_s + resolution - 1) / resolution * resolution;
+
+    json.BeginObject()
+        .Field("series", series.name())
+        .Field("unit", series.unit())
+        .Field("now", (int)now)
+        .Field("resolution", (int)resolution)
+        .Field("step", (int)step_s);
+    json.Key("points").BeginArray();
+    if (level >= 0) {
+        auto aggregate = kTelemetryDefinitions[id].aggregate;
+        uint32_t bucket = UINT32_MAX;
+        int64_t sum = 0;
+        int32_t max = 0;
+        int count = 0;
+        auto emit = [&]() {
+            int64_t value = aggregate == kTelemetryMax ? max : aggregate == kTelemetrySum ? sum : sum / count;
+            json.BeginArray().Number(from + bucket * step_s).Number(value).EndArray();
+        };
+        series.Visit(level, from, now, [&](uint32_t time, int32_t value) {
+            uint32_t index = (time - from) / step_s;
+            if (index != bucket) {
+                if (count > 0) {
+                    emit();
+                }
+                bucket = index;
+                sum = 0;
+                max = value;
+                count = 0;
+            }
+            sum += value;
+            if (value > max) {
+                max = value;
+            }
+            count++;
+        });
+        if (count > 0) {
+            emit();
+        }
+    }
+    json.EndArray().EndObject();
+
+    if (json.overflow()) {
+        return "{}";
+    }
+    json_str.resize(json.size());
+    return json_str;
+}
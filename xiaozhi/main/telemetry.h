@@ -0,0 +1,57 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "telemetry_series.h"
+
+#include <mutex>
+#include <string>
+
+// Most points returned by one query, coarser steps are picked to stay below it
+#define TELEMETRY_MAX_POINTS 120
+
+enum TelemetryId {
+    kTelemetryHeapFree,         // KB, internal SRAM
+    kTelemetryHeapMinFree,      // KB, internal SRAM low-water mark
+    kTelemetryCpuLoad,          // %, both cores
+    kTelemetryWifiRssi,         // dBm
+    kTelemetryBattery,          // %, board fuel gauge
+    kTelemetryActuatorBattery,  // mV, reported over I2C
+    kTelemetryQueueDepth,       // tasks waiting in the main loop lanes
+    kTelemetryAudioPower,       // codec power bits, 1 input, 2 output
+    kTelemetryI2cErrors,        // failed status polls
+    kTelemetryCount
+};
+
+/*
+ * History of device health metrics kept in PSRAM, see TelemetrySeries.
+ * Record() is cheap enough for the periodic paths that feed it (main loop
+ * clock tick, audio power timer, I2C status polling) and may be called from
+ * any task. Series whose memory could not be allocated are skipped.
+ */
+class Telemetry {
+public:
+    static Telemetry& GetInstance() {
+        static Telemetry instance;
+        return instance;
+    }
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    void Record(TelemetryId id, int32_t value);
+
+    // Last range_s seconds of one series, averaged over step_s (0 picks a step)
+    std::string QueryJson(const std::string& name, uint32_t range_s, uint32_t step_s);
+    // Comma separated names for the MCP tool description
+    static std::string SeriesNames();
+
+private:
+    Telemetry();
+    ~Telemetry();
+
+    std::mutex mutex_;
+    TelemetrySeries* series_[kTelemetryCount] = {};
+
+    static uint32_t Now();
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,197 @@
+#ifndef TELEMETRY_SERIES_H
+#define TELEMETRY_SERIES_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Samples per block, the first is stored in full and the rest as deltas
+#define TELEMETRY_BLOCK_SAMPLES 32
+#define TELEMETRY_LEVEL_COUNT 3
+
+// Resolution in seconds and kept history per level: 1 s for an hour, 1 min for a day, 1 h for 30 days
+static constexpr uint32_t kTelemetryResolution[TELEMETRY_LEVEL_COUNT] = {1, 60, 3600};
+static constexpr uint32_t kTelemetryHistory[TELEMETRY_LEVEL_COUNT] = {3600, 24 * 60, 30 * 24};
+
+// How samples falling into the same slot are combined
+enum TelemetryAggregate {
+    kTelemetryAverage,  // gauges: heap, RSSI, battery
+    kTelemetryMax,      // peaks: queue depth
+    kTelemetrySum,      // counters: errors
+};
+
+/*
+ * One metric at several resolutions in fixed memory.
+ * Each level is a ring of blocks; a block holds a base value and time, then
+ * up to TELEMETRY_BLOCK_SAMPLES - 1 samples of 3 bytes (16 bit value delta and
+ * 8 bit time step). A delta or gap that does not fit starts a new block, the
+ * oldest block is overwritten when the ring is full. Coarser levels are fed
+ * with the aggregate of each finished slot of the finest one.
+ * The memory comes from the caller (PSRAM on the device), see MemorySize().
+ */
+class TelemetrySeries {
+public:
+    TelemetrySeries(const char* name, const char* unit, TelemetryAggregate aggregate, void* memory)
+        : name_(name), unit_(unit), aggregate_(aggregate) {
+        Block* blocks = static_cast<Block*>(memory);
+        for (int level = 0; level < TELEMETRY_LEVEL_COUNT; level++) {
+            levels_[level].blocks = blocks;
+            levels_[level].capacity = BlockCount(level);
+            levels_[level].resolution = kTelemetryResolution[level];
+            blocks += levels_[level].capacity;
+        }
+    }
+
+    static constexpr size_t MemorySize() {
+        size_t blocks = 0;
+        for (int level = 0; level < TELEMETRY_LEVEL_COUNT; level++) {
+            blocks += BlockCount(level);
+        }
+        return blocks * sizeof(Block);
+    }
+
+    const char* name() const { return name_; }
+    const char* unit() const { return unit_; }
+
+    // time in seconds, must not go backwards
+    void Record(uint32_t time, int32_t value) {
+        for (int level = 0; level < TELEMETRY_LEVEL_COUNT; level++) {
+            Slot& slot = slots_[level];
+            uint32_t index = time / kTelemetryResolution[level];
+            if (slot.count > 0 && slot.index != index) {
+                Append(levels_[level], slot.index * kTelemetryResolution[level], slot.Value(aggregate_));
+                slot.count = 0;
+            }
+            if (slot.count == 0) {
+                slot.index = index;
+                slot.sum = 0;
+                slot.max = value;
+            }
+            slot.count++;
+            slot.sum += value;
+            if (value > slot.max) {
+                slot.max = value;
+            }
+        }
+    }
+
+    // Finest level still holding samples as old as from, -1 if none recorded
+    int LevelFor(uint32_t from) const {
+        for (int level = 0; level < TELEMETRY_LEVEL_COUNT; level++) {
+            if (levels_[level].used > 0 && OldestTime(level) <= from) {
+                return level;
+            }
+        }
+        for (int level = TELEMETRY_LEVEL_COUNT - 1; level >= 0; level--) {
+            if (levels_[level].used > 0) {
+                return level;
+            }
+        }
+        return -1;
+    }
+
+    // Calls visit(time, value) for each stored sample of a level in [from, to], oldest first
+    template <typename Visitor>
+    void Visit(int level, uint32_t from, uint32_t to, Visitor&& visit) const {
+        const Level& ring = levels_[level];
+        for (int i = 0; i < ring.used; i++) {
+            const Block& block = ring.blocks[(ring.head - ring.used + 1 + i + ring.capacity) % ring.capacity];
+            uint32_t time = block.start;
+            int32_t value = block.base;
+            for (int n = 0; n < block.count && time <= to; n++) {
+                if (n > 0) {
+                    time += block.deltas[n - 1].step * kTelemetryResolution[level];
+                    value += block.deltas[n - 1].value;
+                }
+                if (time >= from && time <= to) {
+                    visit(time, value);
+                }
+            }
+        }
+    }
+
+private:
+    struct __attribute__((packed)) Delta {
+        int16_t value;
+        uint8_t step;  // in units of the level resolution
+    };
+
+    struct Block {
+        uint32_t start;
+        int32_t base;
+        uint16_t count;
+        Delta deltas[TELEMETRY_BLOCK_SAMPLES - 1];
+    };
+
+    struct Level {
+        Block* blocks = nullptr;
+        int capacity = 0;
+        uint32_t resolution = 1;
+        int head = -1;  // newest block
+        int used = 0;
+        uint32_t last_time = 0;
+        int32_t last_value = 0;
+    };
+
+    // Samples of the slot currently being filled
+    struct Slot {
+        uint32_t index = 0;
+        uint32_t count = 0;
+        int64_t sum = 0;
+        int32_t max = 0;
+
+        int32_t Value(TelemetryAggregate aggregate) const {
+            switch (aggregate) {
+            case kTelemetryMax:
+                return max;
+            case kTelemetrySum:
+                return (int32_t)sum;
+            default:
+                return sum / (int64_t)count;
+            }
+        }
+    };
+
+    const char* name_;
+    const char* unit_;
+    TelemetryAggregate aggregate_;
+    Level levels_[TELEMETRY_LEVEL_COUNT];
+    Slot slots_[TELEMETRY_LEVEL_COUNT];
+
+    // Enough blocks for the history even if every block is full; a gap or big jump costs a block
+    static constexpr int BlockCount(int level) {
+        return (kTelemetryHistory[level] + TELEMETRY_BLOCK_SAMPLES - 1) / TELEMETRY_BLOCK_SAMPLES + 1;
+    }
+
+    uint32_t OldestTime(int level) const {
+        const Level& ring = levels_[level];
+        return ring.blocks[(ring.head - ring.used + 1 + ring.capacity) % ring.capacity].start;
+    }
+
+    static void Append(Level& ring, uint32_t time, int32_t value) {
+        if (ring.used > 0) {
+            Block& block = ring.blocks[ring.head];
+            uint32_t step = (time - ring.last_time) / ring.resolution;
+            int64_t delta = (int64_t)value - ring.last_value;
+            if (block.count < TELEMETRY_BLOCK_SAMPLES && step >= 1 && step <= UINT8_MAX &&
+                delta >= INT16_MIN && delta <= INT16_MAX) {
+                block.deltas[block.count - 1] = {(int16_t)delta, (uint8_t)step};
+                block.count++;
+                ring.last_time = time;
+                ring.last_value = value;
+                return;
+            }
+        }
+        ring.head = (ring.head + 1) % ring.capacity;
+        if (ring.used < ring.capacity) {
+            ring.used++;
+        }
+        Block& block = ring.blocks[ring.head];
+        block.start = time;
+        block.base = value;
+        block.count = 1;
+        ring.last_time = time;
+        ring.last_value = value;
+    }
+};
+
+#endif // TELEMETRY_SERIES_H
@@ -0,0 +1,65 @@
+/*
+ * Host simulation: time from power on to idle, serial versus graph boot.
+ * Steps sleep for typical latencies seen on an S3 over WiFi; the graph is the
+ * one Application::Start builds with BootSequence.
+ *
+ *   serial:  audio, network, assets, version check, MQTT connect in turn
+ *   graph:   audio, network and assets overlap, the MQTT connect waits for
+ *            the version check that may change its config
+ *
+ *   g++ -O2 -std=c++17 -pthread -I ../../main main.cc -o boot_sequence_bench
+ *   ./boot_sequence_bench [time scale, default 1]
+ */
+#include "boot_sequence.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+// Nominal step latencies in ms
+#define AUDIO_INIT_MS 350
+#define NETWORK_MS 2200
+#define ASSETS_VERIFY_MS 400
+#define ASSETS_APPLY_MS 250
+#define VERSION_CHECK_MS 1200
+#define MQTT_CONNECT_MS 900
+
+static double scale = 1;
+
+static std::function<void()> Sleep(int ms) {
+    return [ms]() { std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(ms * 1000 * scale))); };
+}
+
+static void Report(const char* name, BootSequence& boot) {
+    printf("%s: idle after %d ms\n", name, (int)(boot.total_ms() / scale));
+    for (auto& line : boot.Timeline()) {
+        printf("  %s\n", line.c_str());
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        scale = atof(argv[1]);
+    }
+    printf("time scale %.2f, timelines are in scaled ms\n\n", scale);
+
+    BootSequence serial;
+    serial.AddStep("audio", {}, Sleep(AUDIO_INIT_MS));
+    serial.AddStep("network", {"audio"}, Sleep(NETWORK_MS));
+    serial.AddStep("assets_verify", {"network"}, Sleep(ASSETS_VERIFY_MS));
+    serial.AddStep("assets", {"assets_verify"}, Sleep(ASSETS_APPLY_MS));
+    serial.AddStep("ota", {"assets"}, Sleep(VERSION_CHECK_MS));
+    serial.AddStep("protocol", {"ota"}, Sleep(MQTT_CONNECT_MS));
+    serial.Run();
+    Report("serial", serial);
+
+    BootSequence graph;
+    graph.AddStep("audio", {}, Sleep(AUDIO_INIT_MS));
+    graph.AddStep("network", {}, Sleep(NETWORK_MS));
+    graph.AddStep("assets_verify", {}, Sleep(ASSETS_VERIFY_MS));
+    graph.AddStep("assets", {"assets_verify", "audio"}, Sleep(ASSETS_APPLY_MS));
+    graph.AddStep("ota", {"network", "audio"}, Sleep(VERSION_CHECK_MS));
+    graph.AddStep("protocol", {"ota"}, Sleep(MQTT_CONNECT_MS));
+    graph.Run();
+    Report("\ngraph", graph);
+    return 0;
+}
@@ -0,0 +1,38 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <esp_log.h>
+
+// Stand-in for display/display.h: the setters DisplayUpdater calls and the
+// lock it takes, implemented by the bench
+#define HAVE_LVGL 1
+
+class Display {
+public:
+    virtual ~Display() = default;
+    virtual void SetStatus(const char* status) = 0;
+    virtual void SetEmotion(const char* emotion) = 0;
+    virtual void SetChatMessage(const char* role, const char* content) = 0;
+
+protected:
+    friend class DisplayLockGuard;
+    virtual bool Lock(int timeout_ms = 0) = 0;
+    virtual void Unlock() = 0;
+};
+
+class DisplayLockGuard {
+public:
+    DisplayLockGuard(Display* display) : display_(display) {
+        if (!display_->Lock(30000)) {
+            ESP_LOGE("Display", "Failed to lock display");
+        }
+    }
+    ~DisplayLockGuard() {
+        display_->Unlock();
+    }
+
+private:
+    Display* display_;
+};
+
+#endif // DISPLAY_H
@@ -0,0 +1,3 @@
+// Included first (-include): display_updater.h picks up display.h from its own
+// directory, these stand-ins take its include guard
+#include "display.h"
@@ -0,0 +1,172 @@
+/*
+ * Host benchmark: display lock traffic during a fast sentence stream.
+ * A fake display holds a recursive lock for a fixed cost per setter, like
+ * the LVGL port lock around label/emoji updates. The stream replays what
+ * the server sends in a turn: stt text, state changes, then sentences with
+ * an llm emotion each, 20..150 ms apart.
+ *
+ *   direct:    every update calls the display (the old background lane path)
+ *   coalesced: updates go through the real DisplayUpdater
+ *              (xiaozhi/main/display/display_updater.cc) on the FreeRTOS /
+ *              esp_timer stand-ins of scripts/i2c_sim
+ *
+ * Exits non-zero if a chat message is lost or one lock hold of the updater
+ * applies more than DISPLAY_UPDATE_MAX_CHAT_PER_LOCK chat messages.
+ *
+ *   g++ -O2 -std=c++17 -pthread -I fake -I ../i2c_sim/fake -I ../../main/display -include fake/shadow.h \
+ *       main.cc ../../main/display/display_updater.cc ../i2c_sim/fake/freertos.cc ../i2c_sim/fake/esp_idf.cc \
+ *       -o display_update_bench
+ *   ./display_update_bench [seconds]
+ */
+#include "display_updater.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+// Time spent under the lock per setter, roughly what label relayout costs on the S3
+#define STATUS_COST_US 150
+#define EMOTION_COST_US 300
+#define CHAT_COST_US 600
+
+using Clock = std::chrono::steady_clock;
+
+static int64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static void Spin(int us) {
+    int64_t end = NowUs() + us;
+    while (NowUs() < end) {
+    }
+}
+
+class FakeDisplay : public Display {
+public:
+    void SetStatus(const char*) override { Apply(STATUS_COST_US); }
+    void SetEmotion(const char*) override { Apply(EMOTION_COST_US); }
+    void SetChatMessage(const char*, const char*) override {
+        Lock();
+        chat_++;
+        chat_in_hold_++;
+        Apply(CHAT_COST_US);
+        Unlock();
+    }
+
+    // Counts outermost acquisitions only, nested ones are free on a recursive lock
+    bool Lock(int = 0) override {
+        mutex_.lock();
+        if (depth_++ == 0) {
+            acquisitions_++;
+            lock_time_ = NowUs();
+            chat_in_hold_ = 0;
+        }
+        return true;
+    }
+
+    void Unlock() override {
+        if (--depth_ == 0) {
+            int64_t held = NowUs() - lock_time_;
+            total_hold_us_ += held;
+            max_hold_us_ = std::max(max_hold_us_, held);
+            max_chat_per_hold_ = std::max(max_chat_per_hold_, chat_in_hold_);
+        }
+        mutex_.unlock();
+    }
+
+    int acquisitions_ = 0;
+    int64_t total_hold_us_ = 0;
+    int64_t max_hold_us_ = 0;
+    int max_chat_per_hold_ = 0;
+    int applied_ = 0;
+    int chat_ = 0;
+
+private:
+    std::recursive_mutex mutex_;
+    int depth_ = 0;
+    int64_t lock_time_ = 0;
+    int chat_in_hold_ = 0;
+
+    void Apply(int cost_us) {
+        Lock();
+        applied_++;
+        Spin(cost_us);
+        Unlock();
+    }
+};
+
+static int chat_posted;
+
+template <typename Sink>
+static int Stream(Sink& sink, double seconds) {
+    static const char* const kEmotions[] = {"happy", "thinking", "neutral", "laughing", "surprised"};
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> gap_ms(20, 150);
+    std::uniform_int_distribution<int> sentences(6, 14);
+    int posted = 0;
+    chat_posted = 0;
+    auto end = Clock::now() + std::chrono::duration<double>(seconds);
+    while (Clock::now() < end) {
+        sink.SetStatus("Listening");
+        sink.SetEmotion("neutral");
+        sink.SetChatMessage("user", "What is the weather like tomorrow?");
+        sink.SetStatus("Speaking");
+        posted += 4;
+        chat_posted++;
+        int count = sentences(rng);
+        for (int i = 0; i < count && Clock::now() < end; i++) {
+            sink.SetChatMessage("assistant", "Tomorrow will be partly cloudy with a light breeze.");
+            sink.SetEmotion(kEmotions[rng() % 5]);
+            posted += 2;
+            chat_posted++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(gap_ms(rng)));
+        }
+        sink.SetStatus("Standby");
+        sink.SetEmotion("neutral");
+        posted += 2;
+    }
+    return posted;
+}
+
+// Chat lines are never coalesced, every posted one must reach the display
+static bool Report(const char* name, const FakeDisplay& display, int posted, double seconds) {
+    printf("%-10s posted %5d applied %5d  chat %4d/%-4d  lock %6.1f /s  hold %6.2f ms/s  avg %5d us  max %5d us\n",
+        name, posted, display.applied_, display.chat_, chat_posted, display.acquisitions_ / seconds,
+        display.total_hold_us_ / 1000.0 / seconds,
+        display.acquisitions_ ? (int)(display.total_hold_us_ / display.acquisitions_) : 0, (int)display.max_hold_us_);
+    return display.chat_ == chat_posted;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 5;
+
+    FakeDisplay direct_display;
+    int direct_posted = Stream(direct_display, seconds);
+    bool ok = Report("direct", direct_display, direct_posted, seconds);
+
+    FakeDisplay coalesced_display;
+    // The update task never exits, the updater outlives main
+    auto updater = new DisplayUpdater();
+    updater->Start(&coalesced_display);
+    int coalesced_posted = Stream(*updater, seconds);
+    std::this_thread::sleep_for(std::chrono::milliseconds(DISPLAY_UPDATE_INTERVAL_MS * 4));
+    ok = Report("coalesced", coalesced_display, coalesced_posted, seconds) && ok;
+    auto stats = updater->stats();
+    printf("updater: posted %u coalesced %u lock holds %u, max %d chat messages per hold\n", stats.posted,
+        stats.coalesced, stats.flushes, coalesced_display.max_chat_per_hold_);
+    if (!ok) {
+        printf("chat messages lost\n");
+    }
+    if (coalesced_display.max_chat_per_hold_ > DISPLAY_UPDATE_MAX_CHAT_PER_LOCK) {
+        printf("more than %d chat messages under one lock hold\n", DISPLAY_UPDATE_MAX_CHAT_PER_LOCK);
+        ok = false;
+    }
+    fflush(stdout);
+    _exit(ok ? 0 : 1);
+}
@@ -0,0 +1,424 @@
+/*
+ * Host check for the actuator bus task (main/actuator/i2c_bus_scheduler.h).
+ *
+ * Scheduler: lane order, FIFO within a lane, identical polls coalesced into
+ * one transaction, tickets past their deadline dropped unsent, Close()
+ * failing everything pending, Next(now, kI2cBusStop) leaving lower lanes.
+ *
+ * Saturation: two threads poll status back to back, one opens and closes
+ * doors back to back, one sends a move every 20 ms, and a stop goes out
+ * every 97 ms. Transactions take their bus time at 100 kHz plus the
+ * actuator's work (0.2-1 ms status, 1 ms move, 600 ms door), replies are
+ * polled on the I2cReplyWait schedule. Runs once the way the bridge did
+ * before (each caller holds a mutex for its whole write, wait and read) and
+ * once through a bus task that, like I2CCommandBridge::Transact, sends
+ * pending stops between the polls of a slow reply. Prints stop latency from
+ * submit to ack and exits non-zero if it ever exceeds kStopBoundUs with the
+ * bus task. Strict priority lets back to back doors starve the polls; on the
+ * device the polling task's deadline drops them instead.
+ *
+ *   g++ -O2 -std=c++17 -pthread -I ../../main/actuator main.cc -o i2c_bus_scheduler_check
+ *   ./i2c_bus_scheduler_check [seconds]
+ */
+#include "i2c_bus_scheduler.h"
+#include "i2c_reply_wait.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const int kBusHz = 100000;
+static const int64_t kStopBoundUs = 20000;
+
+static bool Check(bool ok, const char* what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static int64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static void SleepUs(int64_t us) {
+    if (us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    }
+}
+
+static int64_t TransactionUs(size_t bytes) {
+    return ((1 + (int64_t)bytes) * 9 + 2) * 1000000 / kBusHz;
+}
+
+static int64_t ActuatorUs(uint8_t type) {
+    switch (type) {
+    case kI2cFrameStatus:
+        return 200 + rand() % 800;
+    case kI2cFrameStorage:
+        return 600000;
+    default:
+        return 1000;
+    }
+}
+
+static I2cFrame Move(uint8_t dir, uint32_t ms) {
+    I2cFrame frame(kI2cFrameVehicleTime, 0);
+    frame.U8(dir).U8(50).U32(ms);
+    return frame;
+}
+
+static I2cFrame Door(uint8_t slot, uint8_t action) {
+    I2cFrame frame(kI2cFrameStorage, 0);
+    frame.U8(slot).U8(action);
+    return frame;
+}
+
+// ==================== scheduler unit checks ====================
+
+struct Recorder {
+    std::vector<I2cBusTicket*> done;
+
+    static void Done(I2cBusTicket* ticket) { static_cast<Recorder*>(ticket->user_data)->done.push_back(ticket); }
+
+    void Prepare(I2cBusTicket& ticket, I2cBusPriority priority, const I2cFrame& request) {
+        ticket.request = request;
+        ticket.priority = priority;
+        ticket.done = Done;
+        ticket.user_data = this;
+    }
+};
+
+static bool CheckScheduler() {
+    bool ok = true;
+    Recorder recorder;
+    I2cBusScheduler bus;
+
+    I2cBusTicket poll, door, move1, move2, stop;
+    recorder.Prepare(poll, kI2cBusPoll, I2cFrame(kI2cFrameStatus, 0));
+    recorder.Prepare(door, kI2cBusStorage, Door(0, ACT_OPEN));
+    recorder.Prepare(move1, kI2cBusMotion, Move(DIR_FORWARD, 500));
+    recorder.Prepare(move2, kI2cBusMotion, Move(DIR_LEFT, 500));
+    recorder.Prepare(stop, kI2cBusStop, Move(DIR_STOP, 0));
+    bus.Submit(&poll, 0);
+    bus.Submit(&door, 1);
+    bus.Submit(&move1, 2);
+    bus.Submit(&move2, 3);
+    bus.Submit(&stop, 4);
+    std::vector<I2cBusTicket*> order;
+    for (I2cBusTicket* t; (t = bus.Next(10)) != nullptr;) {
+        order.push_back(t);
+        bus.Complete(t);
+    }
+    std::vector<I2cBusTicket*> expected = {&stop, &move1, &move2, &door, &poll};
+    ok &= Check(order == expected, "stop > motion > storage > poll, FIFO in a lane");
+    ok &= Check(bus.stats(kI2cBusMotion).run == 2 && bus.stats(kI2cBusMotion).max_wait_us == 8,
+        "lane stats count runs and the longest wait");
+
+    recorder.done.clear();
+    I2cBusTicket polls[3], probe;
+    for (auto& p : polls) {
+        recorder.Prepare(p, kI2cBusPoll, I2cFrame(kI2cFrameStatus, 0));
+        bus.Submit(&p, 20);
+    }
+    recorder.Prepare(probe, kI2cBusPoll, I2cFrame());
+    probe.probe = true;
+    bus.Submit(&probe, 20);
+    I2cBusTicket* first = bus.Next(21);
+    first->reply = I2cFrame(kI2cFrameStatusReply, 7);
+    first->reply.U8(I2C_STATUS_MOVING).U16(72).U8(1).U8(0);
+    bus.Complete(first);
+    bool same = recorder.done.size() == 3;
+    for (auto* t : recorder.done) {
+        same &= t->error == nullptr && t->reply.type == kI2cFrameStatusReply && t->reply.u16(1) == 72;
+    }
+    I2cBusTicket* second = bus.Next(22);
+    ok &= Check(first == &polls[0] && same && second == &probe && bus.Next(23) == nullptr,
+        "identical polls coalesced, probes kept apart");
+    bus.Complete(second);
+    ok &= Check(bus.stats(kI2cBusPoll).coalesced == 2, "coalesced polls counted");
+
+    recorder.done.clear();
+    I2cBusTicket late, fresh, joined;
+    recorder.Prepare(late, kI2cBusMotion, Move(DIR_FORWARD, 100));
+    recorder.Prepare(fresh, kI2cBusMotion, Move(DIR_BACKWARD, 100));
+    recorder.Prepare(joined, kI2cBusPoll, I2cFrame(kI2cFrameStatus, 0));
+    I2cBusTicket polled;
+    recorder.Prepare(polled, kI2cBusPoll, I2cFrame(kI2cFrameStatus, 0));
+    late.deadline_us = 100;
+    polled.deadline_us = 100;
+    joined.deadline_us = 0;
+    bus.Submit(&late, 50);
+    bus.Submit(&fresh, 50);
+    bus.Submit(&polled, 50);
+    bus.Submit(&joined, 60);
+    I2cBusTicket* next = bus.Next(200);
+    ok &= Check(next == &fresh && recorder.done.size() == 1 && late.error != nullptr &&
+            std::string(late.error) == "deadline_expired" && bus.stats(kI2cBusMotion).expired == 1,
+        "ticket past its deadline dropped unsent");
+    bus.Complete(next);
+    ok &= Check(bus.Next(200) == &polled, "a joined poll without deadline keeps the poll");
+    bus.Complete(&polled);
+
+    recorder.done.clear();
+    I2cBusTicket a, b, c;
+    recorder.Prepare(a, kI2cBusPoll, I2cFrame(kI2cFrameStatus, 0));
+    recorder.Prepare(b, kI2cBusStorage, Door(1, ACT_CLOSE));
+    recorder.Prepare(c, kI2cBusStop, Move(DIR_STOP, 0));
+    bus.Submit(&a, 300);
+    bus.Submit(&b, 300);
+    ok &= Check(bus.Next(301, kI2cBusStop) == nullptr, "urgent Next() leaves lower lanes queued");
+    bus.Submit(&c, 302);
+    ok &= Check(bus.Next(303, kI2cBusStop) == &c, "urgent Next() takes a pending stop");
+    bus.Complete(&c);
+    recorder.done.clear();
+    bus.Close("not_initialized");
+    ok &= Check(recorder.done.size() == 2 && a.error == b.error && std::string(a.error) == "not_initialized" &&
+            !bus.Submit(&c, 400),
+        "Close() fails pending tickets and later submits");
+    bus.Open();
+    ok &= Check(bus.Submit(&c, 500) && bus.Next(501) == &c, "Open() accepts tickets again");
+    bus.Complete(&c);
+    return ok;
+}
+
+// ==================== saturation ====================
+
+struct Latencies {
+    std::mutex mutex;
+    std::vector<int64_t> values;
+
+    void Add(int64_t us) {
+        std::lock_guard<std::mutex> lock(mutex);
+        values.push_back(us);
+    }
+};
+
+struct Counters {
+    std::atomic<int> polls{0};
+    std::atomic<int> doors{0};
+    std::atomic<int> moves{0};
+    std::atomic<int> transactions{0};
+};
+
+// Writes the request and polls for the reply. Between the polls of a slow
+// reply `between(delay)` sleeps, the bus task uses it to send stops.
+template <typename Between>
+static void Transaction(const I2cFrame& request, Counters& counters, Between between) {
+    counters.transactions++;
+    SleepUs(TransactionUs(request.size()));
+    int64_t start = NowUs();
+    int64_t ready_at = start + ActuatorUs(request.type);
+    I2cReplyWait wait(start, I2cReplyBudgetUs(request.type));
+    for (int64_t delay_us; (delay_us = wait.NextDelayUs(NowUs())) >= 0;) {
+        if (delay_us < I2C_REPLY_SPIN_US) {
+            SleepUs(delay_us);
+        } else {
+            between(delay_us);
+        }
+        bool ready = NowUs() >= ready_at;
+        SleepUs(TransactionUs(I2cFrameReplySize(request.type)));
+        if (ready) {
+            return;
+        }
+    }
+}
+
+// Before: every caller holds the bus for its whole transaction
+class MutexBus {
+public:
+    explicit MutexBus(Counters& counters) : counters_(counters) {}
+
+    void Run(const I2cFrame& request, I2cBusPriority) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Transaction(request, counters_, [](int64_t delay_us) { SleepUs(delay_us); });
+    }
+
+private:
+    std::mutex mutex_;
+    Counters& counters_;
+};
+
+// After: one bus task, the shape of I2CCommandBridge::BusTask and RunUrgent
+class TaskBus {
+public:
+    explicit TaskBus(Counters& counters) : counters_(counters), thread_([this] { Loop(); }) {}
+
+    ~TaskBus() {
+        bus_.Close("not_initialized");
+        Notify();
+        thread_.join();
+    }
+
+    void Run(const I2cFrame& request, I2cBusPriority priority) {
+        Waiter waiter;
+        I2cBusTicket ticket;
+        ticket.request = request;
+        ticket.priority = priority;
+        ticket.user_data = &waiter;
+        ticket.done = [](I2cBusTicket* t) {
+            Waiter* w = static_cast<Waiter*>(t->user_data);
+            std::lock_guard<std::mutex> lock(w->mutex);
+            w->done = true;
+            w->cv.notify_one();
+        };
+        if (!bus_.Submit(&ticket, NowUs())) {
+            return;
+        }
+        Notify();
+        std::unique_lock<std::mutex> lock(waiter.mutex);
+        waiter.cv.wait(lock, [&] { return waiter.done; });
+    }
+
+    I2cBusLaneStats stats(I2cBusPriority priority) { return bus_.stats(priority); }
+
+private:
+    struct Waiter {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+    };
+
+    I2cBusScheduler bus_;
+    Counters& counters_;
+    std::mutex notify_mutex_;
+    std::condition_variable notify_cv_;
+    int notified_ = 0;
+    std::thread thread_;
+
+    // xTaskNotifyGive / ulTaskNotifyTake
+    void Notify() {
+        std::lock_guard<std::mutex> lock(notify_mutex_);
+        notified_++;
+        notify_cv_.notify_one();
+    }
+
+    void Take(int64_t timeout_us) {
+        std::unique_lock<std::mutex> lock(notify_mutex_);
+        notify_cv_.wait_for(lock, std::chrono::microseconds(timeout_us), [&] { return notified_ > 0; });
+        notified_ = 0;
+    }
+
+    void RunUrgent() {
+        for (I2cBusTicket* ticket; (ticket = bus_.Next(NowUs(), kI2cBusStop)) != nullptr;) {
+            counters_.transactions++;
+            SleepUs(TransactionUs(ticket->request.size()));
+            bus_.Complete(ticket);
+        }
+    }
+
+    void Loop() {
+        while (!bus_.closed()) {
+            I2cBusTicket* ticket = bus_.Next(NowUs());
+            if (ticket == nullptr) {
+                Take(1000000);
+                continue;
+            }
+            bool preemptible = ticket->priority != kI2cBusStop;
+            Transaction(ticket->request, counters_, [&](int64_t delay_us) {
+                if (preemptible) {
+                    Take(delay_us);
+                    RunUrgent();
+                } else {
+                    SleepUs(delay_us);
+                }
+            });
+            bus_.Complete(ticket);
+        }
+    }
+};
+
+template <typename Bus>
+static void Saturate(Bus& bus, Counters& counters, Latencies& stops, int seconds) {
+    std::atomic<bool> running{true};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 2; i++) {
+        threads.emplace_back([&] {
+            while (running) {
+                bus.Run(I2cFrame(kI2cFrameStatus, 0), kI2cBusPoll);
+                counters.polls++;
+            }
+        });
+    }
+    threads.emplace_back([&] {
+        for (int i = 0; running; i++) {
+            bus.Run(Door(i % 4, i % 2 ? ACT_CLOSE : ACT_OPEN), kI2cBusStorage);
+            counters.doors++;
+        }
+    });
+    threads.emplace_back([&] {
+        while (running) {
+            bus.Run(Move(DIR_FORWARD, 200), kI2cBusMotion);
+            counters.moves++;
+            SleepUs(20000);
+        }
+    });
+    threads.emplace_back([&] {
+        while (running) {
+            SleepUs(97000);
+            int64_t start = NowUs();
+            bus.Run(Move(DIR_STOP, 0), kI2cBusStop);
+            stops.Add(NowUs() - start);
+        }
+    });
+
+    SleepUs((int64_t)seconds * 1000000);
+    running = false;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+static int64_t Percentile(std::vector<int64_t> values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (size_t)(p * values.size()))];
+}
+
+static void Report(const char* name, Latencies& stops, Counters& counters, int seconds) {
+    auto& v = stops.values;
+    printf("%-22s %6d %8.2f %8.2f %8.2f %8d %8d %8d %8.0f\n", name, (int)v.size(), Percentile(v, 0.5) / 1000.0,
+        Percentile(v, 0.99) / 1000.0, Percentile(v, 1.0) / 1000.0, counters.polls.load(), counters.doors.load(),
+        counters.moves.load(), (double)counters.transactions / seconds);
+}
+
+int main(int argc, char** argv) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 5;
+    bool ok = CheckScheduler();
+
+    printf("\nsaturated bus for %d s, stop latency in ms from submit to ack\n", seconds);
+    printf("%-22s %6s %8s %8s %8s %8s %8s %8s %8s\n", "bus", "stops", "p50", "p99", "max", "polls", "doors", "moves",
+        "tx/s");
+
+    Counters mutex_counters;
+    Latencies mutex_stops;
+    {
+        MutexBus bus(mutex_counters);
+        Saturate(bus, mutex_counters, mutex_stops, seconds);
+    }
+    Report("mutex per caller", mutex_stops, mutex_counters, seconds);
+
+    Counters task_counters;
+    Latencies task_stops;
+    I2cBusLaneStats polls;
+    {
+        TaskBus bus(task_counters);
+        Saturate(bus, task_counters, task_stops, seconds);
+        polls = bus.stats(kI2cBusPoll);
+    }
+    Report("bus task, priorities", task_stops, task_counters, seconds);
+    printf("polls submitted %u, coalesced %u\n", polls.submitted, polls.coalesced);
+
+    int64_t worst = Percentile(task_stops.values, 1.0);
+    ok &= Check(!task_stops.values.empty() && worst <= kStopBoundUs, "stop latency under kStopBoundUs with the bus task");
+    ok &= Check(polls.coalesced > 0, "concurrent polls coalesced");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+/*
+ * Host check and comparison: binary I2C frames (main/actuator/i2c_frame.h)
+ * against the compact JSON the bridge sent before.
+ *
+ * Codec: CRC-16/CCITT-FALSE check value, round trip of every request and reply
+ * type at the field limits, every 1 and 2 bit error and every truncation
+ * rejected, 0xFF padding after a frame ignored, payload overflow refused.
+ *
+ * Comparison: bytes on the wire and bus time per command at 100 kHz. A byte is
+ * 9 clocks (8 bits and the ack), a transaction adds the address byte plus
+ * start and stop. JSON replies are read in 32-byte chunks until '}', frames
+ * are read once at their known size. The liveness probe and the wait between
+ * write and read are the same for both and left out.
+ *
+ *   g++ -O2 -std=c++17 -I ../../main/actuator main.cc -o i2c_frame_check
+ *   ./i2c_frame_check
+ */
+#include "i2c_frame.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const int kBusHz = 100000;
+static const int kJsonChunk = 32;
+
+static bool Check(bool ok, const char* what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static std::vector<uint8_t> Encode(const I2cFrame& frame) {
+    std::vector<uint8_t> bytes(I2C_FRAME_MAX_SIZE);
+    bytes.resize(frame.Encode(bytes.data(), bytes.size()));
+    return bytes;
+}
+
+static bool SameFrame(const I2cFrame& a, const I2cFrame& b) {
+    return a.type == b.type && a.seq == b.seq && a.length == b.length && memcmp(a.payload, b.payload, a.length) == 0;
+}
+
+// Clocks of one transaction carrying `bytes` data bytes
+static int TransactionClocks(int bytes) {
+    return (1 + bytes) * 9 + 2;
+}
+
+static double ClocksToUs(int clocks) {
+    return clocks * 1e6 / kBusHz;
+}
+
+struct Command {
+    const char* name;
+    std::string json_request;
+    std::string json_reply;
+    I2cFrame frame;
+};
+
+int main() {
+    bool ok = true;
+
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    ok &= Check(I2cFrameCrc16(check, sizeof(check)) == 0x29B1, "CRC-16/CCITT-FALSE check value 0x29B1");
+
+    std::vector<I2cFrame> frames;
+    frames.push_back(I2cFrame(kI2cFrameVehicleTime, 1));
+    frames.back().U8(DIR_ROTATE_RIGHT).U8(100).U32(0xFFFFFFFF);
+    frames.push_back(I2cFrame(kI2cFrameVehicleDistance, 127));
+    frames.back().U8(DIR_BACKWARD).U8(40).U32(300);
+    frames.push_back(I2cFrame(kI2cFrameStorage, 255));
+    frames.back().U8(3).U8(ACT_OPEN);
+    frames.push_back(I2cFrame(kI2cFrameStatus, 9));
+    frames.push_back(I2cFrame(kI2cFrameAck, 9));
+    frames.back().U8((uint8_t)STATUS_UNKNOWN);
+    frames.push_back(I2cFrame(kI2cFrameStatusReply, 9));
+    frames.back().U8(I2C_STATUS_BLE_CONNECTED | I2C_STATUS_MOVING).U16((uint16_t)-1).U8(0x0A).U8(0x21);
+
+    bool round_trip = true;
+    bool fields = true;
+    for (auto& frame : frames) {
+        auto bytes = Encode(frame);
+        I2cFrame decoded;
+        round_trip &= bytes.size() == frame.size() && decoded.Decode(bytes.data(), bytes.size()) == kI2cFrameOk &&
+            SameFrame(frame, decoded);
+    }
+    fields &= frames[0].u32(2) == 0xFFFFFFFF && frames[1].u32(2) == 300 && (int16_t)frames[5].u16(1) == -1;
+    fields &= frames[3].u8(0) == 0 && frames[1].u32(4) == 0;
+    ok &= Check(round_trip, "every frame type survives a round trip");
+    ok &= Check(fields, "little endian fields, reads past length return 0");
+
+    bool sizes = Encode(frames[3]).size() == 6 && Encode(frames[0]).size() == 12 &&
+        Encode(frames[4]).size() == I2cFrameReplySize(kI2cFrameVehicleTime) &&
+        Encode(frames[5]).size() == I2cFrameReplySize(kI2cFrameStatus);
+    ok &= Check(sizes, "I2cFrameReplySize matches the replies");
+
+    int missed = 0;
+    int checked = 0;
+    for (auto& frame : frames) {
+        auto bytes = Encode(frame);
+        int bits = (int)bytes.size() * 8;
+        for (int i = 0; i < bits; i++) {
+            for (int j = i; j < bits; j++) {
+                auto damaged = bytes;
+                damaged[i / 8] ^= 1 << (i % 8);
+                if (j != i) {
+                    damaged[j / 8] ^= 1 << (j % 8);
+                }
+                I2cFrame decoded;
+                checked++;
+                if (decoded.Decode(damaged.data(), damaged.size()) == kI2cFrameOk) {
+                    missed++;
+                }
+            }
+        }
+    }
+    printf("%d corrupted frames tried\n", checked);
+    ok &= Check(missed == 0, "every 1 and 2 bit error rejected");
+
+    bool truncated = true;
+    for (auto& frame : frames) {
+        auto bytes = Encode(frame);
+        for (size_t size = 0; size < bytes.size(); size++) {
+            I2cFrame decoded;
+            truncated &= decoded.Decode(bytes.data(), size) == kI2cFrameTruncated;
+        }
+    }
+    ok &= Check(truncated, "every truncation reported as truncated");
+
+    auto padded = Encode(frames[4]);
+    padded.resize(I2C_FRAME_MAX_SIZE, 0xFF);
+    I2cFrame decoded;
+    ok &= Check(decoded.Decode(padded.data(), padded.size()) == kI2cFrameOk && SameFrame(decoded, frames[4]),
+        "0xFF padding after a frame ignored");
+
+    uint8_t idle[I2C_FRAME_MAX_SIZE];
+    memset(idle, 0xFF, sizeof(idle));
+    const uint8_t json[] = "{\"t\":\"t\"}";
+    uint8_t long_frame[I2C_FRAME_MAX_SIZE] = {I2C_FRAME_MAGIC, kI2cFrameAck, 1, I2C_FRAME_MAX_PAYLOAD + 1};
+    ok &= Check(decoded.Decode(idle, sizeof(idle)) == kI2cFrameBadMagic &&
+            decoded.Decode(json, sizeof(json) - 1) == kI2cFrameBadMagic &&
+            decoded.Decode(long_frame, sizeof(long_frame)) == kI2cFrameBadLength,
+        "idle bus, JSON and oversized length rejected");
+
+    I2cFrame full(kI2cFrameStorage, 1);
+    for (int i = 0; i <= I2C_FRAME_MAX_PAYLOAD; i++) {
+        full.U8((uint8_t)i);
+    }
+    uint8_t out[I2C_FRAME_MAX_SIZE * 2];
+    ok &= Check(full.overflow && full.Encode(out, sizeof(out)) == 0, "payload past I2C_FRAME_MAX_PAYLOAD refused");
+    ok &= Check(frames[0].Encode(out, frames[0].size() - 1) == 0, "Encode refuses a short buffer");
+
+    // Requests as I2CCommandBridge built them with cJSON, replies as the actuator sent them
+    std::vector<Command> commands = {
+        {"move 2 s", "{\"t\":\"v\",\"d\":1,\"p\":50,\"ms\":2000}", "{\"s\":1}", I2cFrame(kI2cFrameVehicleTime, 1)},
+        {"move 500 mm", "{\"t\":\"v\",\"d\":1,\"p\":50,\"mm\":500}", "{\"s\":1}",
+            I2cFrame(kI2cFrameVehicleDistance, 1)},
+        {"stop", "{\"t\":\"v\",\"d\":0}", "{\"s\":1}", I2cFrame(kI2cFrameVehicleTime, 1)},
+        {"open slot", "{\"t\":\"s\",\"i\":0,\"a\":1}", "{\"s\":1}", I2cFrame(kI2cFrameStorage, 1)},
+        {"status", "{\"t\":\"t\"}", "{\"c\":1,\"h\":72,\"g\":[0,0,1,1]}", I2cFrame(kI2cFrameStatus, 1)},
+    };
+    commands[0].frame.U8(DIR_FORWARD).U8(50).U32(2000);
+    commands[1].frame.U8(DIR_FORWARD).U8(50).U32(500);
+    commands[2].frame.U8(DIR_STOP).U8(0).U32(0);
+    commands[3].frame.U8(0).U8(ACT_OPEN);
+
+    printf("\nper command at %d kHz (write + read, bus bytes include the address)\n", kBusHz / 1000);
+    printf("%-12s %14s %10s %14s %10s %8s\n", "command", "json bytes", "json us", "frame bytes", "frame us",
+        "speedup");
+    for (auto& command : commands) {
+        int json_clocks = TransactionClocks((int)command.json_request.size());
+        int json_bytes = 1 + (int)command.json_request.size();
+        int read = 0;
+        while (read < (int)command.json_reply.size()) {
+            json_clocks += TransactionClocks(kJsonChunk);
+            json_bytes += 1 + kJsonChunk;
+            read += kJsonChunk;
+        }
+        int request_size = (int)command.frame.size();
+        int reply_size = (int)I2cFrameReplySize(command.frame.type);
+        int frame_clocks = TransactionClocks(request_size) + TransactionClocks(reply_size);
+        int frame_bytes = 2 + request_size + reply_size;
+        printf("%-12s %14d %10.0f %14d %10.0f %7.1fx\n", command.name, json_bytes, ClocksToUs(json_clocks),
+            frame_bytes, ClocksToUs(frame_clocks), (double)json_clocks / frame_clocks);
+        ok &= frame_bytes * 2 < json_bytes;
+    }
+
+    // Codec cost on this machine, for scale against the bus time
+    const int iterations = 1000000;
+    uint8_t buffer[I2C_FRAME_MAX_SIZE];
+    uint32_t sink = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        I2cFrame request(kI2cFrameVehicleTime, (uint8_t)i);
+        request.U8(DIR_FORWARD).U8(50).U32(i);
+        size_t size = request.Encode(buffer, sizeof(buffer));
+        I2cFrame received;
+        received.Decode(buffer, size);
+        sink += received.u32(2);
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+    printf("\nencode + decode of a move frame: %.0f ns (checksum %u)\n", ns, sink);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+/*
+ * Host benchmark: I2C transactions spent on actuator liveness, a probe before
+ * every command and poll (before) against the cached state of
+ * main/actuator/actuator_liveness.h (after).
+ *
+ * Workload, 10 minutes: status poll every 2 s (IsSlaveOnline, then the
+ * request), a five step move sequence every 60 s, a door open and close
+ * every 120 s, a stop after each sequence (sent without the online check).
+ * The actuator is unplugged from 200 s to 260 s.
+ *
+ * A probe is one transaction, a command is the write plus one read of the
+ * reply (the reply polling of i2c_reply_wait.h is the same for both and left
+ * out). A write to the unplugged actuator is one NACKed transaction.
+ * Reports transactions per minute, commands refused, and how long after the
+ * unplug and the replug the state changed. Exits non-zero if the cache does
+ * not save transactions or is slower to notice than ACTUATOR_PROBE_BACKOFF_MAX_MS
+ * plus one poll.
+ *
+ *   g++ -O2 -std=c++17 -I ../../main/actuator main.cc -o i2c_liveness_bench
+ *   ./i2c_liveness_bench
+ */
+#include "actuator_liveness.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+static const int64_t kSecond = 1000000;
+static const int64_t kRunUs = 600 * kSecond;
+static const int64_t kPollUs = 2 * kSecond;
+static const int64_t kUnplugUs = 200 * kSecond;
+static const int64_t kReplugUs = 260 * kSecond;
+
+static bool Check(bool ok, const char* what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+struct Event {
+    int64_t at_us;
+    bool checks_online;  // VehicleStop skips IsSlaveOnline
+};
+
+static std::vector<Event> Workload() {
+    std::vector<Event> events;
+    for (int64_t t = 0; t < kRunUs; t += kPollUs) {
+        events.push_back({t, true});
+    }
+    for (int64_t t = 30 * kSecond; t < kRunUs; t += 60 * kSecond) {
+        for (int step = 0; step < 5; step++) {
+            events.push_back({t + step * kSecond, true});
+        }
+        events.push_back({t + 5 * kSecond, false});
+    }
+    for (int64_t t = 45 * kSecond; t < kRunUs; t += 120 * kSecond) {
+        events.push_back({t, true});
+        events.push_back({t + 3 * kSecond, true});
+    }
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) { return a.at_us < b.at_us; });
+    return events;
+}
+
+struct Result {
+    int transactions = 0;
+    int probes = 0;
+    int commands = 0;
+    int refused = 0;
+    int64_t offline_after_us = -1;
+    int64_t online_after_us = -1;
+};
+
+static bool Present(int64_t t) {
+    return t < kUnplugUs || t >= kReplugUs;
+}
+
+static Result Run(bool cached) {
+    ActuatorLiveness liveness;
+    Result result;
+    bool was_online = true;
+
+    auto changed = [&](bool online, int64_t t) {
+        if (online == was_online) {
+            return;
+        }
+        was_online = online;
+        if (!online && result.offline_after_us < 0 && t >= kUnplugUs) {
+            result.offline_after_us = t - kUnplugUs;
+        }
+        if (online && result.online_after_us < 0 && t >= kReplugUs) {
+            result.online_after_us = t - kReplugUs;
+        }
+    };
+
+    auto probe = [&](int64_t t) {
+        result.transactions++;
+        result.probes++;
+        return Present(t);
+    };
+
+    for (auto& event : Workload()) {
+        int64_t t = event.at_us;
+        if (event.checks_online) {
+            bool online;
+            if (!cached) {
+                online = probe(t);
+                changed(online, t);
+            } else if (liveness.NeedsProbe(t)) {
+                if (liveness.Record(probe(t), t)) {
+                    changed(liveness.online(), t);
+                }
+                online = liveness.online();
+            } else {
+                online = liveness.online();
+            }
+            if (!online) {
+                result.refused++;
+                continue;
+            }
+        }
+
+        result.commands++;
+        result.transactions++;
+        bool ok = Present(t);
+        if (cached && liveness.Record(ok, t)) {
+            changed(liveness.online(), t);
+        }
+        if (ok) {
+            result.transactions++;
+        }
+    }
+    return result;
+}
+
+int main() {
+    bool ok = true;
+
+    ActuatorLiveness liveness;
+    ok &= Check(liveness.state() == ActuatorLiveness::kUnknown && liveness.NeedsProbe(0), "unknown until the first probe");
+    ok &= Check(liveness.Record(true, 0) && liveness.online() && !liveness.NeedsProbe(1000), "success: online, no probe");
+    ok &= Check(!liveness.NeedsProbe(ACTUATOR_IDLE_PROBE_MS * 1000 - 1) &&
+            liveness.NeedsProbe(ACTUATOR_IDLE_PROBE_MS * 1000),
+        "probe after ACTUATOR_IDLE_PROBE_MS without traffic");
+    ok &= Check(!liveness.Record(false, 100) && liveness.online() && liveness.NeedsProbe(100),
+        "one failure: still online, probe next time");
+    ok &= Check(liveness.Record(false, 200) && liveness.state() == ActuatorLiveness::kOffline,
+        "offline after ACTUATOR_OFFLINE_FAILURES, reported once");
+
+    int64_t now = 200;
+    int64_t expected_ms = ACTUATOR_PROBE_BACKOFF_MS;
+    bool backoff = true;
+    for (int i = 0; i < 8; i++) {
+        int64_t due = now + expected_ms * 1000;
+        backoff &= !liveness.NeedsProbe(due - 1) && liveness.NeedsProbe(due);
+        backoff &= !liveness.Record(false, due);
+        now = due;
+        expected_ms = std::min<int64_t>(expected_ms * 2, ACTUATOR_PROBE_BACKOFF_MAX_MS);
+    }
+    ok &= Check(backoff, "offline probes back off, capped at the max");
+    ok &= Check(liveness.Record(true, now) && liveness.online() && !liveness.Record(true, now + 1),
+        "recovery reported once");
+    liveness.Reset();
+    ok &= Check(liveness.state() == ActuatorLiveness::kUnknown && liveness.NeedsProbe(now), "Reset forgets the state");
+
+    Result before = Run(false);
+    Result after = Run(true);
+    double minutes = (double)kRunUs / (60 * kSecond);
+
+    printf("\n%d minutes, actuator unplugged %d s to %d s\n", (int)minutes, (int)(kUnplugUs / kSecond),
+        (int)(kReplugUs / kSecond));
+    printf("%-18s %14s %10s %10s %10s %14s %14s\n", "policy", "transact/min", "probes", "commands", "refused",
+        "offline after", "online after");
+    const Result* results[] = {&before, &after};
+    const char* names[] = {"probe every call", "cached liveness"};
+    for (int i = 0; i < 2; i++) {
+        const Result& r = *results[i];
+        printf("%-18s %14.1f %10d %10d %10d %12.1f s %12.1f s\n", names[i], r.transactions / minutes, r.probes,
+            r.commands, r.refused, r.offline_after_us / 1e6, r.online_after_us / 1e6);
+    }
+    printf("bus transactions saved: %.0f%%\n", 100.0 - 100.0 * after.transactions / before.transactions);
+
+    ok &= Check(after.transactions < before.transactions, "fewer transactions with the cache");
+    int64_t bound_us = ACTUATOR_PROBE_BACKOFF_MAX_MS * 1000 + kPollUs;
+    ok &= Check(after.offline_after_us >= 0 && after.offline_after_us <= bound_us,
+        "unplug noticed within the max backoff and a poll");
+    ok &= Check(after.online_after_us >= 0 && after.online_after_us <= bound_us,
+        "replug noticed within the max backoff and a poll");
+    return ok ? 0 : 1;
+}
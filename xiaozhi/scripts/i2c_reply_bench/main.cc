@@ -0,0 +1,218 @@
+/*
+ * Host benchmark: command round trip from I2CCommandBridge to the actuator,
+ * fixed wait against the data-ready handshake (main/actuator/i2c_reply_wait.h).
+ *
+ * fixed:   vTaskDelay(60 ms), read, then up to two more reads 20 ms apart.
+ * poll:    read right away and back off (I2cReplyWait), the actuator answers
+ *          a busy frame until its reply is written. Delays under
+ *          I2C_REPLY_SPIN_US spin, longer ones sleep whole FreeRTOS ticks,
+ *          modelled at 100 Hz (the esp32s3 default) and 1000 Hz.
+ * gpio:    wait for the data-ready line, then read once.
+ *
+ * The bus runs at 100 kHz (9 clocks a byte, plus address, start and stop).
+ * The actuator needs 0.2-1 ms for a status, 0.3-2 ms for a move and 450-750 ms
+ * for a door (the servo steps 10 ms a degree). Every command starts at a
+ * random point of the tick. Reports the latency distribution from the start of
+ * the write to the end of the read that returned the reply, the reads per
+ * command and the commands that got no reply. Exits non-zero if polling is not
+ * faster than the fixed wait or loses replies.
+ *
+ *   g++ -O2 -std=c++17 -I ../../main/actuator main.cc -o i2c_reply_bench
+ *   ./i2c_reply_bench
+ */
+#include "i2c_reply_wait.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+static const int kBusHz = 100000;
+static const int64_t kIsrWakeUs = 20;
+
+static bool Check(bool ok, const char* what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static int64_t TransactionUs(size_t bytes) {
+    return ((1 + (int64_t)bytes) * 9 + 2) * 1000000 / kBusHz;
+}
+
+// Deterministic so runs compare
+struct Random {
+    uint32_t state = 12345;
+
+    int64_t Between(int64_t low, int64_t high) {
+        state = state * 1664525 + 1013904223;
+        return low + (int64_t)(state >> 8) % (high - low + 1);
+    }
+};
+
+// vTaskDelay(ticks) called at now_us wakes on the tick boundary ticks later
+static int64_t TaskDelay(int64_t now_us, int64_t ticks, int64_t tick_us) {
+    return (now_us / tick_us + ticks) * tick_us;
+}
+
+struct CommandType {
+    const char* name;
+    uint8_t type;
+    int64_t min_us;
+    int64_t max_us;
+};
+
+enum Policy { kFixed, kPoll100Hz, kPoll1000Hz, kGpio };
+static const char* kPolicyNames[] = {"fixed 60 ms", "poll, 100 Hz tick", "poll, 1000 Hz tick", "gpio data-ready"};
+
+struct Outcome {
+    bool replied;
+    int64_t latency_us;
+    int reads;
+};
+
+// One command: written at start_us, reply ready ready_after_us after the write
+static Outcome Run(Policy policy, const CommandType& command, int64_t start_us, int64_t ready_after_us) {
+    size_t request_size = command.type == kI2cFrameStatus ? 6 : (command.type == kI2cFrameStorage ? 8 : 12);
+    int64_t read_us = TransactionUs(I2cFrameReplySize(command.type));
+    int64_t now = start_us + TransactionUs(request_size);
+    int64_t ready_at = now + ready_after_us;
+    Outcome outcome = {false, 0, 0};
+
+    // A read returns the reply if it starts once the reply is written
+    auto read = [&]() {
+        outcome.reads++;
+        bool ok = now >= ready_at;
+        now += read_us;
+        if (ok) {
+            outcome.replied = true;
+            outcome.latency_us = now - start_us;
+        }
+        return ok;
+    };
+
+    if (policy == kFixed) {
+        now = TaskDelay(now, 6, 10000);
+        for (int attempt = 0; attempt < 3; attempt++) {
+            if (attempt > 0) {
+                now = TaskDelay(now, 2, 10000);
+            }
+            if (read()) {
+                break;
+            }
+        }
+        return outcome;
+    }
+
+    int64_t tick_us = policy == kPoll1000Hz ? 1000 : 10000;
+    uint32_t budget_us = I2cReplyBudgetUs(command.type);
+    uint32_t first_poll_us = I2C_REPLY_FIRST_POLL_US;
+    int64_t wait_start = now;
+    if (policy == kGpio) {
+        if (ready_at <= wait_start + budget_us) {
+            now = ready_at + kIsrWakeUs;
+            first_poll_us = 0;
+        } else {
+            now = wait_start + budget_us;
+        }
+    }
+    I2cReplyWait wait(wait_start, budget_us, first_poll_us);
+    for (int64_t delay_us; (delay_us = wait.NextDelayUs(now)) >= 0;) {
+        if (delay_us < I2C_REPLY_SPIN_US) {
+            now += delay_us;
+        } else {
+            int64_t ticks = delay_us / 1000 * 1000000 / tick_us / 1000;
+            now = TaskDelay(now, ticks > 0 ? ticks : 1, tick_us);
+        }
+        if (read()) {
+            break;
+        }
+    }
+    return outcome;
+}
+
+static int64_t Percentile(std::vector<int64_t>& values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t index = std::min(values.size() - 1, (size_t)(p * values.size()));
+    return values[index];
+}
+
+int main() {
+    bool ok = true;
+
+    // Schedule
+    I2cReplyWait wait(0, 10000);
+    int64_t d1 = wait.NextDelayUs(0);
+    int64_t d2 = wait.NextDelayUs(300);
+    int64_t d3 = wait.NextDelayUs(900);
+    ok &= Check(d1 == I2C_REPLY_FIRST_POLL_US && d2 == 2 * d1 && d3 == 4 * d1, "delays double from I2C_REPLY_FIRST_POLL_US");
+    ok &= Check(wait.NextDelayUs(9500) == 500 && wait.NextDelayUs(10000) == -1, "last delay clipped, then budget spent");
+    I2cReplyWait spent(0, 1000);
+    ok &= Check(spent.NextDelayUs(5000) == 0 && spent.NextDelayUs(5000) == -1, "first poll granted after the budget");
+    I2cReplyWait capped(0, 10000000);
+    int64_t last = 0;
+    for (int i = 0; i < 20; i++) {
+        last = capped.NextDelayUs(0);
+    }
+    ok &= Check(last == I2C_REPLY_MAX_POLL_US, "delay capped at I2C_REPLY_MAX_POLL_US");
+    I2cReplyWait gpio(0, 10000, 0);
+    ok &= Check(gpio.NextDelayUs(0) == 0 && gpio.NextDelayUs(0) == I2C_REPLY_FIRST_POLL_US, "data-ready: read at once");
+
+    const CommandType commands[] = {
+        {"status", kI2cFrameStatus, 200, 1000},
+        {"move", kI2cFrameVehicleTime, 300, 2000},
+        {"door", kI2cFrameStorage, 450000, 750000},
+    };
+    const int runs = 20000;
+
+    printf("\nround trip in ms over %d commands each\n", runs);
+    printf("%-7s %-20s %8s %8s %8s %8s %8s %8s\n", "command", "policy", "p50", "p90", "p99", "max", "reads",
+        "no reply");
+    for (auto& command : commands) {
+        int64_t fixed_p99 = 0;
+        for (int policy = kFixed; policy <= kGpio; policy++) {
+            Random random;
+            std::vector<int64_t> latencies;
+            int reads = 0;
+            int lost = 0;
+            for (int i = 0; i < runs; i++) {
+                int64_t start = random.Between(0, 9999);
+                int64_t ready_after = random.Between(command.min_us, command.max_us);
+                Outcome outcome = Run((Policy)policy, command, start, ready_after);
+                reads += outcome.reads;
+                if (outcome.replied) {
+                    latencies.push_back(outcome.latency_us);
+                } else {
+                    lost++;
+                }
+            }
+            int64_t p50 = Percentile(latencies, 0.5);
+            int64_t p90 = Percentile(latencies, 0.9);
+            int64_t p99 = Percentile(latencies, 0.99);
+            int64_t max = latencies.empty() ? 0 : latencies.back();
+            printf("%-7s %-20s %8.2f %8.2f %8.2f %8.2f %8.1f %7.1f%%\n", command.name, kPolicyNames[policy],
+                p50 / 1000.0, p90 / 1000.0, p99 / 1000.0, max / 1000.0, (double)reads / runs, 100.0 * lost / runs);
+            if (policy == kFixed) {
+                fixed_p99 = lost == runs ? INT64_MAX : p99;
+            } else {
+                ok &= lost == 0 && p99 < fixed_p99;
+            }
+        }
+    }
+
+    // Back to back moves: the fixed wait caps the rate at about 15 a second
+    printf("\nback to back moves per second:");
+    for (int policy = kFixed; policy <= kGpio; policy++) {
+        Random random;
+        int64_t now = 0;
+        int done = 0;
+        while (now < 10000000) {
+            Outcome outcome = Run((Policy)policy, commands[1], now, random.Between(300, 2000));
+            now += outcome.replied ? outcome.latency_us : 100000;
+            done++;
+        }
+        printf("  %s %d%s", kPolicyNames[policy], done / 10, policy == kGpio ? "\n" : ",");
+    }
+    return ok ? 0 : 1;
+}
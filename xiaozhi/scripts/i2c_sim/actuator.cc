@@ -0,0 +1,114 @@
+// The unmodified actuator sketch built against the Arduino fakes, plus the
+// HeartRateBLE it talks to
+#include "Arduino.h"
+
+#include "../../../xiaozhi-actuator/src/main.ino"
+
+#include "sim_actuator.h"
+#include "sim_bus.h"
+
+#include <atomic>
+
+static std::atomic<bool> strap_connected(false);
+static std::atomic<int> strap_bpm(-1);
+
+HeartRateBLE* HeartRateBLE::_instance = nullptr;
+
+HeartRateBLE::HeartRateBLE() {
+    _instance = this;
+}
+
+void HeartRateBLE::begin(const char*) {}
+
+void HeartRateBLE::setDataCallback(DataCallback cb) {
+    _dataCb = cb;
+}
+
+void HeartRateBLE::setConnectCallback(ConnectCallback cb) {
+    _connCb = cb;
+}
+
+void HeartRateBLE::setAutoReconnect(bool enable, uint8_t maxRetry) {
+    _autoReconnect = enable;
+    _maxRetry = maxRetry;
+}
+
+bool HeartRateBLE::connectDirect(const char*, esp_ble_addr_type_t) {
+    return true;
+}
+
+// Picks up what SimHeartRate() set, as notifications would
+void HeartRateBLE::loop() {
+    bool connected = strap_connected;
+    if (connected != _connected) {
+        _connected = connected;
+        if (_connCb) {
+            _connCb(connected);
+        }
+    }
+    int bpm = connected ? strap_bpm.load() : -1;
+    if (bpm != _heartRate) {
+        _heartRate = bpm;
+        if (_dataCb && connected) {
+            _dataCb(bpm, _battery);
+        }
+    }
+}
+
+static void LoopTask(void*) {
+    setup();
+    for (;;) {
+        loop();
+    }
+}
+
+void SimActuatorStart() {
+    xTaskCreate(LoopTask, "loopTask", 8192, nullptr, 1, nullptr);
+    // setup() waits 500 ms for Serial, then starts the tasks and Wire
+    delay(700);
+}
+
+void SimHeartRate(bool connected, int bpm) {
+    strap_connected = connected;
+    strap_bpm = bpm;
+}
+
+bool SimActuatorMoving() {
+    return isMoving;
+}
+
+bool SimActuatorDoorOpen(int slot) {
+    return storageStates[slot];
+}
+
+I2cBatch SimActuatorLastList() {
+    portENTER_CRITICAL(&batchMux);
+    I2cBatch batch = batchNext;
+    portEXIT_CRITICAL(&batchMux);
+    return batch;
+}
+
+// Sits between the bus and Wire, renaming step list frames
+class LegacyFirmware : public SimI2cSlave {
+public:
+    void Receive(const uint8_t* data, size_t size) override {
+        I2cFrame frame;
+        uint8_t buffer[I2C_FRAME_MAX_SIZE];
+        if (frame.Decode(data, size) == kI2cFrameOk && frame.type == kI2cFrameBatch) {
+            frame.type = 0x7F;
+            size = frame.Encode(buffer, sizeof(buffer));
+            data = buffer;
+        }
+        Wire.Receive(data, size);
+    }
+
+    bool Request(uint8_t* data, size_t size, int64_t timeout_us) override {
+        return Wire.Request(data, size, timeout_us);
+    }
+};
+
+static LegacyFirmware legacy_firmware;
+
+void SimActuatorStepLists(bool supported) {
+    SimBus::Get().Attach(I2C_SLAVE_ADDR, supported ? static_cast<SimI2cSlave*>(&Wire) : &legacy_firmware);
+}
@@ -0,0 +1,64 @@
+#ifndef SIM_ACCEL_STEPPER_H
+#define SIM_ACCEL_STEPPER_H
+
+/*
+ * AccelStepper by elapsed time: runSpeed() and run() add every step due since
+ * the last call instead of at most one, run() goes at the max speed without
+ * ramps. Enough for move timing and status, not for motion profiles.
+ */
+
+#include "Arduino.h"
+
+class AccelStepper {
+public:
+    enum MotorInterfaceType { DRIVER = 1 };
+
+    AccelStepper(uint8_t = DRIVER, uint8_t = 2, uint8_t = 3) {}
+
+    void setPinsInverted(bool = false, bool = false, bool = false) {}
+    void setMaxSpeed(float speed) { max_speed_ = std::fabs(speed); }
+    void setAcceleration(float) {}
+    void setSpeed(float speed) {
+        speed_ = speed;
+        last_us_ = SimNowUs();
+    }
+    void setCurrentPosition(long position) {
+        position_ = target_ = position;
+        last_us_ = SimNowUs();
+    }
+    void moveTo(long target) {
+        target_ = target;
+        last_us_ = SimNowUs();
+    }
+    long distanceToGo() const { return target_ - (long)position_; }
+    long currentPosition() const { return (long)position_; }
+    void stop() { target_ = (long)position_; }
+
+    bool runSpeed() {
+        position_ += speed_ * Elapsed();
+        return speed_ != 0;
+    }
+
+    bool run() {
+        double step = max_speed_ * Elapsed();
+        double left = target_ - position_;
+        position_ += std::fabs(left) <= step ? left : (left > 0 ? step : -step);
+        return distanceToGo() != 0;
+    }
+
+private:
+    double position_ = 0;
+    long target_ = 0;
+    float speed_ = 0;
+    float max_speed_ = 1;
+    int64_t last_us_ = 0;
+
+    double Elapsed() {
+        int64_t now = SimNowUs();
+        double seconds = (now - last_us_) / 1e6;
+        last_us_ = now;
+        return seconds;
+    }
+};
+
+#endif // SIM_ACCEL_STEPPER_H
@@ -0,0 +1,92 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+/*
+ * The part of the arduino-esp32 core the actuator sketch uses. FreeRTOS runs
+ * at the core's 1000 Hz tick, digital outputs wired with SimGpioWire() drive
+ * master inputs, Serial prints only at --log 3 and above.
+ */
+
+#define configTICK_RATE_HZ 1000
+
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sim_clock.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+inline unsigned long millis() {
+    return (unsigned long)(SimNowUs() / 1000);
+}
+
+inline unsigned long micros() {
+    return (unsigned long)SimNowUs();
+}
+
+inline void delay(uint32_t ms) {
+    vTaskDelay(ms / portTICK_PERIOD_MS);
+}
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+uint32_t esp_random();
+
+class String {
+public:
+    String(const char* value = "") : value_(value ? value : "") {}
+    String(const std::string& value) : value_(value) {}
+
+    const char* c_str() const { return value_.c_str(); }
+    unsigned int length() const { return value_.size(); }
+    bool isEmpty() const { return value_.empty(); }
+    bool operator==(const char* other) const { return value_ == other; }
+    bool operator==(const String& other) const { return value_ == other.value_; }
+    String& operator+=(const char* other) {
+        value_ += other;
+        return *this;
+    }
+
+private:
+    std::string value_;
+};
+
+class HardwareSerial {
+public:
+    void begin(unsigned long) {}
+    size_t print(const char* text);
+    size_t println(const char* text = "");
+    size_t println(const String& text) { return println(text.c_str()); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t write(uint8_t c);
+};
+
+extern HardwareSerial Serial;
+
+#endif // SIM_ARDUINO_H
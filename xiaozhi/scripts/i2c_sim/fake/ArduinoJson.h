@@ -0,0 +1,56 @@
+#ifndef SIM_ARDUINO_JSON_H
+#define SIM_ARDUINO_JSON_H
+
+/*
+ * Compiles the sketch's JSON debug protocol without running it: every
+ * document fails to deserialize and serializes to "{}". The simulator runs
+ * the binary protocol.
+ */
+
+#include "Arduino.h"
+
+class JsonArray {
+public:
+    template <typename T>
+    bool add(T) {
+        return true;
+    }
+};
+
+class JsonVariant {
+public:
+    int operator|(int fallback) const { return fallback; }
+    const char* operator|(const char* fallback) const { return fallback; }
+    template <typename T>
+    JsonVariant& operator=(T) {
+        return *this;
+    }
+};
+
+class JsonDocument {
+public:
+    JsonVariant operator[](const char*) { return JsonVariant(); }
+    JsonArray createNestedArray(const char*) { return JsonArray(); }
+};
+
+template <size_t N>
+class StaticJsonDocument : public JsonDocument {};
+
+struct DeserializationError {
+    explicit operator bool() const { return true; }
+};
+
+inline DeserializationError deserializeJson(JsonDocument&, const String&) {
+    return DeserializationError();
+}
+
+inline size_t serializeJson(const JsonDocument&, String& output) {
+    output = String("{}");
+    return 2;
+}
+
+inline size_t serializeJson(const JsonDocument&, HardwareSerial& output) {
+    return output.print("{}");
+}
+
+#endif // SIM_ARDUINO_JSON_H
@@ -0,0 +1,21 @@
+#ifndef SIM_BLE_DEVICE_H
+#define SIM_BLE_DEVICE_H
+
+// Declarations HeartRateBLE.h needs; the simulator defines HeartRateBLE itself
+
+typedef enum {
+    BLE_ADDR_TYPE_PUBLIC = 0,
+    BLE_ADDR_TYPE_RANDOM = 1,
+} esp_ble_addr_type_t;
+
+class BLEClient;
+class BLERemoteCharacteristic;
+
+class BLEClientCallbacks {
+public:
+    virtual ~BLEClientCallbacks() = default;
+    virtual void onConnect(BLEClient* client) = 0;
+    virtual void onDisconnect(BLEClient* client) = 0;
+};
+
+#endif // SIM_BLE_DEVICE_H
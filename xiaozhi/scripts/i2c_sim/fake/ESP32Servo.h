@@ -0,0 +1,16 @@
+#ifndef SIM_ESP32_SERVO_H
+#define SIM_ESP32_SERVO_H
+
+#include "Arduino.h"
+
+class Servo {
+public:
+    int attach(int, int = 544, int = 2400) { return 1; }
+    void write(int angle) { angle_ = angle; }
+    int read() const { return angle_; }
+
+private:
+    int angle_ = 90;
+};
+
+#endif // SIM_ESP32_SERVO_H
@@ -0,0 +1,49 @@
+#ifndef SIM_PS2X_LIB_H
+#define SIM_PS2X_LIB_H
+
+/*
+ * PS2 gamepad with no buttons held. SimGamepadPress() makes the next
+ * read_gamepad() report one press of a button.
+ */
+
+#include "Arduino.h"
+
+#define PSB_SELECT 0x0001
+#define PSB_L3 0x0002
+#define PSB_R3 0x0004
+#define PSB_START 0x0008
+#define PSB_PAD_UP 0x0010
+#define PSB_PAD_RIGHT 0x0020
+#define PSB_PAD_DOWN 0x0040
+#define PSB_PAD_LEFT 0x0080
+#define PSB_L2 0x0100
+#define PSB_R2 0x0200
+#define PSB_L1 0x0400
+#define PSB_R1 0x0800
+#define PSB_TRIANGLE 0x1000
+#define PSB_CIRCLE 0x2000
+#define PSB_CROSS 0x4000
+#define PSB_SQUARE 0x8000
+#define PSAB_CROSS 14
+
+void SimGamepadPress(uint16_t button);
+uint16_t SimGamepadTakePresses();
+
+class PS2X {
+public:
+    byte config_gamepad(uint8_t, uint8_t, uint8_t, uint8_t, bool, bool) {
+        return 0;
+    }
+    bool read_gamepad(bool, byte) {
+        pressed_ = SimGamepadTakePresses();
+        return true;
+    }
+    bool Button(uint16_t) const { return false; }
+    bool ButtonPressed(unsigned int button) const { return pressed_ & button; }
+    byte Analog(byte) const { return 0; }
+
+private:
+    uint16_t pressed_ = 0;
+};
+
+#endif // SIM_PS2X_LIB_H
@@ -0,0 +1,56 @@
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+/*
+ * Wire in slave mode on the simulated bus. Like the arduino-esp32 slave
+ * driver, onReceive and onRequest run one at a time on a slave task:
+ * onReceive after the master's stop condition, onRequest when the master
+ * addresses a read, with the clock stretched until it returns.
+ */
+
+#include "Arduino.h"
+#include "sim_bus.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class TwoWire : public SimI2cSlave {
+public:
+    bool begin(uint8_t address, int sda, int scl, uint32_t frequency);
+    void onReceive(void (*handler)(int)) { receive_handler_ = handler; }
+    void onRequest(void (*handler)()) { request_handler_ = handler; }
+
+    int available();
+    int read();
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t size);
+
+    void Receive(const uint8_t* data, size_t size) override;
+    bool Request(uint8_t* data, size_t size, int64_t timeout_us) override;
+
+private:
+    struct Event {
+        bool request;
+        std::vector<uint8_t> data;
+        bool done = false;
+    };
+
+    void (*receive_handler_)(int) = nullptr;
+    void (*request_handler_)() = nullptr;
+    std::vector<uint8_t> rx_;
+    size_t rx_index_ = 0;
+    std::vector<uint8_t> tx_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<Event>> events_;
+
+    static void SlaveTask(void* param);
+};
+
+extern TwoWire Wire;
+
+#endif // SIM_WIRE_H
@@ -0,0 +1,165 @@
+// arduino-esp32 core pieces for the actuator sketch: Serial, digital pins,
+// the Wire slave and the gamepad presses injected by the simulator
+#include "Arduino.h"
+#include "PS2X_lib.h"
+#include "Wire.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <random>
+
+HardwareSerial Serial;
+TwoWire Wire;
+
+// ==================== Serial ====================
+
+size_t HardwareSerial::print(const char* text) {
+    if (sim_log_level >= 3) {
+        fputs(text, stdout);
+    }
+    return strlen(text);
+}
+
+size_t HardwareSerial::println(const char* text) {
+    size_t size = print(text);
+    return size + print("\n");
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int size = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    print(buffer);
+    return size > 0 ? size : 0;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    char text[2] = {(char)c, 0};
+    return print(text);
+}
+
+// ==================== Pins ====================
+
+static std::mutex pin_mutex;
+static std::map<int, int> pin_levels;
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+    {
+        std::lock_guard<std::mutex> lock(pin_mutex);
+        pin_levels[pin] = level;
+    }
+    SimGpioActuatorWrite(pin, level);
+}
+
+int digitalRead(uint8_t pin) {
+    std::lock_guard<std::mutex> lock(pin_mutex);
+    return pin_levels[pin];
+}
+
+uint32_t esp_random() {
+    static std::mt19937 rng(std::random_device{}());
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    return rng();
+}
+
+// ==================== Gamepad ====================
+
+static std::atomic<uint16_t> gamepad_presses(0);
+
+void SimGamepadPress(uint16_t button) {
+    gamepad_presses |= button;
+}
+
+uint16_t SimGamepadTakePresses() {
+    return gamepad_presses.exchange(0);
+}
+
+// ==================== Wire slave ====================
+
+bool TwoWire::begin(uint8_t address, int, int, uint32_t) {
+    xTaskCreate(SlaveTask, "i2c_slave", 4096, this, 10, nullptr);
+    SimBus::Get().Attach(address, this);
+    return true;
+}
+
+int TwoWire::available() {
+    return (int)(rx_.size() - rx_index_);
+}
+
+int TwoWire::read() {
+    return rx_index_ < rx_.size() ? rx_[rx_index_++] : -1;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t size) {
+    // The driver's TX buffer holds 128 bytes
+    size_t room = tx_.size() < 128 ? 128 - tx_.size() : 0;
+    size = size < room ? size : room;
+    tx_.insert(tx_.end(), data, data + size);
+    return size;
+}
+
+void TwoWire::Receive(const uint8_t* data, size_t size) {
+    auto event = std::make_shared<Event>();
+    event->request = false;
+    event->data.assign(data, data + size);
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back(event);
+    cv_.notify_all();
+}
+
+bool TwoWire::Request(uint8_t* data, size_t size, int64_t timeout_us) {
+    auto event = std::make_shared<Event>();
+    event->request = true;
+    std::unique_lock<std::mutex> lock(mutex_);
+    events_.push_back(event);
+    cv_.notify_all();
+    // Behind any onReceive still queued, as on the slave task
+    if (!cv_.wait_for(lock, std::chrono::microseconds(timeout_us), [&event]() { return event->done; })) {
+        return false;
+    }
+    // Released SDA reads as 0xFF past what onRequest wrote
+    memset(data, 0xFF, size);
+    memcpy(data, event->data.data(), std::min(size, event->data.size()));
+    return true;
+}
+
+void TwoWire::SlaveTask(void* param) {
+    TwoWire* wire = static_cast<TwoWire*>(param);
+    for (;;) {
+        std::shared_ptr<Event> event;
+        {
+            std::unique_lock<std::mutex> lock(wire->mutex_);
+            wire->cv_.wait(lock, [wire]() { return !wire->events_.empty(); });
+            event = wire->events_.front();
+            wire->events_.pop_front();
+        }
+
+        if (event->request) {
+            wire->tx_.clear();
+            if (wire->request_handler_) {
+                wire->request_handler_();
+            }
+            event->data = wire->tx_;
+        } else {
+            wire->rx_ = event->data;
+            wire->rx_index_ = 0;
+            if (wire->receive_handler_) {
+                wire->receive_handler_((int)event->data.size());
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(wire->mutex_);
+        event->done = true;
+        wire->cv_.notify_all();
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef SIM_CJSON_H
+#define SIM_CJSON_H
+
+/*
+ * Host cJSON: builds, reads and prints trees like the real one, enough for
+ * I2CCommandBridge and McpServer. There is no parser, Parse() returns
+ * nullptr, so the JSON debug protocol is not simulated and MCP requests are
+ * built as trees.
+ */
+
+#include <cstddef>
+
+#define cJSON_Invalid (0)
+#define cJSON_False (1 << 0)
+#define cJSON_True (1 << 1)
+#define cJSON_NULL (1 << 2)
+#define cJSON_Number (1 << 3)
+#define cJSON_String (1 << 4)
+#define cJSON_Array (1 << 5)
+#define cJSON_Object (1 << 6)
+
+typedef int cJSON_bool;
+
+typedef struct cJSON {
+    struct cJSON* next;
+    struct cJSON* prev;
+    struct cJSON* child;
+    int type;
+    char* valuestring;
+    int valueint;
+    double valuedouble;
+    char* string;
+} cJSON;
+
+cJSON* cJSON_CreateObject(void);
+cJSON* cJSON_CreateArray(void);
+cJSON* cJSON_CreateString(const char* string);
+cJSON* cJSON_CreateNumber(double number);
+cJSON* cJSON_CreateBool(cJSON_bool boolean);
+cJSON* cJSON_Duplicate(const cJSON* item, cJSON_bool recurse);
+cJSON* cJSON_Parse(const char* value);
+char* cJSON_Print(const cJSON* item);
+char* cJSON_PrintUnformatted(const cJSON* item);
+void cJSON_free(void* object);
+void cJSON_Delete(cJSON* item);
+cJSON_bool cJSON_AddItemToArray(cJSON* array, cJSON* item);
+cJSON_bool cJSON_AddItemToObject(cJSON* object, const char* name, cJSON* item);
+cJSON* cJSON_AddStringToObject(cJSON* object, const char* name, const char* string);
+cJSON* cJSON_AddNumberToObject(cJSON* object, const char* name, double number);
+cJSON* cJSON_AddBoolToObject(cJSON* object, const char* name, cJSON_bool boolean);
+cJSON* cJSON_GetObjectItem(const cJSON* object, const char* string);
+int cJSON_GetArraySize(const cJSON* array);
+cJSON* cJSON_GetArrayItem(const cJSON* array, int index);
+
+#define cJSON_IsBool(item) ((item) != nullptr && ((item)->type & (cJSON_True | cJSON_False)) != 0)
+#define cJSON_IsTrue(item) ((item) != nullptr && (item)->type == cJSON_True)
+#define cJSON_IsNumber(item) ((item) != nullptr && (item)->type == cJSON_Number)
+#define cJSON_IsString(item) ((item) != nullptr && (item)->type == cJSON_String)
+#define cJSON_IsArray(item) ((item) != nullptr && (item)->type == cJSON_Array)
+#define cJSON_IsObject(item) ((item) != nullptr && (item)->type == cJSON_Object)
+#define cJSON_ArrayForEach(element, array) \
+    for (element = (array != nullptr) ? (array)->child : nullptr; element != nullptr; element = element->next)
+
+#endif // SIM_CJSON_H
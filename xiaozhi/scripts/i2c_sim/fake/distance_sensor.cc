@@ -0,0 +1,30 @@
+// The DistanceSensor calls VehicleController links against. There is no
+// UART: SimObstacle() sets what HasObstacle() reports, the obstacle callback
+// is never called.
+// DistanceSensor.h counts on FreeRTOS being included before it
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "DistanceSensor.h"
+
+#include <atomic>
+
+static std::atomic<bool> obstacle(false);
+
+void SimObstacle(bool present) {
+    obstacle = present;
+}
+
+DistanceSensor::DistanceSensor(uart_port_t, int, int) {}
+
+DistanceSensor::~DistanceSensor() {}
+
+void DistanceSensor::SetObstacleCallback(ObstacleCallback) {}
+
+bool DistanceSensor::HasObstacle() {
+    return obstacle;
+}
+
+float DistanceSensor::GetCurrentDistance() {
+    return obstacle ? 10 : -1;
+}
@@ -0,0 +1,52 @@
+#ifndef SIM_DRIVER_I2C_MASTER_H
+#define SIM_DRIVER_I2C_MASTER_H
+
+/*
+ * ESP-IDF i2c_master API on the simulated bus (sim_bus.h). Transfers take
+ * bus time at the device's scl_speed_hz scaled by the bus model's clock, and
+ * fail like the driver: ESP_ERR_INVALID_STATE on an address NACK,
+ * ESP_ERR_TIMEOUT when the slave stretches the clock past the timeout.
+ */
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+#include <cstddef>
+#include <cstdint>
+
+typedef struct SimI2cBus* i2c_master_bus_handle_t;
+typedef struct SimI2cDevice* i2c_master_dev_handle_t;
+
+typedef enum { I2C_NUM_0, I2C_NUM_1 } i2c_port_num_t;
+typedef enum { I2C_CLK_SRC_DEFAULT } i2c_clock_source_t;
+typedef enum { I2C_ADDR_BIT_LEN_7, I2C_ADDR_BIT_LEN_10 } i2c_addr_bit_len_t;
+
+typedef struct {
+    int i2c_port;
+    gpio_num_t sda_io_num;
+    gpio_num_t scl_io_num;
+    i2c_clock_source_t clk_source;
+    uint8_t glitch_ignore_cnt;
+    int intr_priority;
+    size_t trans_queue_depth;
+    struct {
+        uint32_t enable_internal_pullup : 1;
+    } flags;
+} i2c_master_bus_config_t;
+
+typedef struct {
+    i2c_addr_bit_len_t dev_addr_length;
+    uint16_t device_address;
+    uint32_t scl_speed_hz;
+    uint32_t scl_wait_us;
+} i2c_device_config_t;
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t* config, i2c_master_bus_handle_t* bus);
+esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus);
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t* config,
+    i2c_master_dev_handle_t* device);
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t device);
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t device, const uint8_t* data, size_t size, int timeout_ms);
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t device, uint8_t* data, size_t size, int timeout_ms);
+
+#endif // SIM_DRIVER_I2C_MASTER_H
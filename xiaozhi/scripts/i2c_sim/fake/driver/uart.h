@@ -0,0 +1,10 @@
+#ifndef SIM_DRIVER_UART_H
+#define SIM_DRIVER_UART_H
+
+// Only what DistanceSensor.h names, the simulator has no UART
+
+typedef int uart_port_t;
+
+#define UART_PIN_NO_CHANGE (-1)
+
+#endif // SIM_DRIVER_UART_H
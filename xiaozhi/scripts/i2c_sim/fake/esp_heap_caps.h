@@ -0,0 +1,18 @@
+#ifndef SIM_ESP_HEAP_CAPS_H
+#define SIM_ESP_HEAP_CAPS_H
+
+#include <cstdlib>
+
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_8BIT (1 << 2)
+
+inline void* heap_caps_malloc(size_t size, unsigned) {
+    return malloc(size);
+}
+
+inline void heap_caps_free(void* memory) {
+    free(memory);
+}
+
+#endif // SIM_ESP_HEAP_CAPS_H
@@ -0,0 +1,300 @@
+// ESP-IDF odds and ends for the xiaozhi side: error names, log level, GPIO
+// inputs wired to actuator outputs, and the cJSON stand-in
+#include "cJSON.h"
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <strings.h>
+
+int sim_log_level = 0;
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_RESPONSE:
+        return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+// ==================== GPIO ====================
+
+struct SimGpioInput {
+    gpio_isr_t handler = nullptr;
+    void* arg = nullptr;
+    int level = 0;
+};
+
+static std::mutex gpio_mutex;
+static std::map<int, int> gpio_wires;  // actuator pin -> master pin
+static std::map<int, SimGpioInput> gpio_inputs;
+
+esp_err_t gpio_config(const gpio_config_t*) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int) {
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t handler, void* arg) {
+    std::lock_guard<std::mutex> lock(gpio_mutex);
+    gpio_inputs[pin].handler = handler;
+    gpio_inputs[pin].arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t pin) {
+    std::lock_guard<std::mutex> lock(gpio_mutex);
+    gpio_inputs[pin].handler = nullptr;
+    return ESP_OK;
+}
+
+void SimGpioWire(int actuator_pin, int master_pin) {
+    std::lock_guard<std::mutex> lock(gpio_mutex);
+    gpio_wires[actuator_pin] = master_pin;
+}
+
+void SimGpioActuatorWrite(int actuator_pin, int level) {
+    gpio_isr_t handler = nullptr;
+    void* arg = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(gpio_mutex);
+        auto wire = gpio_wires.find(actuator_pin);
+        if (wire == gpio_wires.end()) {
+            return;
+        }
+        SimGpioInput& input = gpio_inputs[wire->second];
+        // Every input is configured for the rising edge
+        if (level && !input.level) {
+            handler = input.handler;
+            arg = input.arg;
+        }
+        input.level = level;
+    }
+    if (handler != nullptr) {
+        handler(arg);
+    }
+}
+
+// ==================== cJSON ====================
+
+static cJSON* NewItem(int type) {
+    cJSON* item = static_cast<cJSON*>(calloc(1, sizeof(cJSON)));
+    item->type = type;
+    return item;
+}
+
+cJSON* cJSON_CreateObject(void) {
+    return NewItem(cJSON_Object);
+}
+
+cJSON* cJSON_CreateArray(void) {
+    return NewItem(cJSON_Array);
+}
+
+cJSON* cJSON_CreateString(const char* string) {
+    cJSON* item = NewItem(cJSON_String);
+    item->valuestring = strdup(string);
+    return item;
+}
+
+cJSON* cJSON_CreateNumber(double number) {
+    cJSON* item = NewItem(cJSON_Number);
+    item->valuedouble = number;
+    item->valueint = (int)number;
+    return item;
+}
+
+cJSON* cJSON_CreateBool(cJSON_bool boolean) {
+    return NewItem(boolean ? cJSON_True : cJSON_False);
+}
+
+cJSON* cJSON_Duplicate(const cJSON* item, cJSON_bool recurse) {
+    if (item == nullptr) {
+        return nullptr;
+    }
+    cJSON* copy = NewItem(item->type);
+    copy->valueint = item->valueint;
+    copy->valuedouble = item->valuedouble;
+    copy->valuestring = item->valuestring ? strdup(item->valuestring) : nullptr;
+    copy->string = item->string ? strdup(item->string) : nullptr;
+    if (recurse) {
+        for (cJSON* child = item->child; child != nullptr; child = child->next) {
+            cJSON_AddItemToArray(copy, cJSON_Duplicate(child, true));
+        }
+    }
+    return copy;
+}
+
+cJSON* cJSON_Parse(const char*) {
+    return nullptr;
+}
+
+static void PrintString(std::string& out, const char* string) {
+    out += '"';
+    for (const char* c = string; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            out += '\\';
+        }
+        out += *c;
+    }
+    out += '"';
+}
+
+static void PrintItem(std::string& out, const cJSON* item) {
+    switch (item->type) {
+    case cJSON_False:
+        out += "false";
+        break;
+    case cJSON_True:
+        out += "true";
+        break;
+    case cJSON_Number: {
+        char number[32];
+        snprintf(number, sizeof(number), "%.15g", item->valuedouble);
+        out += number;
+        break;
+    }
+    case cJSON_String:
+        PrintString(out, item->valuestring);
+        break;
+    case cJSON_Array:
+    case cJSON_Object:
+        out += item->type == cJSON_Array ? '[' : '{';
+        for (const cJSON* child = item->child; child != nullptr; child = child->next) {
+            if (child != item->child) {
+                out += ',';
+            }
+            if (item->type == cJSON_Object) {
+                PrintString(out, child->string);
+                out += ':';
+            }
+            PrintItem(out, child);
+        }
+        out += item->type == cJSON_Array ? ']' : '}';
+        break;
+    default:
+        out += "null";
+        break;
+    }
+}
+
+char* cJSON_Print(const cJSON* item) {
+    return cJSON_PrintUnformatted(item);
+}
+
+char* cJSON_PrintUnformatted(const cJSON* item) {
+    if (item == nullptr) {
+        return nullptr;
+    }
+    std::string out;
+    PrintItem(out, item);
+    return strdup(out.c_str());
+}
+
+void cJSON_free(void* object) {
+    free(object);
+}
+
+void cJSON_Delete(cJSON* item) {
+    while (item != nullptr) {
+        cJSON* next = item->next;
+        cJSON_Delete(item->child);
+        free(item->valuestring);
+        free(item->string);
+        free(item);
+        item = next;
+    }
+}
+
+cJSON_bool cJSON_AddItemToArray(cJSON* array, cJSON* item) {
+    if (array == nullptr || item == nullptr) {
+        return false;
+    }
+    if (array->child == nullptr) {
+        array->child = item;
+        item->prev = item;
+        return true;
+    }
+    // The first child's prev is the last one, as in cJSON
+    cJSON* last = array->child->prev;
+    last->next = item;
+    item->prev = last;
+    array->child->prev = item;
+    return true;
+}
+
+cJSON_bool cJSON_AddItemToObject(cJSON* object, const char* name, cJSON* item) {
+    if (item == nullptr) {
+        return false;
+    }
+    free(item->string);
+    item->string = strdup(name);
+    return cJSON_AddItemToArray(object, item);
+}
+
+cJSON* cJSON_AddStringToObject(cJSON* object, const char* name, const char* string) {
+    cJSON* item = cJSON_CreateString(string);
+    cJSON_AddItemToObject(object, name, item);
+    return item;
+}
+
+cJSON* cJSON_AddNumberToObject(cJSON* object, const char* name, double number) {
+    cJSON* item = cJSON_CreateNumber(number);
+    cJSON_AddItemToObject(object, name, item);
+    return item;
+}
+
+cJSON* cJSON_AddBoolToObject(cJSON* object, const char* name, cJSON_bool boolean) {
+    cJSON* item = cJSON_CreateBool(boolean);
+    cJSON_AddItemToObject(object, name, item);
+    return item;
+}
+
+cJSON* cJSON_GetObjectItem(const cJSON* object, const char* string) {
+    if (object == nullptr) {
+        return nullptr;
+    }
+    for (cJSON* child = object->child; child != nullptr; child = child->next) {
+        if (child->string != nullptr && strcasecmp(child->string, string) == 0) {
+            return child;
+        }
+    }
+    return nullptr;
+}
+
+int cJSON_GetArraySize(const cJSON* array) {
+    int size = 0;
+    for (cJSON* child = array ? array->child : nullptr; child != nullptr; child = child->next) {
+        size++;
+    }
+    return size;
+}
+
+cJSON* cJSON_GetArrayItem(const cJSON* array, int index) {
+    cJSON* child = array ? array->child : nullptr;
+    while (child != nullptr && index-- > 0) {
+        child = child->next;
+    }
+    return child;
+}
@@ -0,0 +1,22 @@
+#ifndef SIM_ESP_LOG_H
+#define SIM_ESP_LOG_H
+
+#include <cstdio>
+
+// 0 silent (default), 1 errors ... 4 debug, set by the simulator's --log
+extern int sim_log_level;
+
+#define SIM_LOG(level, letter, tag, format, ...)                               \
+    do {                                                                       \
+        if (sim_log_level >= level) {                                          \
+            printf(letter " (%s) " format "\n", tag, ##__VA_ARGS__);           \
+        }                                                                      \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) SIM_LOG(1, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) SIM_LOG(2, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) SIM_LOG(3, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) SIM_LOG(4, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) SIM_LOG(5, "V", tag, format, ##__VA_ARGS__)
+
+#endif // SIM_ESP_LOG_H
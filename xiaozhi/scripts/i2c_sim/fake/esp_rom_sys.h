@@ -0,0 +1,15 @@
+#ifndef SIM_ESP_ROM_SYS_H
+#define SIM_ESP_ROM_SYS_H
+
+#include "sim_clock.h"
+
+#include <cstdint>
+
+// Busy-waits like the ROM function
+inline void esp_rom_delay_us(uint32_t us) {
+    int64_t end = SimNowUs() + us;
+    while (SimNowUs() < end) {
+    }
+}
+
+#endif // SIM_ESP_ROM_SYS_H
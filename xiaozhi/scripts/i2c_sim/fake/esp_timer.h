@@ -0,0 +1,10 @@
+#ifndef SIM_ESP_TIMER_H
+#define SIM_ESP_TIMER_H
+
+#include "sim_clock.h"
+
+inline int64_t esp_timer_get_time() {
+    return SimNowUs();
+}
+
+#endif // SIM_ESP_TIMER_H
@@ -0,0 +1,214 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "sim_clock.h"
+
+#include <pthread.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SimTask {
+    std::string name;
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint32_t notifications = 0;
+    bool deleted = false;  // by another task, the thread exits at its next kernel call
+};
+
+struct SimSemaphore {
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint32_t count;
+    uint32_t max;
+};
+
+struct SimQueue {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t item_size;
+};
+
+static std::recursive_mutex critical_mutex;
+static thread_local SimTask* current_task = nullptr;
+
+static std::chrono::steady_clock::time_point Deadline(int64_t timeout_us) {
+    if (timeout_us == SIM_FOREVER) {
+        return std::chrono::steady_clock::time_point::max();
+    }
+    return std::chrono::steady_clock::now() + std::chrono::microseconds(timeout_us > 0 ? timeout_us : 0);
+}
+
+// vTaskDelete() of another task takes effect when that task next blocks
+static void ExitIfDeleted() {
+    SimTask* task = SimCurrentTask();
+    bool deleted;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        deleted = task->deleted;
+    }
+    if (deleted) {
+        pthread_exit(nullptr);
+    }
+}
+
+void SimEnterCritical() {
+    critical_mutex.lock();
+}
+
+void SimExitCritical() {
+    critical_mutex.unlock();
+}
+
+int64_t SimTicksToUs(TickType_t ticks, int tick_hz) {
+    if (ticks == portMAX_DELAY) {
+        return SIM_FOREVER;
+    }
+    // Ends on a tick boundary, so n ticks last between n-1 and n periods
+    int64_t tick_us = 1000000 / tick_hz;
+    int64_t now = SimNowUs();
+    return (now / tick_us + (int64_t)ticks) * tick_us - now;
+}
+
+BaseType_t SimTaskCreate(TaskFunction_t fn, const char* name, void* param, TaskHandle_t* handle) {
+    SimTask* task = new SimTask();  // never freed, handles may outlive the task
+    task->name = name;
+    if (handle != nullptr) {
+        *handle = task;
+    }
+    std::thread([task, fn, param]() {
+        current_task = task;
+        fn(param);
+    }).detach();
+    return pdPASS;
+}
+
+void SimTaskDelete(TaskHandle_t task) {
+    if (task == nullptr || task == SimCurrentTask()) {
+        pthread_exit(nullptr);
+    }
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->deleted = true;
+    task->cv.notify_all();
+}
+
+void SimDelayUs(int64_t us) {
+    if (us > 0) {
+        std::this_thread::sleep_until(Deadline(us));
+    } else {
+        std::this_thread::yield();
+    }
+    ExitIfDeleted();
+}
+
+TaskHandle_t SimCurrentTask() {
+    if (current_task == nullptr) {
+        current_task = new SimTask();
+        current_task->name = "main";
+    }
+    return current_task;
+}
+
+void SimNotifyGive(TaskHandle_t task) {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->notifications++;
+    task->cv.notify_all();
+}
+
+uint32_t SimNotifyTake(bool clear, int64_t timeout_us) {
+    SimTask* task = SimCurrentTask();
+    uint32_t value;
+    {
+        std::unique_lock<std::mutex> lock(task->mutex);
+        task->cv.wait_until(lock, Deadline(timeout_us), [task]() { return task->notifications > 0 || task->deleted; });
+        value = task->notifications;
+        if (value > 0) {
+            task->notifications = clear ? 0 : value - 1;
+        }
+    }
+    ExitIfDeleted();
+    return value;
+}
+
+TickType_t SimTickCount(int tick_hz) {
+    return (TickType_t)(SimNowUs() * tick_hz / 1000000);
+}
+
+SemaphoreHandle_t SimSemaphoreCreate(uint32_t max, uint32_t initial) {
+    SimSemaphore* semaphore = new SimSemaphore();
+    semaphore->max = max;
+    semaphore->count = initial;
+    return semaphore;
+}
+
+void SimSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+BaseType_t SimSemaphoreTake(SemaphoreHandle_t semaphore, int64_t timeout_us) {
+    bool taken;
+    {
+        std::unique_lock<std::mutex> lock(semaphore->mutex);
+        taken = semaphore->cv.wait_until(lock, Deadline(timeout_us), [semaphore]() { return semaphore->count > 0; });
+        if (taken) {
+            semaphore->count--;
+        }
+    }
+    ExitIfDeleted();
+    return taken ? pdTRUE : pdFALSE;
+}
+
+BaseType_t SimSemaphoreGive(SemaphoreHandle_t semaphore) {
+    std::lock_guard<std::mutex> lock(semaphore->mutex);
+    if (semaphore->count >= semaphore->max) {
+        return pdFALSE;
+    }
+    semaphore->count++;
+    semaphore->cv.notify_one();
+    return pdTRUE;
+}
+
+QueueHandle_t SimQueueCreate(size_t length, size_t item_size) {
+    SimQueue* queue = new SimQueue();
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+void SimQueueDelete(QueueHandle_t queue) {
+    delete queue;
+}
+
+BaseType_t SimQueueSend(QueueHandle_t queue, const void* item, int64_t timeout_us) {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!queue->cv.wait_until(lock, Deadline(timeout_us), [queue]() { return queue->items.size() < queue->length; })) {
+        return pdFALSE;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(bytes, bytes + queue->item_size);
+    queue->cv.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t SimQueueReceive(QueueHandle_t queue, void* item, int64_t timeout_us) {
+    {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        if (queue->cv.wait_until(lock, Deadline(timeout_us), [queue]() { return !queue->items.empty(); })) {
+            memcpy(item, queue->items.front().data(), queue->item_size);
+            queue->items.pop_front();
+            queue->cv.notify_all();
+            return pdTRUE;
+        }
+    }
+    ExitIfDeleted();
+    return pdFALSE;
+}
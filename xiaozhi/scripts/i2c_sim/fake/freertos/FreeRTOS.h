@@ -0,0 +1,63 @@
+#ifndef SIM_FREERTOS_H
+#define SIM_FREERTOS_H
+
+/*
+ * FreeRTOS on host threads for the I2C simulator. Tasks are std::threads,
+ * time is the host's steady clock. Delays end on tick boundaries like the
+ * real kernel, at the tick rate of the including side: 100 Hz for xiaozhi
+ * (sdkconfig default), 1000 Hz for the Arduino core (Arduino.h sets it
+ * first). Priorities and cores are ignored.
+ */
+
+#include "esp_err.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef configTICK_RATE_HZ
+#define configTICK_RATE_HZ 100
+#endif
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#define IRAM_ATTR
+#define portYIELD_FROM_ISR(...)
+
+// Critical sections share one host lock
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+void SimEnterCritical();
+void SimExitCritical();
+#define portENTER_CRITICAL(mux) SimEnterCritical()
+#define portEXIT_CRITICAL(mux) SimExitCritical()
+#define portENTER_CRITICAL_ISR(mux) SimEnterCritical()
+#define portEXIT_CRITICAL_ISR(mux) SimExitCritical()
+
+struct SimTask;
+struct SimSemaphore;
+struct SimQueue;
+typedef SimTask* TaskHandle_t;
+typedef SimSemaphore* SemaphoreHandle_t;
+typedef SimQueue* QueueHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+struct StaticSemaphore_t {
+    SimSemaphore* semaphore;
+};
+
+// Microseconds until the end of the tick `ticks` from now at `tick_hz`,
+// SIM_FOREVER for portMAX_DELAY
+#define SIM_FOREVER INT64_MAX
+int64_t SimTicksToUs(TickType_t ticks, int tick_hz);
+
+#endif // SIM_FREERTOS_H
@@ -0,0 +1,18 @@
+#ifndef SIM_FREERTOS_QUEUE_H
+#define SIM_FREERTOS_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+QueueHandle_t SimQueueCreate(size_t length, size_t item_size);
+void SimQueueDelete(QueueHandle_t queue);
+BaseType_t SimQueueSend(QueueHandle_t queue, const void* item, int64_t timeout_us);
+BaseType_t SimQueueReceive(QueueHandle_t queue, void* item, int64_t timeout_us);
+
+// Items are copied bytewise like the real queue
+#define xQueueCreate(length, item_size) SimQueueCreate(length, item_size)
+#define vQueueDelete(queue) SimQueueDelete(queue)
+#define xQueueSend(queue, item, ticks) SimQueueSend(queue, item, SimTicksToUs(ticks, configTICK_RATE_HZ))
+#define xQueueSendToBack xQueueSend
+#define xQueueReceive(queue, item, ticks) SimQueueReceive(queue, item, SimTicksToUs(ticks, configTICK_RATE_HZ))
+
+#endif // SIM_FREERTOS_QUEUE_H
@@ -0,0 +1,21 @@
+#ifndef SIM_FREERTOS_SEMPHR_H
+#define SIM_FREERTOS_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+
+SemaphoreHandle_t SimSemaphoreCreate(uint32_t max, uint32_t initial);
+void SimSemaphoreDelete(SemaphoreHandle_t semaphore);
+BaseType_t SimSemaphoreTake(SemaphoreHandle_t semaphore, int64_t timeout_us);
+BaseType_t SimSemaphoreGive(SemaphoreHandle_t semaphore);
+
+// Mutexes are binary semaphores given once, without priority inheritance
+#define xSemaphoreCreateBinary() SimSemaphoreCreate(1, 0)
+#define xSemaphoreCreateBinaryStatic(buffer) ((buffer)->semaphore = SimSemaphoreCreate(1, 0))
+#define xSemaphoreCreateMutex() SimSemaphoreCreate(1, 1)
+#define xSemaphoreCreateCounting(max, initial) SimSemaphoreCreate(max, initial)
+#define vSemaphoreDelete(semaphore) SimSemaphoreDelete(semaphore)
+#define xSemaphoreTake(semaphore, ticks) SimSemaphoreTake(semaphore, SimTicksToUs(ticks, configTICK_RATE_HZ))
+#define xSemaphoreGive(semaphore) SimSemaphoreGive(semaphore)
+#define xSemaphoreGiveFromISR(semaphore, woken) SimSemaphoreGive(semaphore)
+
+#endif // SIM_FREERTOS_SEMPHR_H
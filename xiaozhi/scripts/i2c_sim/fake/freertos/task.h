@@ -0,0 +1,24 @@
+#ifndef SIM_FREERTOS_TASK_H
+#define SIM_FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+BaseType_t SimTaskCreate(TaskFunction_t fn, const char* name, void* param, TaskHandle_t* handle);
+void SimTaskDelete(TaskHandle_t task);
+void SimDelayUs(int64_t us);
+TaskHandle_t SimCurrentTask();
+void SimNotifyGive(TaskHandle_t task);
+uint32_t SimNotifyTake(bool clear, int64_t timeout_us);
+TickType_t SimTickCount(int tick_hz);
+
+#define xTaskCreate(fn, name, stack, param, priority, handle) SimTaskCreate(fn, name, param, handle)
+#define xTaskCreatePinnedToCore(fn, name, stack, param, priority, handle, core) \
+    SimTaskCreate(fn, name, param, handle)
+#define vTaskDelete(task) SimTaskDelete(task)
+#define vTaskDelay(ticks) SimDelayUs(SimTicksToUs(ticks, configTICK_RATE_HZ))
+#define xTaskGetCurrentTaskHandle() SimCurrentTask()
+#define xTaskGetTickCount() SimTickCount(configTICK_RATE_HZ)
+#define xTaskNotifyGive(task) SimNotifyGive(task)
+#define ulTaskNotifyTake(clear, ticks) SimNotifyTake(clear, SimTicksToUs(ticks, configTICK_RATE_HZ))
+
+#endif // SIM_FREERTOS_TASK_H
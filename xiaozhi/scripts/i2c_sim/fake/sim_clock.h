@@ -0,0 +1,13 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+// Microseconds since the simulator started, esp_timer and millis() both
+inline int64_t SimNowUs() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+#endif // SIM_CLOCK_H
@@ -0,0 +1,433 @@
+/*
+ * Host I2C simulator: the real I2CCommandBridge (xiaozhi/main) and the real
+ * actuator sketch (xiaozhi-actuator/src/main.ino) in one process, connected
+ * by a bus model (sim_bus.h) with configurable clock, NACKs, clock stretching
+ * and bit errors. FreeRTOS, ESP-IDF and the Arduino core are host fakes
+ * (fake/) on threads and the wall clock; the binary protocol runs, the JSON
+ * debug protocol does not.
+ *
+ * Scenarios, on a clean bus and then on a faulty one:
+ *   move burst      20 timed moves back to back, then a stop
+ *   storage         open doors 0-3 and close them again (servo ~0.6 s each)
+ *   sequences       VehicleController::ExecuteSequence() with nine timed
+ *                   moves and a stop: first against firmware without step
+ *                   lists (one command per move, 100 ms apart), then as one
+ *                   step list run by the actuator; latency is the whole
+ *                   sequence
+ *   status polling  StartStatusPolling(4000) for 12 s while the heart rate
+ *                   changes every second
+ * Reports per call latency, calls per second, bus bytes per second and bus
+ * utilisation, and the faults injected. Then checks ExecuteSequence() on the
+ * clean bus: progress for every command with and without step lists, abort
+ * from the progress callback, a move longer than one step split in two, and
+ * a sequence refused with a status report when an obstacle is ahead.
+ * Exits non-zero if a command fails on the clean bus, if the callback ever
+ * gets a heart rate the actuator never had (a corrupted reply accepted), if
+ * the faulty bus loses more than a fifth of the commands, if the step list
+ * cuts a move short or adds 100 ms or more to it, or if a sequence check
+ * fails.
+ *
+ *   g++ -O2 -std=c++17 -Wall -Wextra -pthread -I fake -I . -I ../../main \
+ *       -I ../../main/actuator -I ../../main/protocols \
+ *       main.cc sim_bus.cc actuator.cc fake/freertos.cc fake/esp_idf.cc fake/arduino.cc \
+ *       fake/distance_sensor.cc ../../main/I2CCommandBridge.cc ../../main/VehicleController.cc \
+ *       ../../main/telemetry.cc -o i2c_sim
+ *   ./i2c_sim [--clock 400000] [--nack 0.01] [--stretch 100] [--ber 1e-4] [--seed 1] [--log 3]
+ *
+ * --nack, --stretch and --ber set the faulty profile. To wire the data-ready
+ * and status-changed lines, build with e.g. -DDATA_READY_PIN=32
+ * -DCONFIG_ACTUATOR_DATA_READY_GPIO=4 -DSTATUS_CHANGED_PIN=33
+ * -DCONFIG_ACTUATOR_STATUS_CHANGED_GPIO=5.
+ */
+#include "I2CCommandBridge.h"
+#include "VehicleController.h"
+#include "driver/gpio.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sim_actuator.h"
+#include "sim_bus.h"
+#include "sim_clock.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static bool Check(bool ok, const char* what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static void SleepMs(int ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+// fake/distance_sensor.cc: what DistanceSensor::HasObstacle() reports
+void SimObstacle(bool present);
+
+struct Result {
+    std::string scenario;
+    std::string profile;
+    int calls = 0;
+    int failed = 0;
+    std::vector<int64_t> latencies_us;
+    int64_t elapsed_us = 0;
+    SimBusStats bus;
+    std::map<std::string, int> errors;
+};
+
+static int64_t Percentile(std::vector<int64_t> values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[(size_t)(p * (values.size() - 1))];
+}
+
+// Runs `calls` commands, timing each and counting anything but {"s":1}
+static Result RunCommands(const char* scenario, const char* profile, int calls,
+    const std::function<std::string(int)>& command) {
+    Result result;
+    result.scenario = scenario;
+    result.profile = profile;
+    SimBus::Get().ResetStats();
+    int64_t start = SimNowUs();
+    for (int i = 0; i < calls; i++) {
+        int64_t begin = SimNowUs();
+        std::string response = command(i);
+        result.latencies_us.push_back(SimNowUs() - begin);
+        result.calls++;
+        if (response != "{\"s\":1}") {
+            result.failed++;
+            result.errors[response]++;
+        }
+    }
+    result.elapsed_us = SimNowUs() - start;
+    result.bus = SimBus::Get().stats();
+    return result;
+}
+
+// ==================== Vehicle sequences ====================
+
+static const char* kOk = "{\"s\":1}";
+
+// Nine timed moves and a stop, kRouteMoveMs of actuator work
+static const int kRouteMoveMs = 3000;
+
+static std::vector<VehicleController::MoveCommand> Route() {
+    return {
+        {"forward", 50, 0, 400},
+        {"rotate_left", 50, 0, 300},
+        {"right", 50, 0, 300},
+        {"forward", 50, 0, 200},
+        {"rotate_right", 50, 0, 300},
+        {"backward", 50, 0, 400},
+        {"left", 50, 0, 300},
+        {"forward", 50, 0, 300},
+        {"rotate_left", 50, 0, 500},
+        {"stop", 0},
+    };
+}
+
+static std::string RunSequence(VehicleController& controller) {
+    return controller.ExecuteSequence(Route()) ? kOk : "{\"error\":\"sequence_failed\"}";
+}
+
+// Progress, abort and the long move split, on the clean bus
+static bool CheckSequences(I2CCommandBridge& bridge) {
+    VehicleController controller(&bridge);
+    size_t total = Route().size();
+    std::vector<size_t> every;
+    for (size_t i = 0; i <= total; i++) {
+        every.push_back(i);
+    }
+    bool ok = true;
+
+    // A step list is polled: a step ending between two polls (the stop) is
+    // not reported on its own, but progress never repeats or goes back
+    SimActuatorStepLists(true);
+    std::vector<size_t> seen;
+    bool done = controller.ExecuteSequence(Route(), [&seen](size_t done, size_t) {
+        seen.push_back(done);
+        return true;
+    });
+    bool increasing = std::is_sorted(seen.begin(), seen.end()) &&
+                      std::adjacent_find(seen.begin(), seen.end()) == seen.end();
+    ok &= Check(done && increasing && seen.front() == 0 && seen.back() == total && seen.size() >= total - 1,
+        "step list: progress in order, from 0 to the end");
+
+    SimActuatorStepLists(false);
+    seen.clear();
+    done = controller.ExecuteSequence(Route(), [&seen](size_t done, size_t) {
+        seen.push_back(done);
+        return true;
+    });
+    ok &= Check(done && seen == every, "one by one: progress for every command, in order");
+    SimActuatorStepLists(true);
+
+    seen.clear();
+    done = controller.ExecuteSequence(Route(), [&seen](size_t done, size_t) {
+        seen.push_back(done);
+        return done < 4;
+    });
+    SleepMs(50);
+    ok &= Check(!done && seen.back() == 4 && !SimActuatorMoving(), "abort from the progress callback stops the vehicle");
+
+    // 70 s does not fit a 16 bit step: two steps, then Stop() cuts it short
+    std::vector<VehicleController::MoveCommand> long_move = {{"forward", 50, 0, 70000}, {"rotate_left", 50, 0, 300}};
+    uint8_t before = SimActuatorLastList().id;
+    std::atomic<bool> finished(false);
+    std::thread sequence([&]() {
+        done = controller.ExecuteSequence(long_move);
+        finished = true;
+    });
+    I2cBatch list;
+    for (int waited = 0; waited < 1000 && (list = SimActuatorLastList()).id == before; waited += 10) {
+        SleepMs(10);
+    }
+    SleepMs(200);
+    controller.Stop();
+    sequence.join();
+    ok &= Check(list.count == 3 && list.steps[0].value + list.steps[1].value == 70000 &&
+            list.steps[2].target == DIR_ROTATE_LEFT,
+        "move longer than a step split into two steps");
+    ok &= Check(finished && !done && !SimActuatorMoving(), "Stop() ends the split move");
+
+    // An obstacle ahead: nothing is sent and the status listener learns why
+    DistanceSensor sensor(0, -1);
+    VehicleController guarded(&bridge, &sensor);
+    std::string status;
+    guarded.SetStatusCallback([&status](const std::string& text) { status = text; });
+    before = SimActuatorLastList().id;
+    SimObstacle(true);
+    done = guarded.ExecuteSequence(Route());
+    SimObstacle(false);
+    ok &= Check(!done && SimActuatorLastList().id == before && status.find("vật cản") != std::string::npos,
+        "obstacle ahead: sequence not sent, stop reported");
+    return ok;
+}
+
+// ==================== Status polling ====================
+
+struct StatusProbe {
+    std::mutex mutex;
+    std::map<int, int64_t> set_us;  // heart rate -> when the strap reported it
+    std::map<int, int64_t> seen_us; // heart rate -> first callback with it
+    int callbacks = 0;
+    int unknown = 0;  // heart rates never set: corrupted and accepted
+};
+
+static StatusProbe status_probe;
+
+static void OnStatus(const ActuatorStatus& status, void*) {
+    int64_t now = SimNowUs();
+    std::lock_guard<std::mutex> lock(status_probe.mutex);
+    status_probe.callbacks++;
+    if (status_probe.set_us.count(status.heart_rate) == 0) {
+        status_probe.unknown++;
+        return;
+    }
+    status_probe.seen_us.emplace(status.heart_rate, now);
+}
+
+static Result RunStatusPolling(const char* profile, int first_bpm, int changes) {
+    auto& bridge = I2CCommandBridge::GetInstance();
+    {
+        std::lock_guard<std::mutex> lock(status_probe.mutex);
+        status_probe.set_us.clear();
+        status_probe.seen_us.clear();
+        status_probe.callbacks = 0;
+        status_probe.set_us[first_bpm] = SimNowUs();
+    }
+    SimHeartRate(true, first_bpm);
+    SleepMs(100);
+
+    Result result;
+    result.scenario = "status polling";
+    result.profile = profile;
+    SimBus::Get().ResetStats();
+    int64_t start = SimNowUs();
+    bridge.SetStatusCallback(OnStatus, nullptr);
+    bridge.StartStatusPolling(4000);
+
+    for (int i = 1; i <= changes; i++) {
+        SleepMs(1000);
+        int bpm = first_bpm + i;
+        {
+            std::lock_guard<std::mutex> lock(status_probe.mutex);
+            status_probe.set_us[bpm] = SimNowUs();
+        }
+        SimHeartRate(true, bpm);
+    }
+    // The last value may wait for up to the longest poll interval
+    int last_bpm = first_bpm + changes;
+    for (int waited = 0; waited < 4500; waited += 50) {
+        {
+            std::lock_guard<std::mutex> lock(status_probe.mutex);
+            if (status_probe.seen_us.count(last_bpm)) {
+                break;
+            }
+        }
+        SleepMs(50);
+    }
+    bridge.StopStatusPolling();
+    result.elapsed_us = SimNowUs() - start;
+    result.bus = SimBus::Get().stats();
+
+    std::lock_guard<std::mutex> lock(status_probe.mutex);
+    result.calls = status_probe.callbacks;
+    for (auto& set : status_probe.set_us) {
+        auto seen = status_probe.seen_us.find(set.first);
+        if (seen == status_probe.seen_us.end()) {
+            if (set.first != last_bpm) {
+                continue;  // replaced before a poll, nothing was late
+            }
+            result.failed++;
+            result.errors["last value never delivered"]++;
+            continue;
+        }
+        result.latencies_us.push_back(std::max<int64_t>(0, seen->second - set.second));
+    }
+    return result;
+}
+
+// ==================== Report ====================
+
+static void Print(const Result& r) {
+    double seconds = r.elapsed_us / 1e6;
+    printf("%-15s %-7s %6d %6d %9.1f %9.1f %9.1f %9.1f %9.0f %6.1f%% %5u %5u\n", r.scenario.c_str(),
+        r.profile.c_str(), r.calls, r.failed, Percentile(r.latencies_us, 0.5) / 1e3,
+        Percentile(r.latencies_us, 0.99) / 1e3, Percentile(r.latencies_us, 1.0) / 1e3,
+        r.calls / seconds, r.bus.bytes / seconds, 100.0 * r.bus.busy_us / r.elapsed_us, r.bus.nacks,
+        r.bus.corrupted_bytes);
+    for (auto& error : r.errors) {
+        printf("%27s %d x %s\n", "", error.second, error.first.c_str());
+    }
+}
+
+int main(int argc, char** argv) {
+    SimBusConfig faulty;
+    faulty.nack_rate = 0.01;
+    faulty.stretch_us = 100;
+    faulty.bit_error_rate = 1e-4;
+    uint32_t clock_hz = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--clock")) {
+            clock_hz = atoi(argv[i + 1]);
+        } else if (!strcmp(argv[i], "--nack")) {
+            faulty.nack_rate = atof(argv[i + 1]);
+        } else if (!strcmp(argv[i], "--stretch")) {
+            faulty.stretch_us = atoi(argv[i + 1]);
+        } else if (!strcmp(argv[i], "--ber")) {
+            faulty.bit_error_rate = atof(argv[i + 1]);
+        } else if (!strcmp(argv[i], "--seed")) {
+            faulty.seed = atoi(argv[i + 1]);
+        } else if (!strcmp(argv[i], "--log")) {
+            sim_log_level = atoi(argv[i + 1]);
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    faulty.clock_hz = clock_hz;
+    SimBusConfig clean;
+    clean.clock_hz = clock_hz;
+
+#if defined(DATA_READY_PIN) && defined(CONFIG_ACTUATOR_DATA_READY_GPIO)
+    SimGpioWire(DATA_READY_PIN, CONFIG_ACTUATOR_DATA_READY_GPIO);
+#endif
+#if defined(STATUS_CHANGED_PIN) && defined(CONFIG_ACTUATOR_STATUS_CHANGED_GPIO)
+    SimGpioWire(STATUS_CHANGED_PIN, CONFIG_ACTUATOR_STATUS_CHANGED_GPIO);
+#endif
+
+    SimBus::Get().Configure(clean);
+    SimActuatorStart();
+    auto& bridge = I2CCommandBridge::GetInstance();
+    if (!bridge.Init()) {
+        printf("bridge init failed\n");
+        return 1;
+    }
+
+    printf("bus %u Hz, faulty profile: %.3f NACK, %u us stretch, %.0e bit errors, seed %u\n",
+        clock_hz ? clock_hz : I2C_MASTER_FREQ_HZ, faulty.nack_rate, faulty.stretch_us, faulty.bit_error_rate,
+        faulty.seed);
+    printf("data-ready line %s, status-changed line %s\n\n", ACTUATOR_DATA_READY_GPIO >= 0 ? "wired" : "off",
+        ACTUATOR_STATUS_CHANGED_GPIO >= 0 ? "wired" : "off");
+
+    std::vector<Result> results;
+    const char* profiles[] = {"clean", "faulty"};
+    for (int p = 0; p < 2; p++) {
+        SimBus::Get().Configure(p == 0 ? clean : faulty);
+
+        results.push_back(RunCommands("move burst", profiles[p], 21, [&bridge](int i) {
+            return i < 20 ? bridge.VehicleMoveTime(DIR_FORWARD + i % 4, 50, 200) : bridge.VehicleStop();
+        }));
+        SleepMs(300);
+
+        results.push_back(RunCommands("storage", profiles[p], 8, [&bridge](int i) {
+            return i < 4 ? bridge.StorageOpen(i) : bridge.StorageClose(7 - i);
+        }));
+
+        VehicleController controller(&bridge);
+        SimActuatorStepLists(false);
+        results.push_back(RunCommands("sequence steps", profiles[p], 3, [&controller](int) {
+            return RunSequence(controller);
+        }));
+        SimActuatorStepLists(true);
+        results.push_back(RunCommands("sequence list", profiles[p], 3, [&controller](int) {
+            return RunSequence(controller);
+        }));
+
+        results.push_back(RunStatusPolling(profiles[p], 60 + p * 40, 12));
+    }
+
+    printf("%-15s %-7s %6s %6s %9s %9s %9s %9s %9s %7s %5s %5s\n", "scenario", "bus", "calls", "failed", "p50 ms",
+        "p99 ms", "max ms", "calls/s", "bytes/s", "busy", "nacks", "bit");
+    for (auto& r : results) {
+        Print(r);
+    }
+    printf("status polling: calls are callbacks, latency from the strap's new value to the callback\n");
+
+    printf("sequences: calls are whole ExecuteSequence() runs of %d commands, %d ms of moves\n\n", (int)Route().size(),
+        kRouteMoveMs);
+
+    bool ok = true;
+    bool clean_ok = true;
+    int64_t list_us = 0;
+    int faulty_calls = 0;
+    int faulty_failed = 0;
+    for (auto& r : results) {
+        if (r.profile == "clean") {
+            clean_ok &= r.failed == 0;
+            if (r.scenario == "sequence list") {
+                list_us = Percentile(r.latencies_us, 0.5);
+            }
+        } else if (r.scenario != "status polling") {
+            faulty_calls += r.calls;
+            faulty_failed += r.failed;
+        }
+    }
+    ok &= Check(clean_ok, "clean bus: every command acknowledged");
+    ok &= Check(status_probe.unknown == 0, "no corrupted status reached the callback");
+    ok &= Check(faulty_failed * 5 <= faulty_calls, "faulty bus: at most a fifth of the commands lost");
+    ok &= Check(list_us >= kRouteMoveMs * 1000 && list_us < (kRouteMoveMs + 100) * 1000,
+        "step list: every move runs to its end, < 100 ms on top");
+    SimBus::Get().Configure(clean);
+    ok &= CheckSequences(bridge);
+    ok &= Check(!SimActuatorDoorOpen(0) && !SimActuatorDoorOpen(1) && !SimActuatorDoorOpen(3),
+        "doors closed at the end");
+
+    // Tasks keep running, leave without tearing them down
+    fflush(stdout);
+    _exit(ok ? 0 : 1);
+}
@@ -0,0 +1,26 @@
+#ifndef SIM_ACTUATOR_H
+#define SIM_ACTUATOR_H
+
+// The actuator sketch (xiaozhi-actuator/src/main.ino) running in-process
+
+#include "i2c_batch.h"
+
+#include <cstdint>
+
+// Runs setup() then loop() on a task, returns once the sketch is up
+void SimActuatorStart();
+
+// What the heart rate strap reports from now on
+void SimHeartRate(bool connected, int bpm);
+
+// Sketch state, read without the sketch's locks
+bool SimActuatorMoving();
+bool SimActuatorDoorOpen(int slot);
+// The last step list the sketch accepted
+I2cBatch SimActuatorLastList();
+
+// false: firmware from before step lists, a list frame reaches the sketch as
+// a type it does not know and is answered STATUS_UNKNOWN
+void SimActuatorStepLists(bool supported);
+
+#endif // SIM_ACTUATOR_H
@@ -0,0 +1,185 @@
+#include "sim_bus.h"
+#include "driver/i2c_master.h"
+#include "sim_clock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+struct SimI2cBus {};
+
+struct SimI2cDevice {
+    uint16_t address;
+    uint32_t speed_hz;
+};
+
+SimBus& SimBus::Get() {
+    static SimBus bus;
+    return bus;
+}
+
+void SimBus::Configure(const SimBusConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+    rng_.seed(config.seed);
+}
+
+SimBusConfig SimBus::config() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return config_;
+}
+
+void SimBus::Attach(uint16_t address, SimI2cSlave* slave) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    address_ = address;
+    slave_ = slave;
+}
+
+uint32_t SimBus::ClockHz(uint32_t speed_hz) const {
+    uint32_t hz = config_.clock_hz ? config_.clock_hz : speed_hz;
+    return hz ? hz : 100000;
+}
+
+bool SimBus::Acknowledged(uint16_t address) {
+    if (!config_.present || slave_ == nullptr || address != address_) {
+        return false;
+    }
+    return std::uniform_real_distribution<double>(0, 1)(rng_) >= config_.nack_rate;
+}
+
+void SimBus::Corrupt(uint8_t* data, size_t size) {
+    if (config_.bit_error_rate <= 0) {
+        return;
+    }
+    std::uniform_real_distribution<double> chance(0, 1);
+    for (size_t i = 0; i < size; i++) {
+        uint8_t flips = 0;
+        for (int bit = 0; bit < 8; bit++) {
+            if (chance(rng_) < config_.bit_error_rate) {
+                flips |= 1 << bit;
+            }
+        }
+        if (flips) {
+            data[i] ^= flips;
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.corrupted_bytes++;
+        }
+    }
+}
+
+// The transfer keeps the bus until start_us + duration_us
+void SimBus::Hold(int64_t start_us, int64_t duration_us) {
+    int64_t left_us = start_us + duration_us - SimNowUs();
+    if (left_us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(left_us));
+    }
+}
+
+void SimBus::Count(bool write, size_t bytes, int64_t busy_us, bool nack, bool timeout) {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    if (write) {
+        stats_.writes++;
+    } else {
+        stats_.reads++;
+    }
+    stats_.bytes += bytes;
+    stats_.busy_us += busy_us;
+    stats_.nacks += nack;
+    stats_.timeouts += timeout;
+}
+
+static int64_t WireUs(size_t bytes, uint32_t hz) {
+    // Start, 9 clocks a byte (ack included), stop
+    return ((int64_t)bytes * 9 + 2) * 1000000 / hz;
+}
+
+esp_err_t SimBus::Write(uint16_t address, uint32_t speed_hz, const uint8_t* data, size_t size, int) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t start_us = SimNowUs();
+    uint32_t hz = ClockHz(speed_hz);
+
+    if (!Acknowledged(address)) {
+        Hold(start_us, WireUs(1, hz));
+        Count(true, 1, WireUs(1, hz), true, false);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint8_t wire[256];
+    size = size < sizeof(wire) ? size : sizeof(wire);
+    std::copy(data, data + size, wire);
+    Corrupt(wire, size);
+    Hold(start_us, WireUs(1 + size, hz));
+    Count(true, 1 + size, WireUs(1 + size, hz), false, false);
+
+    // The slave sees the bytes after the stop condition
+    slave_->Receive(wire, size);
+    return ESP_OK;
+}
+
+esp_err_t SimBus::Read(uint16_t address, uint32_t speed_hz, uint8_t* data, size_t size, int timeout_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t start_us = SimNowUs();
+    uint32_t hz = ClockHz(speed_hz);
+
+    if (!Acknowledged(address)) {
+        Hold(start_us, WireUs(1, hz));
+        Count(false, 1, WireUs(1, hz), true, false);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // The slave stretches the clock after the address until its data is ready
+    Hold(start_us, WireUs(1, hz));
+    int64_t timeout_us = timeout_ms >= 0 ? (int64_t)timeout_ms * 1000 : INT64_MAX / 2;
+    bool answered = slave_->Request(data, size, timeout_us);
+    int64_t stretched_us = SimNowUs() - start_us - WireUs(1, hz) + config_.stretch_us;
+    if (!answered || stretched_us > timeout_us) {
+        int64_t busy_us = SimNowUs() - start_us;
+        Count(false, 1, busy_us, false, true);
+        return ESP_ERR_TIMEOUT;
+    }
+    Corrupt(data, size);
+    Hold(start_us, WireUs(1 + size, hz) + stretched_us);
+    Count(false, 1 + size, SimNowUs() - start_us, false, false);
+    return ESP_OK;
+}
+
+SimBusStats SimBus::stats() {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
+
+void SimBus::ResetStats() {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    stats_ = SimBusStats();
+}
+
+// ==================== i2c_master ====================
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t*, i2c_master_bus_handle_t* bus) {
+    *bus = new SimI2cBus();
+    return ESP_OK;
+}
+
+esp_err_t i2c_del_master_bus(i2c_master_bus_handle_t bus) {
+    delete bus;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t, const i2c_device_config_t* config,
+    i2c_master_dev_handle_t* device) {
+    *device = new SimI2cDevice{config->device_address, config->scl_speed_hz};
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t device) {
+    delete device;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t device, const uint8_t* data, size_t size, int timeout_ms) {
+    return SimBus::Get().Write(device->address, device->speed_hz, data, size, timeout_ms);
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t device, uint8_t* data, size_t size, int timeout_ms) {
+    return SimBus::Get().Read(device->address, device->speed_hz, data, size, timeout_ms);
+}
@@ -0,0 +1,84 @@
+#ifndef SIM_BUS_H
+#define SIM_BUS_H
+
+/*
+ * In-process I2C bus between the fake i2c_master driver (xiaozhi side) and
+ * the fake Wire slave (actuator side). A transfer holds the bus for its wire
+ * time, start and stop plus 9 clocks per byte with the address, and can fail
+ * or be corrupted the way a real bus does:
+ *
+ *   nack_rate       chance the address byte is not acknowledged
+ *   stretch_us      clock stretched by the slave on every read, on top of the
+ *                   time its onRequest handler takes
+ *   bit_error_rate  chance each data bit flips on the wire, both directions
+ *   present         false: every address is NACKed (unplugged actuator)
+ */
+
+#include "esp_err.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <random>
+
+struct SimBusConfig {
+    uint32_t clock_hz = 0;  // 0 = the device's scl_speed_hz
+    double nack_rate = 0;
+    uint32_t stretch_us = 0;
+    double bit_error_rate = 0;
+    bool present = true;
+    uint32_t seed = 1;
+};
+
+struct SimBusStats {
+    uint32_t writes = 0;
+    uint32_t reads = 0;
+    uint64_t bytes = 0;  // on the wire, address bytes included
+    uint32_t nacks = 0;
+    uint32_t timeouts = 0;
+    uint32_t corrupted_bytes = 0;
+    int64_t busy_us = 0;
+};
+
+// The slave end, implemented by the fake Wire
+class SimI2cSlave {
+public:
+    virtual ~SimI2cSlave() = default;
+    // Bytes of a master write, after its stop condition
+    virtual void Receive(const uint8_t* data, size_t size) = 0;
+    // Fills a master read; may block (clock stretching), false if it did not
+    // answer within timeout_us
+    virtual bool Request(uint8_t* data, size_t size, int64_t timeout_us) = 0;
+};
+
+class SimBus {
+public:
+    static SimBus& Get();
+
+    void Configure(const SimBusConfig& config);
+    SimBusConfig config();
+    void Attach(uint16_t address, SimI2cSlave* slave);
+
+    esp_err_t Write(uint16_t address, uint32_t speed_hz, const uint8_t* data, size_t size, int timeout_ms);
+    esp_err_t Read(uint16_t address, uint32_t speed_hz, uint8_t* data, size_t size, int timeout_ms);
+
+    SimBusStats stats();
+    void ResetStats();
+
+private:
+    std::mutex mutex_;  // held for the whole transfer, one master at a time
+    std::mutex stats_mutex_;
+    SimBusConfig config_;
+    std::mt19937 rng_;
+    uint16_t address_ = 0;
+    SimI2cSlave* slave_ = nullptr;
+    SimBusStats stats_;
+
+    uint32_t ClockHz(uint32_t speed_hz) const;
+    bool Acknowledged(uint16_t address);
+    void Corrupt(uint8_t* data, size_t size);
+    void Hold(int64_t start_us, int64_t duration_us);
+    void Count(bool write, size_t bytes, int64_t busy_us, bool nack, bool timeout);
+};
+
+#endif // SIM_BUS_H
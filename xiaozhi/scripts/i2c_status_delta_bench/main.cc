@@ -0,0 +1,268 @@
+/*
+ * Host benchmark: actuator status polling, a full status every 2 s (before)
+ * against the versioned deltas of main/actuator/i2c_status_delta.h with the
+ * adaptive interval of StatusPollingTask (after), and with the optional
+ * status-changed line.
+ *
+ * Scenarios, 10 minutes each: idle with a door opened and closed twice, a
+ * heart rate strap changing the value every second, gamepad bursts of six
+ * changes 150 ms apart every minute. The actuator side is the real
+ * I2cStatusRecord, the master the real I2cStatusView and I2cStatusPollInterval.
+ *
+ * A poll is the request write and a read of I2cFrameReplySize(), each with
+ * its address byte, at 100 kHz (9 bit times per byte). The reply wait of
+ * i2c_reply_wait.h is the same for every policy and left out. With the
+ * status-changed line the actuator raises it on its next 20 ms status sample
+ * (TaskStatusTrack). Reports bus bytes and callbacks per minute and how long
+ * after a change the master read it. Exits non-zero on a failed check.
+ *
+ *   g++ -O2 -std=c++17 -I ../../main/actuator main.cc -o i2c_status_delta_bench
+ *   ./i2c_status_delta_bench
+ */
+#include "i2c_status_delta.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+static const int64_t kMs = 1000;
+static const int64_t kSecond = 1000 * kMs;
+static const int64_t kRunUs = 600 * kSecond;
+static const int64_t kByteUs = 90;
+static const uint32_t kFixedMs = 2000;
+static const uint32_t kMinPollMs = 250;   // ACTUATOR_STATUS_MIN_POLL_MS
+static const uint32_t kMaxPollMs = 4000;  // StartStatusPolling() in application.cc
+static const int64_t kTrackUs = 20 * kMs; // TaskStatusTrack period
+
+static bool Check(bool ok, const char* what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+struct Change {
+    int64_t at_us;
+    I2cStatusFields fields;  // status from then on
+};
+
+typedef std::vector<Change> Scenario;
+
+static I2cStatusFields Connected() {
+    I2cStatusFields fields;
+    fields.flags = I2C_STATUS_BLE_CONNECTED;
+    fields.heart_rate = 72;
+    return fields;
+}
+
+static Scenario Idle() {
+    Scenario changes;
+    I2cStatusFields fields = Connected();
+    const int64_t doors[] = {100, 103, 400, 403};
+    for (int64_t at : doors) {
+        fields.storage ^= 0x01;
+        changes.push_back({at * kSecond, fields});
+    }
+    return changes;
+}
+
+static Scenario HeartRate() {
+    Scenario changes;
+    I2cStatusFields fields = Connected();
+    for (int64_t t = kSecond; t < kRunUs; t += kSecond) {
+        fields.heart_rate = (int16_t)(70 + (t / kSecond * 7) % 11);
+        changes.push_back({t, fields});
+    }
+    return changes;
+}
+
+static Scenario Gamepad() {
+    Scenario changes;
+    I2cStatusFields fields = Connected();
+    for (int64_t t = 30 * kSecond; t < kRunUs; t += 60 * kSecond) {
+        for (int i = 0; i < 6; i++) {
+            fields.gamepad = (uint8_t)(1 << (i % 4));
+            changes.push_back({t + i * 150 * kMs, fields});
+        }
+        fields.gamepad = 0;
+        changes.push_back({t + 6 * 150 * kMs, fields});
+    }
+    return changes;
+}
+
+enum Policy { kFixedFull, kAdaptiveDelta, kChangedLine };
+
+struct Result {
+    double bytes_per_min = 0;
+    double polls_per_min = 0;
+    double callbacks_per_min = 0;
+    int64_t p50_us = 0;
+    int64_t p99_us = 0;
+    int64_t max_us = 0;
+};
+
+static int64_t Percentile(std::vector<int64_t> values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[(size_t)(p * (values.size() - 1))];
+}
+
+static Result Run(const Scenario& changes, Policy policy) {
+    I2cStatusRecord record(0x5A);
+    I2cStatusView view;
+    I2cStatusPollInterval interval(kMinPollMs, kMaxPollMs);
+    I2cStatusFields initial = Connected();
+    record.Update(initial);
+
+    int64_t bytes = 0;
+    int polls = 0;
+    int callbacks = 0;
+    std::vector<int64_t> latencies;
+    size_t applied = 0;  // changes the actuator has
+    size_t read = 0;     // changes the master has read
+
+    int64_t t = 0;
+    while (t < kRunUs) {
+        while (applied < changes.size() && changes[applied].at_us <= t) {
+            record.Update(changes[applied].fields);
+            applied++;
+        }
+
+        I2cFrame request(policy == kFixedFull ? kI2cFrameStatus : kI2cFrameStatusDelta, 1);
+        if (policy != kFixedFull) {
+            view.BuildRequest(request);
+        }
+        size_t reply_size = I2cFrameReplySize(request.type);
+        int64_t done = t + (int64_t)(request.size() + 1 + reply_size + 1) * kByteUs;
+        bytes += request.size() + 1 + reply_size + 1;
+        polls++;
+
+        uint8_t changed;
+        if (policy == kFixedFull) {
+            changed = I2C_STATUS_ALL_FIELDS;  // the old task called back on every poll
+        } else {
+            I2cFrame reply(kI2cFrameStatusDeltaReply, 1);
+            record.EncodeDelta(request, reply);
+            changed = view.Apply(reply);
+        }
+        if (changed) {
+            callbacks++;
+        }
+        for (; read < applied; read++) {
+            latencies.push_back(done - changes[read].at_us);
+        }
+
+        // Next read
+        int64_t next;
+        if (policy == kFixedFull) {
+            next = done + (int64_t)kFixedMs * kMs;
+        } else if (policy == kAdaptiveDelta) {
+            next = done + (int64_t)interval.Next(changed) * kMs;
+        } else {
+            next = done + (int64_t)kMaxPollMs * kMs;
+            // The line rises on the first status sample after the next change
+            if (applied < changes.size()) {
+                int64_t edge = (changes[applied].at_us + kTrackUs - 1) / kTrackUs * kTrackUs;
+                next = std::min(next, std::max(edge, done));
+            }
+        }
+        t = next;
+    }
+
+    double minutes = (double)kRunUs / (60 * kSecond);
+    Result result;
+    result.bytes_per_min = bytes / minutes;
+    result.polls_per_min = polls / minutes;
+    result.callbacks_per_min = callbacks / minutes;
+    result.p50_us = Percentile(latencies, 0.5);
+    result.p99_us = Percentile(latencies, 0.99);
+    result.max_us = Percentile(latencies, 1.0);
+    return result;
+}
+
+int main() {
+    bool ok = true;
+
+    I2cStatusRecord record(0);
+    ok &= Check(record.epoch() != 0 && record.version() == 1, "epoch never 0, version starts at 1");
+    I2cStatusFields fields;
+    ok &= Check(!record.Update(fields) && record.version() == 1, "same fields: no new version");
+    fields.heart_rate = 80;
+    ok &= Check(record.Update(fields) && record.version() == 2, "a change moves the version on");
+    ok &= Check(record.ChangedSince(record.epoch(), 1) == kI2cStatusHeartRate &&
+            record.ChangedSince(record.epoch(), 2) == 0,
+        "ChangedSince reports the changed field only");
+    ok &= Check(record.ChangedSince(record.epoch(), 0) == I2C_STATUS_ALL_FIELDS &&
+            record.ChangedSince(record.epoch() + 1, 2) == I2C_STATUS_ALL_FIELDS &&
+            record.ChangedSince(record.epoch(), 9) == I2C_STATUS_ALL_FIELDS,
+        "since 0, other epoch or future version: all");
+
+    I2cStatusView view;
+    I2cFrame request(kI2cFrameStatusDelta, 1);
+    view.BuildRequest(request);
+    I2cFrame reply(kI2cFrameStatusDeltaReply, 1);
+    record.EncodeDelta(request, reply);
+    ok &= Check(reply.size() == I2cFrameReplySize(kI2cFrameStatusDelta), "full delta fills the reply size");
+    ok &= Check(view.Apply(reply) == I2C_STATUS_ALL_FIELDS && view.fields.heart_rate == 80 && view.version == 2,
+        "first read: every field");
+
+    fields.storage = 0x02;
+    record.Update(fields);
+    request = I2cFrame(kI2cFrameStatusDelta, 2);
+    view.BuildRequest(request);
+    reply = I2cFrame(kI2cFrameStatusDeltaReply, 2);
+    record.EncodeDelta(request, reply);
+    ok &= Check(reply.length == 5 && view.Apply(reply) == kI2cStatusStorage && view.fields.storage == 0x02 &&
+            view.fields.heart_rate == 80,
+        "delta carries the changed field, keeps the rest");
+
+    I2cStatusRecord rebooted(record.epoch() + 1);
+    rebooted.Update(fields);
+    request = I2cFrame(kI2cFrameStatusDelta, 3);
+    view.BuildRequest(request);
+    reply = I2cFrame(kI2cFrameStatusDeltaReply, 3);
+    rebooted.EncodeDelta(request, reply);
+    ok &= Check(view.Apply(reply) == I2C_STATUS_ALL_FIELDS && view.epoch == rebooted.epoch(),
+        "reboot: new epoch, every field reported changed");
+
+    I2cStatusPollInterval interval(250, 4000);
+    bool doubles = interval.Next(false) == 500 && interval.Next(false) == 1000 && interval.Next(false) == 2000 &&
+        interval.Next(false) == 4000 && interval.Next(false) == 4000;
+    ok &= Check(doubles && interval.Next(true) == 250, "interval doubles to the max, resets on a change");
+
+    struct {
+        const char* name;
+        Scenario changes;
+    } scenarios[] = {{"idle", Idle()}, {"heart rate", HeartRate()}, {"gamepad", Gamepad()}};
+    const char* policies[] = {"fixed 2 s full", "adaptive delta", "delta + line"};
+
+    Result results[3][3];
+    printf("\n%-12s %-16s %10s %10s %10s %10s %10s %10s\n", "scenario", "policy", "bytes/min", "polls/min",
+        "calls/min", "p50 ms", "p99 ms", "max ms");
+    for (int s = 0; s < 3; s++) {
+        for (int p = 0; p < 3; p++) {
+            Result& r = results[s][p];
+            r = Run(scenarios[s].changes, (Policy)p);
+            printf("%-12s %-16s %10.0f %10.1f %10.1f %10.1f %10.1f %10.1f\n", scenarios[s].name, policies[p],
+                r.bytes_per_min, r.polls_per_min, r.callbacks_per_min, r.p50_us / 1e3, r.p99_us / 1e3,
+                r.max_us / 1e3);
+        }
+    }
+    printf("\n");
+
+    const Result& idle_fixed = results[0][kFixedFull];
+    const Result& idle_delta = results[0][kAdaptiveDelta];
+    ok &= Check(idle_delta.bytes_per_min < idle_fixed.bytes_per_min, "idle: fewer bus bytes than fixed polling");
+    ok &= Check(idle_delta.callbacks_per_min < idle_fixed.callbacks_per_min, "idle: callbacks only on changes");
+    // Without the line, steady changes are seen sooner and cost more polls,
+    // while an idle actuator is read up to kMaxPollMs late
+    ok &= Check(results[1][kAdaptiveDelta].p50_us < results[1][kFixedFull].p50_us,
+        "heart rate: lower median latency than fixed");
+    bool line = true;
+    for (int s = 0; s < 3; s++) {
+        line &= results[s][kChangedLine].max_us <= kTrackUs + 5 * kMs;
+        line &= results[s][kChangedLine].bytes_per_min <= 3 * results[s][kFixedFull].bytes_per_min;
+    }
+    ok &= Check(line, "line: read within a sample, bytes within 3x fixed");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+/*
+ * Host benchmark: outbound control messages built with JsonWriter versus the
+ * previous std::string concatenation and cJSON tree paths.
+ *
+ *   g++ -O2 -std=c++17 -I ../../main/protocols main.cc -o json_writer_bench
+ *
+ * To include the cJSON path, point CJSON_DIR at cJSON sources
+ * (e.g. $IDF_PATH/components/json/cJSON):
+ *
+ *   g++ -O2 -std=c++17 -DHAVE_CJSON -I ../../main/protocols -I $CJSON_DIR \
+ *       main.cc $CJSON_DIR/cJSON.c -o json_writer_bench
+ */
+#include "json_writer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#ifdef HAVE_CJSON
+#include <cJSON.h>
+#endif
+
+static size_t g_allocations = 0;
+
+void* operator new(size_t size) {
+    g_allocations++;
+    if (void* p = malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+static const std::string kSessionId = "4f2a9c1e-7b3d-4e8a-9f61-2c5d8e0b7a13";
+static const std::string kWakeWord = "你好小智";
+static size_t g_sink = 0;
+
+static void Consume(const char* data, size_t length) {
+    g_sink += length + (unsigned char)data[length / 2];
+}
+
+// Previous Protocol::SendStartListening
+static void ListenConcat() {
+    std::string message = "{\"session_id\":\"" + kSessionId + "\"";
+    message += ",\"type\":\"listen\",\"state\":\"start\"";
+    message += ",\"mode\":\"auto\"";
+    message += "}";
+    Consume(message.data(), message.size());
+}
+
+// Previous Protocol::SendWakeWordDetected
+static void WakeWordConcat() {
+    std::string json = "{\"session_id\":\"" + kSessionId +
+                       "\",\"type\":\"listen\",\"state\":\"detect\",\"text\":\"" +
+                       kWakeWord + "\"}";
+    Consume(json.data(), json.size());
+}
+
+static void ListenWriter() {
+    char buffer[256];
+    JsonWriter json(buffer, sizeof(buffer));
+    json.BeginObject()
+        .Field("session_id", kSessionId)
+        .Field("type", "listen")
+        .Field("state", "start")
+        .Field("mode", "auto")
+        .EndObject();
+    Consume(json.data(), json.size());
+}
+
+static void WakeWordWriter() {
+    char buffer[256];
+    JsonWriter json(buffer, sizeof(buffer));
+    json.BeginObject()
+        .Field("session_id", kSessionId)
+        .Field("type", "listen")
+        .Field("state", "detect")
+        .Field("text", kWakeWord)
+        .EndObject();
+    Consume(json.data(), json.size());
+}
+
+static void HelloWriter() {
+    char buffer[256];
+    JsonWriter json(buffer, sizeof(buffer));
+    json.BeginObject().Field("type", "hello").Field("version", 3).Field("transport", "udp");
+    json.Key("features").BeginObject().Field("mcp", true).EndObject();
+    json.Key("audio_params").BeginObject()
+        .Field("format", "opus")
+        .Field("sample_rate", 16000)
+        .Field("channels", 1)
+        .Field("frame_duration", 60)
+        .EndObject();
+    json.EndObject();
+    Consume(json.data(), json.size());
+}
+
+#ifdef HAVE_CJSON
+static void* CountingMalloc(size_t size) {
+    g_allocations++;
+    return malloc(size);
+}
+
+// Previous MqttProtocol::GetHelloMessage
+static void HelloCjson() {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "type", "hello");
+    cJSON_AddNumberToObject(root, "version", 3);
+    cJSON_AddStringToObject(root, "transport", "udp");
+    cJSON* features = cJSON_CreateObject();
+    cJSON_AddBoolToObject(features, "mcp", true);
+    cJSON_AddItemToObject(root, "features", features);
+    cJSON* audio_params = cJSON_CreateObject();
+    cJSON_AddStringToObject(audio_params, "format", "opus");
+    cJSON_AddNumberToObject(audio_params, "sample_rate", 16000);
+    cJSON_AddNumberToObject(audio_params, "channels", 1);
+    cJSON_AddNumberToObject(audio_params, "frame_duration", 60);
+    cJSON_AddItemToObject(root, "audio_params", audio_params);
+    auto json_str = cJSON_PrintUnformatted(root);
+    std::string message(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    Consume(message.data(), message.size());
+}
+#endif
+
+static void Run(const char* name, void (*build)(), int iterations) {
+    build();
+    size_t allocations = g_allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        build();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-22s %12.0f msg/s %8.2f alloc/msg\n", name, iterations / elapsed,
+           (double)(g_allocations - allocations) / iterations);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 1000000;
+#ifdef HAVE_CJSON
+    cJSON_Hooks hooks = {CountingMalloc, free};
+    cJSON_InitHooks(&hooks);
+#endif
+    Run("listen concat", ListenConcat, iterations);
+    Run("listen writer", ListenWriter, iterations);
+    Run("wake word concat", WakeWordConcat, iterations);
+    Run("wake word writer", WakeWordWriter, iterations);
+#ifdef HAVE_CJSON
+    Run("hello cJSON", HelloCjson, iterations);
+#endif
+    Run("hello writer", HelloWriter, iterations);
+    // The protocol copies the writer output into one std::string for SendText,
+    // so the send path costs one allocation per message on top of the numbers above.
+    return g_sink == 0;
+}
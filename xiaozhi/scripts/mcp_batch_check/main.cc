@@ -0,0 +1,290 @@
+/*
+ * Host check and benchmark: JSON-RPC batches (mcp_batch.h).
+ * Drives McpBatch the way McpServer::ParseBatch / PumpBatch do, with each
+ * dispatched tools/call finishing on its own thread like the MCP workers.
+ * Checks that the window never exceeds MCP_BATCH_CONCURRENCY, that all
+ * responses go out once, packed under MCP_BATCH_MAX_PAYLOAD, and that dropped
+ * (cancelled) ids and notification-only batches do not hold anything up,
+ * and that a duplicate id, within the batches or of a single call still
+ * running, gets an error entry instead of running twice.
+ * Then compares N sequential calls, each paying the link round trip, against
+ * one batch. Exits non-zero if any check fails.
+ *
+ *   g++ -O2 -std=c++17 -pthread -I ../../main -I ../../main/protocols main.cc -o mcp_batch_check
+ *   ./mcp_batch_check
+ */
+#include "mcp_batch.h"
+
+#include <atomic>
+#include <cstdio>
+#include <set>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Stands in for a duplicated batch entry
+struct cJSON {
+    int id;
+};
+
+static void FreeEntry(cJSON* entry) {
+    delete entry;
+}
+
+static const int kLinkMs = 40;  // one way, device <-> server
+static const int kToolMs = 30;
+
+struct Outbox {
+    std::mutex mutex;
+    std::vector<std::string> messages;
+
+    McpCall::Sender Sender() {
+        return [this](const std::string& payload) {
+            std::lock_guard<std::mutex> lock(mutex);
+            messages.push_back(payload);
+        };
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return messages.size();
+    }
+};
+
+// A batch of tool calls on the fake server
+class FakeServer {
+public:
+    FakeServer(int calls, size_t response_size, int tool_ms, Outbox& outbox)
+        : batch_(outbox.Sender(), FreeEntry), response_size_(response_size), tool_ms_(tool_ms) {
+        for (int id = 1; id <= calls; id++) {
+            batch_.Expect(id);
+            batch_.AddCall(id, new cJSON{id});
+        }
+    }
+
+    ~FakeServer() {
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    void Start() {
+        batch_.Seal();
+        Pump();
+    }
+
+    int max_running() const { return max_running_; }
+    McpBatch& batch() { return batch_; }
+
+    std::function<bool(int id)> drop;
+
+private:
+    McpBatch batch_;
+    size_t response_size_;
+    int tool_ms_;
+    std::mutex mutex_;
+    std::vector<std::thread> threads_;
+    std::atomic<int> running_{0};
+    int max_running_ = 0;
+
+    // Same drain loop as McpServer::PumpBatch
+    void Pump() {
+        if (!batch_.BeginDispatch()) {
+            return;
+        }
+        do {
+            int id;
+            cJSON* entry;
+            while ((entry = batch_.NextEntry(id)) != nullptr) {
+                Dispatch(id);
+                FreeEntry(entry);
+            }
+        } while (!batch_.EndDispatch());
+    }
+
+    void Dispatch(int id) {
+        int running = ++running_;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            max_running_ = std::max(max_running_, running);
+            threads_.emplace_back([this, id]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(tool_ms_));
+                running_--;
+                if (drop && drop(id)) {
+                    batch_.Drop(id);
+                } else {
+                    std::string text(response_size_, 'x');
+                    batch_.Complete(id, "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(id) + ",\"result\":\"" +
+                        text + "\"}");
+                }
+                Pump();
+            });
+        }
+    }
+};
+
+// Same registration as McpServer::ParseBatch, running stands in for calls_
+// (single calls in flight) and waiting for batches_
+static bool Register(McpBatch& batch, const std::set<int>& running, std::set<int>& waiting, int id) {
+    if (running.count(id) != 0 || !waiting.insert(id).second) {
+        batch.AddResponse("{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(id) +
+            ",\"error\":{\"code\":-32600,\"message\":\"Duplicate id\"}}");
+        return false;
+    }
+    batch.Expect(id);
+    return true;
+}
+
+static int Count(const std::vector<std::string>& messages, const char* text) {
+    int count = 0;
+    for (auto& message : messages) {
+        for (size_t pos = 0; (pos = message.find(text, pos)) != std::string::npos; pos++) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static bool Check(bool ok, const char* what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static int CountIds(const std::vector<std::string>& messages) {
+    return Count(messages, "\"id\":");
+}
+
+int main() {
+    bool ok = true;
+
+    // Small responses: one message with every id
+    {
+        Outbox outbox;
+        int sent_at_finish = -1;
+        {
+            FakeServer server(8, 40, 5, outbox);
+            server.Start();
+            while (outbox.size() == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            sent_at_finish = (int)server.batch().messages_sent();
+            ok &= Check(server.max_running() <= MCP_BATCH_CONCURRENCY, "window stays within MCP_BATCH_CONCURRENCY");
+        }
+        ok &= Check(outbox.messages.size() == 1 && sent_at_finish == 1, "8 small responses sent as one message");
+        ok &= Check(CountIds(outbox.messages) == 8, "every id answered once");
+        ok &= Check(outbox.messages[0].front() == '[' && outbox.messages[0].back() == ']', "response is a JSON array");
+    }
+
+    // Large responses: split under the payload limit
+    {
+        Outbox outbox;
+        {
+            FakeServer server(MCP_BATCH_MAX_SIZE, 900, 1, outbox);
+            server.Start();
+            while (outbox.size() == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        bool within = true;
+        for (auto& message : outbox.messages) {
+            within &= message.size() <= MCP_BATCH_MAX_PAYLOAD;
+        }
+        printf("%d responses of ~%d bytes -> %d messages\n", MCP_BATCH_MAX_SIZE, 940, (int)outbox.messages.size());
+        ok &= Check(outbox.messages.size() > 1 && within, "large batch split under MCP_BATCH_MAX_PAYLOAD");
+        ok &= Check(CountIds(outbox.messages) == MCP_BATCH_MAX_SIZE, "no response lost when splitting");
+    }
+
+    // A cancelled call drops out, the others still go out
+    {
+        Outbox outbox;
+        {
+            FakeServer server(4, 40, 5, outbox);
+            server.drop = [](int id) { return id == 2; };
+            server.Start();
+            while (outbox.size() == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        ok &= Check(CountIds(outbox.messages) == 3 && outbox.messages[0].find("\"id\":2,") == std::string::npos,
+            "dropped id leaves the others to be sent");
+    }
+
+    // Only notifications: nothing to send
+    {
+        Outbox outbox;
+        McpBatch batch(outbox.Sender(), FreeEntry);
+        batch.Seal();
+        ok &= Check(outbox.size() == 0, "batch without responses sends nothing");
+    }
+
+    // Unexpected ids are not collected
+    {
+        Outbox outbox;
+        McpBatch batch(outbox.Sender(), FreeEntry);
+        batch.Expect(1);
+        ok &= Check(!batch.Complete(9, "{}") && batch.Complete(1, "{\"id\":1}") && outbox.size() == 0,
+            "nothing sent before the batch is sealed");
+        batch.Seal();
+        ok &= Check(outbox.size() == 1, "sealing a complete batch sends it");
+    }
+
+    // Duplicate ids: the first one runs, every repeat gets an error entry,
+    // and so does an id a single call still running holds
+    {
+        Outbox outbox;
+        McpBatch batch(outbox.Sender(), FreeEntry);
+        std::set<int> running = {3};
+        std::set<int> waiting;
+        for (int id : {1, 2, 2, 3, 1, 2}) {
+            if (Register(batch, running, waiting, id)) {
+                batch.AddCall(id, new cJSON{id});
+            }
+        }
+        batch.Seal();
+        std::vector<int> runs;
+        if (batch.BeginDispatch()) {
+            do {
+                int id;
+                cJSON* entry;
+                while ((entry = batch.NextEntry(id)) != nullptr) {
+                    runs.push_back(id);
+                    FreeEntry(entry);
+                    batch.Complete(id, "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(id) + ",\"result\":{}}");
+                }
+            } while (!batch.EndDispatch());
+        }
+        ok &= Check(runs == std::vector<int>({1, 2}), "duplicate ids are not run");
+        ok &= Check(outbox.size() == 1 && CountIds(outbox.messages) == 6 &&
+                Count(outbox.messages, "Duplicate id") == 4,
+            "each duplicate answered with an error entry");
+    }
+
+    // N sequential requests each pay the link round trip, a batch pays it once
+    printf("\nlink %d ms each way, tool %d ms\n", kLinkMs, kToolMs);
+    for (int n : {2, 4, 8}) {
+        auto start = Clock::now();
+        for (int i = 0; i < n; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(kLinkMs + kToolMs + kLinkMs));
+        }
+        double sequential_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        Outbox outbox;
+        start = Clock::now();
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(kLinkMs));
+            FakeServer server(n, 40, kToolMs, outbox);
+            server.Start();
+            while (outbox.size() == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(kLinkMs));
+        }
+        double batch_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        printf("  %d calls: sequential %6.0f ms (%d messages), batch %6.0f ms (%d messages)\n", n, sequential_ms, n * 2,
+            batch_ms, (int)outbox.size() + 1);
+        ok &= Check(batch_ms < sequential_ms, "  batch is faster");
+    }
+
+    return ok ? 0 : 1;
+}
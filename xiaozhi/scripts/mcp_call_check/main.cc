@@ -0,0 +1,127 @@
+/*
+ * Host check: MCP call cancellation and progress (mcp_call.h).
+ * Two fake long-running tools run at once on their own threads, like the MCP
+ * workers. One is cancelled part way and must return within a step and get no
+ * reply, the other must finish untouched with rate limited progress and its
+ * final step reported. Exits non-zero if any check fails.
+ *
+ *   g++ -O2 -std=c++17 -pthread -I ../../main -I ../../main/protocols main.cc -o mcp_call_check
+ *   ./mcp_call_check
+ */
+#include "mcp_call.h"
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const int kSteps = 50;
+static const int kStepMs = 20;
+
+struct Outbox {
+    std::mutex mutex;
+    std::vector<std::string> messages;
+
+    McpCall::Sender Sender() {
+        return [this](const std::string& payload) {
+            std::lock_guard<std::mutex> lock(mutex);
+            messages.push_back(payload);
+        };
+    }
+
+    int Count(const std::string& needle) {
+        std::lock_guard<std::mutex> lock(mutex);
+        int count = 0;
+        for (auto& message : messages) {
+            if (message.find(needle) != std::string::npos) {
+                count++;
+            }
+        }
+        return count;
+    }
+};
+
+// A vehicle sequence: one step at a time, checks the token between steps
+static std::string FakeSequence() {
+    for (int step = 0; step < kSteps; step++) {
+        McpCall::ReportProgress(step, kSteps);
+        McpCall::ThrowIfCancelled();
+        std::this_thread::sleep_for(std::chrono::milliseconds(kStepMs));
+    }
+    McpCall::ReportProgress(kSteps, kSteps);
+    return "done";
+}
+
+// Same order as McpServer::RunCall
+static void RunCall(McpCallRegistry& calls, McpCall& call, Outbox& outbox, Clock::time_point& finished) {
+    std::string result;
+    {
+        McpCall::Scope scope(&call);
+        try {
+            McpCall::ThrowIfCancelled();
+            result = FakeSequence();
+        } catch (const McpCancelled&) {
+        }
+    }
+    finished = Clock::now();
+    calls.End(call.id());
+    if (!call.cancelled()) {
+        outbox.Sender()("{\"id\":" + std::to_string(call.id()) + ",\"result\":\"" + result + "\"}");
+    }
+}
+
+static bool Check(bool ok, const char* what) {
+    printf("%-52s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main() {
+    McpCallRegistry calls;
+    Outbox outbox;
+    bool ok = true;
+
+    auto a = calls.Begin(1, "\"move-a\"", outbox.Sender());
+    auto b = calls.Begin(2, "7", outbox.Sender());
+    ok &= Check(a != nullptr && b != nullptr, "two calls in flight");
+    ok &= Check(calls.Begin(1, "", outbox.Sender()) == nullptr, "duplicate id rejected while running");
+
+    auto start = Clock::now();
+    Clock::time_point a_finished, b_finished;
+    std::thread worker_a([&]() { RunCall(calls, *a, outbox, a_finished); });
+    std::thread worker_b([&]() { RunCall(calls, *b, outbox, b_finished); });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kSteps * kStepMs / 4));
+    auto cancelled_at = Clock::now();
+    ok &= Check(calls.Cancel(1), "notifications/cancelled finds call 1");
+    worker_a.join();
+    worker_b.join();
+
+    double cancel_ms = std::chrono::duration<double, std::milli>(a_finished - cancelled_at).count();
+    double a_ms = std::chrono::duration<double, std::milli>(a_finished - start).count();
+    double b_ms = std::chrono::duration<double, std::milli>(b_finished - start).count();
+    printf("cancel latency %.1f ms (step %d ms), call 1 ran %.0f ms, call 2 ran %.0f ms\n\n", cancel_ms, kStepMs,
+        a_ms, b_ms);
+
+    ok &= Check(cancel_ms <= kStepMs * 2, "cancelled call returns within a step");
+    ok &= Check(b_ms >= kSteps * kStepMs, "other call keeps running to the end");
+    ok &= Check(outbox.Count("\"id\":1,") == 0, "cancelled call gets no reply");
+    ok &= Check(outbox.Count("\"id\":2,\"result\":\"done\"") == 1, "other call replies once");
+    ok &= Check(!calls.Cancel(2) && calls.size() == 0, "finished calls leave the registry");
+
+    int b_progress = outbox.Count("\"progressToken\":7,");
+    int limit = kSteps * kStepMs / MCP_PROGRESS_INTERVAL_MS + 2;
+    printf("call 2 progress notifications: %d for %d steps (limit %d)\n", b_progress, kSteps, limit);
+    ok &= Check(b_progress >= 2 && b_progress <= limit, "progress is rate limited");
+    ok &= Check(outbox.Count("\"progressToken\":7,\"progress\":50,\"total\":50") == 1, "final progress always sent");
+    ok &= Check(outbox.Count("\"progressToken\":\"move-a\"") >= 1, "string progress tokens are kept as sent");
+
+    // Without a token nothing is sent
+    Outbox quiet;
+    McpCall silent(3, "", quiet.Sender());
+    silent.Progress(1, 2);
+    silent.Progress(2, 2);
+    ok &= Check(quiet.Count("progress") == 0, "no progress without a token");
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,336 @@
+/*
+ * Host benchmark: an MCP tools/call response carrying a 20 to 200 KB JPEG,
+ * from the tool's return value to the message queued on the transport.
+ *
+ * previous: ImageContent base64 encoded the image into a string, to_json()
+ *           copied it into a cJSON tree and printed it, FormatResult copied
+ *           that into another tree and printed it escaped, then ReplyResult
+ *           and Protocol::SendMcpMessage each copied the result once more.
+ * streaming: ImageContent keeps the raw bytes and JsonWriter::Base64 encodes
+ *           them straight into the message (McpServer::ReplyToolResult ->
+ *           Protocol::SendMcpMessage).
+ *
+ * Reports peak heap above the raw image and throughput, and checks both paths
+ * produce the same bytes. Without cJSON the previous path is replayed buffer
+ * by buffer, print buffers growing like cJSON's (double on overflow, shrink
+ * at the end):
+ *
+ *   g++ -O2 -std=c++17 -I ../../main -I ../../main/protocols main.cc -o mcp_image_bench
+ *
+ * With cJSON sources (e.g. $IDF_PATH/components/json/cJSON) the previous path
+ * runs the original code:
+ *
+ *   g++ -O2 -std=c++17 -DHAVE_CJSON -I ../../main -I ../../main/protocols -I $CJSON_DIR \
+ *       main.cc $CJSON_DIR/cJSON.c -o mcp_image_bench
+ */
+#include "mcp_image_content.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_CJSON
+#include <cJSON.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static size_t g_heap = 0;
+static size_t g_peak = 0;
+
+// Size kept in front of each block so frees can be counted
+static void* CountedMalloc(size_t size) {
+    auto block = (size_t*)malloc(size + sizeof(max_align_t));
+    if (block == nullptr) {
+        return nullptr;
+    }
+    *block = size;
+    g_heap += size;
+    if (g_heap > g_peak) {
+        g_peak = g_heap;
+    }
+    return (char*)block + sizeof(max_align_t);
+}
+
+static void CountedFree(void* p) {
+    if (p == nullptr) {
+        return;
+    }
+    auto block = (size_t*)((char*)p - sizeof(max_align_t));
+    g_heap -= *block;
+    free(block);
+}
+
+void* operator new(size_t size) {
+    if (void* p = CountedMalloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    CountedFree(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    CountedFree(p);
+}
+
+static const std::string kSessionId = "d8a7f3c2b1e04f5a";
+static const int kCallId = 42;
+
+// Protocol::SendMcpMessage envelope around an already written payload
+static std::string WrapMessage(const std::string& payload) {
+    std::string message(payload.size() + kSessionId.size() * 6 + 64, '\0');
+    JsonWriter json(message.data(), message.size());
+    json.BeginObject().Field("session_id", kSessionId).Field("type", "mcp").Key("payload").Raw(payload).EndObject();
+    message.resize(json.size());
+    return message;
+}
+
+#ifdef HAVE_CJSON
+static std::string PreviousPath(const std::string& mime_type, std::string data) {
+    // ImageContent::Base64Encode
+    std::string encoded(JsonWriter::Base64Size(data.size()), '\0');
+    JsonWriter encoder(encoded.data(), encoded.size());
+    encoder.Base64(data.data(), data.size());
+    std::string().swap(data);  // the handler's buffer goes away with it
+
+    // ImageContent::to_json
+    cJSON* inner = cJSON_CreateObject();
+    cJSON_AddStringToObject(inner, "type", "image");
+    cJSON_AddStringToObject(inner, "mimeType", mime_type.c_str());
+    cJSON_AddStringToObject(inner, "data", encoded.c_str());
+    char* inner_str = cJSON_PrintUnformatted(inner);
+    std::string inner_json(inner_str);
+    cJSON_free(inner_str);
+    cJSON_Delete(inner);
+
+    // McpTool::FormatResult
+    cJSON* result = cJSON_CreateObject();
+    cJSON* content = cJSON_CreateArray();
+    cJSON* image = cJSON_CreateObject();
+    cJSON_AddStringToObject(image, "type", "image");
+    cJSON_AddStringToObject(image, "image", inner_json.c_str());
+    std::string().swap(inner_json);
+    std::string().swap(encoded);  // delete image_content
+    cJSON_AddItemToArray(content, image);
+    cJSON_AddItemToObject(result, "content", content);
+    cJSON_AddBoolToObject(result, "isError", false);
+    char* json_str = cJSON_PrintUnformatted(result);
+    std::string result_str(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(result);
+
+    // McpServer::ReplyResult
+    std::string payload(result_str.size() + 64, '\0');
+    JsonWriter json(payload.data(), payload.size());
+    json.BeginObject().Field("jsonrpc", "2.0").Field("id", kCallId).Key("result").Raw(result_str).EndObject();
+    payload.resize(json.size());
+    return WrapMessage(payload);
+}
+#else
+// Output buffer of cJSON_PrintUnformatted: starts at 256 bytes, doubles past
+// what is needed, shrinks to fit once printed
+class PrintBuffer {
+public:
+    PrintBuffer() : capacity_(256), buffer_((char*)CountedMalloc(capacity_)) {}
+    ~PrintBuffer() { CountedFree(buffer_); }
+
+    void Append(const std::string& text) {
+        Ensure(length_ + text.size() + 1);
+        memcpy(buffer_ + length_, text.data(), text.size());
+        length_ += text.size();
+    }
+
+    std::string Finish() {
+        char* fitted = (char*)CountedMalloc(length_ + 1);
+        memcpy(fitted, buffer_, length_);
+        CountedFree(buffer_);
+        buffer_ = fitted;
+        capacity_ = length_ + 1;
+        return std::string(buffer_, length_);
+    }
+
+private:
+    size_t capacity_;
+    char* buffer_;
+    size_t length_ = 0;
+
+    void Ensure(size_t needed) {
+        if (needed <= capacity_) {
+            return;
+        }
+        size_t capacity = needed * 2;
+        char* grown = (char*)CountedMalloc(capacity);
+        memcpy(grown, buffer_, length_);
+        CountedFree(buffer_);
+        buffer_ = grown;
+        capacity_ = capacity;
+    }
+};
+
+static std::string Quote(const std::string& value) {
+    std::string quoted(JsonWriter::StringSize(value), '\0');
+    JsonWriter json(quoted.data(), quoted.size());
+    json.String(value);
+    return quoted;
+}
+
+static std::string PreviousPath(const std::string& mime_type, std::string data) {
+    // ImageContent::Base64Encode
+    std::string encoded(JsonWriter::Base64Size(data.size()), '\0');
+    JsonWriter encoder(encoded.data(), encoded.size());
+    encoder.Base64(data.data(), data.size());
+    std::string().swap(data);
+
+    // ImageContent::to_json: cJSON tree holds a copy of the encoded data
+    std::string inner_json;
+    {
+        std::string tree_data(encoded);
+        PrintBuffer print;
+        print.Append("{\"type\":\"image\",\"mimeType\":" + Quote(mime_type) + ",\"data\":");
+        print.Append(Quote(tree_data));
+        print.Append("}");
+        inner_json = print.Finish();
+    }
+
+    // McpTool::FormatResult: the tree holds a copy of to_json()
+    std::string result_str;
+    {
+        std::string tree_image(inner_json);
+        std::string().swap(inner_json);
+        std::string().swap(encoded);
+        PrintBuffer print;
+        print.Append("{\"content\":[{\"type\":\"image\",\"image\":");
+        print.Append(Quote(tree_image));
+        print.Append("}],\"isError\":false}");
+        result_str = print.Finish();
+    }
+
+    // McpServer::ReplyResult
+    std::string payload(result_str.size() + 64, '\0');
+    JsonWriter json(payload.data(), payload.size());
+    json.BeginObject().Field("jsonrpc", "2.0").Field("id", kCallId).Key("result").Raw(result_str).EndObject();
+    payload.resize(json.size());
+    return WrapMessage(payload);
+}
+#endif
+
+// McpServer::ReplyToolResult through Protocol::SendMcpMessage
+static std::string StreamingPath(const std::string& mime_type, std::string data) {
+    ImageContent image(mime_type, std::move(data));
+    size_t payload_size = image.json_size() + 64 + 64;
+    std::string message(payload_size + kSessionId.size() * 6 + 64, '\0');
+    JsonWriter json(message.data(), message.size());
+    json.BeginObject().Field("session_id", kSessionId).Field("type", "mcp").Key("payload");
+    json.BeginObject().Field("jsonrpc", "2.0").Field("id", kCallId).Key("result");
+    json.BeginObject().Key("content").BeginArray();
+    image.Write(json);
+    json.EndArray().Field("isError", false).EndObject();
+    json.EndObject();
+    json.EndObject();
+    if (json.overflow()) {
+        return std::string();
+    }
+    message.resize(json.size());
+    return message;
+}
+
+// Plain bit-at-a-time encoder to check JsonWriter::Base64 against
+static std::string ReferenceBase64(const std::string& data) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    uint32_t bits = 0;
+    int count = 0;
+    for (unsigned char c : data) {
+        bits = bits << 8 | c;
+        count += 8;
+        while (count >= 6) {
+            count -= 6;
+            out += table[(bits >> count) & 0x3f];
+        }
+    }
+    if (count > 0) {
+        out += table[(bits << (6 - count)) & 0x3f];
+    }
+    while (out.size() % 4 != 0) {
+        out += '=';
+    }
+    return out;
+}
+
+static std::string RandomBytes(size_t size, uint32_t seed) {
+    std::string data(size, '\0');
+    for (auto& c : data) {
+        seed = seed * 1664525 + 1013904223;
+        c = (char)(seed >> 24);
+    }
+    return data;
+}
+
+struct Result {
+    size_t peak;
+    double mb_per_s;
+    std::string message;
+};
+
+template <typename Path>
+static Result Measure(Path path, const std::string& image, int iterations) {
+    Result result;
+    std::string data = image;
+    size_t base = g_heap;
+    g_peak = g_heap;
+    result.message = path("image/jpeg", std::move(data));
+    result.peak = g_peak - base;
+
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        path("image/jpeg", image);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.mb_per_s = image.size() * (double)iterations / seconds / 1e6;
+    return result;
+}
+
+int main() {
+#ifdef HAVE_CJSON
+    cJSON_Hooks hooks = {CountedMalloc, CountedFree};
+    cJSON_InitHooks(&hooks);
+#endif
+    bool ok = true;
+
+    for (size_t size = 0; size < 64; size++) {
+        std::string data = RandomBytes(size, (uint32_t)size);
+        std::string encoded(JsonWriter::Base64Size(size), '\0');
+        JsonWriter json(encoded.data(), encoded.size());
+        json.Base64(data.data(), data.size());
+        ok &= !json.overflow() && json.view() == ReferenceBase64(data);
+    }
+    printf("JsonWriter::Base64 matches reference: %s\n", ok ? "ok" : "FAILED");
+
+    std::string text = RandomBytes(4096, 7);
+    std::string quoted(JsonWriter::EscapedSize(text.size()), '\0');
+    JsonWriter text_json(quoted.data(), quoted.size());
+    text_json.String(text);
+    bool exact = text_json.size() == JsonWriter::StringSize(text);
+    printf("JsonWriter::StringSize exact: %s\n\n", exact ? "ok" : "FAILED");
+    ok &= exact;
+
+    printf("%8s  %22s  %22s  %s\n", "image", "previous peak / MB/s", "streaming peak / MB/s", "same bytes");
+    for (size_t kb : {20, 50, 100, 200}) {
+        std::string image = RandomBytes(kb * 1024, (uint32_t)kb);
+        int iterations = (int)(20000 / kb);
+        auto previous = Measure(PreviousPath, image, iterations);
+        auto streaming = Measure(StreamingPath, image, iterations);
+        bool same = !streaming.message.empty() && previous.message == streaming.message;
+        ok &= same && streaming.peak < previous.peak;
+        printf("%5d KB  %9.1f KB %7.0f    %9.1f KB %7.0f    %s (%.1fx less heap)\n", (int)kb,
+            previous.peak / 1024.0, previous.mb_per_s, streaming.peak / 1024.0, streaming.mb_per_s,
+            same ? "yes" : "NO", (double)previous.peak / streaming.peak);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,359 @@
+/*
+ * Host benchmark: tools/list with the schemas serialised on every request
+ * (previous McpServer::GetToolsList) versus McpToolsList, for 50 to 200
+ * synthetic tools. Walks every page through nextCursor, checks both paths
+ * return the same bytes and reports latency and heap churn per full listing.
+ *
+ * Without cJSON the previous path builds each schema by string concatenation,
+ * which is cheaper than the cJSON trees it really used, so its numbers are a
+ * lower bound:
+ *
+ *   g++ -O2 -std=c++17 -I ../../main main.cc -o mcp_tools_list_bench
+ *
+ * To serialise like McpTool::to_json, point CJSON_DIR at cJSON sources
+ * (e.g. $IDF_PATH/components/json/cJSON):
+ *
+ *   g++ -O2 -std=c++17 -DHAVE_CJSON -I ../../main -I $CJSON_DIR \
+ *       main.cc $CJSON_DIR/cJSON.c -o mcp_tools_list_bench
+ */
+#include "mcp_tools_list.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_CJSON
+#include <cJSON.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static size_t g_allocations = 0;
+static size_t g_allocated_bytes = 0;
+
+// Out of line so the compiler never sees free() on a pointer from operator new
+__attribute__((noinline)) static void* CountedMalloc(size_t size) {
+    g_allocations++;
+    g_allocated_bytes += size;
+    return malloc(size);
+}
+
+__attribute__((noinline)) static void CountedFree(void* p) {
+    free(p);
+}
+
+void* operator new(size_t size) {
+    if (void* p = CountedMalloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    CountedFree(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    CountedFree(p);
+}
+
+enum PropertyType { kBoolean, kInteger, kString };
+
+struct Property {
+    std::string name;
+    PropertyType type;
+    bool has_default;
+    int default_value;
+};
+
+struct Tool {
+    std::string name;
+    std::string description;
+    std::vector<Property> properties;
+    bool user_only;
+};
+
+// Roughly the size of the board tools: a long description and up to three arguments
+static std::vector<Tool> MakeTools(int count) {
+    std::vector<Tool> tools;
+    for (int i = 0; i < count; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "self.robot.tool_%03d", i);
+        Tool tool;
+        tool.name = name;
+        tool.description = "Moves or queries part " + std::to_string(i) +
+            " of the robot. Use when the user asks for it, the arguments are checked against the limits below.";
+        for (int p = 0; p < i % 4; p++) {
+            tool.properties.push_back({"arg" + std::to_string(p), (PropertyType)(p % 3), p == 2, p * 10});
+        }
+        tool.user_only = i % 5 == 4;
+        tools.push_back(tool);
+    }
+    return tools;
+}
+
+#ifdef HAVE_CJSON
+// Same steps as Property/PropertyList/McpTool::to_json
+static std::string PropertyJson(const Property& property) {
+    cJSON* json = cJSON_CreateObject();
+    if (property.type == kBoolean) {
+        cJSON_AddStringToObject(json, "type", "boolean");
+        if (property.has_default) {
+            cJSON_AddBoolToObject(json, "default", property.default_value != 0);
+        }
+    } else if (property.type == kInteger) {
+        cJSON_AddStringToObject(json, "type", "integer");
+        if (property.has_default) {
+            cJSON_AddNumberToObject(json, "default", property.default_value);
+        }
+        cJSON_AddNumberToObject(json, "minimum", 0);
+        cJSON_AddNumberToObject(json, "maximum", 100);
+    } else {
+        cJSON_AddStringToObject(json, "type", "string");
+        if (property.has_default) {
+            cJSON_AddStringToObject(json, "default", std::to_string(property.default_value).c_str());
+        }
+    }
+    char* json_str = cJSON_PrintUnformatted(json);
+    std::string result(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(json);
+    return result;
+}
+
+static std::string ToolJson(const Tool& tool) {
+    cJSON* list = cJSON_CreateObject();
+    for (auto& property : tool.properties) {
+        cJSON_AddItemToObject(list, property.name.c_str(), cJSON_Parse(PropertyJson(property).c_str()));
+    }
+    char* list_str = cJSON_PrintUnformatted(list);
+    std::string properties_json(list_str);
+    cJSON_free(list_str);
+    cJSON_Delete(list);
+
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "name", tool.name.c_str());
+    cJSON_AddStringToObject(json, "description", tool.description.c_str());
+    cJSON* input_schema = cJSON_CreateObject();
+    cJSON_AddStringToObject(input_schema, "type", "object");
+    cJSON_AddItemToObject(input_schema, "properties", cJSON_Parse(properties_json.c_str()));
+    cJSON* required = nullptr;
+    for (auto& property : tool.properties) {
+        if (!property.has_default) {
+            if (required == nullptr) {
+                required = cJSON_CreateArray();
+            }
+            cJSON_AddItemToArray(required, cJSON_CreateString(property.name.c_str()));
+        }
+    }
+    if (required != nullptr) {
+        cJSON_AddItemToObject(input_schema, "required", required);
+    }
+    cJSON_AddItemToObject(json, "inputSchema", input_schema);
+    if (tool.user_only) {
+        cJSON* annotations = cJSON_CreateObject();
+        cJSON* audience = cJSON_CreateArray();
+        cJSON_AddItemToArray(audience, cJSON_CreateString("user"));
+        cJSON_AddItemToObject(annotations, "audience", audience);
+        cJSON_AddItemToObject(json, "annotations", annotations);
+    }
+    char* json_str = cJSON_PrintUnformatted(json);
+    std::string result(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(json);
+    return result;
+}
+#else
+static std::string PropertyJson(const Property& property) {
+    static const char* kTypes[] = {"boolean", "integer", "string"};
+    std::string json = "{\"type\":\"" + std::string(kTypes[property.type]) + "\"";
+    if (property.has_default) {
+        if (property.type == kBoolean) {
+            json += property.default_value ? ",\"default\":true" : ",\"default\":false";
+        } else if (property.type == kInteger) {
+            json += ",\"default\":" + std::to_string(property.default_value);
+        } else {
+            json += ",\"default\":\"" + std::to_string(property.default_value) + "\"";
+        }
+    }
+    if (property.type == kInteger) {
+        json += ",\"minimum\":0,\"maximum\":100";
+    }
+    return json + "}";
+}
+
+static std::string ToolJson(const Tool& tool) {
+    std::string properties;
+    std::string required;
+    for (auto& property : tool.properties) {
+        properties += (properties.empty() ? "" : ",") + ("\"" + property.name + "\":") + PropertyJson(property);
+        if (!property.has_default) {
+            required += (required.empty() ? "\"" : ",\"") + property.name + "\"";
+        }
+    }
+    std::string json = "{\"name\":\"" + tool.name + "\",\"description\":\"" + tool.description +
+        "\",\"inputSchema\":{\"type\":\"object\",\"properties\":{" + properties + "}";
+    if (!required.empty()) {
+        json += ",\"required\":[" + required + "]";
+    }
+    json += "}";
+    if (tool.user_only) {
+        json += ",\"annotations\":{\"audience\":[\"user\"]}";
+    }
+    return json + "}";
+}
+#endif
+
+// Previous McpServer::GetToolsList, returns the next cursor
+static std::string PreviousPage(const std::vector<Tool>& tools, const std::string& cursor, bool list_user_only_tools,
+                                std::string& json) {
+    json = "{\"tools\":[";
+    bool found_cursor = cursor.empty();
+    auto it = tools.begin();
+    std::string next_cursor = "";
+    while (it != tools.end()) {
+        if (!found_cursor) {
+            if (it->name == cursor) {
+                found_cursor = true;
+            } else {
+                ++it;
+                continue;
+            }
+        }
+        if (!list_user_only_tools && it->user_only) {
+            ++it;
+            continue;
+        }
+        std::string tool_json = ToolJson(*it) + ",";
+        if (json.length() + tool_json.length() + 30 > MCP_TOOLS_LIST_PAGE_SIZE) {
+            next_cursor = it->name;
+            break;
+        }
+        json += tool_json;
+        ++it;
+    }
+    if (json.back() == ',') {
+        json.pop_back();
+    }
+    if (next_cursor.empty()) {
+        json += "]}";
+    } else {
+        json += "],\"nextCursor\":\"" + next_cursor + "\"}";
+    }
+    return next_cursor;
+}
+
+static size_t g_sink = 0;
+
+// Every page of one listing, pages are appended to out when given
+template <typename Page>
+static void ListAll(Page&& page, std::vector<std::string>* out) {
+    std::string cursor;
+    std::string json;
+    do {
+        cursor = page(cursor, json);
+        g_sink += json.size();
+        if (out != nullptr) {
+            out->push_back(json);
+        }
+    } while (!cursor.empty());
+}
+
+static std::string NextCursor(const std::string& json) {
+    static const char kKey[] = "\"nextCursor\":\"";
+    size_t pos = json.rfind(kKey);
+    if (pos == std::string::npos) {
+        return "";
+    }
+    pos += sizeof(kKey) - 1;
+    return json.substr(pos, json.find('"', pos) - pos);
+}
+
+int main() {
+#ifdef HAVE_CJSON
+    cJSON_Hooks hooks = {CountedMalloc, CountedFree};
+    cJSON_InitHooks(&hooks);
+    printf("previous path: cJSON trees\n\n");
+#else
+    printf("previous path: string concatenation (lower bound, build with -DHAVE_CJSON for cJSON)\n\n");
+#endif
+    const int kIterations = 500;
+    bool ok = true;
+    for (int count : {50, 100, 200}) {
+        auto tools = MakeTools(count);
+
+        auto previous = [&](const std::string& cursor, std::string& json) {
+            return PreviousPage(tools, cursor, true, json);
+        };
+
+        auto build_start = Clock::now();
+        size_t build_allocations = g_allocations;
+        McpToolsList list;
+        for (auto& tool : tools) {
+            list.Add(tool.name, ToolJson(tool), tool.user_only);
+        }
+        double build_us = std::chrono::duration<double, std::micro>(Clock::now() - build_start).count();
+        build_allocations = g_allocations - build_allocations;
+
+        auto cached = [&](const std::string& cursor, std::string& json) {
+            std::string failed_tool;
+            if (!list.Render(cursor, true, json, failed_tool)) {
+                json.clear();
+                return std::string();
+            }
+            return NextCursor(json);
+        };
+
+        // The listing the AI gets, without the user only tools, must match as well
+        bool same = true;
+        size_t pages = 0;
+        for (bool list_user_only_tools : {true, false}) {
+            std::vector<std::string> previous_pages;
+            std::vector<std::string> cached_pages;
+            ListAll([&](const std::string& cursor, std::string& json) {
+                return PreviousPage(tools, cursor, list_user_only_tools, json);
+            }, &previous_pages);
+            ListAll([&](const std::string& cursor, std::string& json) {
+                std::string failed_tool;
+                list.Render(cursor, list_user_only_tools, json, failed_tool);
+                return NextCursor(json);
+            }, &cached_pages);
+            same = same && previous_pages == cached_pages;
+            if (list_user_only_tools) {
+                pages = cached_pages.size();
+            }
+        }
+        ok = ok && same;
+
+        struct Result {
+            double us;
+            double allocations;
+            double kbytes;
+        } results[2];
+        for (int path = 0; path < 2; path++) {
+            size_t allocations = g_allocations;
+            size_t bytes = g_allocated_bytes;
+            auto start = Clock::now();
+            for (int i = 0; i < kIterations; i++) {
+                if (path == 0) {
+                    ListAll(previous, nullptr);
+                } else {
+                    ListAll(cached, nullptr);
+                }
+            }
+            results[path].us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / kIterations;
+            results[path].allocations = (double)(g_allocations - allocations) / kIterations;
+            results[path].kbytes = (double)(g_allocated_bytes - bytes) / kIterations / 1024;
+        }
+
+        printf("%3d tools, %zu pages, %s\n", count, pages, same ? "same bytes" : "MISMATCH");
+        printf("  previous  %8.1f us/list  %7.0f allocs  %7.1f KB\n", results[0].us, results[0].allocations,
+            results[0].kbytes);
+        printf("  cached    %8.1f us/list  %7.0f allocs  %7.1f KB  (built once: %.1f us, %zu allocs)\n",
+            results[1].us, results[1].allocations, results[1].kbytes, build_us, build_allocations);
+    }
+    return ok && g_sink > 0 ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+/*
+ * Host check: per call MCP tracing (mcp_trace.h).
+ * Fake tools with known costs run through the same trace points as
+ * McpServer (received, parsed, scheduled, started, finished, replied) on a
+ * fake clock, so every span and histogram bucket is known in advance. Checks
+ * the breakdown, the per tool histograms, the bounded ring, the "other" entry
+ * once MCP_TRACE_MAX_TOOLS is reached and the _meta trace object. Prints a
+ * sample self.get_mcp_stats output. Exits non-zero if any check fails.
+ *
+ *   g++ -O2 -std=c++17 -I ../../main -I ../../main/protocols main.cc -o mcp_trace_check
+ *   ./mcp_trace_check
+ */
+#include "mcp_call.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Advanced by hand, never by the wall clock
+struct FakeClock {
+    int64_t now_us = 1000000;
+
+    int64_t Advance(int64_t us) {
+        now_us += us;
+        return now_us;
+    }
+};
+
+// A tool and what each phase of a call to it costs, in microseconds
+struct FakeTool {
+    const char* name;
+    int64_t parse_us;
+    int64_t queue_us;
+    int64_t run_us;
+    int64_t reply_us;
+    bool fails;
+};
+
+// Trace points in the order McpServer::DoToolCall / RunCall / RecordTrace set them
+static McpTrace RunFakeCall(FakeClock& clock, McpTracer& tracer, int id, const FakeTool& tool, bool cancel = false) {
+    McpCall call(id, "", [](const std::string&) {});
+    auto& trace = call.trace();
+    trace.tool = tool.name;
+    trace.Mark(kMcpTraceReceived, clock.now_us);
+    trace.Mark(kMcpTraceParsed, clock.Advance(tool.parse_us));
+    trace.Mark(kMcpTraceScheduled, clock.Advance(10));
+    trace.Mark(kMcpTraceStarted, clock.Advance(tool.queue_us));
+    if (cancel) {
+        call.Cancel();
+    }
+    trace.Mark(kMcpTraceFinished, clock.Advance(tool.run_us));
+    trace.error = tool.fails;
+    trace.Mark(kMcpTraceReplied, clock.Advance(tool.reply_us));
+    trace.cancelled = call.cancelled();
+    tracer.Record(trace);
+    clock.Advance(1000);
+    return trace;
+}
+
+static bool Check(bool ok, const char* what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static bool Contains(const std::string& json, const std::string& needle) {
+    return json.find(needle) != std::string::npos;
+}
+
+int main() {
+    bool ok = true;
+    FakeClock clock;
+    McpTracer tracer;
+
+    const FakeTool i2c = {"vehicle.get_sensors", 150, 2000, 4000, 300, false};
+    const FakeTool servo = {"storage.open_door", 150, 30000, 120000, 300, false};
+    const FakeTool upload = {"telegram.send_photo", 400, 500, 1800000, 2500, false};
+    const FakeTool broken = {"vehicle.move", 150, 800, 1000, 200, true};
+
+    auto trace = RunFakeCall(clock, tracer, 1, servo);
+    ok &= Check(trace.Span(kMcpTraceReceived, kMcpTraceParsed) == 150 &&
+            trace.Span(kMcpTraceScheduled, kMcpTraceStarted) == 30000 &&
+            trace.Span(kMcpTraceStarted, kMcpTraceFinished) == 120000 &&
+            trace.Span(kMcpTraceFinished, kMcpTraceReplied) == 300,
+        "spans match the fake tool's costs");
+    ok &= Check(trace.Span(kMcpTraceReceived, kMcpTraceReplied) == 150 + 10 + 30000 + 120000 + 300,
+        "total covers receive to reply");
+
+    // _meta trace as written into a result, before the reply point is known
+    McpTrace partial = trace;
+    partial.at[kMcpTraceReplied] = 0;
+    char buffer[256];
+    JsonWriter json(buffer, sizeof(buffer));
+    partial.Write(json);
+    ok &= Check(json.view() == "{\"parse_us\":150,\"queue_us\":30000,\"run_us\":120000}",
+        "_meta trace leaves out reply and total until replied");
+
+    for (int i = 0; i < 10; i++) {
+        RunFakeCall(clock, tracer, 100 + i, i2c);
+    }
+    RunFakeCall(clock, tracer, 200, upload);
+    RunFakeCall(clock, tracer, 201, upload, true);
+    RunFakeCall(clock, tracer, 300, broken);
+
+    std::string stats = tracer.GetStatsJson();
+    ok &= Check(stats != "{}", "stats fit their buffer");
+    ok &= Check(Contains(stats, "\"calls\":14"), "every call counted");
+    // i2c: 6.46 ms end to end -> first bucket (< 10 ms)
+    ok &= Check(Contains(stats, "\"tool\":\"vehicle.get_sensors\",\"count\":10,\"errors\":0,\"cancelled\":0,"
+                                "\"avg_parse_us\":150,\"avg_queue_us\":2000,\"avg_run_us\":4000,\"avg_reply_us\":300,"
+                                "\"max_us\":6460,\"histogram\":[10,0,0,0,0,0]"),
+        "i2c tool: averages and histogram");
+    // servo: 150.46 ms -> 50..200 ms bucket
+    ok &= Check(Contains(stats, "\"tool\":\"storage.open_door\",\"count\":1") &&
+            Contains(stats, "\"max_us\":150460,\"histogram\":[0,0,1,0,0,0]"),
+        "servo tool lands in the 50-200 ms bucket");
+    // upload: 1.8 s -> 1..5 s bucket, one of two cancelled
+    ok &= Check(Contains(stats, "\"tool\":\"telegram.send_photo\",\"count\":2,\"errors\":0,\"cancelled\":1") &&
+            Contains(stats, "\"histogram\":[0,0,0,0,2,0]"),
+        "upload tool: slow bucket and cancellation");
+    ok &= Check(Contains(stats, "\"tool\":\"vehicle.move\",\"count\":1,\"errors\":1"), "failed call counted as error");
+    ok &= Check(Contains(stats, "\"recent\":[{\"id\":300,"), "recent calls newest first");
+    std::string sample = stats;
+
+    // Ring keeps only the last MCP_TRACE_RING_SIZE calls
+    for (int i = 0; i < MCP_TRACE_RING_SIZE * 2; i++) {
+        RunFakeCall(clock, tracer, 1000 + i, i2c);
+    }
+    stats = tracer.GetStatsJson();
+    int recent = 0;
+    for (size_t pos = 0; (pos = stats.find("\"trace\":", pos)) != std::string::npos; pos++) {
+        recent++;
+    }
+    ok &= Check(recent == MCP_TRACE_RING_SIZE && !Contains(stats, "\"id\":300,") &&
+            Contains(stats, "\"recent\":[{\"id\":" + std::to_string(1000 + MCP_TRACE_RING_SIZE * 2 - 1) + ","),
+        "ring bounded to MCP_TRACE_RING_SIZE");
+
+    // More tools than MCP_TRACE_MAX_TOOLS fold into "other"
+    std::vector<std::string> names;
+    for (int i = 0; i < MCP_TRACE_MAX_TOOLS + 4; i++) {
+        names.push_back("fake.tool_" + std::to_string(i));
+    }
+    for (auto& name : names) {
+        RunFakeCall(clock, tracer, 5000, {name.c_str(), 100, 100, 100, 100, false});
+    }
+    stats = tracer.GetStatsJson();
+    ok &= Check(stats != "{}" && Contains(stats, "\"tool\":\"other\""), "tools past MCP_TRACE_MAX_TOOLS share \"other\"");
+
+    printf("\nself.get_mcp_stats after the first 14 calls:\n%s\n", sample.c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,218 @@
+/*
+ * Host benchmark: per-call argument handling of an MCP tool, the PropertyList
+ * path (copy the tool's list, set each value through the variant, look the
+ * values up by name in the handler) versus typed parameters from
+ * mcp_tool_params.h (read straight into a tuple and applied to the handler).
+ * Both read the same cJSON request object, so only the parse overhead differs.
+ *
+ * Needs cJSON sources (e.g. $IDF_PATH/components/json/cJSON):
+ *
+ *   g++ -O2 -std=c++17 -I ../../main -I $CJSON_DIR main.cc $CJSON_DIR/cJSON.c \
+ *       -o mcp_typed_params_bench
+ */
+#include "mcp_tool_params.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <variant>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static size_t g_allocations = 0;
+
+void* operator new(size_t size) {
+    g_allocations++;
+    if (void* p = malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+// Property and PropertyList as in mcp_server.h, schema parts left out
+enum PropertyType { kPropertyTypeBoolean, kPropertyTypeInteger, kPropertyTypeString };
+
+class Property {
+public:
+    Property(const std::string& name, PropertyType type) : name_(name), type_(type), has_default_value_(false) {}
+    template <typename T>
+    Property(const std::string& name, PropertyType type, const T& default_value)
+        : name_(name), type_(type), has_default_value_(true) {
+        value_ = default_value;
+    }
+    Property(const std::string& name, PropertyType type, int min_value, int max_value)
+        : name_(name), type_(type), has_default_value_(false), min_value_(min_value), max_value_(max_value) {}
+
+    const std::string& name() const { return name_; }
+    PropertyType type() const { return type_; }
+    bool has_default_value() const { return has_default_value_; }
+
+    template <typename T>
+    T value() const {
+        return std::get<T>(value_);
+    }
+
+    template <typename T>
+    void set_value(const T& value) {
+        if constexpr (std::is_same_v<T, int>) {
+            if (min_value_.has_value() && value < min_value_.value()) {
+                throw std::invalid_argument("Value is below minimum allowed: " + std::to_string(min_value_.value()));
+            }
+            if (max_value_.has_value() && value > max_value_.value()) {
+                throw std::invalid_argument("Value exceeds maximum allowed: " + std::to_string(max_value_.value()));
+            }
+        }
+        value_ = value;
+    }
+
+private:
+    std::string name_;
+    PropertyType type_;
+    std::variant<bool, int, std::string> value_;
+    bool has_default_value_;
+    std::optional<int> min_value_;
+    std::optional<int> max_value_;
+};
+
+class PropertyList {
+public:
+    PropertyList(const std::vector<Property>& properties) : properties_(properties) {}
+
+    const Property& operator[](const std::string& name) const {
+        for (const auto& property : properties_) {
+            if (property.name() == name) {
+                return property;
+            }
+        }
+        throw std::runtime_error("Property not found: " + name);
+    }
+
+    auto begin() { return properties_.begin(); }
+    auto end() { return properties_.end(); }
+
+private:
+    std::vector<Property> properties_;
+};
+
+// Previous McpServer::DoToolCall argument loop
+static PropertyList ParsePropertyList(const PropertyList& schema, const cJSON* arguments) {
+    PropertyList properties = schema;
+    for (auto& property : properties) {
+        bool found = false;
+        auto value = cJSON_GetObjectItem(arguments, property.name().c_str());
+        if (property.type() == kPropertyTypeBoolean && cJSON_IsBool(value)) {
+            property.set_value<bool>(value->valueint == 1);
+            found = true;
+        } else if (property.type() == kPropertyTypeInteger && cJSON_IsNumber(value)) {
+            property.set_value<int>(value->valueint);
+            found = true;
+        } else if (property.type() == kPropertyTypeString && cJSON_IsString(value)) {
+            property.set_value<std::string>(value->valuestring);
+            found = true;
+        }
+        if (!property.has_default_value() && !found) {
+            throw std::runtime_error("Missing valid argument: " + property.name());
+        }
+    }
+    return properties;
+}
+
+static size_t g_sink = 0;
+
+struct Case {
+    const char* name;
+    cJSON* arguments;
+    std::function<void()> property_list;
+    std::function<void()> typed;
+};
+
+template <typename Fn>
+static void Measure(const char* label, Fn&& fn, int iterations) {
+    size_t allocations = g_allocations;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        fn();
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+    printf("  %-13s %7.1f ns/call  %5.1f allocs/call\n", label, ns, (double)(g_allocations - allocations) / iterations);
+}
+
+int main() {
+    const int kIterations = 200000;
+
+    // self.audio_speaker.set_volume
+    cJSON* volume_arguments = cJSON_CreateObject();
+    cJSON_AddNumberToObject(volume_arguments, "volume", 60);
+    PropertyList volume_schema({Property("volume", kPropertyTypeInteger, 0, 100)});
+    auto volume_params = McpParams(McpInt("volume", 0, 100));
+
+    // vehicle.move
+    cJSON* move_arguments = cJSON_CreateObject();
+    cJSON_AddStringToObject(move_arguments, "direction", "forward");
+    cJSON_AddNumberToObject(move_arguments, "distance_mm", 800);
+    PropertyList move_schema({Property("direction", kPropertyTypeString),
+                              Property("distance_mm", kPropertyTypeInteger, 500),
+                              Property("speed", kPropertyTypeInteger, 50)});
+    auto move_params = McpParams(McpString("direction"), McpIntDefault("distance_mm", 500), McpIntDefault("speed", 50));
+
+    // storage.store_item
+    cJSON* store_arguments = cJSON_CreateObject();
+    cJSON_AddStringToObject(store_arguments, "item_name", "charger");
+    cJSON_AddStringToObject(store_arguments, "location", "slot_2");
+    cJSON_AddStringToObject(store_arguments, "description", "usb-c, the white one");
+    PropertyList store_schema({Property("item_name", kPropertyTypeString),
+                               Property("location", kPropertyTypeString),
+                               Property("description", kPropertyTypeString, std::string())});
+    auto store_params = McpParams(McpString("item_name"), McpString("location"), McpString("description", ""));
+
+    auto set_volume = [](int volume) { g_sink += volume; };
+    auto move = [](const std::string& direction, int distance_mm, int speed) {
+        g_sink += direction.size() + distance_mm + speed;
+    };
+    auto store = [](const std::string& item_name, const std::string& location, const std::string& description) {
+        g_sink += item_name.size() + location.size() + description.size();
+    };
+
+    std::vector<Case> cases = {
+        {"set_volume", volume_arguments,
+            [&]() {
+                auto properties = ParsePropertyList(volume_schema, volume_arguments);
+                set_volume(properties["volume"].value<int>());
+            },
+            [&]() { std::apply(set_volume, McpParseArguments(volume_arguments, volume_params)); }},
+        {"vehicle.move", move_arguments,
+            [&]() {
+                auto properties = ParsePropertyList(move_schema, move_arguments);
+                move(properties["direction"].value<std::string>(), properties["distance_mm"].value<int>(),
+                    properties["speed"].value<int>());
+            },
+            [&]() { std::apply(move, McpParseArguments(move_arguments, move_params)); }},
+        {"store_item", store_arguments,
+            [&]() {
+                auto properties = ParsePropertyList(store_schema, store_arguments);
+                store(properties["item_name"].value<std::string>(), properties["location"].value<std::string>(),
+                    properties["description"].value<std::string>());
+            },
+            [&]() { std::apply(store, McpParseArguments(store_arguments, store_params)); }},
+    };
+
+    for (auto& c : cases) {
+        printf("%s\n", c.name);
+        Measure("PropertyList", c.property_list, kIterations);
+        Measure("typed", c.typed, kIterations);
+        cJSON_Delete(c.arguments);
+    }
+    return g_sink > 0 ? 0 : 1;
+}
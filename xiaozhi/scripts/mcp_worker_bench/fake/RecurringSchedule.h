@@ -0,0 +1,19 @@
+#ifndef RECURRING_SCHEDULE_H
+#define RECURRING_SCHEDULE_H
+
+#include <cstdint>
+#include <string>
+
+// Stand-in for xiaozhi/main/RecurringSchedule.h: nothing is scheduled
+class RecurringSchedule {
+public:
+    static RecurringSchedule& GetInstance() {
+        static RecurringSchedule instance;
+        return instance;
+    }
+    bool addOnceAfterDelay(int, uint32_t, const std::string&, bool = true) { return false; }
+    bool removeSchedule(int, bool = true) { return false; }
+    std::string getSchedulesJSON() { return "[]"; }
+};
+
+#endif // RECURRING_SCHEDULE_H
@@ -0,0 +1,76 @@
+#ifndef _APPLICATION_H_
+#define _APPLICATION_H_
+
+/*
+ * Stand-in for xiaozhi/main/application.h. The main loop is a TaskScheduler
+ * the bench runs on its own thread; MCP messages are rendered like
+ * Protocol::SendMcpMessage does and handed to a callback.
+ */
+#include "json_writer.h"
+#include "task_scheduler.h"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+
+class Ota {};
+
+class Application {
+public:
+    static Application& GetInstance() {
+        static Application instance;
+        return instance;
+    }
+
+    template <typename F>
+    void Schedule(F&& callback, TaskSource source = TaskSource::Here()) {
+        Schedule(kTaskLaneNormal, std::forward<F>(callback), 0, source);
+    }
+    template <typename F>
+    void Schedule(TaskLane lane, F&& callback, uint32_t deadline_ms = 0, TaskSource source = TaskSource::Here()) {
+        main_tasks_.Post(lane, std::forward<F>(callback), esp_timer_get_time(), deadline_ms, source);
+    }
+    TaskScheduler& main_tasks() { return main_tasks_; }
+
+    void SendMcpMessage(const std::string& payload) {
+        SendMcpMessage(payload.size(), [&payload](JsonWriter& json) { json.Raw(payload); });
+    }
+    void SendMcpMessage(size_t payload_size, const std::function<void(JsonWriter&)>& write_payload) {
+        std::string message(payload_size + 64, '\0');
+        JsonWriter json(message.data(), message.size());
+        json.BeginObject().Field("type", "mcp").Key("payload");
+        write_payload(json);
+        json.EndObject();
+        message.resize(json.size());
+        if (on_mcp_message) {
+            on_mcp_message(message);
+        }
+    }
+    // Set before the first call, replies come from the main loop and the workers
+    std::function<void(const std::string&)> on_mcp_message;
+
+    // Used by tools the bench does not call
+    void Reboot() {}
+    bool UpgradeFirmware(Ota&, const std::string& = "") { return false; }
+    void SendTelegramMessage(const std::string&) {}
+    std::string GetTelegramMsgBufferAsJson() const { return "[]"; }
+    std::string getHeartRate() { return ""; }
+    bool StartSensorReporting(int) { return false; }
+    void StopSensorReporting() {}
+    bool IsSensorReportingEnabled() const { return false; }
+    int GetSensorReportInterval() const { return 0; }
+
+private:
+    TaskScheduler main_tasks_;
+};
+
+class TaskPriorityReset {
+public:
+    TaskPriorityReset(BaseType_t) {}
+};
+
+#endif // _APPLICATION_H_
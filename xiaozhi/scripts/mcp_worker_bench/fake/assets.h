@@ -0,0 +1,14 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+// Stand-in for xiaozhi/main/assets.h: no assets partition
+class Assets {
+public:
+    static Assets& GetInstance() {
+        static Assets instance;
+        return instance;
+    }
+    bool partition_valid() const { return false; }
+};
+
+#endif // ASSETS_H
@@ -0,0 +1,50 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include "display.h"
+
+#include <cstdint>
+#include <string>
+
+// Stand-in for boards/common/board.h: a board without display, backlight or
+// camera
+
+#define BOARD_NAME "mcp-worker-bench"
+
+class AudioCodec {
+public:
+    void SetOutputVolume(int) {}
+};
+
+class Backlight {
+public:
+    void SetBrightness(uint8_t, bool = false) {}
+};
+
+class Camera {
+public:
+    virtual ~Camera() = default;
+    virtual bool Capture() { return false; }
+    virtual std::string Explain(const std::string&) { return ""; }
+    virtual void SetExplainUrl(const std::string&, const std::string&) {}
+};
+
+class Board {
+public:
+    static Board& GetInstance() {
+        static Board instance;
+        return instance;
+    }
+    virtual ~Board() = default;
+    std::string GetDeviceStatusJson() { return "{}"; }
+    std::string GetSystemInfoJson() { return "{}"; }
+    AudioCodec* GetAudioCodec() { return &codec_; }
+    Backlight* GetBacklight() { return nullptr; }
+    Display* GetDisplay() { return nullptr; }
+    Camera* GetCamera() { return nullptr; }
+
+private:
+    AudioCodec codec_;
+};
+
+#endif // BOARD_H
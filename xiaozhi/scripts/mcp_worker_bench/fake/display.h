@@ -0,0 +1,20 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+// Stand-in for display/display.h, Board::GetDisplay() returns nullptr
+class Theme {
+public:
+    virtual ~Theme() = default;
+};
+
+class Display {
+public:
+    virtual ~Display() = default;
+    virtual void SetTheme(Theme* theme) { theme_ = theme; }
+    virtual Theme* GetTheme() { return theme_; }
+
+private:
+    Theme* theme_ = nullptr;
+};
+
+#endif // DISPLAY_H
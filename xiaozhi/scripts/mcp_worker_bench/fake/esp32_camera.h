@@ -0,0 +1,21 @@
+#ifndef ESP32_CAMERA_H
+#define ESP32_CAMERA_H
+
+#include "board.h"
+
+#include <string>
+
+// Stand-in for boards/common/esp32_camera.h
+struct TelegramPhotoInfo {
+    std::string caption;
+    std::string parse_mode;
+    std::string bot_token;
+    std::string chat_id;
+};
+
+class Esp32Camera : public Camera {
+public:
+    void SendPhotoToTelegram(const TelegramPhotoInfo&) {}
+};
+
+#endif // ESP32_CAMERA_H
@@ -0,0 +1,13 @@
+#ifndef BENCH_ESP_APP_DESC_H
+#define BENCH_ESP_APP_DESC_H
+
+typedef struct {
+    char version[32];
+} esp_app_desc_t;
+
+inline const esp_app_desc_t* esp_app_get_description() {
+    static const esp_app_desc_t desc = {"bench"};
+    return &desc;
+}
+
+#endif // BENCH_ESP_APP_DESC_H
@@ -0,0 +1,6 @@
+#ifndef BENCH_ESP_PTHREAD_H
+#define BENCH_ESP_PTHREAD_H
+
+// Nothing in mcp_server.cc uses it on the host
+
+#endif // BENCH_ESP_PTHREAD_H
@@ -0,0 +1,13 @@
+#ifndef LVGL_DISPLAY_H
+#define LVGL_DISPLAY_H
+
+#include "display.h"
+
+// Stand-in for display/lvgl_display/lvgl_display.h
+class LvglDisplay : public Display {
+public:
+    int width() const { return 0; }
+    int height() const { return 0; }
+};
+
+#endif // LVGL_DISPLAY_H
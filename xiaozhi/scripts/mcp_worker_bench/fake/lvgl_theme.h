@@ -0,0 +1,20 @@
+#ifndef LVGL_THEME_H
+#define LVGL_THEME_H
+
+#include "display.h"
+
+#include <string>
+
+// Stand-in for display/lvgl_display/lvgl_theme.h: no themes
+class LvglTheme : public Theme {};
+
+class LvglThemeManager {
+public:
+    static LvglThemeManager& GetInstance() {
+        static LvglThemeManager instance;
+        return instance;
+    }
+    LvglTheme* GetTheme(const std::string&) { return nullptr; }
+};
+
+#endif // LVGL_THEME_H
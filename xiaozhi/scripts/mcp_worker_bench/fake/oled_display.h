@@ -0,0 +1,9 @@
+#ifndef OLED_DISPLAY_H
+#define OLED_DISPLAY_H
+
+#include "lvgl_display.h"
+
+// Stand-in for display/oled_display.h
+class OledDisplay : public LvglDisplay {};
+
+#endif // OLED_DISPLAY_H
@@ -0,0 +1,13 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <string>
+
+// Stand-in for xiaozhi/main/settings.h: nothing is stored
+class Settings {
+public:
+    Settings(const std::string&, bool = false) {}
+    void SetString(const std::string&, const std::string&) {}
+};
+
+#endif // SETTINGS_H
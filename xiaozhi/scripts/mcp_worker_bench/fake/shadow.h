@@ -0,0 +1,16 @@
+#ifndef BENCH_SHADOW_H
+#define BENCH_SHADOW_H
+
+/*
+ * mcp_server.cc includes these by quote from xiaozhi/main, where the real
+ * headers are found before any -I directory. Built with -include shadow.h,
+ * the stand-ins here define the real include guards first and the real
+ * headers are skipped.
+ */
+#include "application.h"
+#include "RecurringSchedule.h"
+#include "assets.h"
+#include "settings.h"
+#include "wifi_board.h"
+
+#endif // BENCH_SHADOW_H
@@ -0,0 +1,21 @@
+#ifndef TELEGRAM_MANAGER_H
+#define TELEGRAM_MANAGER_H
+
+#include <string>
+
+// Stand-in for the Telegram bot manager: not configured
+class TelegramManager {
+public:
+    struct Config {
+        std::string chat_id;
+        std::string bot_token;
+    };
+
+    static TelegramManager& GetInstance() {
+        static TelegramManager instance;
+        return instance;
+    }
+    Config GetConfig() const { return Config(); }
+};
+
+#endif // TELEGRAM_MANAGER_H
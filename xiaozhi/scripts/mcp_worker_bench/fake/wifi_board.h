@@ -0,0 +1,12 @@
+#ifndef WIFI_BOARD_H
+#define WIFI_BOARD_H
+
+#include "board.h"
+
+// Stand-in for boards/common/wifi_board.h
+class WifiBoard : public Board {
+public:
+    void ResetWifiConfiguration() {}
+};
+
+#endif // WIFI_BOARD_H
@@ -0,0 +1,243 @@
+/*
+ * Host benchmark and check: main loop scheduling latency while a slow MCP
+ * tool runs, through the real McpServer (xiaozhi/main/mcp_server.cc). It runs
+ * on the FreeRTOS / esp_timer stand-ins of scripts/i2c_sim and the
+ * Application / board stand-ins in fake/; the main loop is the fake
+ * Application's TaskScheduler, run by this program. A probe posts a short
+ * task every 10 ms (state changes, audio callbacks) and records its wait.
+ * Requests reach McpServer::ParseMessage from their own thread, as the
+ * protocol hands them to Application::OnIncomingJson; they are built as cJSON
+ * trees since the stand-in has no parser. A fake tool sleeps like vehicle.move
+ * or telegram.send_photo do on I2C / HTTPS.
+ *
+ *   main loop: the tool is added with AddTool, its body runs as a background
+ *              task on the main loop
+ *   workers:   the tool is added with AddBlockingTool and runs on the worker
+ *              pool (MCP_TOOL_WORKER_COUNT, MCP_TOOL_WORKER_QUEUE_SIZE,
+ *              per-tool concurrency 1). A call to the tool while it runs
+ *              waits in the queue for its slot.
+ *
+ * Then checks tool groups: two tools in one McpToolGroup never run at the
+ * same time, while a tool outside the group runs beside them. Exits non-zero
+ * if a worker call is rejected or never answered, if the probe waits as long
+ * as the tool on the worker path, or if the group check fails.
+ *
+ *   g++ -O2 -std=c++17 -pthread -DHAVE_LVGL -I fake -I ../i2c_sim/fake -I ../../main \
+ *       -I ../../main/actuator -I ../../main/protocols -include fake/shadow.h \
+ *       main.cc ../../main/mcp_server.cc ../../main/StorageManager.cc ../../main/VehicleController.cc \
+ *       ../../main/I2CCommandBridge.cc ../../main/telemetry.cc ../i2c_sim/sim_bus.cc \
+ *       ../i2c_sim/fake/freertos.cc ../i2c_sim/fake/esp_idf.cc ../i2c_sim/fake/distance_sensor.cc \
+ *       -o mcp_worker_bench
+ *   ./mcp_worker_bench [tool ms]
+ */
+#include "application.h"
+#include "mcp_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static int64_t NowUs() {
+    return esp_timer_get_time();
+}
+
+static bool Check(bool ok, const char* what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+struct Reply {
+    int64_t time_us;
+    bool error;
+};
+
+// Replies by request id, from the main loop and the workers
+static std::mutex replies_mutex;
+static std::map<int, Reply> replies;
+
+static void OnMcpMessage(const std::string& message) {
+    const char* id = strstr(message.c_str(), "\"id\":");
+    if (id == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(replies_mutex);
+    replies[atoi(id + 5)] = Reply{NowUs(), message.find("\"error\"") != std::string::npos};
+}
+
+static bool WaitReplies(const std::vector<int>& ids, int timeout_ms) {
+    auto end = Clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (Clock::now() < end) {
+        {
+            std::lock_guard<std::mutex> lock(replies_mutex);
+            if (std::all_of(ids.begin(), ids.end(), [](int id) { return replies.count(id) != 0; })) {
+                return true;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+static void CallTool(int id, const char* name) {
+    cJSON* request = cJSON_CreateObject();
+    cJSON_AddStringToObject(request, "jsonrpc", "2.0");
+    cJSON_AddNumberToObject(request, "id", id);
+    cJSON_AddStringToObject(request, "method", "tools/call");
+    cJSON* params = cJSON_CreateObject();
+    cJSON_AddStringToObject(params, "name", name);
+    cJSON_AddItemToObject(params, "arguments", cJSON_CreateObject());
+    cJSON_AddItemToObject(request, "params", params);
+    McpServer::GetInstance().ParseMessage(request);
+    cJSON_Delete(request);
+}
+
+// The main loop: one consumer of the scheduler, like Application::MainEventLoop
+class MainLoop {
+public:
+    MainLoop() : thread_([this]() { Run(); }) {}
+    ~MainLoop() {
+        stop_.store(true);
+        thread_.join();
+    }
+
+private:
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+
+    void Run() {
+        auto& tasks = Application::GetInstance().main_tasks();
+        while (!stop_.load()) {
+            if (!tasks.RunNext(NowUs())) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+        while (tasks.RunNext(NowUs())) {
+        }
+    }
+};
+
+static bool Run(bool workers, int tool_ms, int first_id) {
+    auto& app = Application::GetInstance();
+    const char* tool = workers ? "bench.slow_worker" : "bench.slow_main";
+    auto before = app.main_tasks().stats(kTaskLaneNormal);
+    std::atomic<bool> stop{false};
+    std::mutex waits_mutex;
+    std::vector<int64_t> waits;
+    waits.reserve(10000);
+    std::vector<int> ids;
+
+    MainLoop main_loop;
+    int64_t first_call_us = NowUs();
+    std::thread probe([&]() {
+        while (!stop.load()) {
+            int64_t posted = NowUs();
+            app.Schedule([&waits_mutex, &waits, posted]() {
+                std::lock_guard<std::mutex> lock(waits_mutex);
+                waits.push_back(NowUs() - posted);
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+    for (int i = 0; i < 3; i++) {
+        ids.push_back(first_id + i);
+        CallTool(first_id + i, tool);
+        std::this_thread::sleep_for(std::chrono::milliseconds(tool_ms * 2 / 3));
+    }
+    bool answered = WaitReplies(ids, tool_ms * 4);
+    stop.store(true);
+    probe.join();
+
+    int replied = 0, rejected = 0;
+    int64_t last_reply_us = 0;
+    {
+        std::lock_guard<std::mutex> lock(replies_mutex);
+        for (int id : ids) {
+            auto reply = replies.find(id);
+            if (reply == replies.end()) {
+                continue;
+            }
+            reply->second.error ? rejected++ : replied++;
+            last_reply_us = std::max(last_reply_us, reply->second.time_us);
+        }
+    }
+    std::lock_guard<std::mutex> lock(waits_mutex);
+    std::sort(waits.begin(), waits.end());
+    size_t n = waits.size();
+    auto normal = app.main_tasks().stats(kTaskLaneNormal);
+    printf("%-9s probe %4zu tasks, wait p50 %8.2f ms  p99 %8.2f ms  max %8.2f ms, deadline misses %u, "
+           "tool replies %d rejected %d, last reply %.0f ms after the first call\n",
+           workers ? "workers" : "main loop", n, waits[n / 2] / 1000.0, waits[n * 99 / 100] / 1000.0,
+           waits.back() / 1000.0, normal.deadline_misses - before.deadline_misses, replied, rejected,
+           (last_reply_us - first_call_us) / 1000.0);
+    if (!workers) {
+        return true;
+    }
+    bool ok = Check(answered && replied == 3, "workers: every call answered, none rejected");
+    ok &= Check(waits.back() < (int64_t)tool_ms * 1000 / 2, "workers: the probe never waits for the tool");
+    return ok;
+}
+
+static const int kGroupToolMs = 200;
+
+// Two tools of one group and one outside it, called back to back
+static bool CheckGroups(int first_id) {
+    MainLoop main_loop;
+    CallTool(first_id, "bench.group_a");
+    CallTool(first_id + 1, "bench.group_b");
+    CallTool(first_id + 2, "bench.free");
+    bool answered = WaitReplies({first_id, first_id + 1, first_id + 2}, kGroupToolMs * 10);
+
+    Reply a, b, free;
+    {
+        std::lock_guard<std::mutex> lock(replies_mutex);
+        a = replies[first_id];
+        b = replies[first_id + 1];
+        free = replies[first_id + 2];
+    }
+    bool ok = Check(answered && !a.error && !b.error && !free.error, "groups: every call answered");
+    ok &= Check(std::abs(b.time_us - a.time_us) >= kGroupToolMs * 900, "groups: tools of one group run one at a time");
+    ok &= Check(free.time_us < std::max(a.time_us, b.time_us), "groups: a tool outside the group runs beside it");
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    int tool_ms = argc > 1 ? atoi(argv[1]) : 1500;
+    auto& app = Application::GetInstance();
+    auto& server = McpServer::GetInstance();
+    app.on_mcp_message = OnMcpMessage;
+
+    auto slow = [tool_ms](const PropertyList&) -> ReturnValue {
+        std::this_thread::sleep_for(std::chrono::milliseconds(tool_ms));
+        return true;
+    };
+    server.AddTool("bench.slow_main", "Sleeps on the main loop", PropertyList(), slow);
+    server.AddBlockingTool("bench.slow_worker", "Sleeps on a worker", PropertyList(), slow);
+
+    static McpToolGroup group;
+    auto short_tool = [](const PropertyList&) -> ReturnValue {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kGroupToolMs));
+        return true;
+    };
+    server.AddBlockingTool("bench.group_a", "Sleeps in the group", PropertyList(), short_tool, 1, &group);
+    server.AddBlockingTool("bench.group_b", "Sleeps in the group", PropertyList(), short_tool, 1, &group);
+    server.AddBlockingTool("bench.free", "Sleeps outside the group", PropertyList(), short_tool);
+
+    printf("fake tool %d ms, called 3 times\n", tool_ms);
+    bool ok = Run(false, tool_ms, 100);
+    ok &= Run(true, tool_ms, 200);
+    ok &= CheckGroups(300);
+
+    // The MCP workers never exit, leave without tearing them down
+    fflush(stdout);
+    _exit(ok ? 0 : 1);
+}
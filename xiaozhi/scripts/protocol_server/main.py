@@ -0,0 +1,971 @@
+'''
+  Local stand-in for the xiaozhi cloud backend.
+
+  serve: OTA endpoint + minimal MQTT 3.1.1 broker + AES-CTR UDP audio endpoint
+         + WebSocket endpoint. Implements hello/goodbye/listen/abort/tts flow,
+         echoes uplink audio back as TTS and reports per-session metrics.
+         --mcp-bench N times N sequential MCP tools/call against one batch.
+  bench: host-side client that speaks the same wire format as MqttProtocol /
+         WebsocketProtocol and measures channel-open latency, packets/sec,
+         CPU per packet and reconnect time against a running server.
+  channel: wake-to-channel-ready time for the cold, warm (parked channel)
+         and resumed (session id after a drop) OpenAudioChannel paths,
+         with --rtt-ms charged per round trip the device waits on.
+  abort: emulates the device send path on a throttled uplink and measures
+         abort -> tts stop latency with a single FIFO versus the SendScheduler
+         policy (control lane first, bounded audio backlog, drop oldest).
+'''
+import argparse
+import asyncio
+import json
+import os
+import socket
+import struct
+import time
+import uuid
+
+from cryptography.hazmat.primitives.ciphers import Cipher, algorithms, modes
+
+try:
+    import websockets
+except ImportError:
+    websockets = None
+
+
+def aes_ctr(key, nonce, data):
+    encryptor = Cipher(algorithms.AES(key), modes.CTR(nonce)).encryptor()
+    return encryptor.update(data) + encryptor.finalize()
+
+
+def local_ip():
+    s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    try:
+        s.connect(('8.8.8.8', 80))
+        return s.getsockname()[0]
+    except OSError:
+        return '127.0.0.1'
+    finally:
+        s.close()
+
+
+class Stats:
+    def __init__(self, name):
+        self.name = name
+        self.rx_packets = 0
+        self.rx_bytes = 0
+        self.tx_packets = 0
+        self.first_rx = None
+        self.last_rx = None
+
+    def on_rx(self, size):
+        now = time.monotonic()
+        if self.first_rx is None:
+            self.first_rx = now
+        self.last_rx = now
+        self.rx_packets += 1
+        self.rx_bytes += size
+
+    def pps(self):
+        if self.first_rx is None or self.last_rx == self.first_rx:
+            return 0.0
+        return (self.rx_packets - 1) / (self.last_rx - self.first_rx)
+
+    def report(self):
+        print(f"[{self.name}] rx {self.rx_packets} packets / {self.rx_bytes} bytes, "
+              f"{self.pps():.1f} pkt/s, tx {self.tx_packets} packets")
+
+
+class Session:
+    '''One audio channel (between hello and goodbye)'''
+
+    def __init__(self, transport, sample_rate, frame_duration):
+        self.session_id = uuid.uuid4().hex[:16]
+        self.transport = transport
+        self.sample_rate = sample_rate
+        self.frame_duration = frame_duration
+        self.key = os.urandom(16)
+        self.ssrc = os.urandom(4)
+        self.nonce = b'\x01\x00\x00\x00' + self.ssrc + b'\x00' * 8
+        self.udp_addr = None
+        self.remote_sequence = 0
+        self.local_sequence = 0
+        self.frames = []
+        self.hello_time = time.monotonic()
+        self.open_latency = None
+        self.stats = Stats(f"{transport} {self.session_id}")
+        self.tts_task = None
+        self.detached_at = None
+        self.kind = 'cold'
+        self.mcp_pending = {}
+        self.mcp_next_id = 10000
+
+    def mark_opened(self):
+        # The device sends its first control message (listen/start or detect)
+        # right after OpenAudioChannel() returns, so hello -> first message
+        # covers the whole channel-open path on the device.
+        if self.open_latency is None:
+            self.open_latency = (time.monotonic() - self.hello_time) * 1000
+            print(f"[{self.transport}] session {self.session_id} channel open latency ({self.kind}) {self.open_latency:.1f} ms")
+
+
+class ProtocolServer:
+    def __init__(self, args):
+        self.args = args
+        self.host = args.advertise or local_ip()
+        self.sessions = {}
+        self.sessions_by_ssrc = {}
+        self.udp_transport = None
+        self.disconnect_times = {}
+
+    # ---------------------------------------------------------------- OTA
+    def ota_response(self, client_id):
+        response = {
+            'server_time': {'timestamp': int(time.time() * 1000), 'timezone_offset': 0},
+            'firmware': {'version': '0.0.0', 'url': ''},
+            'mqtt': {
+                'endpoint': f"{self.host}:{self.args.mqtt_port}",
+                'client_id': client_id or 'xiaozhi-local',
+                'username': 'local',
+                'password': 'local',
+                'publish_topic': 'device-server',
+                'keepalive': self.args.keepalive,
+            },
+            'websocket': {
+                'url': f"ws://{self.host}:{self.args.ws_port}/xiaozhi/v1/",
+                'token': 'local',
+                'version': self.args.ws_version,
+            },
+        }
+        if self.args.idle_window > 0:
+            response['mqtt']['idle_window'] = self.args.idle_window
+            response['websocket']['idle_window'] = self.args.idle_window
+        return response
+
+    async def handle_http(self, reader, writer):
+        try:
+            head = await reader.readuntil(b'\r\n\r\n')
+            lines = head.decode(errors='replace').split('\r\n')
+            headers = {}
+            for line in lines[1:]:
+                if ':' in line:
+                    k, v = line.split(':', 1)
+                    headers[k.strip().lower()] = v.strip()
+            length = int(headers.get('content-length', 0))
+            if length:
+                await reader.readexactly(length)
+            body = json.dumps(self.ota_response(headers.get('client-id'))).encode()
+            writer.write(b'HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n'
+                         + f"Content-Length: {len(body)}\r\nConnection: close\r\n\r\n".encode() + body)
+            await writer.drain()
+            print(f"[ota] {lines[0]} from {headers.get('device-id')}")
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            writer.close()
+
+    # --------------------------------------------------------- control flow
+    def open_session(self, transport, hello, current):
+        # A hello carrying the id of a live or recently dropped session resumes it
+        session = self.sessions.get(hello.get('session_id'))
+        if session is not None and session.transport == transport and (
+                session.detached_at is None or time.monotonic() - session.detached_at < self.args.resume_seconds):
+            session.kind = 'resumed'
+            session.detached_at = None
+            session.hello_time = time.monotonic()
+            session.open_latency = None
+            session.remote_sequence = 0
+            session.local_sequence = 0
+            return session
+        if current is not None:
+            self.close_session(current)
+        session = Session(transport, self.args.sample_rate, 60)
+        self.sessions[session.session_id] = session
+        return session
+
+    def server_hello(self, session, hello):
+        params = hello.get('audio_params', {})
+        session.frame_duration = params.get('frame_duration', session.frame_duration)
+        reply = {
+            'type': 'hello',
+            'transport': session.transport,
+            'session_id': session.session_id,
+            'audio_params': {
+                'format': 'opus',
+                'sample_rate': session.sample_rate,
+                'channels': 1,
+                'frame_duration': session.frame_duration,
+            },
+        }
+        if session.transport == 'udp':
+            reply['udp'] = {
+                'server': self.host,
+                'port': self.args.udp_port,
+                'encryption': 'aes-128-ctr',
+                'key': session.key.hex(),
+                'nonce': session.nonce.hex(),
+            }
+            self.sessions_by_ssrc[session.ssrc] = session
+        return reply
+
+    async def play_tts(self, session, send_json, send_audio):
+        # Echo captured uplink frames back as TTS, paced at frame_duration
+        frames, session.frames = session.frames, []
+        await send_json({'session_id': session.session_id, 'type': 'stt', 'text': f"{len(frames)} frames"})
+        await send_json({'session_id': session.session_id, 'type': 'tts', 'state': 'start'})
+        await send_json({'session_id': session.session_id, 'type': 'tts', 'state': 'sentence_start',
+                         'text': f"echo {len(frames)} frames"})
+        start = time.monotonic()
+        for i, frame in enumerate(frames):
+            await send_audio(frame, i * session.frame_duration)
+            delay = start + (i + 1) * session.frame_duration / 1000 - time.monotonic()
+            if delay > 0:
+                await asyncio.sleep(delay)
+        await send_json({'session_id': session.session_id, 'type': 'tts', 'state': 'stop'})
+
+    async def on_control(self, session, message, send_json, send_audio):
+        msg_type = message.get('type')
+        if session is None:
+            print(f"[{msg_type}] ignored, no open session")
+            return
+        session.mark_opened()
+        if msg_type == 'listen':
+            state = message.get('state')
+            if state == 'start':
+                session.frames = []
+                if message.get('mode') != 'manual' and self.args.listen_seconds > 0:
+                    # No VAD here: end the turn after a fixed listening window
+                    async def auto_stop():
+                        await asyncio.sleep(self.args.listen_seconds)
+                        await self.play_tts(session, send_json, send_audio)
+                    session.tts_task = asyncio.ensure_future(auto_stop())
+            elif state == 'stop':
+                if session.tts_task is None or session.tts_task.done():
+                    session.tts_task = asyncio.ensure_future(self.play_tts(session, send_json, send_audio))
+            elif state == 'detect':
+                print(f"[{session.transport}] wake word: {message.get('text')}")
+        elif msg_type == 'abort':
+            if session.tts_task is not None:
+                session.tts_task.cancel()
+            await send_json({'session_id': session.session_id, 'type': 'tts', 'state': 'stop'})
+        elif msg_type == 'mcp':
+            print(f"[mcp] {json.dumps(message.get('payload'))[:200]}")
+            self.on_mcp(session, message.get('payload'))
+
+    # ---------------------------------------------------------------- MCP
+    def on_mcp(self, session, payload):
+        # A batch response is an array, possibly split over several messages
+        responses = payload if isinstance(payload, list) else [payload]
+        for response in responses:
+            if not isinstance(response, dict):
+                continue
+            future = session.mcp_pending.pop(response.get('id'), None)
+            if future is not None and not future.done():
+                future.set_result(response)
+
+    async def mcp_send(self, session, send_json, requests):
+        # Resolves once every request has its response
+        loop = asyncio.get_running_loop()
+        futures = []
+        for request in requests:
+            future = loop.create_future()
+            session.mcp_pending[request['id']] = future
+            futures.append(future)
+        payload = requests if len(requests) > 1 else requests[0]
+        await send_json({'session_id': session.session_id, 'type': 'mcp', 'payload': payload})
+        return await asyncio.wait_for(asyncio.gather(*futures), 30)
+
+    def mcp_call(self, session):
+        session.mcp_next_id += 1
+        return {'jsonrpc': '2.0', 'id': session.mcp_next_id, 'method': 'tools/call',
+                'params': {'name': self.args.mcp_tool, 'arguments': json.loads(self.args.mcp_arguments)}}
+
+    async def mcp_bench(self, session, send_json):
+        n = self.args.mcp_bench
+        try:
+            await self.mcp_send(session, send_json, [self.mcp_call(session)])  # warm up
+            start = time.monotonic()
+            for _ in range(n):
+                await self.mcp_send(session, send_json, [self.mcp_call(session)])
+            sequential = (time.monotonic() - start) * 1000
+            start = time.monotonic()
+            responses = await self.mcp_send(session, send_json, [self.mcp_call(session) for _ in range(n)])
+            batch = (time.monotonic() - start) * 1000
+        except asyncio.TimeoutError:
+            print(f"[mcp] bench timed out, {len(session.mcp_pending)} responses missing")
+            session.mcp_pending.clear()
+            return
+        errors = sum(1 for response in responses if 'error' in response)
+        print(f"[mcp] {n} x {self.args.mcp_tool}: sequential {sequential:.1f} ms, "
+              f"batch {batch:.1f} ms ({errors} errors)")
+
+    def on_audio(self, session, payload):
+        session.stats.on_rx(len(payload))
+        if self.args.mode == 'loopback':
+            return True
+        if len(session.frames) < self.args.max_frames:
+            session.frames.append(payload)
+        return False
+
+    def close_session(self, session):
+        if session is None:
+            return
+        if session.tts_task is not None:
+            session.tts_task.cancel()
+        self.sessions_by_ssrc.pop(session.ssrc, None)
+        self.sessions.pop(session.session_id, None)
+        session.stats.report()
+
+    def detach_session(self, session):
+        # Transport dropped without goodbye, keep the session resumable for a while
+        if session is None:
+            return
+        if session.tts_task is not None:
+            session.tts_task.cancel()
+        session.detached_at = time.monotonic()
+        session.stats.report()
+
+    # ---------------------------------------------------------------- UDP
+    def udp_send(self, session, payload, timestamp):
+        if session.udp_addr is None:
+            return
+        session.local_sequence += 1
+        nonce = bytearray(session.nonce)
+        struct.pack_into('>H', nonce, 2, len(payload))
+        struct.pack_into('>I', nonce, 8, timestamp & 0xffffffff)
+        struct.pack_into('>I', nonce, 12, session.local_sequence)
+        nonce = bytes(nonce)
+        self.udp_transport.sendto(nonce + aes_ctr(session.key, nonce, payload), session.udp_addr)
+        session.stats.tx_packets += 1
+
+    def on_datagram(self, data, addr):
+        if len(data) < 16 or data[0] != 0x01:
+            return
+        session = self.sessions_by_ssrc.get(data[4:8])
+        if session is None:
+            return
+        session.udp_addr = addr
+        sequence = struct.unpack_from('>I', data, 12)[0]
+        if sequence != session.remote_sequence + 1:
+            print(f"[udp] session {session.session_id} sequence {sequence}, expected {session.remote_sequence + 1}")
+        session.remote_sequence = sequence
+        payload = aes_ctr(session.key, data[:16], data[16:])
+        if self.on_audio(session, payload):
+            self.udp_send(session, payload, struct.unpack_from('>I', data, 8)[0])
+
+    # --------------------------------------------------------------- MQTT
+    async def handle_mqtt(self, reader, writer):
+        client_id = None
+        session = None
+
+        async def publish(message):
+            topic = b'server-device'
+            body = struct.pack('>H', len(topic)) + topic + json.dumps(message).encode()
+            writer.write(bytes([0x30]) + encode_remaining_length(len(body)) + body)
+            await writer.drain()
+
+        async def send_audio(payload, timestamp):
+            self.udp_send(session, payload, timestamp)
+
+        try:
+            while True:
+                header = await reader.readexactly(1)
+                length = await decode_remaining_length(reader)
+                body = await reader.readexactly(length) if length else b''
+                packet_type = header[0] >> 4
+                if packet_type == 1:  # CONNECT
+                    name_len = struct.unpack_from('>H', body, 0)[0]
+                    offset = 2 + name_len + 4
+                    id_len = struct.unpack_from('>H', body, offset)[0]
+                    client_id = body[offset + 2:offset + 2 + id_len].decode(errors='replace')
+                    gap = ''
+                    if client_id in self.disconnect_times:
+                        gap = f", reconnect after {(time.monotonic() - self.disconnect_times.pop(client_id)) * 1000:.0f} ms"
+                    print(f"[mqtt] connect {client_id}{gap}")
+                    writer.write(b'\x20\x02\x00\x00')
+                elif packet_type == 3:  # PUBLISH
+                    qos = (header[0] >> 1) & 0x03
+                    topic_len = struct.unpack_from('>H', body, 0)[0]
+                    offset = 2 + topic_len
+                    if qos:
+                        writer.write(b'\x40\x02' + body[offset:offset + 2])
+                        offset += 2
+                    message = json.loads(body[offset:])
+                    if message.get('type') == 'hello':
+                        session = self.open_session('udp', message, session)
+                        await publish(self.server_hello(session, message))
+                        if self.args.mcp_bench > 0:
+                            asyncio.ensure_future(self.mcp_bench(session, publish))
+                    elif message.get('type') == 'goodbye':
+                        self.close_session(session)
+                        session = None
+                    else:
+                        await self.on_control(session, message, publish, send_audio)
+                elif packet_type == 8:  # SUBSCRIBE
+                    granted, offset = b'', 2
+                    while offset < len(body):
+                        offset += 2 + struct.unpack_from('>H', body, offset)[0] + 1
+                        granted += b'\x00'
+                    writer.write(b'\x90' + encode_remaining_length(2 + len(granted)) + body[:2] + granted)
+                elif packet_type == 12:  # PINGREQ
+                    writer.write(b'\xd0\x00')
+                elif packet_type == 14:  # DISCONNECT
+                    break
+                await writer.drain()
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            self.detach_session(session)
+            if client_id is not None:
+                self.disconnect_times[client_id] = time.monotonic()
+                print(f"[mqtt] disconnect {client_id}")
+            writer.close()
+
+    # ---------------------------------------------------------- WebSocket
+    async def handle_ws(self, ws, path=None):
+        request = getattr(ws, 'request', None)
+        headers = request.headers if request is not None else ws.request_headers
+        version = int(headers.get('Protocol-Version', '1'))
+        print(f"[ws] connect {headers.get('Device-Id')} version {version}")
+        session = None
+
+        async def send_json(message):
+            await ws.send(json.dumps(message))
+
+        async def send_audio(payload, timestamp):
+            await ws.send(pack_ws_audio(version, payload, timestamp))
+            session.stats.tx_packets += 1
+
+        try:
+            async for data in ws:
+                if isinstance(data, str):
+                    message = json.loads(data)
+                    if message.get('type') == 'hello':
+                        session = self.open_session('websocket', message, session)
+                        await send_json(self.server_hello(session, message))
+                        if self.args.mcp_bench > 0:
+                            asyncio.ensure_future(self.mcp_bench(session, send_json))
+                    elif session is not None:
+                        await self.on_control(session, message, send_json, send_audio)
+                elif session is not None:
+                    payload, timestamp = unpack_ws_audio(version, data)
+                    if self.on_audio(session, payload):
+                        await send_audio(payload, timestamp)
+        except websockets.ConnectionClosed:
+            pass
+        finally:
+            self.detach_session(session)
+
+    async def run(self):
+        loop = asyncio.get_running_loop()
+        server = self
+
+        class UdpProtocol(asyncio.DatagramProtocol):
+            def datagram_received(self, data, addr):
+                server.on_datagram(data, addr)
+
+        self.udp_transport, _ = await loop.create_datagram_endpoint(
+            UdpProtocol, local_addr=('0.0.0.0', self.args.udp_port))
+        servers = [
+            await asyncio.start_server(self.handle_http, '0.0.0.0', self.args.http_port),
+            await asyncio.start_server(self.handle_mqtt, '0.0.0.0', self.args.mqtt_port),
+        ]
+        print(f"OTA url:  http://{self.host}:{self.args.http_port}/xiaozhi/ota/")
+        print(f"MQTT:     {self.host}:{self.args.mqtt_port}, UDP: {self.host}:{self.args.udp_port}")
+        if websockets is not None:
+            servers.append(await websockets.serve(self.handle_ws, '0.0.0.0', self.args.ws_port))
+            print(f"WebSocket: ws://{self.host}:{self.args.ws_port}/xiaozhi/v1/")
+        else:
+            print("websockets not installed, WebSocket endpoint disabled")
+        await asyncio.gather(*(s.wait_closed() for s in servers))
+
+
+def encode_remaining_length(length):
+    out = bytearray()
+    while True:
+        byte = length % 128
+        length //= 128
+        out.append(byte | 0x80 if length else byte)
+        if not length:
+            return bytes(out)
+
+
+async def decode_remaining_length(reader):
+    multiplier, value = 1, 0
+    while True:
+        byte = (await reader.readexactly(1))[0]
+        value += (byte & 0x7f) * multiplier
+        if not byte & 0x80:
+            return value
+        multiplier *= 128
+
+
+def pack_ws_audio(version, payload, timestamp):
+    # Same layouts as BinaryProtocol2 / BinaryProtocol3 in protocols/protocol.h
+    if version == 2:
+        return struct.pack('>HHIII', 2, 0, 0, timestamp & 0xffffffff, len(payload)) + payload
+    if version == 3:
+        return struct.pack('>BBH', 0, 0, len(payload)) + payload
+    return payload
+
+
+def unpack_ws_audio(version, data):
+    if version == 2:
+        _, _, _, timestamp, size = struct.unpack_from('>HHIII', data, 0)
+        return data[16:16 + size], timestamp
+    if version == 3:
+        _, _, size = struct.unpack_from('>BBH', data, 0)
+        return data[4:4 + size], 0
+    return data, 0
+
+
+# ------------------------------------------------------------------- bench
+class MqttClient:
+    '''Minimal MQTT 3.1.1 client with the same message flow as MqttProtocol'''
+
+    def __init__(self, host, port, client_id):
+        self.host, self.port, self.client_id = host, port, client_id
+        self.messages = asyncio.Queue()
+
+    async def connect(self):
+        self.reader, self.writer = await asyncio.open_connection(self.host, self.port)
+        cid = self.client_id.encode()
+        body = b'\x00\x04MQTT\x04\x02\x00\xf0' + struct.pack('>H', len(cid)) + cid
+        self.writer.write(b'\x10' + encode_remaining_length(len(body)) + body)
+        await self.reader.readexactly(4)
+        self.task = asyncio.ensure_future(self.read_loop())
+
+    async def read_loop(self):
+        try:
+            while True:
+                header = await self.reader.readexactly(1)
+                length = await decode_remaining_length(self.reader)
+                body = await self.reader.readexactly(length) if length else b''
+                if header[0] >> 4 == 3:
+                    topic_len = struct.unpack_from('>H', body, 0)[0]
+                    await self.messages.put(json.loads(body[2 + topic_len:]))
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+
+    async def send(self, message):
+        topic = b'device-server'
+        body = struct.pack('>H', len(topic)) + topic + json.dumps(message).encode()
+        self.writer.write(b'\x30' + encode_remaining_length(len(body)) + body)
+        await self.writer.drain()
+
+    async def close(self):
+        self.writer.write(b'\xe0\x00')
+        await self.writer.drain()
+        self.task.cancel()
+        self.writer.close()
+
+
+async def wait_type(queue, msg_type, timeout=10):
+    while True:
+        message = await asyncio.wait_for(queue.get(), timeout)
+        if message.get('type') == msg_type:
+            return message
+
+
+async def bench_udp(args, frame):
+    loop = asyncio.get_running_loop()
+    client = MqttClient(args.host, args.mqtt_port, 'bench-' + uuid.uuid4().hex[:8])
+    open_latencies = []
+    for _ in range(args.iterations):
+        start = time.perf_counter()
+        await client.connect()
+        await client.send({'type': 'hello', 'version': 3, 'transport': 'udp',
+                           'features': {'mcp': True},
+                           'audio_params': {'format': 'opus', 'sample_rate': 16000, 'channels': 1,
+                                            'frame_duration': args.frame_duration}})
+        hello = await wait_type(client.messages, 'hello')
+        udp = hello['udp']
+        key, nonce_template = bytes.fromhex(udp['key']), bytes.fromhex(udp['nonce'])
+        received = asyncio.Queue()
+
+        class UdpProtocol(asyncio.DatagramProtocol):
+            def datagram_received(self, data, addr):
+                received.put_nowait(aes_ctr(key, data[:16], data[16:]))
+
+        transport, _ = await loop.create_datagram_endpoint(UdpProtocol, remote_addr=(args.host, udp['port']))
+        await client.send({'session_id': hello['session_id'], 'type': 'listen', 'state': 'start', 'mode': 'manual'})
+        open_latencies.append((time.perf_counter() - start) * 1000)
+
+        cpu_start, wall_start = time.process_time(), time.perf_counter()
+        for seq in range(1, args.packets + 1):
+            nonce = bytearray(nonce_template)
+            struct.pack_into('>H', nonce, 2, len(frame))
+            struct.pack_into('>I', nonce, 8, seq * args.frame_duration)
+            struct.pack_into('>I', nonce, 12, seq)
+            nonce = bytes(nonce)
+            transport.sendto(nonce + aes_ctr(key, nonce, frame))
+            if args.pace:
+                await asyncio.sleep(args.frame_duration / 1000)
+            elif seq % 64 == 0:
+                await asyncio.sleep(0)
+        wall = time.perf_counter() - wall_start
+        cpu = time.process_time() - cpu_start
+        await client.send({'session_id': hello['session_id'], 'type': 'listen', 'state': 'stop'})
+        await client.send({'session_id': hello['session_id'], 'type': 'goodbye'})
+        await asyncio.sleep(0.2)
+        transport.close()
+
+        reconnect_start = time.perf_counter()
+        await client.close()
+        await client.connect()
+        reconnect = (time.perf_counter() - reconnect_start) * 1000
+        await client.close()
+        print(f"[udp] open {open_latencies[-1]:.1f} ms, {args.packets / wall:.0f} pkt/s, "
+              f"{cpu * 1e6 / args.packets:.1f} us cpu/pkt, echoed {received.qsize()}, reconnect {reconnect:.1f} ms")
+    return open_latencies
+
+
+async def bench_ws(args, frame):
+    open_latencies = []
+    for _ in range(args.iterations):
+        start = time.perf_counter()
+        ws = await websockets.connect(f"ws://{args.host}:{args.ws_port}/xiaozhi/v1/",
+                                      additional_headers={'Protocol-Version': str(args.ws_version),
+                                                          'Device-Id': 'bench'})
+        await ws.send(json.dumps({'type': 'hello', 'version': args.ws_version, 'transport': 'websocket',
+                                  'features': {'mcp': True},
+                                  'audio_params': {'format': 'opus', 'sample_rate': 16000, 'channels': 1,
+                                                   'frame_duration': args.frame_duration}}))
+        hello = json.loads(await asyncio.wait_for(ws.recv(), 10))
+        await ws.send(json.dumps({'session_id': hello['session_id'], 'type': 'listen', 'state': 'start',
+                                  'mode': 'manual'}))
+        open_latencies.append((time.perf_counter() - start) * 1000)
+
+        received = 0
+
+        async def drain():
+            nonlocal received
+            async for data in ws:
+                if isinstance(data, bytes):
+                    received += 1
+
+        drain_task = asyncio.ensure_future(drain())
+        cpu_start, wall_start = time.process_time(), time.perf_counter()
+        for seq in range(1, args.packets + 1):
+            await ws.send(pack_ws_audio(args.ws_version, frame, seq * args.frame_duration))
+            if args.pace:
+                await asyncio.sleep(args.frame_duration / 1000)
+        wall = time.perf_counter() - wall_start
+        cpu = time.process_time() - cpu_start
+        await asyncio.sleep(0.2)
+        await ws.close()
+        drain_task.cancel()
+        print(f"[ws] open {open_latencies[-1]:.1f} ms, {args.packets / wall:.0f} pkt/s, "
+              f"{cpu * 1e6 / args.packets:.1f} us cpu/pkt, echoed {received}")
+    return open_latencies
+
+
+async def channel_udp(args, rtt):
+    '''
+    MqttProtocol::OpenAudioChannel paths. cold and resumed follow a dropped
+    MQTT connection (reconnect + hello), warm reuses the parked channel.
+    '''
+    loop = asyncio.get_running_loop()
+    client = MqttClient(args.host, args.mqtt_port, 'channel-' + uuid.uuid4().hex[:8])
+    hello_message = {'type': 'hello', 'version': 3, 'transport': 'udp', 'features': {'mcp': True},
+                     'audio_params': {'format': 'opus', 'sample_rate': 16000, 'channels': 1,
+                                      'frame_duration': args.frame_duration}}
+    results = {'cold': [], 'warm': [], 'resumed': []}
+    resumed_ok = 0
+    for _ in range(args.iterations):
+        # cold: connect, hello, block on the server hello, then the UDP socket
+        start = time.perf_counter()
+        await client.connect()
+        await asyncio.sleep(rtt)
+        await client.send(hello_message)
+        hello = await wait_type(client.messages, 'hello')
+        await asyncio.sleep(rtt)
+        transport, _ = await loop.create_datagram_endpoint(asyncio.DatagramProtocol,
+                                                           remote_addr=(args.host, hello['udp']['port']))
+        results['cold'].append((time.perf_counter() - start) * 1000)
+        session_id = hello['session_id']
+        await client.send({'session_id': session_id, 'type': 'listen', 'state': 'start', 'mode': 'manual'})
+        await client.send({'session_id': session_id, 'type': 'listen', 'state': 'stop'})
+
+        # warm: the parked channel is handed back without a message
+        start = time.perf_counter()
+        results['warm'].append((time.perf_counter() - start) * 1000)
+        await client.send({'session_id': session_id, 'type': 'listen', 'state': 'start', 'mode': 'manual'})
+
+        # resumed: the connection drops, hello with the cached id and key, no wait
+        transport.close()
+        client.writer.close()
+        client.task.cancel()
+        await asyncio.sleep(0.1)
+        start = time.perf_counter()
+        await client.connect()
+        await asyncio.sleep(rtt)
+        await client.send(dict(hello_message, session_id=session_id))
+        transport, _ = await loop.create_datagram_endpoint(asyncio.DatagramProtocol,
+                                                           remote_addr=(args.host, hello['udp']['port']))
+        results['resumed'].append((time.perf_counter() - start) * 1000)
+        hello = await wait_type(client.messages, 'hello')
+        resumed_ok += hello['session_id'] == session_id
+        await client.send({'session_id': session_id, 'type': 'goodbye'})
+        transport.close()
+        await client.close()
+        await asyncio.sleep(0.1)
+    print(f"[udp] resumed {resumed_ok}/{args.iterations} sessions by id")
+    return results
+
+
+async def channel_ws(args, rtt):
+    '''WebsocketProtocol::OpenAudioChannel paths, resumed after a dropped connection'''
+    url = f"ws://{args.host}:{args.ws_port}/xiaozhi/v1/"
+    headers = {'Protocol-Version': str(args.ws_version), 'Device-Id': 'channel'}
+    hello_message = {'type': 'hello', 'version': args.ws_version, 'transport': 'websocket',
+                     'features': {'mcp': True},
+                     'audio_params': {'format': 'opus', 'sample_rate': 16000, 'channels': 1,
+                                      'frame_duration': args.frame_duration}}
+    results = {'cold': [], 'warm': [], 'resumed': []}
+    resumed_ok = 0
+    for _ in range(args.iterations):
+        # cold: TCP + upgrade, hello, block on the server hello
+        start = time.perf_counter()
+        ws = await websockets.connect(url, additional_headers=headers)
+        await asyncio.sleep(2 * rtt)
+        await ws.send(json.dumps(hello_message))
+        hello = json.loads(await asyncio.wait_for(ws.recv(), 10))
+        await asyncio.sleep(rtt)
+        results['cold'].append((time.perf_counter() - start) * 1000)
+        session_id = hello['session_id']
+        await ws.send(json.dumps({'session_id': session_id, 'type': 'listen', 'state': 'start', 'mode': 'manual'}))
+        await ws.send(json.dumps({'session_id': session_id, 'type': 'listen', 'state': 'stop'}))
+
+        # warm: the parked connection is reused as is
+        start = time.perf_counter()
+        results['warm'].append((time.perf_counter() - start) * 1000)
+        await ws.send(json.dumps({'session_id': session_id, 'type': 'listen', 'state': 'start', 'mode': 'manual'}))
+
+        # resumed: new connection, hello with the cached id, no wait for the reply
+        await ws.close()
+        await asyncio.sleep(0.1)
+        start = time.perf_counter()
+        ws = await websockets.connect(url, additional_headers=headers)
+        await asyncio.sleep(2 * rtt)
+        await ws.send(json.dumps(dict(hello_message, session_id=session_id)))
+        results['resumed'].append((time.perf_counter() - start) * 1000)
+        while True:
+            message = await asyncio.wait_for(ws.recv(), 10)
+            if isinstance(message, str) and json.loads(message).get('type') == 'hello':
+                resumed_ok += json.loads(message)['session_id'] == session_id
+                break
+        await ws.close()
+        await asyncio.sleep(0.1)
+    print(f"[ws] resumed {resumed_ok}/{args.iterations} sessions by id")
+    return results
+
+
+def channel_bench(args):
+    # Loopback has no latency, every awaited round trip is charged --rtt-ms
+    rtt = args.rtt_ms / 1000
+    results = {'udp': asyncio.run(channel_udp(args, rtt))}
+    if websockets is not None:
+        results['websocket'] = asyncio.run(channel_ws(args, rtt))
+    for name, paths in results.items():
+        summary = []
+        for path, latencies in paths.items():
+            latencies.sort()
+            summary.append(f"{path} p50 {latencies[len(latencies) // 2]:.1f} ms / max {latencies[-1]:.1f} ms")
+        print(f"{name} (rtt {args.rtt_ms} ms): " + ", ".join(summary))
+
+
+class UplinkEmulator:
+    '''
+    Device send path on a link slower than the audio rate. 'fifo' is the old
+    single queue; 'priority' mirrors SendScheduler (SEND_SCHEDULER_MAX_AUDIO_BACKLOG,
+    SEND_SCHEDULER_MAX_AUDIO_AGE_MS).
+    '''
+    MAX_AUDIO_BACKLOG = 20
+    MAX_AUDIO_AGE = 1.2
+
+    def __init__(self, ws, policy, uplink_bps):
+        self.ws = ws
+        self.policy = policy
+        self.uplink_bps = uplink_bps
+        self.control = []
+        self.audio = []
+        self.dropped = 0
+        self.event = asyncio.Event()
+
+    def enqueue_control(self, text):
+        if self.policy == 'fifo':
+            self.audio.append((text, time.monotonic()))
+        else:
+            self.control.append(text)
+        self.event.set()
+
+    def enqueue_audio(self, data):
+        if self.policy == 'priority' and len(self.audio) >= self.MAX_AUDIO_BACKLOG:
+            self.audio.pop(0)
+            self.dropped += 1
+        self.audio.append((data, time.monotonic()))
+        self.event.set()
+
+    def next_message(self):
+        if self.control:
+            return self.control.pop(0)
+        if self.policy == 'priority':
+            now = time.monotonic()
+            while self.audio and now - self.audio[0][1] > self.MAX_AUDIO_AGE:
+                self.audio.pop(0)
+                self.dropped += 1
+        return self.audio.pop(0)[0] if self.audio else None
+
+    async def run(self):
+        while True:
+            message = self.next_message()
+            if message is None:
+                self.event.clear()
+                await self.event.wait()
+                continue
+            await self.ws.send(message)
+            # The link is busy for the serialization time of this message
+            await asyncio.sleep(len(message) * 8 / self.uplink_bps)
+
+
+async def bench_abort(args, policy, frame):
+    latencies, dropped = [], 0
+    for _ in range(args.iterations):
+        ws = await websockets.connect(f"ws://{args.host}:{args.ws_port}/xiaozhi/v1/",
+                                      additional_headers={'Protocol-Version': str(args.ws_version),
+                                                          'Device-Id': 'bench'})
+        await ws.send(json.dumps({'type': 'hello', 'version': args.ws_version, 'transport': 'websocket',
+                                  'features': {'mcp': True},
+                                  'audio_params': {'format': 'opus', 'sample_rate': 16000, 'channels': 1,
+                                                   'frame_duration': args.frame_duration}}))
+        hello = json.loads(await asyncio.wait_for(ws.recv(), 10))
+        session_id = hello['session_id']
+        await ws.send(json.dumps({'session_id': session_id, 'type': 'listen', 'state': 'start', 'mode': 'manual'}))
+
+        uplink = UplinkEmulator(ws, policy, args.uplink_kbps * 1000)
+        sender = asyncio.ensure_future(uplink.run())
+        tts_stopped = asyncio.Event()
+
+        async def receive():
+            async for data in ws:
+                if isinstance(data, str):
+                    message = json.loads(data)
+                    if message.get('type') == 'tts' and message.get('state') == 'stop':
+                        tts_stopped.set()
+
+        receiver = asyncio.ensure_future(receive())
+        # Mic keeps producing at the real frame rate, faster than the uplink drains
+        start = time.monotonic()
+        seq = 0
+        while time.monotonic() - start < args.saturate_seconds:
+            seq += 1
+            uplink.enqueue_audio(pack_ws_audio(args.ws_version, frame, seq * args.frame_duration))
+            await asyncio.sleep(args.frame_duration / 1000)
+
+        abort_time = time.monotonic()
+        uplink.enqueue_control(json.dumps({'session_id': session_id, 'type': 'abort'}))
+        while not tts_stopped.is_set():
+            seq += 1
+            uplink.enqueue_audio(pack_ws_audio(args.ws_version, frame, seq * args.frame_duration))
+            try:
+                await asyncio.wait_for(tts_stopped.wait(), args.frame_duration / 1000)
+            except asyncio.TimeoutError:
+                pass
+        latencies.append((time.monotonic() - abort_time) * 1000)
+        dropped += uplink.dropped
+
+        sender.cancel()
+        receiver.cancel()
+        await ws.close()
+    latencies.sort()
+    print(f"[abort] {policy:8s} uplink {args.uplink_kbps} kbps: abort -> tts stop p50 {latencies[len(latencies) // 2]:.0f} ms, "
+          f"max {latencies[-1]:.0f} ms, audio dropped {dropped / len(latencies):.0f} per run")
+
+
+def abort_bench(args):
+    if websockets is None:
+        print("websockets not installed")
+        return
+    frame = os.urandom(args.frame_size)
+    for policy in ('fifo', 'priority'):
+        asyncio.run(bench_abort(args, policy, frame))
+
+
+def bench(args):
+    frame = os.urandom(args.frame_size)
+    results = {}
+    if args.transport in ('udp', 'all'):
+        results['udp'] = asyncio.run(bench_udp(args, frame))
+    if args.transport in ('websocket', 'all') and websockets is not None:
+        results['websocket'] = asyncio.run(bench_ws(args, frame))
+    for name, latencies in results.items():
+        latencies.sort()
+        print(f"{name}: channel open p50 {latencies[len(latencies) // 2]:.1f} ms, "
+              f"max {latencies[-1]:.1f} ms over {len(latencies)} runs")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Local xiaozhi protocol server and protocol benchmark')
+    parser.add_argument('--mqtt-port', type=int, default=1883)
+    parser.add_argument('--udp-port', type=int, default=8884)
+    parser.add_argument('--ws-port', type=int, default=8000)
+    parser.add_argument('--ws-version', type=int, default=3, choices=[1, 2, 3])
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    serve_parser = sub.add_parser('serve', help='run the stand-in server')
+    serve_parser.add_argument('--http-port', type=int, default=8002)
+    serve_parser.add_argument('--advertise', help='address handed to the device (default: local ip)')
+    serve_parser.add_argument('--mode', choices=['echo', 'loopback'], default='echo',
+                              help='echo: replay the utterance as TTS; loopback: return every packet immediately')
+    serve_parser.add_argument('--sample-rate', type=int, default=16000)
+    serve_parser.add_argument('--listen-seconds', type=float, default=3.0,
+                              help='auto/realtime listen window before TTS starts (0: wait for listen stop)')
+    serve_parser.add_argument('--max-frames', type=int, default=1000)
+    serve_parser.add_argument('--keepalive', type=int, default=240)
+    serve_parser.add_argument('--idle-window', type=int, default=0,
+                              help='idle_window handed to the device via OTA (seconds, 0: firmware default)')
+    serve_parser.add_argument('--resume-seconds', type=float, default=120,
+                              help='how long a dropped session can be resumed by its session id')
+    serve_parser.add_argument('--mcp-bench', type=int, default=0,
+                              help='after each hello, time N sequential tools/call against one batch of N')
+    serve_parser.add_argument('--mcp-tool', default='self.get_device_status')
+    serve_parser.add_argument('--mcp-arguments', default='{}', help='tool arguments as JSON')
+
+    bench_parser = sub.add_parser('bench', help='benchmark a running server with a host client')
+    bench_parser.add_argument('--host', default='127.0.0.1')
+    bench_parser.add_argument('--transport', choices=['udp', 'websocket', 'all'], default='all')
+    bench_parser.add_argument('--iterations', type=int, default=5)
+    bench_parser.add_argument('--packets', type=int, default=2000)
+    bench_parser.add_argument('--frame-size', type=int, default=120)
+    bench_parser.add_argument('--frame-duration', type=int, default=60)
+    bench_parser.add_argument('--pace', action='store_true', help='send at real-time frame rate')
+
+    channel_parser = sub.add_parser('channel', help='cold, warm and resumed channel-open latency')
+    channel_parser.add_argument('--host', default='127.0.0.1')
+    channel_parser.add_argument('--iterations', type=int, default=10)
+    channel_parser.add_argument('--frame-duration', type=int, default=60)
+    channel_parser.add_argument('--rtt-ms', type=float, default=0,
+                                help='link round trip charged per awaited exchange (loopback has none)')
+
+    abort_parser = sub.add_parser('abort', help='abort latency on a saturated uplink, FIFO vs priority')
+    abort_parser.add_argument('--host', default='127.0.0.1')
+    abort_parser.add_argument('--iterations', type=int, default=5)
+    abort_parser.add_argument('--frame-size', type=int, default=120)
+    abort_parser.add_argument('--frame-duration', type=int, default=60)
+    abort_parser.add_argument('--uplink-kbps', type=float, default=12,
+                              help='emulated uplink rate, below the audio rate to build a backlog')
+    abort_parser.add_argument('--saturate-seconds', type=float, default=5.0,
+                              help='audio streamed before the abort is issued')
+
+    args = parser.parse_args()
+    if args.command == 'serve':
+        try:
+            asyncio.run(ProtocolServer(args).run())
+        except KeyboardInterrupt:
+            pass
+    elif args.command == 'channel':
+        channel_bench(args)
+    elif args.command == 'abort':
+        abort_bench(args)
+    else:
+        bench(args)
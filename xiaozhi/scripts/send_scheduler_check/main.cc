@@ -0,0 +1,158 @@
+/*
+ * Host check: SendScheduler keeps the whole wake word preroll.
+ *
+ * The wake word path queues about 2 s of audio (34 frames of 60 ms) in one go,
+ * more than SEND_SCHEDULER_MAX_AUDIO_BACKLOG. The link is stalled while the
+ * preroll and the live frames behind it queue up, for longer than
+ * SEND_SCHEDULER_MAX_AUDIO_AGE_MS. Every preroll frame must still go out, in
+ * order, while live audio stays bounded.
+ *
+ * Then checks message order: a listen stop queued behind audio goes out after
+ * those frames, while an abort queued after it still goes out first. Runs on
+ * the FreeRTOS / esp_timer stand-ins of scripts/i2c_sim.
+ *
+ *   g++ -O2 -std=c++17 -pthread -I ../i2c_sim/fake -I ../../main/protocols main.cc \
+ *       ../../main/protocols/send_scheduler.cc ../i2c_sim/fake/freertos.cc ../i2c_sim/fake/esp_idf.cc \
+ *       -o send_scheduler_check
+ *   ./send_scheduler_check
+ */
+#include "protocol.h"
+#include "send_scheduler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const int kPrerollFrames = 34;
+static const int kLiveFrames = 30;
+static const uint32_t kLiveBase = 1000;
+
+static bool Check(bool ok, const char* what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+struct Outcome {
+    std::vector<uint32_t> sent;
+    SendLaneStats stats;
+};
+
+// Queues the preroll and then live frames on a stalled link, then lets it drain
+static std::unique_ptr<AudioStreamPacket> MakePacket(uint32_t timestamp) {
+    auto packet = std::make_unique<AudioStreamPacket>();
+    packet->frame_duration = 60;
+    packet->timestamp = timestamp;
+    packet->payload.resize(120);
+    return packet;
+}
+
+static Outcome Run(bool preroll, int stall_ms) {
+    std::mutex mutex;
+    Outcome outcome;
+    SendScheduler scheduler([](const std::string&) { return true; },
+        [&](std::unique_ptr<AudioStreamPacket> packet) {
+            std::lock_guard<std::mutex> lock(mutex);
+            outcome.sent.push_back(packet->timestamp);
+            return true;
+        });
+    {
+        auto transport_lock = scheduler.LockTransport();
+        for (uint32_t i = 0; i < kPrerollFrames; i++) {
+            scheduler.EnqueueAudio(MakePacket(i), preroll);
+        }
+        for (uint32_t i = 0; i < kLiveFrames; i++) {
+            scheduler.EnqueueAudio(MakePacket(kLiveBase + i));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(stall_ms));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    scheduler.Stop();
+    outcome.stats = scheduler.audio_stats();
+    return outcome;
+}
+
+static int CountPreroll(const std::vector<uint32_t>& sent, bool* in_order) {
+    int count = 0;
+    *in_order = true;
+    for (uint32_t timestamp : sent) {
+        if (timestamp < kLiveBase) {
+            *in_order &= timestamp == (uint32_t)count;
+            count++;
+        }
+    }
+    return count;
+}
+
+// Frames and messages as the link saw them, "audio N" or the message
+static std::vector<std::string> RunOrder() {
+    std::mutex mutex;
+    std::vector<std::string> sent;
+    SendScheduler scheduler(
+        [&](const std::string& message) {
+            std::lock_guard<std::mutex> lock(mutex);
+            sent.push_back(message);
+            return true;
+        },
+        [&](std::unique_ptr<AudioStreamPacket> packet) {
+            std::lock_guard<std::mutex> lock(mutex);
+            sent.push_back("audio " + std::to_string(packet->timestamp));
+            return true;
+        });
+    {
+        auto transport_lock = scheduler.LockTransport();
+        scheduler.EnqueueAfterAudio("listen start");
+        for (uint32_t i = 0; i < 5; i++) {
+            scheduler.EnqueueAudio(MakePacket(i));
+        }
+        scheduler.EnqueueAfterAudio("listen stop");
+        scheduler.EnqueueControl("abort");
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    scheduler.Stop();
+    return sent;
+}
+
+int main() {
+    bool ok = true;
+    bool in_order = false;
+
+    // Link back before live frames age out: only the backlog limit applies
+    auto outcome = Run(true, 100);
+    int preroll_sent = CountPreroll(outcome.sent, &in_order);
+    int live_sent = (int)outcome.sent.size() - preroll_sent;
+    printf("preroll, short stall: sent %d preroll + %d live, dropped %lu\n", preroll_sent, live_sent,
+        (unsigned long)outcome.stats.dropped);
+    ok &= Check(preroll_sent == kPrerollFrames && in_order, "full preroll sent in order");
+    ok &= Check(live_sent == SEND_SCHEDULER_MAX_AUDIO_BACKLOG, "live audio still bounded by the backlog");
+    ok &= Check(outcome.stats.dropped == (uint32_t)(kLiveFrames - SEND_SCHEDULER_MAX_AUDIO_BACKLOG),
+        "only live frames dropped");
+
+    // Stalled past SEND_SCHEDULER_MAX_AUDIO_AGE_MS: the live frames age out, the preroll does not
+    outcome = Run(true, SEND_SCHEDULER_MAX_AUDIO_AGE_MS + 300);
+    preroll_sent = CountPreroll(outcome.sent, &in_order);
+    live_sent = (int)outcome.sent.size() - preroll_sent;
+    printf("preroll, long stall:  sent %d preroll + %d live, dropped %lu\n", preroll_sent, live_sent,
+        (unsigned long)outcome.stats.dropped);
+    ok &= Check(preroll_sent == kPrerollFrames && in_order, "full preroll sent after a long stall");
+    ok &= Check(live_sent == 0, "stale live frames dropped");
+
+    // Without the flag the start of the utterance is lost, as before
+    outcome = Run(false, 100);
+    preroll_sent = CountPreroll(outcome.sent, &in_order);
+    printf("unflagged:            sent %d of %d preroll frames\n", preroll_sent, kPrerollFrames);
+    ok &= Check(preroll_sent == 0, "unflagged preroll goes through drop-oldest");
+
+    auto order = RunOrder();
+    std::vector<std::string> expected = {"abort", "listen start", "audio 0", "audio 1", "audio 2", "audio 3",
+        "audio 4", "listen stop"};
+    printf("order:               ");
+    for (auto& item : order) {
+        printf(" [%s]", item.c_str());
+    }
+    printf("\n");
+    ok &= Check(order == expected, "abort first, listen messages in order with audio");
+    return ok ? 0 : 1;
+}
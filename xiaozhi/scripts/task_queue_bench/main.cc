@@ -0,0 +1,167 @@
+/*
+ * Host benchmark: Application::Schedule with the previous mutex + std::deque of
+ * std::function versus TaskQueue of InlineTask. Producer threads post tasks
+ * whose captures look like the firmware's (this, an id, a timestamp...), one
+ * consumer thread drains them like MainEventLoop.
+ *
+ *   g++ -O2 -std=c++17 -pthread -I ../../main main.cc -o task_queue_bench
+ *   ./task_queue_bench [tasks per producer] [producers]
+ *
+ * "flood" posts as fast as possible (throughput, the queue is mostly full so
+ * latency is queueing delay); "bursts" posts 8 tasks then pauses, closer to
+ * the device where the main loop keeps up (enqueue-to-run latency).
+ */
+#include "task_queue.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+using Clock = std::chrono::steady_clock;
+
+struct Sink {
+    std::vector<int64_t> latencies_ns;
+    uint64_t checksum = 0;
+};
+
+static int64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// Representative capture: owner pointer, a tool id and a small argument block
+static void RunTask(Sink* sink, int64_t posted, int id, const std::array<uint32_t, 4>& args) {
+    sink->latencies_ns.push_back(Now() - posted);
+    sink->checksum += id + args[id & 3];
+}
+
+class MutexDequeScheduler {
+public:
+    void Schedule(std::function<void()> callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(callback));
+    }
+
+    size_t Drain() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto tasks = std::move(tasks_);
+        lock.unlock();
+        for (auto& task : tasks) {
+            task();
+        }
+        return tasks.size();
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<std::function<void()>> tasks_;
+};
+
+class TaskQueueScheduler {
+public:
+    template <typename F>
+    void Schedule(F&& callback) {
+        tasks_.Push(InlineTask(std::forward<F>(callback)));
+    }
+
+    size_t Drain() {
+        InlineTask task;
+        size_t count = 0;
+        while (count < 16 && tasks_.Pop(task)) {
+            task();
+            task.Reset();
+            count++;
+        }
+        return count;
+    }
+
+    uint32_t overflow_count() const { return tasks_.overflow_count(); }
+
+private:
+    TaskQueue<InlineTask, 64> tasks_;
+};
+
+template <typename Scheduler>
+static void Run(const char* name, int producers, int tasks_per_producer, bool paced) {
+    Scheduler scheduler;
+    Sink sink;
+    size_t total = (size_t)producers * tasks_per_producer;
+    sink.latencies_ns.reserve(total);
+
+    size_t allocations = g_allocations.load();
+    auto start = Clock::now();
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p]() {
+            while (!go.load()) {
+            }
+            std::array<uint32_t, 4> args = {(uint32_t)p, 1, 2, 3};
+            Sink* target = &sink;
+            for (int i = 0; i < tasks_per_producer; i++) {
+                int64_t posted = Now();
+                scheduler.Schedule([target, posted, i, args]() { RunTask(target, posted, i, args); });
+                if (paced && i % 8 == 7) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+            }
+        });
+    }
+    go.store(true);
+    size_t done = 0;
+    while (done < total) {
+        size_t count = scheduler.Drain();
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+        done += count;
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    size_t allocations_used = g_allocations.load() - allocations - producers;  // minus std::thread state
+
+    auto& latencies = sink.latencies_ns;
+    std::sort(latencies.begin(), latencies.end());
+    printf("%-6s %-22s %11.0f ops/s %6.2f alloc/op  p50 %7.1f us  p99 %8.1f us\n", paced ? "bursts" : "flood", name, total / elapsed,
+           (double)allocations_used / total, latencies[total / 2] / 1000.0,
+           latencies[total * 99 / 100] / 1000.0);
+}
+
+int main(int argc, char** argv) {
+    int tasks_per_producer = argc > 1 ? atoi(argv[1]) : 200000;
+    int producers = argc > 2 ? atoi(argv[2]) : 4;
+    printf("%d producers x %d tasks, inline capture %zu bytes\n", producers, tasks_per_producer,
+           (size_t)TASK_INLINE_SIZE);
+    for (bool paced : {false, true}) {
+        Run<MutexDequeScheduler>("mutex deque function", producers, tasks_per_producer, paced);
+        Run<TaskQueueScheduler>("TaskQueue InlineTask", producers, tasks_per_producer, paced);
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Host stress check: TaskQueue keeps every producer's tasks in order while the
+ * ring is full and tasks spill into the overflow list.
+ *
+ * The ring is tiny and producers post in bursts, so tasks keep going between
+ * the ring and the overflow list. The
+ * item's move assignment, which a producer runs between claiming a slot and
+ * publishing it, sometimes yields or sleeps: other producers publish behind
+ * the unpublished slot and spill past it meanwhile. The consumer checks each
+ * producer's sequence numbers arrive in order, none lost or repeated.
+ *
+ *   g++ -O2 -std=c++17 -pthread -I ../../main main.cc -o task_queue_check
+ *   ./task_queue_check [rounds]
+ */
+#include "task_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+static const int kProducers = 6;
+static const int kTasksPerProducer = 20000;
+
+static bool Check(bool ok, const char* what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// Slow to move now and then, to stretch the claimed-but-unpublished window
+struct Item {
+    int producer = -1;
+    int sequence = 0;
+
+    Item() = default;
+    Item(int p, int s) : producer(p), sequence(s) {}
+    Item(Item&& other) noexcept { *this = std::move(other); }
+    Item& operator=(Item&& other) noexcept {
+        if (other.sequence % 97 == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        } else if (other.sequence % 7 == 0) {
+            std::this_thread::yield();
+        }
+        producer = other.producer;
+        sequence = other.sequence;
+        return *this;
+    }
+};
+
+static bool RunRound(int round) {
+    TaskQueue<Item, 4> queue;
+    std::atomic<int> started{0};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&queue, &started, p]() {
+            started++;
+            while (started.load() < kProducers) {
+            }
+            // Bursts that overflow the ring, with gaps that let the overflow drain
+            for (int s = 1; s <= kTasksPerProducer; s++) {
+                queue.Push(Item(p, s));
+                if (s % 3 == 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(s % 11));
+                }
+            }
+        });
+    }
+
+    int next[kProducers] = {};
+    int received = 0;
+    int out_of_order = 0;
+    Item item;
+    while (received < kProducers * kTasksPerProducer) {
+        if (!queue.Pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item.sequence != next[item.producer] + 1) {
+            if (out_of_order++ == 0) {
+                printf("round %d: producer %d ran %d after %d\n", round, item.producer, item.sequence,
+                    next[item.producer]);
+            }
+        }
+        next[item.producer] = item.sequence;
+        received++;
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    bool empty = !queue.Pop(item);
+    uint32_t overflowed = queue.overflow_count();
+    printf("round %d: %d tasks, %lu overflowed, %d out of order\n", round, received, (unsigned long)overflowed,
+        out_of_order);
+    return out_of_order == 0 && empty && overflowed > 0 && overflowed < (uint32_t)received;
+}
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 5;
+    bool ok = true;
+    for (int round = 0; round < rounds; round++) {
+        ok &= RunRound(round);
+    }
+    Check(ok, "per-producer order kept with the ring full");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+/*
+ * Host check for TaskScheduler lanes: background producers flood the main
+ * loop with slow tasks (display updates, MCP tool bodies) while a realtime
+ * producer posts an abort-like task every few ms. Runs once with everything
+ * on one lane (the old FIFO behaviour) and once with lanes, prints wait
+ * percentiles and per-lane stats, and exits non-zero if realtime work missed
+ * its deadline with lanes enabled.
+ *
+ *   g++ -O2 -std=c++17 -pthread -I ../../main main.cc -o task_scheduler_bench
+ *   ./task_scheduler_bench [seconds]
+ */
+#include "task_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static int64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static void BusyFor(int64_t us) {
+    int64_t end = NowUs() + us;
+    while (NowUs() < end) {
+    }
+}
+
+static const char* const kLaneNames[kTaskLaneCount] = {"realtime", "normal", "background"};
+
+static bool Run(bool lanes, double seconds) {
+    TaskScheduler scheduler;
+    std::atomic<bool> stop{false};
+    std::vector<int64_t> realtime_waits;
+    realtime_waits.reserve(100000);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 3; p++) {
+        producers.emplace_back([&]() {
+            while (!stop.load()) {
+                // Keep a backlog without growing the overflow list forever
+                if (scheduler.stats(kTaskLaneBackground).depth + scheduler.stats(kTaskLaneNormal).depth < 200) {
+                    scheduler.Post(lanes ? kTaskLaneBackground : kTaskLaneNormal, []() { BusyFor(300); }, NowUs());
+                }
+                std::this_thread::yield();
+            }
+        });
+    }
+    producers.emplace_back([&]() {
+        while (!stop.load()) {
+            int64_t posted = NowUs();
+            scheduler.Post(lanes ? kTaskLaneRealtime : kTaskLaneNormal, [&realtime_waits, posted]() {
+                realtime_waits.push_back(NowUs() - posted);
+            }, posted, kTaskLaneDeadlineMs[kTaskLaneRealtime]);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+
+    auto end = Clock::now() + std::chrono::duration<double>(seconds);
+    while (Clock::now() < end) {
+        if (!scheduler.RunNext(NowUs())) {
+            std::this_thread::yield();
+        }
+    }
+    stop.store(true);
+    for (auto& thread : producers) {
+        thread.join();
+    }
+
+    std::sort(realtime_waits.begin(), realtime_waits.end());
+    size_t count = realtime_waits.size();
+    int64_t p99 = count ? realtime_waits[count * 99 / 100] : 0;
+    printf("%s: realtime tasks %zu, wait p50 %.2f ms, p99 %.2f ms, max %.2f ms\n", lanes ? "lanes" : "fifo ", count,
+           count ? realtime_waits[count / 2] / 1000.0 : 0, p99 / 1000.0, count ? realtime_waits.back() / 1000.0 : 0);
+    for (int lane = 0; lane < kTaskLaneCount; lane++) {
+        auto stats = scheduler.stats((TaskLane)lane);
+        if (stats.run == 0) {
+            continue;
+        }
+        auto& h = stats.wait_histogram;
+        printf("  %-10s depth %4u run %7u missed %7u max %8.2f ms  <1/<5/<20/<100/<500/>500 ms: %u/%u/%u/%u/%u/%u\n",
+               kLaneNames[lane], stats.depth, stats.run, stats.deadline_misses, stats.max_wait_us / 1000.0,
+               h[0], h[1], h[2], h[3], h[4], h[5]);
+    }
+    return count > 0 && p99 <= (int64_t)kTaskLaneDeadlineMs[kTaskLaneRealtime] * 1000;
+}
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+    Run(false, seconds);
+    bool ok = Run(true, seconds);
+    printf("%s: realtime p99 %s the %u ms deadline under background flood\n", ok ? "PASS" : "FAIL",
+           ok ? "within" : "exceeds", kTaskLaneDeadlineMs[kTaskLaneRealtime]);
+    return ok ? 0 : 1;
+}
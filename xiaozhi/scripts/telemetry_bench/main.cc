@@ -0,0 +1,79 @@
+/*
+ * Host benchmark: TelemetrySeries insert cost and memory per series.
+ * Feeds one simulated month of 1 Hz samples for a few value shapes (slowly
+ * drifting heap, noisy RSSI, counters with bursts, a sample every 2 s like the
+ * I2C poll) and checks the 1 s level decodes to exactly what was recorded.
+ *
+ *   g++ -O2 -std=c++17 -I ../../main main.cc -o telemetry_bench
+ *   ./telemetry_bench
+ */
+#include "telemetry_series.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct Shape {
+    const char* name;
+    TelemetryAggregate aggregate;
+    uint32_t interval;
+    std::function<int32_t(uint32_t time, std::mt19937& rng)> value;
+};
+
+int main() {
+    const uint32_t kDuration = 30 * 24 * 3600;
+    std::vector<Shape> shapes = {
+        {"heap_free KB", kTelemetryAverage, 1,
+            [](uint32_t t, std::mt19937& rng) { return 180 + (int32_t)(t / 7200 % 40) - (int32_t)(rng() % 3); }},
+        {"wifi_rssi dBm", kTelemetryAverage, 1, [](uint32_t, std::mt19937& rng) { return -55 - (int32_t)(rng() % 20); }},
+        {"i2c_errors", kTelemetrySum, 2, [](uint32_t t, std::mt19937& rng) { return t % 600 < 20 ? (int32_t)(rng() % 2) : 0; }},
+        {"actuator mV", kTelemetryAverage, 2, [](uint32_t t, std::mt19937& rng) { return 7400 - (int32_t)(t % 86400 / 60) + (int32_t)(rng() % 50); }},
+    };
+
+    printf("memory per series: %zu bytes (raw 8 byte samples for the same history: %zu bytes)\n\n",
+        TelemetrySeries::MemorySize(), (size_t)(3600 + 24 * 60 + 30 * 24) * 8);
+
+    bool ok = true;
+    for (auto& shape : shapes) {
+        std::vector<unsigned char> memory(TelemetrySeries::MemorySize());
+        TelemetrySeries series(shape.name, "", shape.aggregate, memory.data());
+        std::mt19937 rng(7);
+
+        // Kept for the check: the last hour of what went into the 1 s level
+        std::vector<std::pair<uint32_t, int32_t>> recent;
+        uint32_t count = 0;
+        auto start = Clock::now();
+        for (uint32_t t = 0; t < kDuration; t += shape.interval) {
+            int32_t value = shape.value(t, rng);
+            series.Record(t, value);
+            count++;
+            if (t + 3600 >= kDuration) {
+                recent.push_back({t, value});
+            }
+        }
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+
+        // The slot still being filled is not stored yet
+        recent.pop_back();
+        size_t matched = 0;
+        series.Visit(0, recent.front().first, kDuration, [&](uint32_t time, int32_t value) {
+            if (matched < recent.size() && recent[matched].first == time && recent[matched].second == value) {
+                matched++;
+            }
+        });
+        int levels[TELEMETRY_LEVEL_COUNT] = {};
+        for (int level = 0; level < TELEMETRY_LEVEL_COUNT; level++) {
+            series.Visit(level, 0, kDuration, [&](uint32_t, int32_t) { levels[level]++; });
+        }
+        bool shape_ok = matched == recent.size();
+        ok = ok && shape_ok;
+        printf("%-14s %8u inserts  %6.1f ns/insert  kept 1s/1m/1h: %d/%d/%d  last hour %s\n", shape.name, count, ns,
+            levels[0], levels[1], levels[2], shape_ok ? "exact" : "MISMATCH");
+    }
+    return ok ? 0 : 1;
+}